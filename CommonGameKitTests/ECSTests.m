@@ -26,6 +26,7 @@
 //ecs_tool setup -i CommonGameKitTests/ECSTests.h src/ecs/systems/*.h src/ecs/components/*.h -a CommonGameKitTests/ECSTestAccessors.h --max-local 64 -c ecs_env -e 'ECS_PACKED_COMPONENT_ID_BASE=1' -e 'ECS_INDEXED_COMPONENT_ID_BASE=2' CommonGameKitTests/ECSTestData.h
 
 #import <XCTest/XCTest.h>
+#import <threads.h>
 #import "ECS.h"
 #define ECS_PACKED_COMPONENT_ID_BASE 1
 #define ECS_INDEXED_COMPONENT_ID_BASE 2
@@ -499,7 +500,7 @@ ECSMutableState MutableState = ECS_MUTABLE_STATE_CREATE(4096, 4096, 4096, 4096,
     Context.mutations = &MutableState;
     
     Context.manager.map = CCArrayCreate(CC_ALIGNED_ALLOCATOR(ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), CC_ALIGN(sizeof(ECSComponentRefs) + LOCAL_STORAGE_SIZE, ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), 16);
-    Context.manager.available = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(size_t), 16);
+    Context.manager.available = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), 16);
 }
 
 -(void) setUp
@@ -1982,6 +1983,294 @@ ECSMutableState MutableState = ECS_MUTABLE_STATE_CREATE(4096, 4096, 4096, 4096,
     XCTAssertEqual(TestDestructionCount, 1, @"should destroy old data when being replaced");
     
     ECSEntityDestroy(&Context, &Entity, 1);
+    
+    for (size_t Loop = 0; Loop < GroupCount; Loop++)
+    {
+        if (State[Loop].plan) ECSExecutionPlanDestroy(State[Loop].plan);
+    }
+}
+
+static const ECSGroupDependency ConcurrentTickDependencies[] = {
+    { .group = -1, .priority = -1 }
+};
+
+static const ECSSystemRange ConcurrentTickSystemRange[] = {
+    { 0, 1 }
+};
+
+static const ECSSystemUpdate ConcurrentTickSystemUpdate[] = {
+    ECS_SYSTEM_UPDATE_PARALLEL_CHUNK(Sys10WriteJ, offsetof(ECSContext, packed[(COMP_J & ~ECSComponentStorageMask)].entities), 4)
+};
+
+static const ECSSystemAccess ConcurrentTickSystemAccess[] = {
+    { .read = { .ids = NULL, .count = 0 }, .write = { .ids = COMPONENT_ID_LIST_CompJ, .count = 1 }, .component = { .offsets = COMPONENT_OFFSET_LIST_CompJ } }
+};
+
+static const uint8_t ConcurrentTickSystemGraph[] = {
+    0
+};
+
+static const ECSGroup ConcurrentTickGroup = {
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0),
+    .dynamic = FALSE,
+    .priorities = {
+        .count = 1,
+        .deps = ConcurrentTickDependencies,
+        .systems = {
+            .range = ConcurrentTickSystemRange,
+            .graphs = ConcurrentTickSystemGraph,
+            .update = ConcurrentTickSystemUpdate,
+            .access = ConcurrentTickSystemAccess,
+        }
+    }
+};
+
+static ECSContext *TestContextCreate(void)
+{
+    ECSContext *TestContext = CCMalloc(CC_STD_ALLOCATOR, sizeof(ECSContext), NULL, CC_DEFAULT_ERROR_CALLBACK);
+    memset(TestContext, 0, sizeof(ECSContext));
+    
+    TestContext->mutations = &MutableState;
+    TestContext->manager.map = CCArrayCreate(CC_ALIGNED_ALLOCATOR(ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), CC_ALIGN(sizeof(ECSComponentRefs) + LOCAL_STORAGE_SIZE, ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), 16);
+    TestContext->manager.available = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), 16);
+    
+    ECSRegistryInit(TestContext, CC_BIG_INT_FAST_0);
+    ECSLinkMapInit(TestContext);
+    
+    return TestContext;
+}
+
+static void TestContextDestroy(ECSContext *TestContext)
+{
+    for (size_t Loop = 0, Count = CCArrayGetCount(TestContext->manager.map); Loop < Count; Loop++)
+    {
+        const ECSEntity Entity = Loop;
+        ECSEntityDestroy(TestContext, &Entity, 1);
+    }
+    
+    if (TestContext->archetypeInfo)
+    {
+        for (size_t Loop = 0, Count = CCArrayGetCount(TestContext->archetypeInfo); Loop < Count; Loop++)
+        {
+            const ECSArchetypeInfo *Info = CCArrayGetElementAtIndex(TestContext->archetypeInfo, Loop);
+            ECSArchetype *Archetype = (void*)TestContext + Info->offset;
+            
+            CCArrayDestroy(Archetype->entities);
+            for (size_t Loop2 = 0; Loop2 < Info->count; Loop2++) CCArrayDestroy(Archetype->components[Loop2]);
+        }
+        
+        CCArrayDestroy(TestContext->archetypeInfo);
+    }
+    
+    for (size_t Loop = 0; Loop < ECS_PACKED_COMPONENT_MAX; Loop++)
+    {
+        if (TestContext->packed[Loop].entities)
+        {
+            CCArrayDestroy(TestContext->packed[Loop].entities);
+            CCArrayDestroy(TestContext->packed[Loop].components[0]);
+        }
+    }
+    
+    for (size_t Loop = 0; Loop < ECS_INDEXED_COMPONENT_MAX; Loop++)
+    {
+        if (TestContext->indexed[Loop]) CCArrayDestroy(TestContext->indexed[Loop]);
+        
+#if ECS_INDEXED_SPARSE_SET
+        if (TestContext->indexedSets[Loop].entities) CCArrayDestroy(TestContext->indexedSets[Loop].entities);
+        if (TestContext->indexedSets[Loop].sparse) CCArrayDestroy(TestContext->indexedSets[Loop].sparse);
+#endif
+    }
+    
+    for (size_t Loop = 0; Loop < ECS_ARCHETYPE_COMPONENT_MAX; Loop++)
+    {
+        if (TestContext->shared[Loop]) CCDictionaryDestroy(TestContext->shared[Loop]);
+    }
+    
+    if (TestContext->registry.registeredEntities) CCDictionaryDestroy(TestContext->registry.registeredEntities);
+    if (TestContext->registry.uniqueEntityIDs) CCArrayDestroy(TestContext->registry.uniqueEntityIDs);
+    
+    if (TestContext->links.associations)
+    {
+        for (size_t Loop = 0, Count = CCArrayGetCount(TestContext->links.associations); Loop < Count; Loop++)
+        {
+            CCDictionary Assoc = *(CCDictionary*)CCArrayGetElementAtIndex(TestContext->links.associations, Loop);
+            if (Assoc) CCDictionaryDestroy(Assoc);
+        }
+        
+        CCArrayDestroy(TestContext->links.associations);
+    }
+    
+    CCArrayDestroy(TestContext->manager.map);
+    if (TestContext->manager.lookup) CCArrayDestroy(TestContext->manager.lookup);
+    CCArrayDestroy(TestContext->manager.available);
+    CCFree(TestContext);
+}
+
+#define CONCURRENT_TICK_COUNT 1000
+#define CONCURRENT_TICK_ENTITY_COUNT 256
+
+static int ConcurrentTick(ECSContext *TickContext)
+{
+    uint8_t ExecState[1] = { 0 };
+    ECSExecutionGroup State = { .executing = 0, .state = ExecState, .time = 0, .running = 0 };
+    
+    for (size_t Loop = 0; Loop < CONCURRENT_TICK_COUNT; Loop++) ECSTick(TickContext, &ConcurrentTickGroup, 1, &State, ConcurrentTickGroup.freq);
+    
+    ECSExecutionPlanDestroy(State.plan);
+    
+    return 0;
+}
+
+-(void) testConcurrentTicks
+{
+    ECSContext *Contexts[2];
+    ECSEntity Entities[2][CONCURRENT_TICK_ENTITY_COUNT];
+    
+    for (size_t Loop = 0; Loop < 2; Loop++)
+    {
+        Contexts[Loop] = TestContextCreate();
+        
+        ECSEntityCreate(Contexts[Loop], Entities[Loop], CONCURRENT_TICK_ENTITY_COUNT);
+        
+        for (size_t Loop2 = 0; Loop2 < CONCURRENT_TICK_ENTITY_COUNT; Loop2++)
+        {
+            ECSEntityAddComponent(Contexts[Loop], Entities[Loop][Loop2], &(CompJ){ { (int)Loop2 } }, COMP_J);
+        }
+    }
+    
+    thrd_t Threads[2];
+    for (size_t Loop = 0; Loop < 2; Loop++) XCTAssertEqual(thrd_create(&Threads[Loop], (thrd_start_t)ConcurrentTick, Contexts[Loop]), thrd_success, @"should create the thread");
+    for (size_t Loop = 0; Loop < 2; Loop++) thrd_join(Threads[Loop], NULL);
+    
+    for (size_t Loop = 0; Loop < 2; Loop++)
+    {
+        for (size_t Loop2 = 0; Loop2 < CONCURRENT_TICK_ENTITY_COUNT; Loop2++)
+        {
+            const CompJ *J = ECSEntityGetComponent(Contexts[Loop], Entities[Loop][Loop2], COMP_J);
+            XCTAssertEqual(J->v[0], (int)Loop2 + CONCURRENT_TICK_COUNT, @"should run the system exactly once per tick for every entity");
+        }
+        
+        TestContextDestroy(Contexts[Loop]);
+    }
+}
+
+static const ECSSystemUpdate OverflowTickSystemUpdate[] = {
+    ECS_SYSTEM_UPDATE_PARALLEL_CHUNK(Sys10WriteJ, offsetof(ECSContext, packed[(COMP_J & ~ECSComponentStorageMask)].entities), 1)
+};
+
+static const ECSGroup OverflowTickGroup = {
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0),
+    .dynamic = FALSE,
+    .priorities = {
+        .count = 1,
+        .deps = ConcurrentTickDependencies,
+        .systems = {
+            .range = ConcurrentTickSystemRange,
+            .graphs = ConcurrentTickSystemGraph,
+            .update = OverflowTickSystemUpdate,
+            .access = ConcurrentTickSystemAccess,
+        }
+    }
+};
+
+#define OVERFLOW_TICK_ENTITY_COUNT 20000
+
+-(void) testExecutorOverflow
+{
+    ECSContext *Overflow = TestContextCreate();
+    
+    ECSEntity *Entities = CCMalloc(CC_STD_ALLOCATOR, sizeof(ECSEntity) * OVERFLOW_TICK_ENTITY_COUNT, NULL, CC_DEFAULT_ERROR_CALLBACK);
+    ECSEntityCreate(Overflow, Entities, OVERFLOW_TICK_ENTITY_COUNT);
+    
+    for (size_t Loop = 0; Loop < OVERFLOW_TICK_ENTITY_COUNT; Loop++) ECSEntityAddComponent(Overflow, Entities[Loop], &(CompJ){ { (int)Loop } }, COMP_J);
+    
+    uint8_t ExecState[1] = { 0 };
+    ECSExecutionGroup State = { .executing = 0, .state = ExecState, .time = 0, .running = 0 };
+    
+    // A chunk size of 1 submits more executors than all of the worker deques can hold at once
+    ECSTick(Overflow, &OverflowTickGroup, 1, &State, OverflowTickGroup.freq);
+    ECSTick(Overflow, &OverflowTickGroup, 1, &State, OverflowTickGroup.freq);
+    
+    XCTAssertEqual(State.running, 0, @"should finish every executor");
+    
+    for (size_t Loop = 0; Loop < OVERFLOW_TICK_ENTITY_COUNT; Loop++)
+    {
+        const CompJ *J = ECSEntityGetComponent(Overflow, Entities[Loop], COMP_J);
+        
+        if (J->v[0] != (int)Loop + 2)
+        {
+            XCTFail(@"should run the system exactly once per tick for every entity (%zu)", Loop);
+            break;
+        }
+    }
+    
+    ECSExecutionPlanDestroy(State.plan);
+    CCFree(Entities);
+    TestContextDestroy(Overflow);
+}
+
+#define INJECTED_TASK_COUNT 4096
+
+typedef struct {
+    thrd_t caller;
+    _Atomic(int) visits[INJECTED_TASK_COUNT];
+    _Atomic(size_t) workerChunks;
+} InjectedTaskState;
+
+static void InjectedTask(InjectedTaskState *State, ECSRange Range)
+{
+    if (!thrd_equal(thrd_current(), State->caller)) atomic_fetch_add_explicit(&State->workerChunks, 1, memory_order_relaxed);
+    
+    else if (!Range.index)
+    {
+        // Hold the calling thread on the first chunk, so the remaining chunks can only finish if the workers take them
+        for (const double Start = CCTimestamp(); (!atomic_load_explicit(&State->workerChunks, memory_order_relaxed)) && ((CCTimestamp() - Start) < 5.0); ) thrd_yield();
+    }
+    
+    for (size_t Loop = 0; Loop < Range.count; Loop++) atomic_fetch_add_explicit(&State->visits[Range.index + Loop], 1, memory_order_relaxed);
+}
+
+-(void) testOffWorkerTasks
+{
+    InjectedTaskState *State = CCMalloc(CC_STD_ALLOCATOR, sizeof(InjectedTaskState), NULL, CC_DEFAULT_ERROR_CALLBACK);
+    memset(State, 0, sizeof(InjectedTaskState));
+    State->caller = thrd_current();
+    
+    ECSParallelFor((ECSTaskCallback)InjectedTask, State, INJECTED_TASK_COUNT, 16);
+    
+    XCTAssertNotEqual(atomic_load(&State->workerChunks), 0, @"should hand the chunks to the workers");
+    
+    for (size_t Loop = 0; Loop < INJECTED_TASK_COUNT; Loop++)
+    {
+        if (atomic_load(&State->visits[Loop]) != 1)
+        {
+            XCTFail(@"should visit every index exactly once (%zu)", Loop);
+            break;
+        }
+    }
+    
+    memset(State, 0, sizeof(InjectedTaskState));
+    State->caller = thrd_current();
+    
+    ECSTaskGroup Group = ECS_TASK_GROUP_INIT;
+    
+    for (size_t Loop = 0; Loop < INJECTED_TASK_COUNT; Loop += 64) ECSTaskGroupRun(&Group, (ECSTaskCallback)InjectedTask, State, (ECSRange){ .index = Loop, .count = 64 });
+    
+    ECSTaskGroupWait(&Group);
+    
+    XCTAssertEqual(atomic_load(&Group.pending), 0, @"should finish every task in the group");
+    XCTAssertNotEqual(atomic_load(&State->workerChunks), 0, @"should hand the tasks to the workers");
+    
+    for (size_t Loop = 0; Loop < INJECTED_TASK_COUNT; Loop++)
+    {
+        if (atomic_load(&State->visits[Loop]) != 1)
+        {
+            XCTFail(@"should visit every index exactly once (%zu)", Loop);
+            break;
+        }
+    }
+    
+    CCFree(State);
 }
 
 -(void) testTime
@@ -6539,4 +6828,1583 @@ CLEAR_CALLBACK_STATE;
     ECSEntityDestroy(&Context, Entities, 1);
 }
 
-@end
+static size_t SnapshotSerializeCount = 0;
+static void SnapshotSerializeH(ECSContext *Context, void *Components, size_t Count, ECSComponentID ID)
+{
+    SnapshotSerializeCount += Count;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++) ((CompH*)Components)[Loop].v[7] = -((CompH*)Components)[Loop].v[7];
+}
+
+static size_t SnapshotFixupCount = 0;
+static void SnapshotFixupH(ECSContext *Context, void *Components, size_t Count, ECSComponentID ID)
+{
+    SnapshotFixupCount += Count;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++) ((CompH*)Components)[Loop].v[7] = -((CompH*)Components)[Loop].v[7];
+}
+
+static _Bool SnapshotArrayWriter(const void *Data, size_t Size, void *UserData)
+{
+    CCArrayAppendElements(UserData, Data, Size);
+    
+    return TRUE;
+}
+
+-(void) testSnapshot
+{
+    ECSSnapshotComponentHooks ArchetypeHooks[ECS_ARCHETYPE_COMPONENT_MAX] = {0}, PackedHooks[ECS_PACKED_COMPONENT_MAX] = {0}, IndexedHooks[ECS_INDEXED_COMPONENT_MAX] = {0}, LocalHooks[ECS_LOCAL_COMPONENT_MAX] = {0};
+    const ECSSnapshotComponentHooks HooksH = { .serialize = SnapshotSerializeH, .fixup = SnapshotFixupH };
+    
+    ArchetypeHooks[ARCH_H & ~ECSComponentStorageMask] = HooksH;
+    PackedHooks[PACKED_H & ~ECSComponentStorageMask] = HooksH;
+    IndexedHooks[INDEXED_H & ~ECSComponentStorageMask] = HooksH;
+    LocalHooks[ECSLocalComponentIndex(LOCAL_H)] = HooksH;
+    
+    ECSArchetypeComponentSnapshotHooks = ArchetypeHooks;
+    ECSPackedComponentSnapshotHooks = PackedHooks;
+    ECSIndexedComponentSnapshotHooks = IndexedHooks;
+    ECSLocalComponentSnapshotHooks = LocalHooks;
+    
+    const ECSLink *Links[] = { &TestOneToOne, &TestOneToMany };
+    ECSSnapshotLinks = Links;
+    ECSSnapshotLinkCount = sizeof(Links) / sizeof(*Links);
+    
+    SnapshotSerializeCount = 0;
+    SnapshotFixupCount = 0;
+    
+    ECSContext *Source = TestContextCreate();
+    
+    ECSEntity Entities[5];
+    ECSEntityCreate(Source, Entities, 5);
+    
+    ECSEntityAddComponents(Source, Entities[0], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 1 } } },
+        { COMP_B, &(CompB){ { 2, 3 } } }
+    }, 2);
+    
+    ECSEntityAddComponents(Source, Entities[1], (ECSTypedComponent[4]){
+        { COMP_A, &(CompA){ { 4 } } },
+        { ARCH_H, &(ArchH){ { 1, 2, 3, 4, 5, 6, 7, 8 } } },
+        { PACKED_H, &(PackedH){ { 11, 12, 13, 14, 15, 16, 17, 18 } } },
+        { LOCAL_H, &(LocalH){ { 21, 22, 23, 24, 25, 26, 27, 28 } } }
+    }, 4);
+    
+    ECSEntityAddComponents(Source, Entities[3], (ECSTypedComponent[4]){
+        { COMP_F, &(CompF){ { 31, 32, 33, 34, 35, 36 } } },
+        { COMP_H, &(CompH){ { 41, 42, 43, 44, 45, 46, 47, 48 } } },
+        { INDEXED_H, &(IndexedH){ { 51, 52, 53, 54, 55, 56, 57, 58 } } },
+        { LOCAL_H, &(LocalH){ { 61, 62, 63, 64, 65, 66, 67, 68 } } }
+    }, 4);
+    
+    ECSEntityAddComponents(Source, Entities[4], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 7 } } },
+        { COMP_B, &(CompB){ { 8, 9 } } }
+    }, 2);
+    
+    ECSEntityDestroy(Source, &Entities[2], 1);
+    
+    ECSLinkAdd(Source, Entities[0], NULL, &TestOneToOne, Entities[1], NULL);
+    ECSLinkAdd(Source, Entities[3], NULL, &TestOneToMany, Entities[0], NULL);
+    ECSLinkAdd(Source, Entities[3], NULL, &TestOneToMany, Entities[4], NULL);
+    
+    ECSRegistryRegister(Source, Entities[1]);
+    ECSRegistryRegister(Source, Entities[4]);
+    
+    CCArray Snapshot = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(uint8_t), 4096);
+    
+    XCTAssertTrue(ECSSnapshotWrite(Source, SnapshotArrayWriter, Snapshot), @"Should write the snapshot");
+    XCTAssertEqual(SnapshotSerializeCount, 5, @"Should serialize every component with hooks");
+    
+    ECSContext *Restored = TestContextCreate();
+    
+    XCTAssertTrue(ECSSnapshotRestore(Restored, CCArrayGetData(Snapshot), CCArrayGetCount(Snapshot)), @"Should restore the snapshot");
+    XCTAssertEqual(SnapshotFixupCount, 5, @"Should fixup every component with hooks");
+    
+    XCTAssertTrue(ECSEntityIsAlive(Restored, Entities[0]), @"Should restore the entity");
+    XCTAssertTrue(ECSEntityIsAlive(Restored, Entities[1]), @"Should restore the entity");
+    XCTAssertFalse(ECSEntityIsAlive(Restored, Entities[2]), @"Should restore the destroyed entity");
+    XCTAssertTrue(ECSEntityIsAlive(Restored, Entities[3]), @"Should restore the entity");
+    XCTAssertTrue(ECSEntityIsAlive(Restored, Entities[4]), @"Should restore the entity");
+    
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Restored, Entities[0], COMP_A))->v[0], 1, @"Should restore the archetype component");
+    XCTAssertEqual(((CompB*)ECSEntityGetComponent(Restored, Entities[0], COMP_B))->v[1], 3, @"Should restore the archetype component");
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Restored, Entities[1], COMP_A))->v[0], 4, @"Should restore the archetype component");
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Restored, Entities[4], COMP_A))->v[0], 7, @"Should restore the archetype component");
+    XCTAssertEqual(((CompB*)ECSEntityGetComponent(Restored, Entities[4], COMP_B))->v[1], 9, @"Should restore the archetype component");
+    XCTAssertFalse(ECSEntityHasComponent(Restored, Entities[0], ARCH_H), @"Should not add components");
+    
+    XCTAssertEqual(((ArchH*)ECSEntityGetComponent(Restored, Entities[1], ARCH_H))->v[7], 8, @"Should restore the archetype component through its hooks");
+    XCTAssertEqual(((PackedH*)ECSEntityGetComponent(Restored, Entities[1], PACKED_H))->v[7], 18, @"Should restore the packed component through its hooks");
+    XCTAssertEqual(((LocalH*)ECSEntityGetComponent(Restored, Entities[1], LOCAL_H))->v[7], 28, @"Should restore the local component through its hooks");
+    
+    XCTAssertEqual(((CompF*)ECSEntityGetComponent(Restored, Entities[3], COMP_F))->v[5], 36, @"Should restore the packed component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Restored, Entities[3], COMP_H))->v[7], 48, @"Should restore the indexed component");
+    XCTAssertEqual(((IndexedH*)ECSEntityGetComponent(Restored, Entities[3], INDEXED_H))->v[7], 58, @"Should restore the indexed component through its hooks");
+    XCTAssertEqual(((LocalH*)ECSEntityGetComponent(Restored, Entities[3], LOCAL_H))->v[7], 68, @"Should restore the local component through its hooks");
+    
+    XCTAssertTrue(ECSLinked(Restored, Entities[0], &TestOneToOne, Entities[1]), @"Should restore the link");
+    XCTAssertTrue(ECSLinked(Restored, Entities[1], ECS_LINK_INVERT(&TestOneToOne), Entities[0]), @"Should restore the inverse link");
+    
+    size_t LinkCount;
+    const ECSEntity *Linked = ECSLinkGet(Restored, Entities[3], &TestOneToMany, &LinkCount);
+    
+    XCTAssertEqual(LinkCount, 2, @"Should restore all the links");
+    XCTAssertTrue(((Linked[0] == Entities[0]) && (Linked[1] == Entities[4])) || ((Linked[0] == Entities[4]) && (Linked[1] == Entities[0])), @"Should restore all the links");
+    XCTAssertTrue(ECSLinked(Restored, Entities[4], ECS_LINK_INVERT(&TestOneToMany), Entities[3]), @"Should restore the inverse link");
+    
+    XCTAssertEqual(ECSRegistryLookup(Restored, ECSRegistryGetID(Source, Entities[1])), Entities[1], @"Should restore the registered entity");
+    XCTAssertEqual(ECSRegistryLookup(Restored, ECSRegistryGetID(Source, Entities[4])), Entities[4], @"Should restore the registered entity");
+    XCTAssertEqual(ECSRegistryGetID(Restored, Entities[0]), NULL, @"Should not register the entity");
+    
+    ECSEntity Entity;
+    ECSEntityCreate(Restored, &Entity, 1);
+    
+    XCTAssertEqual(Entity, Entities[2], @"Should reuse the restored free entity");
+    
+    TestContextDestroy(Restored);
+    
+    
+    Restored = TestContextCreate();
+    
+    XCTAssertFalse(ECSSnapshotRestore(Restored, CCArrayGetData(Snapshot), CCArrayGetCount(Snapshot) - 1), @"Should not restore a truncated snapshot");
+    
+    TestContextDestroy(Restored);
+    
+    
+    Restored = TestContextCreate();
+    
+    ECSIndexedComponentSizes = DuplicateIndexedComponentSizes;
+    
+    XCTAssertFalse(ECSSnapshotRestore(Restored, CCArrayGetData(Snapshot), CCArrayGetCount(Snapshot)), @"Should not restore a snapshot with a different component layout");
+    
+    ECSIndexedComponentSizes = IndexedComponentSizes;
+    
+    TestContextDestroy(Restored);
+    
+    CCArrayDestroy(Snapshot);
+    TestContextDestroy(Source);
+    
+    ECSArchetypeComponentSnapshotHooks = NULL;
+    ECSPackedComponentSnapshotHooks = NULL;
+    ECSIndexedComponentSnapshotHooks = NULL;
+    ECSLocalComponentSnapshotHooks = NULL;
+    ECSSnapshotLinks = NULL;
+    ECSSnapshotLinkCount = 0;
+}
+
+-(void) testEntityCompact
+{
+    ECSContext *Compact = TestContextCreate();
+    
+    ECSEntity Entities[10];
+    ECSEntityCreate(Compact, Entities, 10);
+    
+    for (size_t Loop = 0; Loop < 10; Loop++) XCTAssertEqual(Entities[Loop], Loop, @"Should create sequential entities");
+    
+    ECSEntityAddComponent(Compact, Entities[0], &(CompA){ { 100 } }, COMP_A);
+    ECSEntityAddComponent(Compact, Entities[6], &(CompA){ { 106 } }, COMP_A);
+    ECSEntityAddComponents(Compact, Entities[7], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 107 } } },
+        { COMP_B, &(CompB){ { 107, 1 } } }
+    }, 2);
+    ECSEntityAddComponents(Compact, Entities[8], (ECSTypedComponent[2]){
+        { COMP_F, &(CompF){ { 108, 1, 2, 3, 4, 5 } } },
+        { COMP_H, &(CompH){ { 108, 1, 2, 3, 4, 5, 6, 7 } } }
+    }, 2);
+    ECSEntityAddComponents(Compact, Entities[9], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 109 } } },
+        { COMP_B, &(CompB){ { 109, 1 } } }
+    }, 2);
+    
+    ECSLinkAdd(Compact, Entities[9], NULL, &TestOneToOne, Entities[7], NULL);
+    ECSLinkAdd(Compact, Entities[8], NULL, &TestOneToMany, Entities[0], NULL);
+    ECSLinkAdd(Compact, Entities[8], NULL, &TestOneToMany, Entities[9], NULL);
+    ECSLinkAdd(Compact, Entities[9], NULL, &TestManyToMany, Entities[9], NULL);
+    
+    const ECSRegistryID ID0 = ECSRegistryRegister(Compact, Entities[0]);
+    const ECSRegistryID ID8 = ECSRegistryRegister(Compact, Entities[8]);
+    const ECSRegistryID ID9 = ECSRegistryRegister(Compact, Entities[9]);
+    
+    ECSEntityDestroy(Compact, (ECSEntity[4]){ Entities[1], Entities[2], Entities[3], Entities[5] }, 4);
+    
+    CCArray(ECSEntityRemap) Remap = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntityRemap), 4);
+    
+    XCTAssertEqual(ECSEntityCompact(Compact, 2, Remap), 2, @"Should only move the maximum number of entities");
+    XCTAssertEqual(CCArrayGetCount(Remap), 2, @"Should record the moved entities");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 0))->from, 9, @"Should move the highest entity");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 0))->to, 1, @"Should move to the lowest free entity");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 1))->from, 8, @"Should move the highest entity");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 1))->to, 2, @"Should move to the lowest free entity");
+    XCTAssertEqual(CCArrayGetCount(Compact->manager.map), 8, @"Should shrink the entity map");
+    XCTAssertEqual(CCArrayGetCount(Compact->manager.lookup), 8, @"Should shrink the entity lookups");
+    XCTAssertEqual(CCArrayGetCount(Compact->manager.available), 2, @"Should remove the used free entities");
+    
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Compact, 1, COMP_A))->v[0], 109, @"Should move the archetype components");
+    XCTAssertEqual(((CompB*)ECSEntityGetComponent(Compact, 1, COMP_B))->v[0], 109, @"Should move the archetype components");
+    XCTAssertEqual(((CompF*)ECSEntityGetComponent(Compact, 2, COMP_F))->v[0], 108, @"Should move the packed components");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Compact, 2, COMP_H))->v[0], 108, @"Should move the indexed components");
+    XCTAssertTrue(ECSLinked(Compact, 1, &TestOneToOne, 7), @"Should remap the link");
+    XCTAssertTrue(ECSLinked(Compact, 1, &TestManyToMany, 1), @"Should remap the self link");
+    
+    CCArrayRemoveAllElements(Remap);
+    
+    XCTAssertEqual(ECSEntityCompact(Compact, SIZE_MAX, Remap), 2, @"Should move the remaining entities");
+    XCTAssertEqual(CCArrayGetCount(Remap), 2, @"Should record the moved entities");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 0))->from, 7, @"Should move the highest entity");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 0))->to, 3, @"Should move to the lowest free entity");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 1))->from, 6, @"Should move the highest entity");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 1))->to, 5, @"Should move to the lowest free entity");
+    XCTAssertEqual(CCArrayGetCount(Compact->manager.map), 6, @"Should shrink the entity map");
+    XCTAssertEqual(CCArrayGetCount(Compact->manager.lookup), 6, @"Should shrink the entity lookups");
+    XCTAssertEqual(CCArrayGetCount(Compact->manager.available), 0, @"Should use all the free entities");
+    
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Compact, 0, COMP_A))->v[0], 100, @"Should not move the entity");
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Compact, 1, COMP_A))->v[0], 109, @"Should keep the moved entity");
+    XCTAssertEqual(((CompF*)ECSEntityGetComponent(Compact, 2, COMP_F))->v[0], 108, @"Should keep the moved entity");
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Compact, 3, COMP_A))->v[0], 107, @"Should move the archetype components");
+    XCTAssertEqual(((CompB*)ECSEntityGetComponent(Compact, 3, COMP_B))->v[0], 107, @"Should move the archetype components");
+    XCTAssertTrue(ECSEntityIsAlive(Compact, 4), @"Should not move the entity");
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Compact, 5, COMP_A))->v[0], 106, @"Should move the archetype components");
+    
+    XCTAssertTrue(ECSLinked(Compact, 1, &TestOneToOne, 3), @"Should remap both sides of the one to one link");
+    XCTAssertTrue(ECSLinked(Compact, 3, ECS_LINK_INVERT(&TestOneToOne), 1), @"Should remap both sides of the one to one link");
+    XCTAssertTrue(ECSLinked(Compact, 1, &TestManyToMany, 1), @"Should remap the self link");
+    
+    size_t LinkCount;
+    const ECSEntity *Linked = ECSLinkGet(Compact, 2, &TestOneToMany, &LinkCount);
+    
+    XCTAssertEqual(LinkCount, 2, @"Should remap the one to many link");
+    XCTAssertTrue(((Linked[0] == 0) && (Linked[1] == 1)) || ((Linked[0] == 1) && (Linked[1] == 0)), @"Should remap the one to many link");
+    XCTAssertTrue(ECSLinked(Compact, 1, ECS_LINK_INVERT(&TestOneToMany), 2), @"Should remap the inverse of the one to many link");
+    XCTAssertTrue(ECSLinked(Compact, 0, ECS_LINK_INVERT(&TestOneToMany), 2), @"Should remap the inverse of the one to many link");
+    
+    XCTAssertEqual(ECSRegistryLookup(Compact, ID0), 0, @"Should not remap the registered entity");
+    XCTAssertEqual(ECSRegistryLookup(Compact, ID8), 2, @"Should remap the registered entity");
+    XCTAssertEqual(ECSRegistryLookup(Compact, ID9), 1, @"Should remap the registered entity");
+    XCTAssertTrue(CCBigIntFastCompareEqual(ECSRegistryGetID(Compact, 2), ID8), @"Should remap the registered entity");
+    XCTAssertEqual(ECSRegistryGetID(Compact, 3), NULL, @"Should not register the moved entity");
+    
+    XCTAssertEqual(ECSEntityCompact(Compact, SIZE_MAX, Remap), 0, @"Should already be compacted");
+    
+    ECSEntity Entity;
+    ECSEntityCreate(Compact, &Entity, 1);
+    
+    XCTAssertEqual(Entity, 6, @"Should create entities after the compacted entities");
+    
+    CCArrayDestroy(Remap);
+    TestContextDestroy(Compact);
+}
+
+-(void) testArchetypeBulkMigration
+{
+    ECSContext *Context = TestContextCreate();
+    
+    ECSEntity Entities[12];
+    ECSEntityCreate(Context, Entities, 12);
+    
+    for (size_t Loop = 0; Loop < 12; Loop++)
+    {
+        ECSEntityAddComponent(Context, Entities[Loop], &(CompA){ { 100 + (int)Loop } }, COMP_A);
+        
+        if ((Loop % 3) == 1) ECSEntityAddComponent(Context, Entities[Loop], &(CompB){ { 200 + (int)Loop, 1 } }, COMP_B);
+        else if ((Loop % 3) == 2) ECSEntityAddComponent(Context, Entities[Loop], &(ArchH){ { 300 + (int)Loop, 1, 2, 3, 4, 5, 6, 7 } }, ARCH_H);
+    }
+    
+    const int DestructionCount = TestDestructionCount;
+    
+    const ECSEntity Added[6] = { Entities[11], Entities[0], Entities[4], Entities[8], Entities[7], Entities[2] };
+    CompC AddedC[6];
+    ArchH AddedH[6];
+    
+    for (size_t Loop = 0; Loop < 6; Loop++)
+    {
+        AddedC[Loop] = (CompC){ { 400 + (int)Added[Loop], 1, 2 } };
+        AddedH[Loop] = (ArchH){ { 500 + (int)Added[Loop], 1, 2, 3, 4, 5, 6, 7 } };
+    }
+    
+    ECSArchetypeAddComponents(Context, Added, 6, (ECSTypedComponent[2]){
+        { ARCH_H, AddedH },
+        { COMP_C, AddedC }
+    }, 2);
+    
+    XCTAssertEqual(TestDestructionCount, DestructionCount + 3, @"Should destroy the replaced components");
+    
+    for (size_t Loop = 0; Loop < 12; Loop++)
+    {
+        const ECSEntity Entity = Entities[Loop];
+        const _Bool WasAdded = (Loop == 0) || (Loop == 2) || (Loop == 4) || (Loop == 7) || (Loop == 8) || (Loop == 11);
+        
+        XCTAssertEqual(((CompA*)ECSEntityGetComponent(Context, Entity, COMP_A))->v[0], 100 + (int)Loop, @"Should keep the existing components");
+        XCTAssertEqual(ECSEntityHasComponent(Context, Entity, COMP_B), (Loop % 3) == 1, @"Should keep the existing components");
+        if ((Loop % 3) == 1) XCTAssertEqual(((CompB*)ECSEntityGetComponent(Context, Entity, COMP_B))->v[0], 200 + (int)Loop, @"Should keep the existing components");
+        
+        XCTAssertEqual(ECSEntityHasComponent(Context, Entity, COMP_C), WasAdded, @"Should only add the components to the given entities");
+        XCTAssertEqual(ECSEntityHasComponent(Context, Entity, ARCH_H), WasAdded || ((Loop % 3) == 2), @"Should only add the components to the given entities");
+        
+        if (WasAdded)
+        {
+            XCTAssertEqual(((CompC*)ECSEntityGetComponent(Context, Entity, COMP_C))->v[0], 400 + (int)Entity, @"Should add the entity's component data");
+            XCTAssertEqual(((ArchH*)ECSEntityGetComponent(Context, Entity, ARCH_H))->v[0], 500 + (int)Entity, @"Should add or replace the entity's component data");
+        }
+        
+        else if ((Loop % 3) == 2) XCTAssertEqual(((ArchH*)ECSEntityGetComponent(Context, Entity, ARCH_H))->v[0], 300 + (int)Loop, @"Should keep the existing components");
+        
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+        XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Lookup->archetype->entities, Lookup->index), Entity, @"Should keep the archetype rows consistent");
+    }
+    
+    const ECSEntity Removed[5] = { Entities[8], Entities[1], Entities[5], Entities[0], Entities[10] };
+    
+    ECSArchetypeRemoveComponents(Context, Removed, 5, (ECSComponentID[2]){ COMP_B, ARCH_H }, 2);
+    
+    XCTAssertEqual(TestDestructionCount, DestructionCount + 6, @"Should destroy the removed components with destructors");
+    
+    for (size_t Loop = 0; Loop < 12; Loop++)
+    {
+        const ECSEntity Entity = Entities[Loop];
+        const _Bool WasAdded = (Loop == 0) || (Loop == 2) || (Loop == 4) || (Loop == 7) || (Loop == 8) || (Loop == 11);
+        const _Bool WasRemoved = (Loop == 0) || (Loop == 1) || (Loop == 5) || (Loop == 8) || (Loop == 10);
+        
+        XCTAssertEqual(((CompA*)ECSEntityGetComponent(Context, Entity, COMP_A))->v[0], 100 + (int)Loop, @"Should keep the remaining components");
+        XCTAssertEqual(ECSEntityHasComponent(Context, Entity, COMP_B), ((Loop % 3) == 1) && !WasRemoved, @"Should only remove the components from the given entities");
+        XCTAssertEqual(ECSEntityHasComponent(Context, Entity, ARCH_H), (WasAdded || ((Loop % 3) == 2)) && !WasRemoved, @"Should only remove the components from the given entities");
+        XCTAssertEqual(ECSEntityHasComponent(Context, Entity, COMP_C), WasAdded, @"Should keep the remaining components");
+        
+        if (WasAdded) XCTAssertEqual(((CompC*)ECSEntityGetComponent(Context, Entity, COMP_C))->v[0], 400 + (int)Entity, @"Should keep the remaining components");
+        if (ECSEntityHasComponent(Context, Entity, COMP_B)) XCTAssertEqual(((CompB*)ECSEntityGetComponent(Context, Entity, COMP_B))->v[0], 200 + (int)Loop, @"Should keep the remaining components");
+        if (ECSEntityHasComponent(Context, Entity, ARCH_H)) XCTAssertEqual(((ArchH*)ECSEntityGetComponent(Context, Entity, ARCH_H))->v[0], (WasAdded ? 500 + (int)Entity : 300 + (int)Loop), @"Should keep the remaining components");
+        
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+        XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Lookup->archetype->entities, Lookup->index), Entity, @"Should keep the archetype rows consistent");
+    }
+    
+    ECSArchetypeRemoveComponents(Context, Removed, 5, (ECSComponentID[1]){ COMP_D }, 1);
+    
+    XCTAssertEqual(TestDestructionCount, DestructionCount + 6, @"Should not change entities without the components");
+    
+    const ECSEntity Replaced[3] = { Entities[11], Entities[4], Entities[2] };
+    ECSArchetype *ReplacedArchetypes[3];
+    size_t ReplacedIndexes[3];
+    
+    for (size_t Loop = 0; Loop < 3; Loop++)
+    {
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Replaced[Loop]);
+        ReplacedArchetypes[Loop] = Lookup->archetype;
+        ReplacedIndexes[Loop] = Lookup->index;
+        
+        AddedH[Loop] = (ArchH){ { 600 + (int)Replaced[Loop], 1, 2, 3, 4, 5, 6, 7 } };
+    }
+    
+    ECSArchetypeAddComponents(Context, Replaced, 3, (ECSTypedComponent[1]){ { ARCH_H, AddedH } }, 1);
+    
+    XCTAssertEqual(TestDestructionCount, DestructionCount + 9, @"Should destroy the replaced components");
+    
+    for (size_t Loop = 0; Loop < 3; Loop++)
+    {
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Replaced[Loop]);
+        
+        XCTAssertEqual(Lookup->archetype, ReplacedArchetypes[Loop], @"Should replace the components without migrating the entity");
+        XCTAssertEqual(Lookup->index, ReplacedIndexes[Loop], @"Should replace the components without migrating the entity");
+        XCTAssertEqual(((ArchH*)ECSEntityGetComponent(Context, Replaced[Loop], ARCH_H))->v[0], 600 + (int)Replaced[Loop], @"Should replace the entity's component data");
+        XCTAssertEqual(((CompC*)ECSEntityGetComponent(Context, Replaced[Loop], COMP_C))->v[0], 400 + (int)Replaced[Loop], @"Should keep the other components");
+    }
+    
+    TestContextDestroy(Context);
+}
+
+// COMP_E's archetype index is reused as a shared component, by swapping in tables that store a handle for it
+#define SHARED_E (ECSComponentStorageTypeArchetype | ECSComponentStorageModifierShared | ECSComponentStorageModifierDestructor | (COMP_E & ~ECSComponentStorageMask))
+
+typedef struct {
+    int v[2];
+} SharedE;
+
+static size_t SharedDestructionCount = 0;
+
+static void SharedValueDestructor(SharedE *Data, ECSComponentID ID)
+{
+    SharedDestructionCount++;
+}
+
+-(void) testSharedComponents
+{
+    const size_t *PrevSizes = ECSArchetypeComponentSizes;
+    const ECSComponentDestructor *PrevDestructors = ECSArchetypeComponentDestructors;
+    const ECSComponentID *PrevIDs = ECSComponentIDs;
+    const size_t *PrevSharedSizes = ECSSharedArchetypeComponentSizes;
+    const ECSComponentDestructor *PrevSharedDestructors = ECSSharedArchetypeComponentDestructors;
+    
+    size_t Sizes[ECS_ARCHETYPE_COMPONENT_MAX], SharedSizes[ECS_ARCHETYPE_COMPONENT_MAX] = { 0 };
+    ECSComponentDestructor Destructors[ECS_ARCHETYPE_COMPONENT_MAX], SharedDestructors[ECS_ARCHETYPE_COMPONENT_MAX] = { NULL };
+    ECSComponentID IDs[ECS_COMPONENT_MAX];
+    
+    memcpy(Sizes, ArchetypeComponentSizes, sizeof(Sizes));
+    memcpy(Destructors, ArchetypeComponentDestructors, sizeof(Destructors));
+    memcpy(IDs, ComponentIDs, sizeof(IDs));
+    
+    const size_t Index = SHARED_E & ~ECSComponentStorageMask;
+    Sizes[Index] = sizeof(ECSSharedComponentHandle);
+    Destructors[Index] = ECSSharedDestructor;
+    IDs[ECS_COMPONENT_BASE_INDEX(COMP_E)] = SHARED_E;
+    SharedSizes[Index] = sizeof(SharedE);
+    SharedDestructors[Index] = (ECSComponentDestructor)SharedValueDestructor;
+    
+    ECSArchetypeComponentSizes = Sizes;
+    ECSArchetypeComponentDestructors = Destructors;
+    ECSComponentIDs = IDs;
+    ECSSharedArchetypeComponentSizes = SharedSizes;
+    ECSSharedArchetypeComponentDestructors = SharedDestructors;
+    
+    SharedDestructionCount = 0;
+    
+    ECSContext *Shared = TestContextCreate();
+    
+    ECSSharedComponentHandle ValueA = ECSSharedComponentIntern(Shared, &(SharedE){ { 1, 2 } }, SHARED_E);
+    ECSSharedComponentHandle ValueB = ECSSharedComponentIntern(Shared, &(SharedE){ { 3, 4 } }, SHARED_E);
+    
+    XCTAssertNotEqual(ValueA, ValueB, @"Should intern different values separately");
+    XCTAssertEqual(ECSSharedComponentIntern(Shared, &(SharedE){ { 1, 2 } }, SHARED_E), ValueA, @"Should deduplicate identical values");
+    XCTAssertEqual(ValueA->refs, 2, @"Should retain the existing value");
+    XCTAssertEqual(((SharedE*)ECSSharedComponentGetData(ValueA))->v[1], 2, @"Should copy the value");
+    
+    ECSSharedComponentRelease(ValueA);
+    
+    XCTAssertEqual(ValueA->refs, 1, @"Should release the reference");
+    XCTAssertEqual(SharedDestructionCount, 0, @"Should not destroy a referenced value");
+    
+    ECSEntity Entities[8];
+    ECSEntityCreate(Shared, Entities, 8);
+    
+    for (size_t Loop = 0; Loop < 8; Loop++)
+    {
+        ECSEntityAddComponent(Shared, Entities[Loop], &(CompA){ { (int)Loop } }, COMP_A);
+        ECSEntityAddComponent(Shared, Entities[Loop], &(ECSSharedComponentHandle){ ECSSharedComponentRetain(Loop % 2 ? ValueB : ValueA) }, SHARED_E);
+    }
+    
+    XCTAssertEqual(ValueA->refs, 5, @"Should pass the retained reference to each entity");
+    XCTAssertEqual(ValueB->refs, 5, @"Should pass the retained reference to each entity");
+    
+    const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Shared->manager.lookup, Entities[0]);
+    const ECSArchetype *Archetype = Lookup->archetype;
+    const size_t Column = ECSArchetypeComponentMaskIndex(&Archetype->mask, Index);
+    
+    ECSRange Remaining = { .index = 0, .count = SIZE_MAX };
+    XCTAssertEqual(ECSArchetypeNextSharedRange(Archetype, Column, &Remaining).count, 1, @"Should not group the values until requested");
+    
+    ECSSharedComponentGroup(Shared, SHARED_E);
+    
+    for (size_t Loop = 0; Loop < 8; Loop++)
+    {
+        const ECSEntityLookup *EntityLookup = CCArrayGetElementAtIndex(Shared->manager.lookup, Entities[Loop]);
+        
+        XCTAssertEqual(EntityLookup->archetype, Archetype, @"Should keep the entity in the same archetype");
+        XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Archetype->entities, EntityLookup->index), Entities[Loop], @"Should update the entity's row");
+        XCTAssertEqual(((CompA*)ECSEntityGetComponent(Shared, Entities[Loop], COMP_A))->v[0], (int)Loop, @"Should move the other components with the row");
+        XCTAssertEqual(*(ECSSharedComponentHandle*)ECSEntityGetComponent(Shared, Entities[Loop], SHARED_E), (Loop % 2 ? ValueB : ValueA), @"Should move the shared component with the row");
+    }
+    
+    Remaining = (ECSRange){ .index = 0, .count = SIZE_MAX };
+    
+    size_t RangeCount = 0, EntityCount = 0;
+    for (ECSRange Range; (Range = ECSArchetypeNextSharedRange(Archetype, Column, &Remaining)).count; RangeCount++)
+    {
+        const ECSSharedComponentHandle *Handles = CCArrayGetData(Archetype->components[Column]);
+        
+        XCTAssertEqual(Range.index, EntityCount, @"Should return consecutive ranges");
+        XCTAssertEqual(Range.count, 4, @"Should return all the entities sharing the value");
+        
+        for (size_t Loop = 0; Loop < Range.count; Loop++) XCTAssertEqual(Handles[Range.index + Loop], Handles[Range.index], @"Should only contain entities sharing the value");
+        
+        EntityCount += Range.count;
+    }
+    
+    XCTAssertEqual(RangeCount, 2, @"Should return one range per value");
+    XCTAssertEqual(EntityCount, 8, @"Should cover every entity");
+    
+    Remaining = (ECSRange){ .index = 1, .count = 2 };
+    const ECSRange Partial = ECSArchetypeNextSharedRange(Archetype, Column, &Remaining);
+    
+    XCTAssertEqual(Partial.index, 1, @"Should start from the range index");
+    XCTAssertEqual(Partial.count, 2, @"Should be limited to the range count");
+    XCTAssertEqual(Remaining.count, 0, @"Should consume the range");
+    
+    ECSEntityRemoveComponent(Shared, Entities[0], SHARED_E);
+    
+    XCTAssertEqual(ValueA->refs, 4, @"Should release the reference when the component is removed");
+    
+    ECSEntityDestroy(Shared, &Entities[2], 1);
+    
+    XCTAssertEqual(ValueA->refs, 3, @"Should release the reference when the entity is destroyed");
+    
+    ECSEntityDestroy(Shared, (ECSEntity[2]){ Entities[4], Entities[6] }, 2);
+    
+    XCTAssertEqual(ValueA->refs, 1, @"Should release the reference when the entity is destroyed");
+    XCTAssertEqual(SharedDestructionCount, 0, @"Should not destroy a referenced value");
+    
+    ECSSharedComponentRelease(ValueA);
+    
+    XCTAssertEqual(SharedDestructionCount, 1, @"Should destroy the value once the last reference is released");
+    XCTAssertEqual(CCDictionaryGetValue(Shared->shared[Index], &(SharedE){ { 1, 2 } }), NULL, @"Should remove the value from the interned values");
+    XCTAssertNotEqual(CCDictionaryGetValue(Shared->shared[Index], &(SharedE){ { 3, 4 } }), NULL, @"Should keep the referenced values");
+    
+    ValueA = ECSSharedComponentIntern(Shared, &(SharedE){ { 1, 2 } }, SHARED_E);
+    
+    XCTAssertEqual(ValueA->refs, 1, @"Should intern the value again");
+    
+    ECSSharedComponentRelease(ValueA);
+    ECSSharedComponentRelease(ValueB);
+    
+    XCTAssertEqual(SharedDestructionCount, 2, @"Should destroy the value once the last reference is released");
+    
+    TestContextDestroy(Shared);
+    
+    XCTAssertEqual(SharedDestructionCount, 3, @"Should release the remaining references when the entities are destroyed");
+    
+    ECSArchetypeComponentSizes = PrevSizes;
+    ECSArchetypeComponentDestructors = PrevDestructors;
+    ECSComponentIDs = PrevIDs;
+    ECSSharedArchetypeComponentSizes = PrevSharedSizes;
+    ECSSharedArchetypeComponentDestructors = PrevSharedDestructors;
+}
+
+#if ECS_INDEXED_SPARSE_SET
+-(void) testIndexedSparseSet
+{
+    ECSContext *Sparse = TestContextCreate();
+    
+    ECSEntity Entities[6];
+    ECSEntityCreate(Sparse, Entities, 6);
+    
+    ECSEntityAddComponent(Sparse, Entities[3], &(CompH){ { 103 } }, COMP_H);
+    ECSEntityAddComponent(Sparse, Entities[0], &(CompH){ { 100 } }, COMP_H);
+    ECSEntityAddComponent(Sparse, Entities[5], &(CompH){ { 105 } }, COMP_H);
+    ECSEntityAddComponent(Sparse, Entities[1], &(CompH){ { 101 } }, COMP_H);
+    
+    CCArray(ECSEntity) Dense = ECSIndexedGetEntities(Sparse, COMP_H);
+    
+    XCTAssertEqual(CCArrayGetCount(Dense), 4, @"Should store each component densely");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 0), Entities[3], @"Should store the components in the order they were added");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 1), Entities[0], @"Should store the components in the order they were added");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 2), Entities[5], @"Should store the components in the order they were added");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 3), Entities[1], @"Should store the components in the order they were added");
+    XCTAssertEqual(((CompH*)CCArrayGetElementAtIndex(Sparse->indexed[COMP_H & ~ECSComponentStorageMask], 1))->v[0], 100, @"Should keep the components parallel to the entities");
+    
+    ECSEntityRemoveComponent(Sparse, Entities[0], COMP_H);
+    
+    XCTAssertEqual(CCArrayGetCount(Dense), 3, @"Should remove the component");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 1), Entities[1], @"Should swap the last entity into the removed slot");
+    XCTAssertEqual(*(ECSEntityIndex*)CCArrayGetElementAtIndex(Sparse->indexedSets[COMP_H & ~ECSComponentStorageMask].sparse, Entities[1]), 1, @"Should update the sparse index of the swapped entity");
+    XCTAssertFalse(ECSEntityHasComponent(Sparse, Entities[0], COMP_H), @"Should remove the component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, Entities[1], COMP_H))->v[0], 101, @"Should find the swapped component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, Entities[3], COMP_H))->v[0], 103, @"Should not move the other components");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, Entities[5], COMP_H))->v[0], 105, @"Should not move the other components");
+    
+    ECSEntityRemoveComponent(Sparse, Entities[5], COMP_H);
+    
+    XCTAssertEqual(CCArrayGetCount(Dense), 2, @"Should remove the last component without swapping");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 0), Entities[3], @"Should not reorder the remaining components");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 1), Entities[1], @"Should not reorder the remaining components");
+    
+    ECSEntityRemoveComponent(Sparse, Entities[3], COMP_H);
+    ECSEntityAddComponent(Sparse, Entities[4], &(CompH){ { 104 } }, COMP_H);
+    ECSEntityAddComponent(Sparse, Entities[0], &(CompH){ { 200 } }, COMP_H);
+    
+    XCTAssertEqual(CCArrayGetCount(Dense), 3, @"Should append the readded components");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 0), Entities[1], @"Should swap the last entity into the removed slot");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 1), Entities[4], @"Should append the added component");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 2), Entities[0], @"Should append the readded component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, Entities[0], COMP_H))->v[0], 200, @"Should use the new data of the readded component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, Entities[1], COMP_H))->v[0], 101, @"Should find the swapped component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, Entities[4], COMP_H))->v[0], 104, @"Should find the added component");
+    
+    
+    TestDestructionCount = 0;
+    
+    ECSEntityAddComponent(Sparse, Entities[2], &(IndexedH){ { 1 } }, INDEXED_H);
+    ECSEntityAddComponent(Sparse, Entities[4], &(IndexedH){ { 2 } }, INDEXED_H);
+    ECSEntityAddComponent(Sparse, Entities[4], &(IndexedH){ { 3 } }, INDEXED_H);
+    
+    CCArray(ECSEntity) DenseDestructible = ECSIndexedGetEntities(Sparse, INDEXED_H);
+    
+    XCTAssertEqual(TestDestructionCount, 1, @"Should destroy the replaced component");
+    XCTAssertEqual(CCArrayGetCount(DenseDestructible), 2, @"Should replace the component in place");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(DenseDestructible, 1), Entities[4], @"Should replace the component in place");
+    XCTAssertEqual(((IndexedH*)ECSEntityGetComponent(Sparse, Entities[4], INDEXED_H))->v[0], 3, @"Should override old data");
+    
+    ECSEntityRemoveComponent(Sparse, Entities[2], INDEXED_H);
+    
+    XCTAssertEqual(TestDestructionCount, 2, @"Should destroy the removed component");
+    XCTAssertEqual(CCArrayGetCount(DenseDestructible), 1, @"Should remove the component");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(DenseDestructible, 0), Entities[4], @"Should swap the last entity into the removed slot");
+    XCTAssertEqual(((IndexedH*)ECSEntityGetComponent(Sparse, Entities[4], INDEXED_H))->v[0], 3, @"Should find the swapped component");
+    
+    
+    ECSEntityDestroy(Sparse, (ECSEntity[2]){ Entities[1], Entities[2] }, 2);
+    
+    XCTAssertEqual(CCArrayGetCount(Dense), 2, @"Should remove the components of the destroyed entities");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 0), Entities[0], @"Should swap the last entity into the removed slot");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 1), Entities[4], @"Should not reorder the remaining components");
+    
+    CCArray(ECSEntityRemap) Remap = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntityRemap), 4);
+    
+    XCTAssertEqual(ECSEntityCompact(Sparse, SIZE_MAX, Remap), 2, @"Should move the entities above the free entities");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 1))->from, Entities[4], @"Should move the entity with the indexed components");
+    XCTAssertEqual(((ECSEntityRemap*)CCArrayGetElementAtIndex(Remap, 1))->to, 2, @"Should move to the lowest free entity");
+    
+    XCTAssertEqual(CCArrayGetCount(Dense), 2, @"Should not change the dense components when remapping");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 0), Entities[0], @"Should not remap the unmoved entity");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(Dense, 1), 2, @"Should remap the moved entity in place");
+    XCTAssertEqual(*(ECSEntity*)CCArrayGetElementAtIndex(DenseDestructible, 0), 2, @"Should remap the moved entity in place");
+    XCTAssertEqual(*(ECSEntityIndex*)CCArrayGetElementAtIndex(Sparse->indexedSets[COMP_H & ~ECSComponentStorageMask].sparse, 2), 1, @"Should move the sparse index");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, 0, COMP_H))->v[0], 200, @"Should find the unmoved component");
+    XCTAssertEqual(((CompH*)ECSEntityGetComponent(Sparse, 2, COMP_H))->v[0], 104, @"Should find the moved component");
+    XCTAssertEqual(((IndexedH*)ECSEntityGetComponent(Sparse, 2, INDEXED_H))->v[0], 3, @"Should find the moved component");
+    XCTAssertFalse(ECSEntityHasComponent(Sparse, 1, COMP_H), @"Should not give the moved entity's old components to the entity moved into the free slot");
+    XCTAssertEqual(TestDestructionCount, 2, @"Should not destroy the moved components");
+    
+    CCArrayDestroy(Remap);
+    TestContextDestroy(Sparse);
+}
+#endif
+
+#if ECS_DUPLICATE_INLINE_CAPACITY
+#define DUPLICATE_E (ECSComponentStorageTypeArchetype | ECSComponentStorageModifierDuplicate | ECSComponentStorageModifierDestructor | (COMP_E & ~ECSComponentStorageMask))
+#define DUPLICATE_INLINE_COUNT (ECS_DUPLICATE_INLINE_CAPACITY + 3)
+
+-(void) testDuplicateInlineStorage
+{
+    const size_t *PrevSizes = ECSArchetypeComponentSizes;
+    const ECSComponentDestructor *PrevDestructors = ECSArchetypeComponentDestructors;
+    const ECSComponentID *PrevIDs = ECSComponentIDs;
+    const size_t *PrevDuplicateSizes = ECSDuplicateArchetypeComponentSizes;
+    const ECSComponentDestructor *PrevDuplicateDestructors = ECSDuplicateArchetypeComponentDestructors;
+    const size_t *PrevPackedSizes = ECSPackedComponentSizes;
+    
+    size_t Sizes[ECS_ARCHETYPE_COMPONENT_MAX], DuplicateSizes[ECS_ARCHETYPE_COMPONENT_MAX], PackedSizes[ECS_PACKED_COMPONENT_MAX];
+    ECSComponentDestructor Destructors[ECS_ARCHETYPE_COMPONENT_MAX], DuplicateDestructors[ECS_ARCHETYPE_COMPONENT_MAX];
+    ECSComponentID IDs[ECS_COMPONENT_MAX];
+    
+    memcpy(Sizes, ArchetypeComponentSizes, sizeof(Sizes));
+    memcpy(DuplicateSizes, DuplicateArchetypeComponentSizes, sizeof(DuplicateSizes));
+    memcpy(PackedSizes, PackedComponentSizes, sizeof(PackedSizes));
+    memcpy(Destructors, ArchetypeComponentDestructors, sizeof(Destructors));
+    memcpy(DuplicateDestructors, DuplicateArchetypeComponentDestructors, sizeof(DuplicateDestructors));
+    memcpy(IDs, ComponentIDs, sizeof(IDs));
+    
+    // The generated sizes assume duplicates are stored as arrays
+    const size_t Index = DUPLICATE_E & ~ECSComponentStorageMask;
+    Sizes[Index] = ECS_DUPLICATE_COMPONENT_SIZE(sizeof(CompE));
+    DuplicateSizes[Index] = sizeof(CompE);
+    Destructors[Index] = ECSDuplicateDestructor;
+    DuplicateDestructors[Index] = TestDestructor;
+    IDs[ECS_COMPONENT_BASE_INDEX(COMP_E)] = DUPLICATE_E;
+    PackedSizes[DUPLICATE_A & ~ECSComponentStorageMask] = ECS_DUPLICATE_COMPONENT_SIZE(sizeof(DuplicateA));
+    PackedSizes[ECS_MONITOR_COMPONENT & ~ECSComponentStorageMask] = ECS_DUPLICATE_COMPONENT_SIZE(sizeof(ECSMonitorComponent));
+    
+    ECSArchetypeComponentSizes = Sizes;
+    ECSArchetypeComponentDestructors = Destructors;
+    ECSComponentIDs = IDs;
+    ECSDuplicateArchetypeComponentSizes = DuplicateSizes;
+    ECSDuplicateArchetypeComponentDestructors = DuplicateDestructors;
+    ECSPackedComponentSizes = PackedSizes;
+    
+    ECSContext *Inline = TestContextCreate();
+    
+    TestDestructionCount = 0;
+    
+    ECSEntity Entities[2];
+    ECSEntityCreate(Inline, Entities, 2);
+    
+    DuplicateA Values[DUPLICATE_INLINE_COUNT];
+    for (size_t Loop = 0; Loop < DUPLICATE_INLINE_COUNT; Loop++) Values[Loop] = (DuplicateA){ { (int)Loop } };
+    
+    ECSEntityAddComponent(Inline, Entities[0], &Values[0], DUPLICATE_A);
+    ECSEntityAddDuplicateComponent(Inline, Entities[0], &Values[1], DUPLICATE_A, DUPLICATE_INLINE_COUNT - 1);
+    
+    ECSDuplicateComponent *Duplicates = ECSEntityGetComponent(Inline, Entities[0], DUPLICATE_A);
+    
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), DUPLICATE_INLINE_COUNT, @"Should add all the duplicates");
+    XCTAssertNotEqual(Duplicates->spill, NULL, @"Should spill the duplicates beyond the inline capacity");
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 3, @"Should only spill the duplicates beyond the inline capacity");
+    
+    for (size_t Loop = 0; Loop < DUPLICATE_INLINE_COUNT; Loop++)
+    {
+        XCTAssertEqual(((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(DuplicateA), Loop))->v[0], Loop, @"Should keep the duplicates in order");
+    }
+    
+    ECSEntityRemoveDuplicateComponent(Inline, Entities[0], DUPLICATE_A, ECS_DUPLICATE_INLINE_CAPACITY - 1, 2);
+    
+    XCTAssertEqual(TestDestructionCount, 2, @"Should destroy the removed duplicates");
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), DUPLICATE_INLINE_COUNT - 2, @"Should remove the duplicates either side of the inline boundary");
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 1, @"Should shrink the spilled duplicates");
+    XCTAssertEqual(((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(DuplicateA), 0))->v[0], ECS_DUPLICATE_INLINE_CAPACITY > 1 ? 0 : ECS_DUPLICATE_INLINE_CAPACITY + 1, @"Should not move the preceding duplicates");
+    XCTAssertEqual(((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(DuplicateA), ECS_DUPLICATE_INLINE_CAPACITY - 1))->v[0], ECS_DUPLICATE_INLINE_CAPACITY + 1, @"Should move the spilled duplicates inline");
+    XCTAssertEqual(((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(DuplicateA), ECS_DUPLICATE_INLINE_CAPACITY))->v[0], ECS_DUPLICATE_INLINE_CAPACITY + 2, @"Should move the following duplicates down");
+    
+    ECSEntityRemoveDuplicateComponent(Inline, Entities[0], DUPLICATE_A, 1, DUPLICATE_INLINE_COUNT);
+    
+    XCTAssertEqual(TestDestructionCount, DUPLICATE_INLINE_COUNT - 1, @"Should destroy the removed duplicates");
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), 1, @"Should remove the trailing duplicates");
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 0, @"Should remove all the spilled duplicates");
+    XCTAssertEqual(((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(DuplicateA), 0))->v[0], 0, @"Should keep the first duplicate");
+    
+    ECSEntityAddDuplicateComponent(Inline, Entities[0], &Values[1], DUPLICATE_A, DUPLICATE_INLINE_COUNT - 1);
+    
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 3, @"Should reuse the spill array");
+    
+    TestDestructionCount = 0;
+    
+    ECSEntityRemoveComponent(Inline, Entities[0], DUPLICATE_A);
+    
+    XCTAssertEqual(TestDestructionCount, DUPLICATE_INLINE_COUNT, @"Should destroy the inline and spilled duplicates");
+    XCTAssertFalse(ECSEntityHasComponent(Inline, Entities[0], DUPLICATE_A), @"Should remove the component");
+    
+    
+    TestDestructionCount = 0;
+    
+    CompE ValuesE[DUPLICATE_INLINE_COUNT];
+    ECSTypedComponent Components[DUPLICATE_INLINE_COUNT + 1] = { { COMP_A, &(CompA){ { 7 } } } };
+    for (size_t Loop = 0; Loop < DUPLICATE_INLINE_COUNT; Loop++)
+    {
+        ValuesE[Loop] = (CompE){ { (int)Loop } };
+        Components[Loop + 1] = (ECSTypedComponent){ DUPLICATE_E, &ValuesE[Loop] };
+    }
+    
+    ECSEntityAddComponents(Inline, Entities[1], Components, DUPLICATE_INLINE_COUNT + 1);
+    
+    Duplicates = ECSEntityGetComponent(Inline, Entities[1], DUPLICATE_E);
+    
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Inline, Entities[1], COMP_A))->v[0], 7, @"Should add the other components");
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), DUPLICATE_INLINE_COUNT, @"Should add all the duplicates to the new archetype");
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 3, @"Should keep the spill array built when adding");
+    
+    for (size_t Loop = 0; Loop < DUPLICATE_INLINE_COUNT; Loop++)
+    {
+        XCTAssertEqual(((CompE*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(CompE), Loop))->v[0], Loop, @"Should copy the inline duplicates out of the shared zone");
+    }
+    
+    ECSEntityAddComponents(Inline, Entities[1], (ECSTypedComponent[2]){
+        { COMP_B, &(CompB){ { 8, 9 } } },
+        { DUPLICATE_E, &(CompE){ { 100 } } }
+    }, 2);
+    
+    Duplicates = ECSEntityGetComponent(Inline, Entities[1], DUPLICATE_E);
+    
+    XCTAssertEqual(((CompB*)ECSEntityGetComponent(Inline, Entities[1], COMP_B))->v[1], 9, @"Should add the other components");
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), DUPLICATE_INLINE_COUNT + 1, @"Should append to the existing duplicates when migrating");
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 4, @"Should move the spill array with the component");
+    XCTAssertEqual(((CompE*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(CompE), DUPLICATE_INLINE_COUNT))->v[0], 100, @"Should append the new duplicate");
+    XCTAssertEqual(((CompE*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(CompE), 0))->v[0], 0, @"Should keep the inline duplicates");
+    
+    ECSEntityRemoveComponents(Inline, Entities[1], (ECSComponentID[2]){ DUPLICATE_E, DUPLICATE_E }, 2);
+    
+    XCTAssertEqual(TestDestructionCount, 2, @"Should destroy the removed duplicates");
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), DUPLICATE_INLINE_COUNT - 1, @"Should remove the last duplicates");
+    XCTAssertEqual(CCArrayGetCount(Duplicates->spill), 2, @"Should shrink the spilled duplicates");
+    
+    ECSEntityRemoveDuplicateComponent(Inline, Entities[1], DUPLICATE_E, 0, ECS_DUPLICATE_INLINE_CAPACITY);
+    
+    XCTAssertEqual(TestDestructionCount, ECS_DUPLICATE_INLINE_CAPACITY + 2, @"Should destroy the removed duplicates");
+    XCTAssertEqual(ECSDuplicateComponentGetCount(Duplicates), 2, @"Should move the spilled duplicates inline");
+    
+    const int Moved[2] = {
+        ((CompE*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(CompE), 0))->v[0],
+        ((CompE*)ECSDuplicateComponentGetElementAtIndex(Duplicates, sizeof(CompE), 1))->v[0]
+    };
+    
+    XCTAssertTrue(((Moved[0] == ECS_DUPLICATE_INLINE_CAPACITY) && (Moved[1] == ECS_DUPLICATE_INLINE_CAPACITY + 1)) || ((Moved[0] == ECS_DUPLICATE_INLINE_CAPACITY + 1) && (Moved[1] == ECS_DUPLICATE_INLINE_CAPACITY)), @"Should move the spilled duplicates inline");
+    
+    ECSEntityAddDuplicateComponent(Inline, Entities[1], ValuesE, DUPLICATE_E, 3);
+    
+    const size_t RemainingCount = ECSDuplicateComponentGetCount(Duplicates);
+    
+    XCTAssertEqual(RemainingCount, 5, @"Should add the duplicates to the existing component");
+    
+    ECSEntityDestroy(Inline, &Entities[1], 1);
+    
+    XCTAssertEqual(TestDestructionCount, ECS_DUPLICATE_INLINE_CAPACITY + 2 + RemainingCount, @"Should destroy the inline and spilled duplicates with the entity");
+    
+    TestContextDestroy(Inline);
+    
+    
+    ECSMonitor Monitor = ECSBinaryMonitorCreate(CC_STD_ALLOCATOR, DUPLICATE_A, 4, 3, sizeof(int));
+    
+    _Alignas(ECSDuplicateComponent) uint8_t Current[ECS_DUPLICATE_COMPONENT_SIZE(sizeof(DuplicateA))];
+    ECSDuplicateComponent *DupA = (ECSDuplicateComponent*)Current;
+    const size_t ChunkSize = ECSDuplicateComponentChunkSize(DUPLICATE_A);
+    
+    ECSDuplicateComponentInit(DupA, sizeof(DuplicateA), ChunkSize);
+    ECSDuplicateComponentAppendElements(DupA, sizeof(DuplicateA), ChunkSize, Values, DUPLICATE_INLINE_COUNT);
+    
+    ECSMonitorRecord(&Monitor, DupA);
+    ECSMonitorRecord(&Monitor, DupA);
+    
+    ((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(DupA, sizeof(DuplicateA), 0))->v[0] = 10;
+    ((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(DupA, sizeof(DuplicateA), ECS_DUPLICATE_INLINE_CAPACITY))->v[0] = 20;
+    
+    ECSMonitorRecord(&Monitor, DupA);
+    ECSMonitorRecord(&Monitor, DupA);
+    
+    ECSDuplicateComponentRemoveElementsAtIndex(DupA, sizeof(DuplicateA), ECS_DUPLICATE_INLINE_CAPACITY - 1, 2);
+    
+    ECSMonitorRecord(&Monitor, DupA);
+    ECSMonitorRecord(&Monitor, DupA);
+    
+    ECSDuplicateComponentAppendElements(DupA, sizeof(DuplicateA), ChunkSize, (DuplicateA[2]){ { { 30 } }, { { 40 } } }, 2);
+    
+    ECSMonitorRecord(&Monitor, DupA);
+    ECSMonitorRecord(&Monitor, DupA);
+    
+    int Expected[4][DUPLICATE_INLINE_COUNT];
+    size_t ExpectedCount[4] = { DUPLICATE_INLINE_COUNT, DUPLICATE_INLINE_COUNT - 2, DUPLICATE_INLINE_COUNT, DUPLICATE_INLINE_COUNT };
+    
+    for (size_t Loop = 0; Loop < DUPLICATE_INLINE_COUNT; Loop++) Expected[3][Loop] = (int)Loop;
+    
+    memcpy(Expected[2], Expected[3], sizeof(Expected[3]));
+    Expected[2][0] = 10;
+    Expected[2][ECS_DUPLICATE_INLINE_CAPACITY] = 20;
+    
+    memcpy(Expected[1], Expected[2], sizeof(Expected[2]));
+    Expected[1][ECS_DUPLICATE_INLINE_CAPACITY - 1] = ECS_DUPLICATE_INLINE_CAPACITY + 1;
+    Expected[1][ECS_DUPLICATE_INLINE_CAPACITY] = ECS_DUPLICATE_INLINE_CAPACITY + 2;
+    
+    memcpy(Expected[0], Expected[1], sizeof(Expected[1]));
+    Expected[0][DUPLICATE_INLINE_COUNT - 2] = 30;
+    Expected[0][DUPLICATE_INLINE_COUNT - 1] = 40;
+    
+    for (size_t Revision = 0; Revision < 4; Revision++)
+    {
+        _Alignas(ECSDuplicateComponent) uint8_t Old[ECS_DUPLICATE_COMPONENT_SIZE(sizeof(DuplicateA))];
+        ECSDuplicateComponent *OldDupA = (ECSDuplicateComponent*)Old;
+        
+        ECSDuplicateComponentInit(OldDupA, sizeof(DuplicateA), ChunkSize);
+        
+        for (size_t Loop = 0, Count = ECSDuplicateComponentGetCount(DupA); Loop < Count; Loop++)
+        {
+            ECSDuplicateComponentAppendElements(OldDupA, sizeof(DuplicateA), ChunkSize, ECSDuplicateComponentGetElementAtIndex(DupA, sizeof(DuplicateA), Loop), 1);
+        }
+        
+        XCTAssertTrue(ECSMonitorTransform(&Monitor, OldDupA, Revision), @"Should exist");
+        XCTAssertEqual(ECSDuplicateComponentGetCount(OldDupA), ExpectedCount[Revision], @"Should have the number of elements");
+        
+        if (ECSDuplicateComponentGetCount(OldDupA) == ExpectedCount[Revision])
+        {
+            for (size_t Loop = 0; Loop < ExpectedCount[Revision]; Loop++)
+            {
+                XCTAssertEqual(((DuplicateA*)ECSDuplicateComponentGetElementAtIndex(OldDupA, sizeof(DuplicateA), Loop))->v[0], Expected[Revision][Loop], @"Should have the correct value");
+            }
+        }
+        
+        ECSDuplicateComponentDestroy(OldDupA);
+    }
+    
+    ECSDuplicateComponentDestroy(DupA);
+    ECSMonitorDestroy(&Monitor);
+    
+    ECSArchetypeComponentSizes = PrevSizes;
+    ECSArchetypeComponentDestructors = PrevDestructors;
+    ECSComponentIDs = PrevIDs;
+    ECSDuplicateArchetypeComponentSizes = PrevDuplicateSizes;
+    ECSDuplicateArchetypeComponentDestructors = PrevDuplicateDestructors;
+    ECSPackedComponentSizes = PrevPackedSizes;
+}
+#endif
+
+-(void) testEntityDestroyBatch
+{
+    ECSContext *Batch = TestContextCreate();
+    
+    ECSEntity Entities[8];
+    ECSEntityCreate(Batch, Entities, 8);
+    
+    ECSEntityAddComponents(Batch, Entities[0], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 100 } } },
+        { ARCH_H, &(ArchH){ { 100 } } }
+    }, 2);
+    ECSEntityAddComponents(Batch, Entities[1], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 101 } } },
+        { ARCH_H, &(ArchH){ { 101 } } }
+    }, 2);
+    ECSEntityAddComponent(Batch, Entities[2], &(PackedH){ { 102 } }, PACKED_H);
+    ECSEntityAddComponent(Batch, Entities[3], &(IndexedH){ { 103 } }, INDEXED_H);
+    ECSEntityAddComponent(Batch, Entities[4], &(LocalH){ { 104 } }, LOCAL_H);
+    ECSEntityAddComponents(Batch, Entities[6], (ECSTypedComponent[2]){
+        { COMP_A, &(CompA){ { 106 } } },
+        { ARCH_H, &(ArchH){ { 106 } } }
+    }, 2);
+    
+    ECSLinkAdd(Batch, Entities[0], NULL, &TestOneToOne, Entities[6], NULL);
+    ECSLinkAdd(Batch, Entities[1], NULL, &TestOneToMany, Entities[6], NULL);
+    
+    const ECSRegistryID ID2 = ECSRegistryRegister(Batch, Entities[2]);
+    const ECSRegistryID ID6 = ECSRegistryRegister(Batch, Entities[6]);
+    
+    ECSEntityDestroy(Batch, &Entities[7], 1);
+    
+    XCTAssertEqual(CCArrayGetCount(Batch->manager.available), 1, @"Should make the destroyed entity available");
+    
+    TestDestructionCount = 0;
+    
+    ECSEntityDestroyBatch(Batch, (ECSEntity[8]){ Entities[0], Entities[1], Entities[2], Entities[0], Entities[3], Entities[4], Entities[5], Entities[7] }, 8);
+    
+    XCTAssertEqual(TestDestructionCount, 5, @"Should destroy the archetype, packed, indexed and local components once each");
+    
+    for (size_t Loop = 0; Loop < 6; Loop++) XCTAssertFalse(ECSEntityIsAlive(Batch, Entities[Loop]), @"Should destroy the entity");
+    
+    XCTAssertFalse(ECSEntityIsAlive(Batch, Entities[7]), @"Should stay destroyed");
+    XCTAssertTrue(ECSEntityIsAlive(Batch, Entities[6]), @"Should not destroy entities outside of the batch");
+    
+    XCTAssertEqual(CCArrayGetCount(Batch->manager.available), 7, @"Should make each destroyed entity available once");
+    
+    for (size_t Loop = 0; Loop < 8; Loop++)
+    {
+        if (Loop == 6) continue;
+        
+        size_t Found = 0;
+        for (size_t Loop2 = 0, Count = CCArrayGetCount(Batch->manager.available); Loop2 < Count; Loop2++)
+        {
+            if (*(ECSEntity*)CCArrayGetElementAtIndex(Batch->manager.available, Loop2) == Entities[Loop]) Found++;
+        }
+        
+        XCTAssertEqual(Found, 1, @"Should make the destroyed entity available once");
+    }
+    
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Batch, Entities[6], COMP_A))->v[0], 106, @"Should keep the components of the remaining entity");
+    XCTAssertEqual(((ArchH*)ECSEntityGetComponent(Batch, Entities[6], ARCH_H))->v[0], 106, @"Should keep the components of the remaining entity");
+    XCTAssertEqual(CCArrayGetCount(((ECSEntityLookup*)CCArrayGetElementAtIndex(Batch->manager.lookup, Entities[6]))->archetype->entities), 1, @"Should remove the destroyed entities from the archetype");
+    
+    XCTAssertFalse(ECSLinked(Batch, Entities[6], ECS_LINK_INVERT(&TestOneToOne), Entities[0]), @"Should remove the links of the destroyed entities");
+    XCTAssertFalse(ECSLinked(Batch, Entities[6], ECS_LINK_INVERT(&TestOneToMany), Entities[1]), @"Should remove the links of the destroyed entities");
+    
+    XCTAssertEqual(ECSRegistryLookup(Batch, ID2), ECS_ENTITY_NULL, @"Should deregister the destroyed entities");
+    XCTAssertEqual(ECSRegistryLookup(Batch, ID6), Entities[6], @"Should not deregister the remaining entities");
+    
+    ECSEntityDestroyBatch(Batch, &Entities[0], 1);
+    
+    XCTAssertEqual(TestDestructionCount, 5, @"Should ignore entities that have already been destroyed");
+    XCTAssertEqual(CCArrayGetCount(Batch->manager.available), 7, @"Should ignore entities that have already been destroyed");
+    
+    TestContextDestroy(Batch);
+}
+
+#if ECS_CHANGE_VERSION
+static void ChangeVersionWriteB(ECSContext *Context, ECSArchetype *Archetype, const size_t *ArchetypeComponentIndexes, const size_t *ComponentOffsets, ECSRange Range, ECSTime Time)
+{
+    CompB *B = CCArrayGetData(Archetype->components[ArchetypeComponentIndexes[1]]);
+    const size_t Count = CCArrayGetCount(Archetype->entities);
+    
+    for (size_t Loop = Range.index, End = Range.count < (Count - Range.index) ? Range.index + Range.count : Count; Loop < End; Loop++) B[Loop].v[0]++;
+}
+
+static const ECSSystemUpdate ChangeVersionSystemUpdate[] = {
+    ECS_SYSTEM_UPDATE_PARALLEL_ARCHETYPE_STORAGE(ChangeVersionWriteB)
+};
+
+static const ECSSystemAccess ChangeVersionSystemAccess[] = {
+    { .read = { .ids = COMPONENT_ID_LIST_CompA, .count = 1 }, .write = { .ids = COMPONENT_ID_LIST_CompB, .count = 1 }, .archetype = COMPONENT_SYSTEM_ACCESS_ARCHETYPE2(CompA, CompB) }
+};
+
+static const ECSGroup ChangeVersionGroup = {
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0),
+    .dynamic = FALSE,
+    .priorities = {
+        .count = 1,
+        .deps = ConcurrentTickDependencies,
+        .systems = {
+            .range = ConcurrentTickSystemRange,
+            .graphs = ConcurrentTickSystemGraph,
+            .update = ChangeVersionSystemUpdate,
+            .access = ChangeVersionSystemAccess,
+        }
+    }
+};
+
+typedef struct {
+    size_t count;
+    ECSRange ranges[8];
+} ChangedRanges;
+
+static void ChangedRangesRecord(ECSContext *Context, ECSArchetype *Archetype, const size_t *ArchetypeComponentIndexes, ECSRange Range, void *Data)
+{
+    ChangedRanges *Changed = Data;
+    
+    if (Changed->count < 8) Changed->ranges[Changed->count] = Range;
+    
+    Changed->count++;
+}
+
+#define CHANGE_VERSION_ENTITY_COUNT 100
+
+-(void) testChangeVersions
+{
+    ECSContext *Changes = TestContextCreate();
+    
+    ECSEntity Entities[CHANGE_VERSION_ENTITY_COUNT], EntitiesAC[8];
+    ECSEntityCreate(Changes, Entities, CHANGE_VERSION_ENTITY_COUNT);
+    ECSEntityCreate(Changes, EntitiesAC, 8);
+    
+    for (size_t Loop = 0; Loop < CHANGE_VERSION_ENTITY_COUNT; Loop++)
+    {
+        ECSEntityAddComponents(Changes, Entities[Loop], (ECSTypedComponent[2]){
+            { COMP_A, &(CompA){ { (int)Loop } } },
+            { COMP_B, &(CompB){ { (int)Loop, 0 } } }
+        }, 2);
+    }
+    
+    for (size_t Loop = 0; Loop < 8; Loop++)
+    {
+        ECSEntityAddComponents(Changes, EntitiesAC[Loop], (ECSTypedComponent[2]){
+            { COMP_A, &(CompA){ { (int)Loop } } },
+            { COMP_C, &(CompC){ { (int)Loop, 0, 0 } } }
+        }, 2);
+    }
+    
+    ECSArchetype *ArchetypeAB = ((ECSEntityLookup*)CCArrayGetElementAtIndex(Changes->manager.lookup, Entities[0]))->archetype;
+    ECSArchetype *ArchetypeAC = ((ECSEntityLookup*)CCArrayGetElementAtIndex(Changes->manager.lookup, EntitiesAC[0]))->archetype;
+    const size_t ChunkSize = ArchetypeAB->chunk;
+    const size_t ChunkCount = (CHANGE_VERSION_ENTITY_COUNT + ChunkSize - 1) / ChunkSize;
+    
+    XCTAssertGreaterThan(ChunkCount, 2, @"Should span several chunks");
+    
+    const ECSChangeVersion Since = ECSContextGetChangeVersion(Changes);
+    
+    ECSRange Remaining = { .index = 0, .count = SIZE_MAX };
+    XCTAssertEqual(ECSArchetypeNextChangedRange(ArchetypeAB, (size_t[2]){ 0, 1 }, 2, &Remaining, Since).count, 0, @"Should not have changed since the version was read");
+    
+    uint8_t ExecState[1] = { 0 };
+    ECSExecutionGroup State = { .executing = 0, .state = ExecState, .time = 0, .running = 0 };
+    
+    ECSTick(Changes, &ChangeVersionGroup, 1, &State, ChangeVersionGroup.freq);
+    
+    for (size_t Loop = 0; Loop < CHANGE_VERSION_ENTITY_COUNT; Loop++)
+    {
+        XCTAssertEqual(((CompB*)ECSEntityGetComponent(Changes, Entities[Loop], COMP_B))->v[0], (int)Loop + 1, @"Should run the system for every entity");
+    }
+    
+    for (size_t Loop = 0; Loop < ChunkCount; Loop++)
+    {
+        XCTAssertTrue(ECSChangeVersionIsNewer(ECSArchetypeGetChangeVersion(ArchetypeAB, 1, Loop * ChunkSize), Since), @"Should stamp every chunk the system wrote to");
+        XCTAssertFalse(ECSChangeVersionIsNewer(ECSArchetypeGetChangeVersion(ArchetypeAB, 0, Loop * ChunkSize), Since), @"Should not stamp the components the system only read");
+    }
+    
+    XCTAssertFalse(ECSChangeVersionIsNewer(ECSArchetypeGetChangeVersion(ArchetypeAC, 0, 0), Since), @"Should not stamp archetypes the system did not run on");
+    XCTAssertFalse(ECSChangeVersionIsNewer(ECSArchetypeGetChangeVersion(ArchetypeAC, 1, 0), Since), @"Should not stamp archetypes the system did not run on");
+    
+    Remaining = (ECSRange){ .index = 0, .count = SIZE_MAX };
+    XCTAssertEqual(ECSArchetypeNextChangedRange(ArchetypeAB, (size_t[1]){ 0 }, 1, &Remaining, Since).count, 0, @"Should skip the components that were only read");
+    
+    Remaining = (ECSRange){ .index = 0, .count = SIZE_MAX };
+    ECSRange Changed = ECSArchetypeNextChangedRange(ArchetypeAB, (size_t[1]){ 1 }, 1, &Remaining, Since);
+    XCTAssertEqual(Changed.index, 0, @"Should find the written chunks");
+    XCTAssertEqual(Changed.count, CHANGE_VERSION_ENTITY_COUNT, @"Should merge the written chunks into one range");
+    
+    ECSQuery QueryA = ECSQueryCreate(Changes, (ECSComponentID[1]){ COMP_A }, 1, NULL, 0, NULL, 0);
+    ECSQuery QueryB = ECSQueryCreate(Changes, (ECSComponentID[1]){ COMP_B }, 1, NULL, 0, NULL, 0);
+    
+    ChangedRanges Ranges = { .count = 0 };
+    ECSQueryIterateChanged(&QueryA, ChangedRangesRecord, &Ranges, SIZE_MAX, Since);
+    
+    XCTAssertEqual(Ranges.count, 0, @"Should skip the archetypes whose with components have not changed");
+    
+    const ECSChangeVersion SinceTick = ECSContextGetChangeVersion(Changes);
+    
+    ECSEntityAddComponent(Changes, Entities[(ChunkSize * 2) + 1], &(CompB){ { -1, -1 } }, COMP_B);
+    
+    Ranges = (ChangedRanges){ .count = 0 };
+    ECSQueryIterateChanged(&QueryB, ChangedRangesRecord, &Ranges, SIZE_MAX, SinceTick);
+    
+    XCTAssertEqual(Ranges.count, 1, @"Should only iterate the changed chunk");
+    XCTAssertEqual(Ranges.ranges[0].index, ChunkSize * 2, @"Should only iterate the changed chunk");
+    XCTAssertEqual(Ranges.ranges[0].count, ChunkSize, @"Should only iterate the changed chunk");
+    
+    Ranges = (ChangedRanges){ .count = 0 };
+    ECSQueryIterateChanged(&QueryB, ChangedRangesRecord, &Ranges, SIZE_MAX, ECSContextGetChangeVersion(Changes));
+    
+    XCTAssertEqual(Ranges.count, 0, @"Should not iterate anything once the changes have been seen");
+    
+    ECSQueryDestroy(&QueryA);
+    ECSQueryDestroy(&QueryB);
+    ECSExecutionPlanDestroy(State.plan);
+    TestContextDestroy(Changes);
+}
+#endif
+
+static const ECSArchetypeEdge *TestFindEdge(ECSContext *Context, const ECSArchetype *Source, ECSComponentID ID, _Bool Add)
+{
+    size_t Count;
+    const ECSArchetypeEdge *Edges = ECSArchetypeGetEdges(Context, &Count);
+    const ptrdiff_t SourceOffset = Source ? (void*)Source - (void*)Context : 0;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        if ((Edges[Loop].dest) && (Edges[Loop].source == SourceOffset) && (Edges[Loop].component == (ID & ~ECSComponentStorageMask)) && (Edges[Loop].add == Add)) return &Edges[Loop];
+    }
+    
+    return NULL;
+}
+
+-(void) testArchetypeEdges
+{
+    ECSContext *Context = TestContextCreate();
+    
+    size_t EdgeCount;
+    const ECSArchetypeEdge *Edges = ECSArchetypeGetEdges(Context, &EdgeCount);
+    
+    XCTAssertEqual(EdgeCount, ECS_ARCHETYPE_EDGE_CACHE_MAX, @"Should return the whole cache");
+    for (size_t Loop = 0; Loop < EdgeCount; Loop++) XCTAssertEqual(Edges[Loop].dest, 0, @"Should start with no cached edges");
+    
+    ECSEntity Entities[3];
+    ECSEntityCreate(Context, Entities, 3);
+    
+    ECSEntityAddComponent(Context, Entities[0], &(CompB){ { 1, 2 } }, COMP_B);
+    
+    ECSArchetype *ArchetypeB = ((ECSEntityLookup*)CCArrayGetElementAtIndex(Context->manager.lookup, Entities[0]))->archetype;
+    const ECSArchetypeEdge *Edge = TestFindEdge(Context, NULL, COMP_B, TRUE);
+    
+    XCTAssertTrue(Edge, @"Should cache the transition from no archetype");
+    if (Edge) XCTAssertEqual((void*)Context + Edge->dest, (void*)ArchetypeB, @"Should cache the destination archetype");
+    
+    ECSEntityAddComponent(Context, Entities[0], &(CompA){ { 3 } }, COMP_A);
+    
+    ECSArchetype *ArchetypeAB = ((ECSEntityLookup*)CCArrayGetElementAtIndex(Context->manager.lookup, Entities[0]))->archetype;
+    Edge = TestFindEdge(Context, ArchetypeB, COMP_A, TRUE);
+    
+    XCTAssertTrue(Edge, @"Should cache the transition between archetypes");
+    if (Edge) XCTAssertEqual((void*)Context + Edge->dest, (void*)ArchetypeAB, @"Should cache the destination archetype");
+    
+    const ECSArchetypeComponentID IDA = COMP_A & ~ECSComponentStorageMask, IDB = COMP_B & ~ECSComponentStorageMask;
+    
+    // Take the same transitions again, so the destination IDs come from the cached archetype
+    for (size_t Loop = 1; Loop < 3; Loop++)
+    {
+        ECSEntityAddComponent(Context, Entities[Loop], &(CompB){ { 10 * (int)Loop, 0 } }, COMP_B);
+        ECSEntityAddComponent(Context, Entities[Loop], &(CompA){ { 10 * (int)Loop } }, COMP_A);
+        
+        const ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Loop]);
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop]);
+        
+        XCTAssertEqual(Lookup->archetype, ArchetypeAB, @"Should transition to the cached archetype");
+        XCTAssertEqual(Refs->archetype.component.count, 2, @"Should copy the destination component IDs");
+        XCTAssertEqual(Refs->archetype.component.ids[0], CCMin(IDA, IDB), @"Should copy the sorted destination component IDs");
+        XCTAssertEqual(Refs->archetype.component.ids[1], CCMax(IDA, IDB), @"Should copy the sorted destination component IDs");
+        XCTAssertEqual(((CompA*)ECSEntityGetComponent(Context, Entities[Loop], COMP_A))->v[0], 10 * (int)Loop, @"Should keep the component data");
+        XCTAssertEqual(((CompB*)ECSEntityGetComponent(Context, Entities[Loop], COMP_B))->v[0], 10 * (int)Loop, @"Should keep the component data");
+    }
+    
+    for (size_t Loop = 0; Loop < 2; Loop++)
+    {
+        ECSEntityRemoveComponent(Context, Entities[Loop], COMP_A);
+        
+        const ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Loop]);
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop]);
+        
+        XCTAssertEqual(Lookup->archetype, ArchetypeB, @"Should transition back to the smaller archetype");
+        XCTAssertEqual(Refs->archetype.component.count, 1, @"Should copy the destination component IDs");
+        XCTAssertEqual(Refs->archetype.component.ids[0], IDB, @"Should copy the destination component IDs");
+        XCTAssertFalse(ECSEntityHasComponent(Context, Entities[Loop], COMP_A), @"Should remove the component");
+        XCTAssertEqual(((CompB*)ECSEntityGetComponent(Context, Entities[Loop], COMP_B))->v[0], Loop ? 10 : 1, @"Should keep the component data");
+    }
+    
+    Edge = TestFindEdge(Context, ArchetypeAB, COMP_A, FALSE);
+    
+    XCTAssertTrue(Edge, @"Should cache removal transitions separately");
+    if (Edge) XCTAssertEqual((void*)Context + Edge->dest, (void*)ArchetypeB, @"Should cache the destination archetype");
+    
+    ECSEntityAddComponent(Context, Entities[0], &(CompA){ { 4 } }, COMP_A);
+    
+    XCTAssertEqual(((ECSEntityLookup*)CCArrayGetElementAtIndex(Context->manager.lookup, Entities[0]))->archetype, ArchetypeAB, @"Should transition to the cached archetype");
+    XCTAssertEqual(((CompA*)ECSEntityGetComponent(Context, Entities[0], COMP_A))->v[0], 4, @"Should add the component data");
+    
+    TestContextDestroy(Context);
+}
+
+static thrd_t MainSystemTickThread;
+static _Atomic(int) MainSystemWorkers = ATOMIC_VAR_INIT(0);
+static _Atomic(_Bool) MainSystemRunning = ATOMIC_VAR_INIT(FALSE);
+static _Atomic(_Bool) MainSystemOverlapped = ATOMIC_VAR_INIT(FALSE);
+static _Atomic(_Bool) MainSystemOffThread = ATOMIC_VAR_INIT(FALSE);
+static _Atomic(int) MainSystemRuns = ATOMIC_VAR_INIT(0);
+
+static ECS_PARALLEL_SYSTEM(MainSystemWorkerWriteJ, (), (CompJ))
+{
+    atomic_fetch_add(&MainSystemWorkers, 1);
+    
+    if (atomic_load(&MainSystemRunning)) atomic_store(&MainSystemOverlapped, TRUE);
+    
+    CompJ *J = CCArrayGetData(Context->packed[COMP_J & ~ECSComponentStorageMask].components[0]);
+    for (size_t Loop = Range.index, End = Range.index + Range.count; Loop < End; Loop++) J[Loop].v[0]++;
+    
+    atomic_fetch_sub(&MainSystemWorkers, 1);
+}
+
+static ECS_MAIN_SYSTEM(MainSystemWriteJ, (), (CompJ))
+{
+    atomic_store(&MainSystemRunning, TRUE);
+    atomic_fetch_add(&MainSystemRuns, 1);
+    
+    if (atomic_load(&MainSystemWorkers)) atomic_store(&MainSystemOverlapped, TRUE);
+    if (!thrd_equal(thrd_current(), MainSystemTickThread)) atomic_store(&MainSystemOffThread, TRUE);
+    
+    CCArray Components = Context->packed[COMP_J & ~ECSComponentStorageMask].components[0];
+    CompJ *J = CCArrayGetData(Components);
+    for (size_t Loop = 0, Count = CCArrayGetCount(Components); Loop < Count; Loop++) J[Loop].v[0] += 10;
+    
+    atomic_store(&MainSystemRunning, FALSE);
+}
+
+static ECS_MAIN_SYSTEM(MainSystemCount, (), ())
+{
+    atomic_fetch_add(&MainSystemRuns, 1);
+    
+    if (!thrd_equal(thrd_current(), MainSystemTickThread)) atomic_store(&MainSystemOffThread, TRUE);
+}
+
+static const ECSSystemRange MainSystemRange[] = {
+    { 0, 3 }
+};
+
+static const ECSSystemUpdate MainSystemUpdate[] = {
+    ECS_SYSTEM_UPDATE_PARALLEL_CHUNK(MainSystemWorkerWriteJ, offsetof(ECSContext, packed[(COMP_J & ~ECSComponentStorageMask)].entities), 4),
+    ECS_SYSTEM_UPDATE_MAIN(MainSystemWriteJ),
+    ECS_SYSTEM_UPDATE_MAIN(MainSystemCount)
+};
+
+static const ECSSystemAccess MainSystemAccess[] = {
+    { .read = { .ids = NULL, .count = 0 }, .write = { .ids = COMPONENT_ID_LIST_CompJ, .count = 1 }, .component = { .offsets = COMPONENT_OFFSET_LIST_CompJ } },
+    { .read = { .ids = NULL, .count = 0 }, .write = { .ids = COMPONENT_ID_LIST_CompJ, .count = 1 }, .component = { .offsets = COMPONENT_OFFSET_LIST_CompJ } },
+    { .read = { .ids = NULL, .count = 0 }, .write = { .ids = NULL, .count = 0 } }
+};
+
+static const uint8_t MainSystemGraph[] = {
+    0,
+    0,
+    0
+};
+
+static const ECSGroup MainSystemGroup = {
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0),
+    .dynamic = FALSE,
+    .priorities = {
+        .count = 1,
+        .deps = ConcurrentTickDependencies,
+        .systems = {
+            .range = MainSystemRange,
+            .graphs = MainSystemGraph,
+            .update = MainSystemUpdate,
+            .access = MainSystemAccess,
+        }
+    }
+};
+
+#define MAIN_SYSTEM_ENTITY_COUNT 4096
+
+-(void) testMainSystems
+{
+    ECSContext *Main = TestContextCreate();
+    
+    ECSEntity Entities[MAIN_SYSTEM_ENTITY_COUNT];
+    ECSEntityCreate(Main, Entities, MAIN_SYSTEM_ENTITY_COUNT);
+    
+    for (size_t Loop = 0; Loop < MAIN_SYSTEM_ENTITY_COUNT; Loop++) ECSEntityAddComponent(Main, Entities[Loop], &(CompJ){ { (int)Loop } }, COMP_J);
+    
+    atomic_store(&MainSystemOverlapped, FALSE);
+    atomic_store(&MainSystemOffThread, FALSE);
+    atomic_store(&MainSystemRuns, 0);
+    MainSystemTickThread = thrd_current();
+    
+    uint8_t ExecState[1] = { 0 };
+    ECSExecutionGroup State = { .executing = 0, .state = ExecState, .time = 0, .running = 0 };
+    
+    ECSTick(Main, &MainSystemGroup, 1, &State, MainSystemGroup.freq);
+    ECSTick(Main, &MainSystemGroup, 1, &State, MainSystemGroup.freq);
+    
+    XCTAssertEqual(State.running, 0, @"should finish every executor");
+    XCTAssertEqual(atomic_load(&MainSystemRuns), 4, @"should run each main system once per tick");
+    XCTAssertFalse(atomic_load(&MainSystemOffThread), @"should run the main systems on the thread calling ECSTick");
+    XCTAssertFalse(atomic_load(&MainSystemOverlapped), @"should not run a main system while a conflicting system is running");
+    
+    for (size_t Loop = 0; Loop < MAIN_SYSTEM_ENTITY_COUNT; Loop++)
+    {
+        const CompJ *J = ECSEntityGetComponent(Main, Entities[Loop], COMP_J);
+        
+        if (J->v[0] != (int)Loop + 22)
+        {
+            XCTFail(@"should run both writing systems exactly once per tick for every entity (%zu)", Loop);
+            break;
+        }
+    }
+    
+    ECSExecutionPlanDestroy(State.plan);
+    TestContextDestroy(Main);
+}
+
+#define MAIN_SYSTEM_OVERFLOW_COUNT 40
+
+static const ECSSystemRange MainSystemOverflowRange[] = {
+    { 0, MAIN_SYSTEM_OVERFLOW_COUNT }
+};
+
+static ECSSystemUpdate MainSystemOverflowUpdate[MAIN_SYSTEM_OVERFLOW_COUNT];
+static const ECSSystemAccess MainSystemOverflowAccess[MAIN_SYSTEM_OVERFLOW_COUNT];
+static const uint8_t MainSystemOverflowGraph[MAIN_SYSTEM_OVERFLOW_COUNT * ((MAIN_SYSTEM_OVERFLOW_COUNT + 7) / 8)];
+
+static const ECSGroup MainSystemOverflowGroup = {
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0),
+    .dynamic = FALSE,
+    .priorities = {
+        .count = 1,
+        .deps = ConcurrentTickDependencies,
+        .systems = {
+            .range = MainSystemOverflowRange,
+            .graphs = MainSystemOverflowGraph,
+            .update = MainSystemOverflowUpdate,
+            .access = MainSystemOverflowAccess,
+        }
+    }
+};
+
+-(void) testMainExecutorOverflow
+{
+    ECSContext *Overflow = TestContextCreate();
+    
+    // More independent main systems than the tick can hold at once, so they're all ready in the same pass
+    for (size_t Loop = 0; Loop < MAIN_SYSTEM_OVERFLOW_COUNT; Loop++) MainSystemOverflowUpdate[Loop] = ECS_SYSTEM_UPDATE_MAIN(MainSystemCount);
+    
+    atomic_store(&MainSystemOffThread, FALSE);
+    atomic_store(&MainSystemRuns, 0);
+    MainSystemTickThread = thrd_current();
+    
+    uint8_t ExecState[(MAIN_SYSTEM_OVERFLOW_COUNT + 7) / 8] = { 0 };
+    ECSExecutionGroup State = { .executing = 0, .state = ExecState, .time = 0, .running = 0 };
+    
+    ECSTick(Overflow, &MainSystemOverflowGroup, 1, &State, MainSystemOverflowGroup.freq);
+    
+    XCTAssertEqual(State.running, 0, @"should finish every executor");
+    XCTAssertEqual(atomic_load(&MainSystemRuns), MAIN_SYSTEM_OVERFLOW_COUNT, @"should run every main system once");
+    
+    ECSTick(Overflow, &MainSystemOverflowGroup, 1, &State, MainSystemOverflowGroup.freq);
+    
+    XCTAssertEqual(State.running, 0, @"should finish every executor");
+    XCTAssertEqual(atomic_load(&MainSystemRuns), MAIN_SYSTEM_OVERFLOW_COUNT * 2, @"should run every main system once per tick");
+    XCTAssertFalse(atomic_load(&MainSystemOffThread), @"should run the main systems on the thread calling ECSTick");
+    
+    ECSExecutionPlanDestroy(State.plan);
+    TestContextDestroy(Overflow);
+}
+
+#ifndef ECS_TICK_BUDGET_DEFERRAL_MAX
+#define ECS_TICK_BUDGET_DEFERRAL_MAX 4
+#endif
+
+static _Atomic(int) BudgetRuns[2];
+
+static ECS_SYSTEM(BudgetEssentialRun, (), ())
+{
+    atomic_fetch_add(&BudgetRuns[0], 1);
+}
+
+static ECS_SYSTEM(BudgetOptionalRun, (), ())
+{
+    atomic_fetch_add(&BudgetRuns[1], 1);
+}
+
+static const ECSSystemUpdate BudgetSystemUpdate[2][1] = {
+    { ECS_SYSTEM_UPDATE(BudgetEssentialRun) },
+    { ECS_SYSTEM_UPDATE(BudgetOptionalRun) }
+};
+
+static const ECSSystemAccess BudgetSystemAccess[] = {
+    { .read = { .ids = NULL, .count = 0 }, .write = { .ids = NULL, .count = 0 } }
+};
+
+#define BUDGET_GROUP(index, groupPriority) { \
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0), \
+    .dynamic = FALSE, \
+    .priority = (groupPriority), \
+    .priorities = { \
+        .count = 1, \
+        .deps = ConcurrentTickDependencies, \
+        .systems = { \
+            .range = ConcurrentTickSystemRange, \
+            .graphs = ConcurrentTickSystemGraph, \
+            .update = BudgetSystemUpdate[index], \
+            .access = BudgetSystemAccess, \
+        } \
+    } \
+}
+
+static const ECSGroup BudgetGroups[2] = {
+    BUDGET_GROUP(0, 0),
+    BUDGET_GROUP(1, 1)
+};
+
+-(void) testTickBudget
+{
+    ECSContext *Budgeted = TestContextCreate();
+    
+    const ECSTime PrevBudget = ECSTickBudget;
+    const ECSTime Freq = BudgetGroups[0].freq;
+    
+    // Any measured cost exceeds the budget, so only the priority 0 group can run until the other has been deferred too many times
+    ECSTickBudget = 1;
+    
+    atomic_store(&BudgetRuns[0], 0);
+    atomic_store(&BudgetRuns[1], 0);
+    
+    uint8_t ExecState[2][1] = { { 0 }, { 0 } };
+    ECSExecutionGroup State[2] = {
+        { .executing = 0, .state = ExecState[0], .time = 0, .running = 0, .cost = ECS_TIME_FROM_SECONDS(1.0) },
+        { .executing = 0, .state = ExecState[1], .time = 0, .running = 0, .cost = ECS_TIME_FROM_SECONDS(1.0) }
+    };
+    
+    ECSTick(Budgeted, BudgetGroups, 2, State, Freq);
+    
+    XCTAssertEqual(atomic_load(&BudgetRuns[0]), 1, @"should never defer a priority 0 group");
+    XCTAssertEqual(atomic_load(&BudgetRuns[1]), 0, @"should defer the group that exceeds the budget");
+    XCTAssertFalse(State[0].deferred, @"should not report a group that ran as deferred");
+    XCTAssertTrue(State[1].deferred, @"should report the group as deferred");
+    XCTAssertEqual(State[1].deferrals, 1, @"should count the deferral");
+    XCTAssertEqual(State[1].time, Freq, @"should carry over the time of the deferred tick");
+    XCTAssertLessThan(State[1].cost, ECS_TIME_FROM_SECONDS(1.0), @"should decay the cost of a deferred group");
+    
+    ECSTick(Budgeted, BudgetGroups, 2, State, Freq * (ECS_TICK_BUDGET_DEFERRAL_MAX + 4));
+    
+    XCTAssertEqual(atomic_load(&BudgetRuns[1]), 0, @"should defer the group that exceeds the budget");
+    XCTAssertTrue(State[1].deferred, @"should report the group as deferred");
+    XCTAssertEqual(State[1].deferrals, 2, @"should count consecutive deferrals");
+    XCTAssertEqual(State[1].time, Freq * (ECS_TICK_BUDGET_DEFERRAL_MAX + 1), @"should clamp the time carried over");
+    
+    for (size_t Loop = 2; Loop < ECS_TICK_BUDGET_DEFERRAL_MAX; Loop++)
+    {
+        ECSTick(Budgeted, BudgetGroups, 2, State, Freq);
+        
+        XCTAssertTrue(State[1].deferred, @"should report the group as deferred");
+        XCTAssertEqual(State[1].time, Freq * (ECS_TICK_BUDGET_DEFERRAL_MAX + 1), @"should clamp the time carried over");
+    }
+    
+    XCTAssertEqual(atomic_load(&BudgetRuns[1]), 0, @"should defer the group until the deferral limit");
+    XCTAssertEqual(State[1].deferrals, ECS_TICK_BUDGET_DEFERRAL_MAX, @"should count consecutive deferrals");
+    
+    ECSTick(Budgeted, BudgetGroups, 2, State, Freq);
+    
+    XCTAssertEqual(atomic_load(&BudgetRuns[0]), ECS_TICK_BUDGET_DEFERRAL_MAX + 1, @"should never defer a priority 0 group");
+    XCTAssertEqual(atomic_load(&BudgetRuns[1]), 1, @"should run the group once it has been deferred too many times");
+    XCTAssertFalse(State[1].deferred, @"should not report a group that ran as deferred");
+    XCTAssertEqual(State[1].deferrals, 0, @"should reset the deferrals once the group runs");
+    XCTAssertEqual(State[1].running, 0, @"should finish every executor");
+    
+    ECSTickBudget = PrevBudget;
+    
+    for (size_t Loop = 0; Loop < 2; Loop++) ECSExecutionPlanDestroy(State[Loop].plan);
+    TestContextDestroy(Budgeted);
+}
+
+#define PARALLEL_FOR_OUTER_COUNT 64
+#define PARALLEL_FOR_INNER_COUNT 256
+
+typedef struct {
+    _Atomic(int) outer[PARALLEL_FOR_OUTER_COUNT];
+    _Atomic(int) inner[PARALLEL_FOR_OUTER_COUNT][PARALLEL_FOR_INNER_COUNT];
+    _Atomic(int) systemRuns;
+} ParallelForState;
+
+static ParallelForState *ParallelForSystemState = NULL;
+
+static void ParallelForInner(_Atomic(int) *Visits, ECSRange Range)
+{
+    for (size_t Loop = 0; Loop < Range.count; Loop++) atomic_fetch_add_explicit(&Visits[Range.index + Loop], 1, memory_order_relaxed);
+}
+
+static void ParallelForOuter(ParallelForState *State, ECSRange Range)
+{
+    for (size_t Loop = 0; Loop < Range.count; Loop++)
+    {
+        const size_t Index = Range.index + Loop;
+        
+        atomic_fetch_add_explicit(&State->outer[Index], 1, memory_order_relaxed);
+        
+        // Nested loop, forked from a task that is itself running on a worker
+        ECSParallelFor((ECSTaskCallback)ParallelForInner, State->inner[Index], PARALLEL_FOR_INNER_COUNT, 16);
+    }
+}
+
+static ECS_SYSTEM(ParallelForSystem, (), ())
+{
+    atomic_fetch_add(&ParallelForSystemState->systemRuns, 1);
+    
+    ECSParallelFor((ECSTaskCallback)ParallelForOuter, ParallelForSystemState, PARALLEL_FOR_OUTER_COUNT, 2);
+}
+
+static const ECSSystemUpdate ParallelForSystemUpdate[] = {
+    ECS_SYSTEM_UPDATE(ParallelForSystem)
+};
+
+static const ECSSystemAccess ParallelForSystemAccess[] = {
+    { .read = { .ids = NULL, .count = 0 }, .write = { .ids = NULL, .count = 0 } }
+};
+
+static const ECSGroup ParallelForGroup = {
+    .freq = ECS_TIME_FROM_SECONDS(1.0 / 60.0),
+    .dynamic = FALSE,
+    .priorities = {
+        .count = 1,
+        .deps = ConcurrentTickDependencies,
+        .systems = {
+            .range = ConcurrentTickSystemRange,
+            .graphs = ConcurrentTickSystemGraph,
+            .update = ParallelForSystemUpdate,
+            .access = ParallelForSystemAccess,
+        }
+    }
+};
+
+-(void) testSystemParallelFor
+{
+    ECSContext *Context = TestContextCreate();
+    
+    ParallelForSystemState = CCMalloc(CC_STD_ALLOCATOR, sizeof(ParallelForState), NULL, CC_DEFAULT_ERROR_CALLBACK);
+    memset(ParallelForSystemState, 0, sizeof(ParallelForState));
+    
+    uint8_t ExecState[1] = { 0 };
+    ECSExecutionGroup State = { .executing = 0, .state = ExecState, .time = 0, .running = 0 };
+    
+    ECSTick(Context, &ParallelForGroup, 1, &State, ParallelForGroup.freq);
+    
+    XCTAssertEqual(State.running, 0, @"should finish every executor");
+    XCTAssertEqual(atomic_load(&ParallelForSystemState->systemRuns), 1, @"should run the system once");
+    
+    for (size_t Loop = 0; Loop < PARALLEL_FOR_OUTER_COUNT; Loop++)
+    {
+        if (atomic_load(&ParallelForSystemState->outer[Loop]) != 1)
+        {
+            XCTFail(@"should visit every outer index exactly once (%zu)", Loop);
+            break;
+        }
+        
+        _Bool Visited = TRUE;
+        for (size_t Loop2 = 0; (Visited) && (Loop2 < PARALLEL_FOR_INNER_COUNT); Loop2++) Visited = atomic_load(&ParallelForSystemState->inner[Loop][Loop2]) == 1;
+        
+        if (!Visited)
+        {
+            XCTFail(@"should visit every nested index exactly once (%zu)", Loop);
+            break;
+        }
+    }
+    
+    CCFree(ParallelForSystemState);
+    ParallelForSystemState = NULL;
+    
+    ECSExecutionPlanDestroy(State.plan);
+    TestContextDestroy(Context);
+}
+
+@end
+
+
+
+
+
+
+
+
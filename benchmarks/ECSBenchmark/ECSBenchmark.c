@@ -0,0 +1,463 @@
+/*
+ *  Copyright (c) 2023, Stefan Johnson
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this list
+ *     of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice, this
+ *     list of conditions and the following disclaimer in the documentation and/or other
+ *     materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//ruby build.rb ... --benchmark=benchmarks/ECSBenchmark,CommonGameKitTests
+//ECSBenchmark [entity count] [max worker count] > results.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ECS.h"
+#define ECS_PACKED_COMPONENT_ID_BASE 1
+#define ECS_INDEXED_COMPONENT_ID_BASE 2
+#include "ECSComponentIDs.h"
+#include "ECSNameComponent.h"
+#include "ECSMonitorComponent.h"
+#include "ECSMonitorSystem.h"
+#include "ECSTestAccessors.h"
+#include "ECSTests.h"
+#include "ECSTestData.h"
+
+#define BENCHMARK_RESULT_MAX 64
+#define BENCHMARK_MUTATION_MAX 4096
+#define BENCHMARK_SHARED_DATA_MAX 1048576
+#define BENCHMARK_TICK_COUNT 10000
+
+#define ECS_SYSTEM_NAME Sys1ReadA_WriteB
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys2ReadAC_WriteB
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys3ReadAC_WriteD
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys4ReadA
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys5ReadC
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys6ReadAC
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys7WriteB
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys8ReadD_WriteC
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys9ReadFGH_WriteAI
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys10WriteJ
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys11ReadAWithArchTag
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys12ReadLocalHLocalDuplicateB_WriteDuplicateA
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys13ReadDestroyMeTag
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys14ReadAJ
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys15ReadH
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+#define ECS_SYSTEM_NAME Sys16ReadCheckRunStateTag
+static ECS_SYSTEM_FUN() {}
+#undef ECS_SYSTEM_NAME
+
+static void TestDestructor(void *Data, ECSComponentID ID)
+{
+}
+
+static void MutationDestructor(void *Data, ECSComponentID ID)
+{
+}
+
+typedef struct {
+    char name[64];
+    size_t ops;
+    double time;
+} BenchmarkResult;
+
+static BenchmarkResult Results[BENCHMARK_RESULT_MAX];
+static size_t ResultCount = 0;
+
+static volatile size_t BenchmarkSink = 0;
+
+static ECSContext Context;
+
+static ECSMutableState MutableState = ECS_MUTABLE_STATE_CREATE(BENCHMARK_MUTATION_MAX, BENCHMARK_MUTATION_MAX, BENCHMARK_MUTATION_MAX, BENCHMARK_MUTATION_MAX, BENCHMARK_MUTATION_MAX, BENCHMARK_MUTATION_MAX, BENCHMARK_MUTATION_MAX, BENCHMARK_SHARED_DATA_MAX);
+
+static void BenchmarkRecord(const char *Name, size_t Ops, double Start)
+{
+    const double Time = CCTimestamp() - Start;
+    
+    if (ResultCount == BENCHMARK_RESULT_MAX) return;
+    
+    BenchmarkResult *Result = &Results[ResultCount++];
+    snprintf(Result->name, sizeof(Result->name), "%s", Name);
+    Result->ops = Ops;
+    Result->time = Time;
+}
+
+static void BenchmarkEntityCreateDestroy(ECSEntity *Entities, size_t Count)
+{
+    double Start = CCTimestamp();
+    ECSEntityCreate(&Context, Entities, Count);
+    BenchmarkRecord("entity_create", Count, Start);
+    
+    Start = CCTimestamp();
+    ECSEntityDestroy(&Context, Entities, Count);
+    BenchmarkRecord("entity_destroy", Count, Start);
+}
+
+static void BenchmarkIterate(const char *Name, const ECSEntity *Entities, size_t Count, ECSComponentID ID)
+{
+    size_t Sum = 0;
+    const double Start = CCTimestamp();
+    
+    switch (ID & ECSComponentStorageTypeMask)
+    {
+        case ECSComponentStorageTypeArchetype:
+            if (!(ID & ECSComponentStorageModifierTag))
+            {
+                const ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context.manager.map, Entities[0]);
+                const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context.manager.lookup, Entities[0]);
+                CCArray Components = Lookup->archetype->components[ECSArchetypeComponentIndex(Refs, ID & ~ECSComponentStorageMask)];
+                
+                for (size_t Loop = 0, ComponentCount = CCArrayGetCount(Components); Loop < ComponentCount; Loop++)
+                {
+                    Sum += *(const int*)CCArrayGetElementAtIndex(Components, Loop);
+                }
+                
+                break;
+            }
+            
+        default:
+            for (size_t Loop = 0; Loop < Count; Loop++)
+            {
+                if (ID & ECSComponentStorageModifierTag) Sum += ECSEntityHasComponent(&Context, Entities[Loop], ID);
+                else if (ID & ECSComponentStorageModifierDuplicate) Sum += ECSDuplicateComponentGetCount(ECSEntityGetComponent(&Context, Entities[Loop], ID));
+                else Sum += *(const int*)ECSEntityGetComponent(&Context, Entities[Loop], ID);
+            }
+            break;
+            
+        case ECSComponentStorageTypePacked:
+            if (!(ID & (ECSComponentStorageModifierTag | ECSComponentStorageModifierDuplicate)))
+            {
+                CCArray Components = *Context.packed[ID & ~ECSComponentStorageMask].components;
+                
+                for (size_t Loop = 0, ComponentCount = CCArrayGetCount(Components); Loop < ComponentCount; Loop++)
+                {
+                    Sum += *(const int*)CCArrayGetElementAtIndex(Components, Loop);
+                }
+            }
+            
+            else
+            {
+                for (size_t Loop = 0; Loop < Count; Loop++)
+                {
+                    if (ID & ECSComponentStorageModifierTag) Sum += ECSEntityHasComponent(&Context, Entities[Loop], ID);
+                    else Sum += ECSDuplicateComponentGetCount(ECSEntityGetComponent(&Context, Entities[Loop], ID));
+                }
+            }
+            break;
+    }
+    
+    BenchmarkRecord(Name, Count, Start);
+    
+    BenchmarkSink += Sum;
+}
+
+static void BenchmarkComponent(const char *Name, ECSEntity *Entities, size_t Count, ECSComponentID ID, size_t Size)
+{
+    char Label[64];
+    uint8_t Data[256] = {0};
+    
+    CCAssertLog(Size <= sizeof(Data), "Component data is too large");
+    
+    ECSEntityCreate(&Context, Entities, Count);
+    
+    double Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < Count; Loop++) ECSEntityAddComponent(&Context, Entities[Loop], Size ? Data : NULL, ID);
+    snprintf(Label, sizeof(Label), "%s_add", Name);
+    BenchmarkRecord(Label, Count, Start);
+    
+    snprintf(Label, sizeof(Label), "%s_iterate", Name);
+    BenchmarkIterate(Label, Entities, Count, ID);
+    
+    Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < Count; Loop++) ECSEntityRemoveComponent(&Context, Entities[Loop], ID);
+    snprintf(Label, sizeof(Label), "%s_remove", Name);
+    BenchmarkRecord(Label, Count, Start);
+    
+    ECSEntityDestroy(&Context, Entities, Count);
+}
+
+static const ECSLink BenchmarkOneToOne = { .type = ECSLinkTypeRelationshipOneToOne };
+
+static void BenchmarkLink(ECSEntity *Entities, size_t Count)
+{
+    const size_t PairCount = Count / 2;
+    
+    ECSEntityCreate(&Context, Entities, PairCount * 2);
+    
+    double Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < PairCount; Loop++) ECSLinkAdd(&Context, Entities[Loop * 2], NULL, &BenchmarkOneToOne, Entities[(Loop * 2) + 1], NULL);
+    BenchmarkRecord("link_add", PairCount, Start);
+    
+    Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < PairCount; Loop++) ECSLinkRemove(&Context, Entities[Loop * 2], &BenchmarkOneToOne, Entities[(Loop * 2) + 1]);
+    BenchmarkRecord("link_remove", PairCount, Start);
+    
+    ECSEntityDestroy(&Context, Entities, PairCount * 2);
+}
+
+static void BenchmarkRegistry(ECSEntity *Entities, size_t Count)
+{
+    ECSEntityCreate(&Context, Entities, Count);
+    
+    double Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < Count; Loop++) ECSRegistryRegister(&Context, Entities[Loop]);
+    BenchmarkRecord("registry_register", Count, Start);
+    
+    size_t Found = 0;
+    Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < Count; Loop++) Found += ECSRegistryLookup(&Context, ECSRegistryGetID(&Context, Entities[Loop])) == Entities[Loop];
+    BenchmarkRecord("registry_lookup", Count, Start);
+    
+    BenchmarkSink += Found;
+    
+    Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < Count; Loop++) ECSRegistryDeregister(&Context, Entities[Loop]);
+    BenchmarkRecord("registry_deregister", Count, Start);
+    
+    ECSEntityDestroy(&Context, Entities, Count);
+}
+
+static void BenchmarkMutationCreated(ECSContext *Context, void *Data, ECSEntity *NewEntities, size_t NewEntityCount)
+{
+    memcpy(Data, NewEntities, sizeof(ECSEntity) * NewEntityCount);
+}
+
+static void BenchmarkMutation(ECSEntity *Entities, size_t Count)
+{
+    size_t Ops = 0;
+    double Time = 0;
+    
+    for (size_t Offset = 0; Offset < Count; Offset += BENCHMARK_MUTATION_MAX)
+    {
+        const size_t BatchCount = CCMin(Count - Offset, BENCHMARK_MUTATION_MAX);
+        
+        const ECSProxyEntity Base = ECSMutationStageEntityCreate(&Context, BatchCount);
+        ECSMutableAddComponentState *AddComponentState = ECSMutationStageEntityAddComponents(&Context, BatchCount);
+        ECSTypedComponent *SharedComponent = ECSMutationSetSharedData(&Context, sizeof(ECSTypedComponent) + sizeof(CompA));
+        
+        SharedComponent->id = COMP_A;
+        SharedComponent->data = SharedComponent + 1;
+        *(CompA*)SharedComponent->data = (CompA){ { 1 } };
+        
+        for (size_t Loop = 0; Loop < BatchCount; Loop++)
+        {
+            AddComponentState[Loop].entity = Base + Loop;
+            AddComponentState[Loop].count = 1;
+            AddComponentState[Loop].components = SharedComponent;
+        }
+        
+        *ECSMutationStageCustomCallback(&Context, 1) = (ECSMutableCustomCallbackState){
+            .callback = BenchmarkMutationCreated,
+            .data = Entities + Offset
+        };
+        
+        const double Start = CCTimestamp();
+        ECSMutationApply(&Context);
+        Time += CCTimestamp() - Start;
+        
+        Ops += BatchCount;
+    }
+    
+    ECSEntityDestroy(&Context, Entities, Count);
+    
+    if (ResultCount < BENCHMARK_RESULT_MAX) Results[ResultCount++] = (BenchmarkResult){ .name = "mutation_apply_create_add", .ops = Ops, .time = Time };
+}
+
+static void BenchmarkTick(size_t WorkerCount)
+{
+    const size_t GroupCount = sizeof(Groups) / sizeof(*Groups);
+    ECSExecutionGroup State[GroupCount];
+    uint8_t ExecState[GroupCount][10];
+    
+    memset(ExecState, 0, sizeof(ExecState));
+    
+    for (size_t Loop = 0; Loop < GroupCount; Loop++)
+    {
+        State[Loop] = (ECSExecutionGroup){
+            .executing = 0,
+            .state = ExecState[Loop],
+            .time = 0,
+            .running = 0
+        };
+    }
+    
+    ECSTick(&Context, Groups, GroupCount, State, Groups[0].freq);
+    
+    const double Start = CCTimestamp();
+    for (size_t Loop = 0; Loop < BENCHMARK_TICK_COUNT; Loop++) ECSTick(&Context, Groups, GroupCount, State, Groups[0].freq);
+    
+    char Label[64];
+    snprintf(Label, sizeof(Label), "tick_empty_workers_%zu", WorkerCount);
+    BenchmarkRecord(Label, BENCHMARK_TICK_COUNT, Start);
+    
+    for (size_t Loop = 0; Loop < GroupCount; Loop++) ECSExecutionPlanDestroy(State[Loop].plan);
+}
+
+static void BenchmarkSetup(void)
+{
+    ECSComponentIDs = ComponentIDs;
+    
+    ECSArchetypeComponentIndexes = ArchetypeComponentIndexes;
+    
+    ECSArchetypeComponentSizes = ArchetypeComponentSizes;
+    ECSPackedComponentSizes = PackedComponentSizes;
+    ECSIndexedComponentSizes = IndexedComponentSizes;
+    ECSLocalComponentSizes = LocalComponentSizes;
+    ECSDuplicateArchetypeComponentSizes = DuplicateArchetypeComponentSizes;
+    ECSDuplicatePackedComponentSizes = DuplicatePackedComponentSizes;
+    ECSDuplicateIndexedComponentSizes = DuplicateIndexedComponentSizes;
+    ECSDuplicateLocalComponentSizes = DuplicateLocalComponentSizes;
+    
+    ECSArchetypeComponentDestructors = ArchetypeComponentDestructors;
+    ECSPackedComponentDestructors = PackedComponentDestructors;
+    ECSIndexedComponentDestructors = IndexedComponentDestructors;
+    ECSLocalComponentDestructors = LocalComponentDestructors;
+    ECSDuplicateArchetypeComponentDestructors = DuplicateArchetypeComponentDestructors;
+    ECSDuplicatePackedComponentDestructors = DuplicatePackedComponentDestructors;
+    ECSDuplicateIndexedComponentDestructors = DuplicateIndexedComponentDestructors;
+    ECSDuplicateLocalComponentDestructors = DuplicateLocalComponentDestructors;
+    
+    ECSMutableStateEntitiesMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateReplaceRegistryMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateAddLinkMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateRemoveLinkMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateAddComponentMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateRemoveComponentMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateCustomCallbackMax = BENCHMARK_MUTATION_MAX;
+    ECSMutableStateSharedDataMax = BENCHMARK_SHARED_DATA_MAX;
+    
+    ECSInit();
+    
+    Context.mutations = &MutableState;
+    
+    Context.manager.map = CCArrayCreate(CC_ALIGNED_ALLOCATOR(ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), CC_ALIGN(sizeof(ECSComponentRefs) + LOCAL_STORAGE_SIZE, ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), 16);
+    Context.manager.available = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), 16);
+    
+    ECSRegistryInit(&Context, CC_BIG_INT_FAST_0);
+    
+    ECSLinkMapInit(&Context);
+}
+
+static void BenchmarkPrint(size_t EntityCount)
+{
+    printf("{\n    \"entities\": %zu,\n    \"benchmarks\": [\n", EntityCount);
+    
+    for (size_t Loop = 0; Loop < ResultCount; Loop++)
+    {
+        const BenchmarkResult *Result = &Results[Loop];
+        const double NsPerOp = Result->ops ? (Result->time * 1e9) / (double)Result->ops : 0.0;
+        const double OpsPerSec = Result->time > 0.0 ? (double)Result->ops / Result->time : 0.0;
+        
+        printf("        { \"name\": \"%s\", \"ops\": %zu, \"time\": %.9f, \"ns_per_op\": %.3f, \"ops_per_sec\": %.3f }%s\n", Result->name, Result->ops, Result->time, NsPerOp, OpsPerSec, Loop + 1 < ResultCount ? "," : "");
+    }
+    
+    printf("    ]\n}\n");
+}
+
+int main(int argc, const char *argv[])
+{
+    const size_t EntityCount = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    const size_t WorkerMax = argc > 2 ? strtoull(argv[2], NULL, 10) : 8;
+    
+    if ((!EntityCount) || (!WorkerMax))
+    {
+        fprintf(stderr, "Usage: %s [entity count] [max worker count]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    BenchmarkSetup();
+    
+    ECSEntity *Entities;
+    CC_SAFE_Malloc(Entities, sizeof(ECSEntity) * EntityCount,
+                   fprintf(stderr, "Failed to allocate entities\n");
+                   return EXIT_FAILURE;
+                   );
+    
+    BenchmarkEntityCreateDestroy(Entities, EntityCount);
+    
+    BenchmarkComponent("archetype", Entities, EntityCount, COMP_A, sizeof(CompA));
+    BenchmarkComponent("packed", Entities, EntityCount, COMP_F, sizeof(CompF));
+    BenchmarkComponent("indexed", Entities, EntityCount, COMP_H, sizeof(CompH));
+    BenchmarkComponent("local", Entities, EntityCount, LOCAL_H, sizeof(LocalH));
+    BenchmarkComponent("duplicate", Entities, EntityCount, DUPLICATE_A, sizeof(DuplicateA));
+    BenchmarkComponent("archetype_tag", Entities, EntityCount, ARCH_TAG, 0);
+    BenchmarkComponent("packed_tag", Entities, EntityCount, PACKED_TAG, 0);
+    
+    BenchmarkLink(Entities, EntityCount);
+    BenchmarkRegistry(Entities, EntityCount);
+    BenchmarkMutation(Entities, EntityCount);
+    
+    for (size_t Loop = 1; Loop <= WorkerMax; Loop++)
+    {
+        if (!ECSWorkerCreate()) break;
+        
+        BenchmarkTick(Loop);
+    }
+    
+    CC_SAFE_Free(Entities);
+    
+    BenchmarkPrint(EntityCount);
+    
+    return EXIT_SUCCESS;
+}
@@ -57,7 +57,8 @@ options = {
     library: [],
     header: [],
     system: [],
-    define: []
+    define: [],
+    benchmark: []
 }
 target = true
 OptionParser.new do |opts|
@@ -87,6 +88,9 @@ OptionParser.new do |opts|
     opts.on('-D', '--define=DEFINE', String) { |define|
         options[:define] << define if target
     }
+    opts.on('-b', '--benchmark=SOURCE,[HEADERS]', Array) { |source, headers|
+        options[:benchmark] << [source, headers] if target
+    }
 end.parse!
 
 build_dir = ENV['BUILD_DIR'] || 'build'
@@ -182,4 +186,28 @@ else
     build += "    args = -shared #{os() == 'mac' ? "-install_name @rpath/#{output}" : ''}\n"
 end
 
+options[:benchmark].each { |source, headers|
+    benchmark_sources = Dir["#{source}/*.c"]
+    benchmark_headers = headers ? "-I#{parent_dir}/#{headers}".gsub(' ', '\$ ') : ''
+
+    benchmark_compile = benchmark_sources.map { |file|
+"""
+build #{file.gsub(/[\/ ]/, '_')}.o: cc #{parent_dir}/#{file.gsub(' ', '$ ')}
+    flags = $flags
+    headers = $headers #{benchmark_headers}
+    libs = $libs
+""".strip
+    }
+
+    benchmark_objects = benchmark_sources.map { |file| file.gsub(/[\/ ]/, '_') + '.o' }
+
+    build += """
+#{benchmark_compile.join("\n")}
+
+build #{project}/#{File.basename(source)}: ld #{benchmark_objects.join(' ')} #{objects.join(' ')}
+    libs = $libs
+    args = #{os() == 'linux' ? '-lpthread -lm' : ''}
+"""
+}
+
 File.write(build_dir + '/build.ninja', build)
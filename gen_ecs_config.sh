@@ -6,5 +6,13 @@ echo '#define CommonGameKit_ECSConfig_h' >> $file
 echo '' >> $file
 echo '#include <CommonGameKit/Base.h>' >> $file
 echo '' >> $file
+
+if [ "$ECS_ENTITY_32" = "1" ]; then
+    echo '#ifndef ECS_ENTITY_32' >> $file
+    echo '#define ECS_ENTITY_32 1' >> $file
+    echo '#endif' >> $file
+    echo '' >> $file
+fi
+
 ecs_tool config 20 >> $file
 echo '#endif' >> $file
@@ -1,8 +1,8 @@
 #!/bin/bash
 
-usage() { echo "Usage: $0 [-h] [-s] [-p] [-i]" 1>&2; exit 1; }
+usage() { echo "Usage: $0 [-h] [-s] [-p] [-i] [-b]" 1>&2; exit 1; }
 
-while getopts "hspi" opt; do
+while getopts "hspib" opt; do
     case "${opt}" in
         s)
             shallow=1
@@ -13,6 +13,9 @@ while getopts "hspi" opt; do
         i)
             internal=1
             ;;
+        b)
+            benchmark=1
+            ;;
         h|*)
             usage
             ;;
@@ -63,6 +66,7 @@ ruby build.rb \
 --platform=win \
 --library=deps/GL \
 --platform=linux \
---library=deps/GL
+--library=deps/GL \
+${benchmark:+--platform=any --benchmark=benchmarks/ECSBenchmark,CommonGameKitTests}
 cd "$build"
 ninja
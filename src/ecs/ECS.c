@@ -31,14 +31,85 @@
 #define ECS_SYSTEM_EXECUTOR_COMPONENT_MAX 16
 #endif
 
-#ifndef ECS_SYSTEM_EXECUTION_POOL_MAX
-#define ECS_SYSTEM_EXECUTION_POOL_MAX 1024
+#ifndef ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE
+#define ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE 64
 #endif
 
+#ifndef ECS_TICK_BUDGET_DEFERRAL_MAX
+#define ECS_TICK_BUDGET_DEFERRAL_MAX 4
+#endif
+
+#ifndef ECS_SNAPSHOT_BUFFER_SIZE
+#define ECS_SNAPSHOT_BUFFER_SIZE 65536
+#endif
+
+#ifndef ECS_WORKER_EXECUTOR_DEQUE_MAX
+#define ECS_WORKER_EXECUTOR_DEQUE_MAX 1024
+#endif
+
+_Static_assert((ECS_WORKER_EXECUTOR_DEQUE_MAX & (ECS_WORKER_EXECUTOR_DEQUE_MAX - 1)) == 0, "ECS_WORKER_EXECUTOR_DEQUE_MAX must be a power of 2");
+
 CC_ARRAY_DECLARE(ECSEntity);
 
+#if CC_HARDWARE_PTR_64
+typedef uint64_t ECSContextAccessFlag;
+#elif CC_HARDWARE_PTR_32
+typedef uint32_t ECSContextAccessFlag;
+#endif
+
+#ifndef ECS_ARCHETYPE_ACCESS_SLOT_MAX
+#define ECS_ARCHETYPE_ACCESS_SLOT_MAX 1024
+#endif
+
+#if ECS_ARCHETYPE_DISJOINT_ACCESS
+_Static_assert((ECS_ARCHETYPE_ACCESS_SLOT_MAX & (ECS_ARCHETYPE_ACCESS_SLOT_MAX - 1)) == 0, "ECS_ARCHETYPE_ACCESS_SLOT_MAX must be a power of 2");
+
+#define ECS_ACCESS_INDEX_MAX (ECS_COMPONENT_MAX + ECS_ARCHETYPE_ACCESS_SLOT_MAX)
+
+/*!
+ * @brief Get the access index of an archetype component in a specific archetype.
+ * @description The (component, archetype) pairs are hashed into @b ECS_ARCHETYPE_ACCESS_SLOT_MAX slots following the component indexes.
+ *              A collision will only cause two systems to be serialised unnecessarily.
+ *
+ * @param ComponentIndex The base index of the archetype component.
+ * @param Archetype The archetype offset.
+ * @return Returns the access index.
+ */
+static inline size_t ECSArchetypeAccessIndex(size_t ComponentIndex, size_t Archetype)
+{
+    const uint64_t Hash = ((uint64_t)Archetype * 0x9e3779b97f4a7c15ULL) ^ ((uint64_t)ComponentIndex * 0xc2b2ae3d27d4eb4fULL);
+    
+    return ECS_COMPONENT_MAX + ((Hash >> 32) & (ECS_ARCHETYPE_ACCESS_SLOT_MAX - 1));
+}
+#else
+#define ECS_ACCESS_INDEX_MAX ECS_COMPONENT_MAX
+#endif
+
+typedef struct {
+    size_t index;
+    ECSContextAccessFlag conflict;
+    ECSContextAccessFlag acquire;
+} ECSAccessMask;
+
+typedef struct {
+    struct {
+        const ECSAccessMask *masks;
+        size_t count;
+    } access;
+    struct {
+        const size_t *indexes;
+        size_t count;
+    } components, successors;
+} ECSExecutionPlanSystem;
+
+struct ECSExecutionPlan {
+    size_t count;
+    ECSExecutionPlanSystem systems[];
+};
+
 typedef struct {
     const ECSSystemAccess *access;
+    const ECSExecutionPlanSystem *system;
     ECSTime time;
     ECSSystemUpdateCallback update;
     struct {
@@ -48,24 +119,43 @@ typedef struct {
     ECSRange range;
     ECSExecutionGroup *executionGroup;
     ECSContext *context;
+    ECSSystemChunk *chunk;
+    struct ECSTickState *tick;
+#if ECS_STATISTICS
+    ECSSystemStatistics *statistics;
+#endif
+#if ECS_CHANGE_VERSION
+    ECSChangeVersion version;
+#endif
 } ECSSystemExecutor;
 
-#define CC_TYPE_ECSSystemExecutor(...) ECSSystemExecutor
-#define CC_TYPE_0_ECSSystemExecutor CC_TYPE_ECSSystemExecutor,
-
-#define CC_PRESERVE_CC_TYPE_ECSSystemExecutor CC_TYPE_ECSSystemExecutor
-
-#define CC_TYPE_DECL_ECSSystemExecutor(...) ECSSystemExecutor, __VA_ARGS__
-#define CC_TYPE_DECL_0_ECSSystemExecutor CC_TYPE_DECL_ECSSystemExecutor,
-
-#define CC_MANGLE_TYPE_0_ECSSystemExecutor ECSSystemExecutor
-
-#define T ECSSystemExecutor
-#include <CommonC/ConcurrentPool.h>
+/*
+ * Each worker has its own executor deque. Ticks are the producers (pushing to the bottom), while every worker (including the owner)
+ * consumes by stealing from the top. Workers will first take from their own deque before stealing from the other deques. As multiple
+ * ticks may be running concurrently, a producer must hold the deque's producer flag while pushing. If every deque is full the tick will
+ * steal and execute executors itself until there's room.
+ */
+typedef struct {
+    _Alignas(CC_HARDWARE_CACHE_LINE) _Atomic(size_t) top;
+    _Alignas(CC_HARDWARE_CACHE_LINE) _Atomic(size_t) bottom;
+    atomic_flag producer;
+    _Alignas(CC_HARDWARE_CACHE_LINE) ECSSystemExecutor executors[ECS_WORKER_EXECUTOR_DEQUE_MAX];
+} ECSExecutorDeque;
 
-static CCConcurrentPool(ECSSystemExecutor, ECS_SYSTEM_EXECUTION_POOL_MAX) ExecutorPool = CC_CONCURRENT_POOL_INIT;
+#ifndef ECS_MAIN_EXECUTOR_MAX
+#define ECS_MAIN_EXECUTOR_MAX 16
+#endif
 
-#define SystemExecutorPool ((CCConcurrentPool*)&ExecutorPool)
+typedef struct {
+    size_t next;
+    struct ECSTickState *tick;
+    ECSContextAccessFlag *accessFlags;
+    _Bool released;
+    struct {
+        size_t count;
+        ECSSystemExecutor executors[ECS_MAIN_EXECUTOR_MAX];
+    } main;
+} ECSExecutorStage;
 
 #ifndef ECS_COMPONENT_ACCESS_RELEASE_MAX
 #define ECS_COMPONENT_ACCESS_RELEASE_MAX 16
@@ -74,7 +164,7 @@ static CCConcurrentPool(ECSSystemExecutor, ECS_SYSTEM_EXECUTION_POOL_MAX) Execut
 typedef struct {
     size_t count;
     struct {
-        const ECSSystemAccess *access;
+        const ECSExecutionPlanSystem *system;
         ECSExecutionGroup *executionGroup;
     } release[ECS_COMPONENT_ACCESS_RELEASE_MAX];
 } ECSComponentAccessRelease;
@@ -87,6 +177,100 @@ int ECSWorker(ECSWorkerID WorkerID);
 
 static ECSWorkerID WorkerThreadCount = 0;
 
+static ECSExecutorDeque ExecutorDeques[ECS_WORKER_THREAD_MAX];
+
+static void ECSExecutorStageDrain(ECSExecutorStage *Stage);
+static void ECSExecutorStageRunMain(ECSExecutorStage *Stage);
+
+static void ECSExecutorPush(const ECSSystemExecutor *Executor, ECSExecutorStage *Stage)
+{
+    for ( ; ; )
+    {
+        _Bool Contended = FALSE;
+        
+        for (size_t Loop = 0; Loop < WorkerThreadCount; Loop++)
+        {
+            ECSExecutorDeque *Deque = &ExecutorDeques[Stage->next];
+            Stage->next = (Stage->next + 1) % WorkerThreadCount;
+            
+            // Rather than wait on another tick pushing to this deque, try the next one
+            if (atomic_flag_test_and_set_explicit(&Deque->producer, memory_order_acquire))
+            {
+                Contended = TRUE;
+                
+                continue;
+            }
+            
+            const size_t Bottom = atomic_load_explicit(&Deque->bottom, memory_order_relaxed);
+            const size_t Top = atomic_load_explicit(&Deque->top, memory_order_acquire);
+            
+            if ((Bottom - Top) < ECS_WORKER_EXECUTOR_DEQUE_MAX)
+            {
+                Deque->executors[Bottom & (ECS_WORKER_EXECUTOR_DEQUE_MAX - 1)] = *Executor;
+                atomic_thread_fence(memory_order_release);
+                atomic_store_explicit(&Deque->bottom, Bottom + 1, memory_order_relaxed);
+                atomic_flag_clear_explicit(&Deque->producer, memory_order_release);
+                
+                return;
+            }
+            
+            atomic_flag_clear_explicit(&Deque->producer, memory_order_release);
+        }
+        
+        // Every deque is full, so help drain them rather than drop the executor (the tick is already waiting on it)
+        if (!Contended) ECSExecutorStageDrain(Stage);
+    }
+}
+
+static _Bool ECSExecutorSteal(ECSExecutorDeque *Deque, ECSSystemExecutor *Executor)
+{
+    for ( ; ; )
+    {
+        size_t Top = atomic_load_explicit(&Deque->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        const size_t Bottom = atomic_load_explicit(&Deque->bottom, memory_order_acquire);
+        
+        if (Top >= Bottom) return FALSE;
+        
+        *Executor = Deque->executors[Top & (ECS_WORKER_EXECUTOR_DEQUE_MAX - 1)];
+        
+        if (atomic_compare_exchange_strong_explicit(&Deque->top, &Top, Top + 1, memory_order_seq_cst, memory_order_relaxed)) return TRUE;
+    }
+}
+
+/*!
+ * @brief Retrieve an executor for the worker.
+ * @description Takes from the worker's own deque first, before trying the other deques starting from a random victim. All deques will be
+ *              checked before failing.
+ *
+ * @param WorkerID The worker retrieving the executor.
+ * @param Seed The worker's random state.
+ * @param Executor The executor to be set.
+ * @return Returns TRUE if an executor was retrieved, otherwise FALSE.
+ */
+static _Bool ECSExecutorPop(ECSWorkerID WorkerID, uint32_t *Seed, ECSSystemExecutor *Executor)
+{
+    if (ECSExecutorSteal(&ExecutorDeques[WorkerID], Executor)) return TRUE;
+    
+    const size_t Count = WorkerThreadCount;
+    
+    if (Count > 1)
+    {
+        uint32_t Random = *Seed;
+        Random ^= Random << 13;
+        Random ^= Random >> 17;
+        Random ^= Random << 5;
+        *Seed = Random;
+        
+        for (size_t Loop = 0, Victim = Random % Count; Loop < Count; Loop++, Victim = (Victim + 1) % Count)
+        {
+            if ((Victim != WorkerID) && (ECSExecutorSteal(&ExecutorDeques[Victim], Executor))) return TRUE;
+        }
+    }
+    
+    return FALSE;
+}
+
 _Bool ECSWorkerCreate(void)
 {
     CCAssertLog(WorkerThreadCount < ECS_WORKER_THREAD_MAX, "Increase size of ECS_WORKER_THREAD_MAX");
@@ -111,1668 +295,4972 @@ static void ECSSpinWait(ECSWorkerID ID)
 
 ECSWaitingCallback ECSWaiting = ECSSpinWait;
 
-const size_t *ECSArchetypeComponentIndexes;
+size_t ECSWorkerSpinBudget = 4096;
 
-static ECSComponentAccessRelease AccessReleases[ECS_WORKER_THREAD_MAX][3];
-static _Alignas(CC_HARDWARE_CACHE_LINE) struct {
-    _Atomic(uint8_t) index;
-#if ECS_ACCESS_RELEASE_INDEX_PAD_TO_CACHE_LINE
-    uint8_t pad[CC_ALIGN(sizeof(_Atomic(uint8_t)), CC_HARDWARE_CACHE_LINE) - sizeof(_Atomic(uint8_t))];
-#endif
-} AccessReleaseIndex[ECS_WORKER_THREAD_MAX] = {ATOMIC_VAR_INIT(0)};
+size_t ECSWorkerParkThreshold = 0;
 
-int ECSWorker(ECSWorkerID WorkerID)
+static mtx_t WorkerParkLock;
+static cnd_t WorkerParkCondition;
+static _Atomic(size_t) ParkedWorkerCount = ATOMIC_VAR_INIT(0);
+static size_t WorkerWakeCount = 0;
+static ECSWorkerParkCounters WorkerParkCounters = { .park = 0, .wake = 0 };
+
+/*!
+ * @brief Announce that the worker intends to park.
+ * @description The worker must attempt to retrieve work once more after announcing, before it can wait. This guarantees that any work
+ *              committed by the tick after the announcement will either be seen by the worker or will result in a wake.
+ *
+ * @return Returns TRUE if the worker may park, otherwise FALSE if it should continue spinning.
+ */
+static _Bool ECSWorkerAnnouncePark(void)
 {
-    const size_t * const ArchetypeComponentIndexes = ECSArchetypeComponentIndexes;
-    size_t LocalAccessReleaseIndex = 1;
+    mtx_lock(&WorkerParkLock);
+    
+    const size_t Parked = atomic_load_explicit(&ParkedWorkerCount, memory_order_relaxed);
+    const _Bool Park = (Parked + ECSWorkerParkThreshold) < WorkerThreadCount;
+    
+    if (Park) atomic_store_explicit(&ParkedWorkerCount, Parked + 1, memory_order_relaxed);
+    
+    mtx_unlock(&WorkerParkLock);
+    
+    atomic_thread_fence(memory_order_seq_cst);
+    
+    return Park;
+}
+
+static void ECSWorkerCancelPark(void)
+{
+    mtx_lock(&WorkerParkLock);
+    
+    const size_t Parked = atomic_load_explicit(&ParkedWorkerCount, memory_order_relaxed) - 1;
+    atomic_store_explicit(&ParkedWorkerCount, Parked, memory_order_relaxed);
+    
+    if (WorkerWakeCount > Parked) WorkerWakeCount = Parked;
+    
+    mtx_unlock(&WorkerParkLock);
+}
+
+static void ECSWorkerPark(void)
+{
+    mtx_lock(&WorkerParkLock);
+    
+    WorkerParkCounters.park++;
+    
+    while (!WorkerWakeCount) cnd_wait(&WorkerParkCondition, &WorkerParkLock);
+    
+    WorkerWakeCount--;
+    atomic_store_explicit(&ParkedWorkerCount, atomic_load_explicit(&ParkedWorkerCount, memory_order_relaxed) - 1, memory_order_relaxed);
+    
+    mtx_unlock(&WorkerParkLock);
+}
+
+/*!
+ * @brief Wake parked workers.
+ * @description Must be called after the work has been committed to the pool.
+ * @param Count The maximum number of workers to wake.
+ */
+static void ECSWorkerWake(size_t Count)
+{
+    atomic_thread_fence(memory_order_seq_cst);
     
-    for (ECSSystemExecutor *Executor; ; )
+    if ((Count) && (atomic_load_explicit(&ParkedWorkerCount, memory_order_relaxed)))
     {
-        if (CCConcurrentPoolPop_weak(SystemExecutorPool, &Executor, ECS_SYSTEM_EXECUTION_POOL_MAX))
-        {
-            const ECSSystemAccess *Access = Executor->access;
-            
-            for (size_t Count = Access->read.count + Access->write.count; Count > (ECS_COMPONENT_ACCESS_RELEASE_MAX - AccessReleases[WorkerID][LocalAccessReleaseIndex].count); )
-            {
-                ECSWaiting(WorkerID);
-                
-                LocalAccessReleaseIndex = atomic_exchange_explicit(&AccessReleaseIndex[WorkerID].index, LocalAccessReleaseIndex, memory_order_consume);
-            }
-            
-            const size_t ArchCount = Executor->archetype.count;
-            const ECSSystemUpdateCallback Callback = Executor->update;
-            ECSContext * const Context = Executor->context;
-            const ECSTime Time = Executor->time;
-            const size_t * const ComponentOffsets = Access->component.offsets;
-            const ECSRange Range = Executor->range;
-            
-            if (ArchCount)
-            {
-                for (size_t Loop = 0; Loop < ArchCount; Loop++)
-                {
-                    const ECSArchetypePointer *ArchPointer = &Access->archetype.pointer[Executor->archetype.offset + Loop];
-                    ECSArchetype *Archetype = (void*)Executor->context + ArchPointer->archetype;
-                    
-                    if ((Archetype->entities) && (CCArrayGetCount(Archetype->entities)))
-                    {
-                        Callback(Context, Archetype, ArchetypeComponentIndexes + ArchPointer->componentIndexes, ComponentOffsets, Range, Time);
-                    }
-                }
-            }
-            
-            else
-            {
-                Callback(Context, NULL, NULL, ComponentOffsets, Range, Time);
-            }
-            
-            const size_t Index = AccessReleases[WorkerID][LocalAccessReleaseIndex].count++;
-            AccessReleases[WorkerID][LocalAccessReleaseIndex].release[Index].access = Access;
-            AccessReleases[WorkerID][LocalAccessReleaseIndex].release[Index].executionGroup = Executor->executionGroup;
-            
-            atomic_thread_fence(memory_order_release);
-            LocalAccessReleaseIndex = atomic_exchange_explicit(&AccessReleaseIndex[WorkerID].index, LocalAccessReleaseIndex, memory_order_consume);
-        }
+        mtx_lock(&WorkerParkLock);
         
-        else
-        {
-            ECSWaiting(WorkerID);
-            
-            if (AccessReleases[WorkerID][LocalAccessReleaseIndex].count)
-            {
-                LocalAccessReleaseIndex = atomic_exchange_explicit(&AccessReleaseIndex[WorkerID].index, LocalAccessReleaseIndex, memory_order_consume);
-            }
-        }
+        const size_t Wake = CCMin(Count, atomic_load_explicit(&ParkedWorkerCount, memory_order_relaxed) - WorkerWakeCount);
+        
+        WorkerWakeCount += Wake;
+        WorkerParkCounters.wake += Wake;
+        
+        for (size_t Loop = 0; Loop < Wake; Loop++) cnd_signal(&WorkerParkCondition);
+        
+        mtx_unlock(&WorkerParkLock);
     }
+}
+
+ECSWorkerParkCounters ECSWorkerGetParkCounters(void)
+{
+    mtx_lock(&WorkerParkLock);
     
-    return 0;
+    const ECSWorkerParkCounters Counters = WorkerParkCounters;
+    
+    mtx_unlock(&WorkerParkLock);
+    
+    return Counters;
 }
 
-static size_t LocalAccessReleaseIndexes[ECS_WORKER_THREAD_MAX];
+#ifndef ECS_WORKER_TASK_DEQUE_MAX
+#define ECS_WORKER_TASK_DEQUE_MAX 256
+#endif
 
-size_t ECSSharedMemorySize = 1048576;
+_Static_assert((ECS_WORKER_TASK_DEQUE_MAX & (ECS_WORKER_TASK_DEQUE_MAX - 1)) == 0, "ECS_WORKER_TASK_DEQUE_MAX must be a power of 2");
 
-CCMemoryZone ECSSharedZone;
+typedef struct {
+    ECSTaskCallback callback;
+    void *data;
+    ECSRange range;
+    ECSTaskGroup *group;
+} ECSTask;
 
-void ECSInit(void)
+/*
+ * Each worker has its own task deque. Unlike the executor deques the owning worker is the producer, it pushes and takes from the bottom
+ * while other workers steal from the top.
+ */
+typedef struct {
+    _Alignas(CC_HARDWARE_CACHE_LINE) _Atomic(size_t) top;
+    _Alignas(CC_HARDWARE_CACHE_LINE) _Atomic(size_t) bottom;
+    _Alignas(CC_HARDWARE_CACHE_LINE) ECSTask tasks[ECS_WORKER_TASK_DEQUE_MAX];
+} ECSTaskDeque;
+
+static ECSTaskDeque TaskDeques[ECS_WORKER_THREAD_MAX];
+
+/*
+ * Tasks forked from threads that aren't workers are pushed to the injection deque. Its producers are serialised by the flag, while the
+ * workers steal from it the same as they do from each other's deques.
+ */
+static ECSTaskDeque InjectedTasks;
+static atomic_flag InjectedTasksProducer = ATOMIC_FLAG_INIT;
+
+static _Thread_local ECSWorkerID CurrentWorkerID = (ECSWorkerID)-1;
+static _Thread_local uint32_t TaskSeed = 1;
+
+static _Bool ECSTaskDequePush(ECSTaskDeque *Deque, const ECSTask *Task)
 {
-    for (size_t Loop = 0; Loop < ECS_WORKER_THREAD_MAX; Loop++) LocalAccessReleaseIndexes[Loop] = 2;
+    const size_t Bottom = atomic_load_explicit(&Deque->bottom, memory_order_relaxed);
+    const size_t Top = atomic_load_explicit(&Deque->top, memory_order_acquire);
     
-    ECSSharedZone = CCMemoryZoneCreate(CC_STD_ALLOCATOR, ECSSharedMemorySize);
+    if ((Bottom - Top) >= ECS_WORKER_TASK_DEQUE_MAX) return FALSE;
+    
+    Deque->tasks[Bottom & (ECS_WORKER_TASK_DEQUE_MAX - 1)] = *Task;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&Deque->bottom, Bottom + 1, memory_order_relaxed);
+    
+    return TRUE;
 }
 
-#if CC_HARDWARE_PTR_64
-typedef uint64_t ECSContextAccessFlag;
-#elif CC_HARDWARE_PTR_32
-typedef uint32_t ECSContextAccessFlag;
-#endif
-
-typedef enum {
-    ECSSystemStatusDeferred,
-    ECSSystemStatusRunning,
-    ECSSystemStatusCompleted
-} ECSSystemStatus;
+/*!
+ * @brief Push a task so it can be executed by the workers.
+ * @description Workers push to their own task deque, any other thread pushes to the injection deque.
+ * @param Task The task to be pushed.
+ * @return Returns TRUE if the task was pushed, otherwise FALSE if it should be executed immediately.
+ */
+static _Bool ECSTaskPush(const ECSTask *Task)
+{
+    if (CurrentWorkerID != (ECSWorkerID)-1) return ECSTaskDequePush(&TaskDeques[CurrentWorkerID], Task);
+    
+    if (!WorkerThreadCount) return FALSE;
+    
+    while (atomic_flag_test_and_set_explicit(&InjectedTasksProducer, memory_order_acquire)) ECSWaiting(-1);
+    
+    const _Bool Pushed = ECSTaskDequePush(&InjectedTasks, Task);
+    
+    atomic_flag_clear_explicit(&InjectedTasksProducer, memory_order_release);
+    
+    return Pushed;
+}
 
-static ECSSystemStatus ECSSubmitSystem(ECSContext *Context, ECSTime Time, size_t SystemIndex, const ECSSystemRange *Range, const ECSSystemAccess *Access, const ECSSystemUpdate *Update, ECSContextAccessFlag *AccessFlags, uint16_t *Refs, uint8_t *Block, uint8_t BlockBit, ECSExecutionGroup *State, CCConcurrentPoolStage *Stage)
+static _Bool ECSTaskTake(ECSWorkerID WorkerID, ECSTask *Task)
 {
-    for (size_t Loop = 0, IdCount = Access[SystemIndex].read.count; Loop < IdCount; Loop++)
+    ECSTaskDeque *Deque = &TaskDeques[WorkerID];
+    
+    const size_t Bottom = atomic_load_explicit(&Deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&Deque->bottom, Bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t Top = atomic_load_explicit(&Deque->top, memory_order_relaxed);
+    
+    _Bool Taken = FALSE;
+    if (Top <= Bottom)
     {
-        const size_t ComponentIndex = ECSComponentBaseIndex(Access[SystemIndex].read.ids[Loop]);
-        const size_t AccessFlagByteIndex = (ComponentIndex * 2) / (sizeof(ECSContextAccessFlag) * 8);
+        *Task = Deque->tasks[Bottom & (ECS_WORKER_TASK_DEQUE_MAX - 1)];
+        Taken = TRUE;
         
-        if ((AccessFlags[AccessFlagByteIndex] >> ((ComponentIndex * 2) % (sizeof(ECSContextAccessFlag) * 8))) & 1) return ECSSystemStatusDeferred;
+        if (Top != Bottom) return TRUE;
+        
+        Taken = atomic_compare_exchange_strong_explicit(&Deque->top, &Top, Top + 1, memory_order_seq_cst, memory_order_relaxed);
     }
     
-    for (size_t Loop = 0, IdCount = Access[SystemIndex].write.count; Loop < IdCount; Loop++)
+    atomic_store_explicit(&Deque->bottom, Bottom + 1, memory_order_relaxed);
+    
+    return Taken;
+}
+
+static _Bool ECSTaskSteal(ECSTaskDeque *Deque, ECSTask *Task)
+{
+    for ( ; ; )
     {
-        const size_t ComponentIndex = ECSComponentBaseIndex(Access[SystemIndex].write.ids[Loop]);
-        const size_t AccessFlagByteIndex = (ComponentIndex * 2) / (sizeof(ECSContextAccessFlag) * 8);
+        size_t Top = atomic_load_explicit(&Deque->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        const size_t Bottom = atomic_load_explicit(&Deque->bottom, memory_order_acquire);
+        
+        if (Top >= Bottom) return FALSE;
         
-        if ((AccessFlags[AccessFlagByteIndex] >> ((ComponentIndex * 2) % (sizeof(ECSContextAccessFlag) * 8))) & 3) return ECSSystemStatusDeferred;
+        *Task = Deque->tasks[Top & (ECS_WORKER_TASK_DEQUE_MAX - 1)];
+        
+        if (atomic_compare_exchange_strong_explicit(&Deque->top, &Top, Top + 1, memory_order_seq_cst, memory_order_relaxed)) return TRUE;
     }
+}
+
+/*!
+ * @brief Steal a task from any of the other workers.
+ * @description Starts from a random victim, all task deques (and then the injection deque) will be checked before failing.
+ * @param WorkerID The worker stealing the task, or -1 if it is not a worker.
+ * @param Seed The worker's random state.
+ * @param Task The task to be set.
+ * @return Returns TRUE if a task was stolen, otherwise FALSE.
+ */
+static _Bool ECSTaskStealAny(ECSWorkerID WorkerID, uint32_t *Seed, ECSTask *Task)
+{
+    const size_t Count = WorkerThreadCount;
     
-    *Block |= 1 << BlockBit;
+    if (!Count) return FALSE;
     
-    ECSSystemExecutor Executor = {
-        .access = &Access[SystemIndex],
-        .time = Time,
-        .update = ECS_SYSTEM_UPDATE_GET_UPDATE(Update[SystemIndex]),
-        .range = { 0, SIZE_MAX },
-        .executionGroup = State,
-        .context = Context
+    uint32_t Random = *Seed;
+    Random ^= Random << 13;
+    Random ^= Random >> 17;
+    Random ^= Random << 5;
+    *Seed = Random;
+    
+    for (size_t Loop = 0, Victim = Random % Count; Loop < Count; Loop++, Victim = (Victim + 1) % Count)
+    {
+        if ((Victim != WorkerID) && (ECSTaskSteal(&TaskDeques[Victim], Task))) return TRUE;
+    }
+    
+    return ECSTaskSteal(&InjectedTasks, Task);
+}
+
+static inline void ECSTaskRun(const ECSTask *Task)
+{
+    Task->callback(Task->data, Task->range);
+    
+    atomic_fetch_sub_explicit(&Task->group->pending, 1, memory_order_release);
+}
+
+void ECSTaskGroupRun(ECSTaskGroup *Group, ECSTaskCallback Callback, void *Data, ECSRange Range)
+{
+    CCAssertLog(Group, "Group must not be null");
+    CCAssertLog(Callback, "Callback must not be null");
+    
+    const ECSTask Task = {
+        .callback = Callback,
+        .data = Data,
+        .range = Range,
+        .group = Group
     };
     
-    const _Bool Parallel = ECS_SYSTEM_UPDATE_GET_PARALLEL(Update[SystemIndex]);
-    const size_t ArchCount = Access[SystemIndex].archetype.count;
-    size_t RefCount = 0;
+    atomic_fetch_add_explicit(&Group->pending, 1, memory_order_relaxed);
     
-    if (Parallel)
+    if (ECSTaskPush(&Task)) ECSWorkerWake(1);
+    else ECSTaskRun(&Task);
+}
+
+void ECSTaskGroupWait(ECSTaskGroup *Group)
+{
+    CCAssertLog(Group, "Group must not be null");
+    
+    const ECSWorkerID WorkerID = CurrentWorkerID;
+    
+    while (atomic_load_explicit(&Group->pending, memory_order_acquire))
+    {
+        ECSTask Task;
+        if (((WorkerID != (ECSWorkerID)-1) && (ECSTaskTake(WorkerID, &Task))) || (ECSTaskStealAny(WorkerID, &TaskSeed, &Task))) ECSTaskRun(&Task);
+        else ECSWaiting(WorkerID);
+    }
+}
+
+void ECSParallelFor(ECSTaskCallback Callback, void *Data, size_t Count, size_t ChunkSize)
+{
+    CCAssertLog(Callback, "Callback must not be null");
+    CCAssertLog(ChunkSize, "ChunkSize must not be 0");
+    
+    if (!Count) return;
+    
+    const size_t ChunkCount = ((Count - 1) / ChunkSize) + 1;
+    
+    if (ChunkCount == 1)
     {
-        const size_t ChunkSize = ECS_SYSTEM_UPDATE_GET_PARALLEL_CHUNK_SIZE(Update[SystemIndex]);
+        Callback(Data, (ECSRange){ .index = 0, .count = Count });
         
-        if (ECS_SYSTEM_UPDATE_GET_PARALLEL_ARCHETYPE(Update[SystemIndex]))
-        {
-            Executor.archetype.count = 1;
-            
-            if (ChunkSize < SIZE_MAX)
-            {
-                for (size_t Loop = 0; Loop < ArchCount; Loop++)
-                {
-                    const ECSArchetypePointer *ArchPointer = &Access->archetype.pointer[Loop];
-                    ECSArchetype *Archetype = (void*)Context + ArchPointer->archetype;
-                    
-                    size_t Count;
-                    if ((Archetype->entities) && (Count = CCArrayGetCount(Archetype->entities)))
-                    {
-                        const size_t ChunkCount = ((Count - 1) / ChunkSize) + 1;
-                        RefCount += ChunkCount;
-                        
-                        Executor.archetype.offset = Loop;
-                        
-                        for (size_t Loop2 = 0; Loop2 < ChunkCount; Loop2++)
-                        {
-                            const size_t Offset = Loop2 * ChunkSize;
-                            Executor.range = (ECSRange){
-                                .index = Offset,
-                                .count = CCMin(Count - Offset, ChunkSize)
-                            };
-                            
-                            CCConcurrentPoolStagePush(SystemExecutorPool, Executor, ECS_SYSTEM_EXECUTION_POOL_MAX, Stage);
-                        }
-                        
-                        State->running += ChunkCount;
-                    }
-                }
-            }
-            
-            else
-            {
-                RefCount = ArchCount;
-                
-                for (size_t Loop = 0; Loop < ArchCount; Loop++)
-                {
-                    Executor.archetype.offset = Loop;
-                    CCConcurrentPoolStagePush(SystemExecutorPool, Executor, ECS_SYSTEM_EXECUTION_POOL_MAX, Stage);
-                }
-                
-                State->running += ArchCount;
-            }
-        }
+        return;
+    }
+    
+    ECSTaskGroup Group = ECS_TASK_GROUP_INIT;
+    size_t Pushed = 0;
+    
+    for (size_t Loop = 1; Loop < ChunkCount; Loop++)
+    {
+        const size_t Offset = Loop * ChunkSize;
+        const ECSTask Task = {
+            .callback = Callback,
+            .data = Data,
+            .range = { .index = Offset, .count = CCMin(Count - Offset, ChunkSize) },
+            .group = &Group
+        };
         
-        else
+        atomic_fetch_add_explicit(&Group.pending, 1, memory_order_relaxed);
+        
+        if (ECSTaskPush(&Task)) Pushed++;
+        else ECSTaskRun(&Task);
+    }
+    
+    ECSWorkerWake(Pushed);
+    
+    Callback(Data, (ECSRange){ .index = 0, .count = CCMin(Count, ChunkSize) });
+    
+    ECSTaskGroupWait(&Group);
+}
+
+const size_t *ECSArchetypeComponentIndexes;
+
+#ifndef ECS_TICK_CONCURRENT_MAX
+#define ECS_TICK_CONCURRENT_MAX 4
+#endif
+
+/*
+ * Each concurrently running tick claims its own tick state, so the access releases of the executors it submitted are routed back to it.
+ * Releases are posted by sources, the first ECS_TICK_CONCURRENT_MAX sources are the other tick states (a tick may execute another tick's
+ * executors when the deques are full), followed by the workers.
+ */
+#define ECS_RELEASE_SOURCE_MAX (ECS_TICK_CONCURRENT_MAX + ECS_WORKER_THREAD_MAX)
+#define ECS_RELEASE_SOURCE_WORKER(id) (ECS_TICK_CONCURRENT_MAX + (id))
+
+typedef struct ECSTickState {
+    atomic_flag active;
+    ECSComponentAccessRelease releases[ECS_RELEASE_SOURCE_MAX][3];
+    _Alignas(CC_HARDWARE_CACHE_LINE) struct {
+        _Atomic(uint8_t) index;
+#if ECS_ACCESS_RELEASE_INDEX_PAD_TO_CACHE_LINE
+        uint8_t pad[CC_ALIGN(sizeof(_Atomic(uint8_t)), CC_HARDWARE_CACHE_LINE) - sizeof(_Atomic(uint8_t))];
+#endif
+    } releaseIndex[ECS_RELEASE_SOURCE_MAX];
+    size_t localReleaseIndexes[ECS_RELEASE_SOURCE_MAX];
+    size_t postReleaseIndexes[ECS_TICK_CONCURRENT_MAX];
+    uint16_t refs[ECS_ACCESS_INDEX_MAX];
+#if ECS_STATISTICS
+    _Atomic(ECSTime) busy[ECS_WORKER_THREAD_MAX];
+#endif
+} ECSTickState;
+
+static ECSTickState TickStates[ECS_TICK_CONCURRENT_MAX];
+
+#if ECS_STATISTICS
+static _Thread_local ECSWorkerStatistics WorkerStatistics[ECS_WORKER_THREAD_MAX];
+static _Thread_local ECSTickStatistics TickStatistics = { .time = 0, .workerCount = 0, .workers = NULL };
+
+ECSTickStatistics ECSTickGetStatistics(void)
+{
+    return TickStatistics;
+}
+#endif
+
+#if ECS_CHANGE_VERSION
+/*!
+ * @brief Stamp the archetype columns and the packed/indexed components a system executor has written to.
+ * @param Executor The executor that was executed.
+ * @param Archetype The archetype it was executed on, or NULL if the packed and indexed components should be stamped.
+ * @param ArchetypeComponentIndexes The archetype component indexes of the system for the archetype.
+ */
+static void ECSSystemExecutorStampWrites(const ECSSystemExecutor *Executor, ECSArchetype *Archetype, const size_t *ArchetypeComponentIndexes)
+{
+    const ECSSystemAccess *Access = Executor->access;
+    ECSContext * const Context = Executor->context;
+    
+    if (!Archetype)
+    {
+        for (size_t Loop = 0; Loop < Access->write.count; Loop++)
         {
-            CCArray Array = *(CCArray*)((void*)Context + ECS_SYSTEM_UPDATE_GET_PARALLEL_OFFSET(Update[SystemIndex]));
-            size_t Count;
+            const ECSComponentID ID = Access->write.ids[Loop];
             
-            if ((Array) && (Count = CCArrayGetCount(Array)))
+            switch (ID & ECSComponentStorageTypeMask)
             {
-                const size_t ChunkCount = ((Count - 1) / ChunkSize) + 1;
-                RefCount = ChunkCount;
-                
-                Executor.archetype.offset = 0;
-                Executor.archetype.count = ArchCount;
-                
-                for (size_t Loop2 = 0; Loop2 < ChunkCount; Loop2++)
-                {
-                    const size_t Offset = Loop2 * ChunkSize;
-                    Executor.range = (ECSRange){
-                        .index = Offset,
-                        .count = CCMin(Count - Offset, ChunkSize)
-                    };
+                case ECSComponentStorageTypePacked:
+                    atomic_store_explicit(&Context->packedVersions[ID & ~ECSComponentStorageMask], Executor->version, memory_order_relaxed);
+                    break;
                     
-                    CCConcurrentPoolStagePush(SystemExecutorPool, Executor, ECS_SYSTEM_EXECUTION_POOL_MAX, Stage);
-                }
-                
-                State->running += ChunkCount;
+                case ECSComponentStorageTypeIndexed:
+                    atomic_store_explicit(&Context->indexedVersions[ID & ~ECSComponentStorageMask], Executor->version, memory_order_relaxed);
+                    break;
             }
         }
         
-        if (!RefCount) return ECSSystemStatusCompleted;
+        return;
     }
     
-    else
-    {
-        RefCount = 1;
-        
-        Executor.archetype.offset = 0;
-        Executor.archetype.count = ArchCount;
-        CCConcurrentPoolStagePush(SystemExecutorPool, Executor, ECS_SYSTEM_EXECUTION_POOL_MAX, Stage);
-        
-        State->running++;
-    }
+    const size_t Count = CCArrayGetCount(Archetype->entities);
+    const size_t Start = Executor->range.index / Archetype->chunk;
+    const size_t End = (CCMin(Count, Executor->range.index + CCMin(Executor->range.count, Count)) + Archetype->chunk - 1) / Archetype->chunk;
+    const size_t Columns = CCArrayGetElementSize(Archetype->versions) / sizeof(ECSChangeVersion);
     
-    for (size_t Loop = 0, IdCount = Access[SystemIndex].read.count; Loop < IdCount; Loop++)
-    {
-        const size_t ComponentIndex = ECSComponentBaseIndex(Access[SystemIndex].read.ids[Loop]);
-        const size_t AccessFlagByteIndex = (ComponentIndex * 2) / (sizeof(ECSContextAccessFlag) * 8);
-        
-        AccessFlags[AccessFlagByteIndex] |= 2 << ((ComponentIndex * 2) % (sizeof(ECSContextAccessFlag) * 8));
-        Refs[ComponentIndex] += RefCount;
-    }
+    CCAssertLog(End <= CCArrayGetCount(Archetype->versions), "Archetype versions must cover all chunks");
     
-    for (size_t Loop = 0, IdCount = Access[SystemIndex].write.count; Loop < IdCount; Loop++)
+    size_t ArchetypeComponentCount = 0;
+    for (size_t Loop = 0; Loop < Access->read.count; Loop++) ArchetypeComponentCount += (Access->read.ids[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype;
+    for (size_t Loop = 0; Loop < Access->write.count; Loop++) ArchetypeComponentCount += (Access->write.ids[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype;
+    
+    // Archetype columns are ordered by component, so an index table ordered by component (across the read and write lists) must be ascending
+    for (size_t Loop = 1; Loop < ArchetypeComponentCount; Loop++)
     {
-        const size_t ComponentIndex = ECSComponentBaseIndex(Access[SystemIndex].write.ids[Loop]);
-        const size_t AccessFlagByteIndex = (ComponentIndex * 2) / (sizeof(ECSContextAccessFlag) * 8);
-        
-        AccessFlags[AccessFlagByteIndex] |= 1 << ((ComponentIndex * 2) % (sizeof(ECSContextAccessFlag) * 8));
-        Refs[ComponentIndex] += RefCount;
+        CCAssertLog(ArchetypeComponentIndexes[Loop - 1] < ArchetypeComponentIndexes[Loop], "Archetype component indexes must be ordered by component ID across the read and write access");
     }
     
-    return ECSSystemStatusRunning;
-}
-
-static inline void ECSReleaseAccessRefs(size_t Worker, uint16_t *Refs, ECSContextAccessFlag *AccessFlags)
-{
-    for (size_t Loop = 0, Count = AccessReleases[Worker][LocalAccessReleaseIndexes[Worker]].count; Loop < Count; Loop++)
+    for (size_t Loop = 0; Loop < Access->write.count; Loop++)
     {
-        const ECSSystemAccess *Access = AccessReleases[Worker][LocalAccessReleaseIndexes[Worker]].release[Loop].access;
+        const ECSComponentID ID = Access->write.ids[Loop];
         
-        for (size_t Loop2 = 0, IdCount = Access->read.count; Loop2 < IdCount; Loop2++)
+        if ((ID & ECSComponentStorageTypeMask) != ECSComponentStorageTypeArchetype) continue;
+        
+        // The system's archetype component indexes are ordered by component, so the rank of the component gives its position
+        size_t Rank = 0;
+        for (size_t Loop2 = 0; Loop2 < Access->read.count; Loop2++)
         {
-            const size_t ComponentIndex = ECSComponentBaseIndex(Access->read.ids[Loop2]);
-            const size_t AccessFlagByteIndex = (ComponentIndex * 2) / (sizeof(ECSContextAccessFlag) * 8);
-            
-            if (!--Refs[ComponentIndex]) AccessFlags[AccessFlagByteIndex] &= ~(3 << ((ComponentIndex * 2) % (sizeof(ECSContextAccessFlag) * 8)));
+            if (((Access->read.ids[Loop2] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype) && ((Access->read.ids[Loop2] & ~ECSComponentStorageMask) < (ID & ~ECSComponentStorageMask))) Rank++;
         }
         
-        for (size_t Loop2 = 0, IdCount = Access->write.count; Loop2 < IdCount; Loop2++)
+        for (size_t Loop2 = 0; Loop2 < Access->write.count; Loop2++)
         {
-            const size_t ComponentIndex = ECSComponentBaseIndex(Access->write.ids[Loop2]);
-            const size_t AccessFlagByteIndex = (ComponentIndex * 2) / (sizeof(ECSContextAccessFlag) * 8);
-            
-            if (!--Refs[ComponentIndex]) AccessFlags[AccessFlagByteIndex] &= ~(3 << ((ComponentIndex * 2) % (sizeof(ECSContextAccessFlag) * 8)));
+            if (((Access->write.ids[Loop2] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype) && ((Access->write.ids[Loop2] & ~ECSComponentStorageMask) < (ID & ~ECSComponentStorageMask))) Rank++;
         }
         
-        AccessReleases[Worker][LocalAccessReleaseIndexes[Worker]].release[Loop].executionGroup->running--;
+        const size_t Column = ArchetypeComponentIndexes[Rank];
+        ECSChangeVersion *Versions = CCArrayGetData(Archetype->versions);
+        
+        for (size_t Chunk = Start; Chunk < End; Chunk++)
+        {
+            atomic_store_explicit((_Atomic(ECSChangeVersion)*)&Versions[(Chunk * Columns) + Column], Executor->version, memory_order_relaxed);
+        }
     }
-    
-    AccessReleases[Worker][LocalAccessReleaseIndexes[Worker]].count = 0;
 }
+#endif
 
-void ECSTick(ECSContext *Context, const ECSGroup *Groups, size_t GroupCount, ECSExecutionGroup *State, ECSTime DeltaTime)
+/*!
+ * @brief Execute a system executor.
+ * @param Executor The executor to be executed.
+ * @param WorkerID The worker executing it, or -1 when the tick executes it.
+ * @param ArchetypeComponentIndexes The archetype component indexes.
+ * @return Returns the time taken to execute if it was timed, otherwise 0.
+ */
+static ECSTime ECSSystemExecutorRun(const ECSSystemExecutor *Executor, ECSWorkerID WorkerID, const size_t *ArchetypeComponentIndexes)
 {
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(Groups, "Groups must not be null");
-    CCAssertLog(State, "State must not be null");
-    
-    size_t RunGroupIndexes[GroupCount], RunCount = 0;
-    ECSTime GroupTimes[GroupCount];
+    const size_t ArchCount = Executor->archetype.count;
+    const ECSSystemUpdateCallback Callback = Executor->update;
+    ECSContext * const Context = Executor->context;
+    const ECSTime Time = Executor->time;
+    const size_t * const ComponentOffsets = Executor->access->component.offsets;
+    const ECSRange Range = Executor->range;
+    ECSSystemChunk * const Chunk = Executor->chunk;
+#if ECS_STATISTICS
+    ECSSystemStatistics * const Statistics = Executor->statistics;
+    const ECSTime Start = ECS_TIME_FROM_SECONDS(CCTimestamp());
+#else
+    const ECSTime Start = Chunk ? ECS_TIME_FROM_SECONDS(CCTimestamp()) : 0;
+#endif
     
-    for (size_t Loop = 0; Loop < GroupCount; Loop++)
+    if (ArchCount)
     {
-        State[Loop].running = 0;
-        
-        State[Loop].time += DeltaTime;
-        ECSTime Ticks = State[Loop].time / Groups[Loop].freq;
-        State[Loop].time -= Ticks * Groups[Loop].freq;
-        
-        if (Ticks)
+        for (size_t Loop = 0; Loop < ArchCount; Loop++)
         {
-            State[Loop].executing = 0;
-            RunGroupIndexes[RunCount++] = Loop;
+            const ECSArchetypePointer *ArchPointer = &Executor->access->archetype.pointer[Executor->archetype.offset + Loop];
+            ECSArchetype *Archetype = (void*)Context + ArchPointer->archetype;
             
-            if (!Groups[Loop].dynamic)
+            if ((Archetype->entities) && (CCArrayGetCount(Archetype->entities)))
             {
-                State[Loop].time += (Ticks - 1) * Groups[Loop].freq;
-                Ticks = 1;
+                Callback(Context, Archetype, ArchetypeComponentIndexes + ArchPointer->componentIndexes, ComponentOffsets, Range, Time);
+                
+#if ECS_CHANGE_VERSION
+                ECSSystemExecutorStampWrites(Executor, Archetype, ArchetypeComponentIndexes + ArchPointer->componentIndexes);
+#endif
             }
-            
-            GroupTimes[Loop] = Ticks * Groups[Loop].freq;
         }
+    }
+    
+    else
+    {
+        Callback(Context, NULL, NULL, ComponentOffsets, Range, Time);
+    }
+    
+#if ECS_CHANGE_VERSION
+    ECSSystemExecutorStampWrites(Executor, NULL, NULL);
+#endif
+    
+#if ECS_STATISTICS
+    const ECSTime Elapsed = ECS_TIME_FROM_SECONDS(CCTimestamp()) - Start;
+    
+    if (Statistics)
+    {
+        atomic_fetch_add_explicit(&Statistics->time, Elapsed, memory_order_relaxed);
+        atomic_store_explicit(&Statistics->worker, WorkerID, memory_order_relaxed);
+    }
+    
+    if (Chunk)
+    {
+        atomic_fetch_add_explicit(&Chunk->time, Elapsed, memory_order_relaxed);
+        atomic_fetch_add_explicit(&Chunk->count, Range.count, memory_order_relaxed);
+    }
+    
+    return Elapsed;
+#else
+    if (Chunk)
+    {
+        const ECSTime Elapsed = ECS_TIME_FROM_SECONDS(CCTimestamp()) - Start;
         
-        else State[Loop].executing = SIZE_MAX;
+        atomic_fetch_add_explicit(&Chunk->time, Elapsed, memory_order_relaxed);
+        atomic_fetch_add_explicit(&Chunk->count, Range.count, memory_order_relaxed);
+        
+        return Elapsed;
     }
     
-    CCConcurrentPoolStage Stage = CCConcurrentPoolStageBegin(SystemExecutorPool);
+    return 0;
+#endif
+}
+
+int ECSWorker(ECSWorkerID WorkerID)
+{
+    const size_t * const ArchetypeComponentIndexes = ECSArchetypeComponentIndexes;
+    const size_t Source = ECS_RELEASE_SOURCE_WORKER(WorkerID);
+    size_t LocalAccessReleaseIndexes[ECS_TICK_CONCURRENT_MAX];
+    size_t IdleCount = 0;
     
-    size_t TargetIndex = 0;
+    for (size_t Loop = 0; Loop < ECS_TICK_CONCURRENT_MAX; Loop++) LocalAccessReleaseIndexes[Loop] = 1;
+    _Bool Parking = FALSE;
     
-    ECSContextAccessFlag AccessFlags[((ECS_COMPONENT_MAX * 2) / (sizeof(ECSContextAccessFlag) * 8)) + 1] = {0};
+    uint32_t Seed = (uint32_t)WorkerID + 1;
     
-    static uint16_t Refs[ECS_COMPONENT_MAX];
+    CurrentWorkerID = WorkerID;
+    TaskSeed = Seed;
     
-    while (RunCount)
+    for (ECSSystemExecutor Work, *Executor = &Work; ; )
     {
-        for (size_t Loop = 0; Loop < RunCount; Loop++)
+        ECSTask Task;
+        
+        if (ECSExecutorPop(WorkerID, &Seed, Executor))
         {
-            const size_t Index = RunGroupIndexes[Loop];
-            const size_t Priority = State[Index].executing;
+            if (Parking)
+            {
+                ECSWorkerCancelPark();
+                Parking = FALSE;
+            }
+            
+            IdleCount = 0;
+            
+            const ECSSystemAccess *Access = Executor->access;
+            ECSTickState * const Tick = Executor->tick;
+            size_t * const LocalAccessReleaseIndex = &LocalAccessReleaseIndexes[Tick - TickStates];
             
-            if ((Groups[Index].priorities.deps[Priority].group == SIZE_MAX) || (Groups[Index].priorities.deps[Priority].priority < State[Groups[Index].priorities.deps[Priority].group].executing))
+            for (size_t Count = Access->read.count + Access->write.count; Count > (ECS_COMPONENT_ACCESS_RELEASE_MAX - Tick->releases[Source][*LocalAccessReleaseIndex].count); )
             {
-                const ECSSystemRange *Range = &Groups[Index].priorities.systems.range[Priority];
-                const uint8_t *Graph = &Groups[Index].priorities.systems.graphs[Range->index];
-                const ECSSystemAccess *Access = &Groups[Index].priorities.systems.access[Range->index];
-                const ECSSystemUpdate *Update = &Groups[Index].priorities.systems.update[Range->index];
-                
-                const size_t SystemCount = Range->count;
-                const size_t BlockCount = (SystemCount + 7) / 8;
-                
-                _Bool Completed = TRUE;
-                for (size_t Loop2 = 0; Loop2 < BlockCount; Loop2++)
-                {
-                    const uint8_t Block = State[Index].state[Loop2];
-                    const size_t BitCount = (Loop2 + 1 != BlockCount ? 8 : (8 - ((BlockCount * 8) - SystemCount)));
-                    
-                    if (Block != (0xff >> (8 - BitCount)))
-                    {
-                        for (size_t Loop3 = 0; Loop3 < BitCount; Loop3++)
-                        {
-                            if (!((Block >> Loop3) & 1))
-                            {
-                                const size_t SystemIndex = Loop3 + (Loop2 * 8);
-                                
-                                switch (ECSSubmitSystem(Context, GroupTimes[Index], SystemIndex, Range, Access, Update, AccessFlags, Refs, &State[Index].state[Loop2], Loop3, &State[Index], &Stage))
-                                {
-                                    case ECSSystemStatusRunning:
-                                        Completed = FALSE;
-                                        
-                                        for (size_t Loop4 = 0; Loop4 < BlockCount; Loop4++)
-                                        {
-                                            const size_t ColIndex = (SystemIndex * BlockCount) + Loop4;
-                                            const uint8_t GraphBlock = Graph[ColIndex];
-                                            uint8_t *Block = &State[Index].state[Loop4];
-                                            const size_t BitCount = (Loop4 + 1 != BlockCount ? 8 : (8 - ((BlockCount * 8) - SystemCount)));
-                                            const uint8_t RunBlock = ~*Block & GraphBlock;
-                                            
-                                            if (RunBlock)
-                                            {
-                                                for (size_t Loop5 = 0; Loop5 < BitCount; Loop5++)
-                                                {
-                                                    if ((RunBlock >> Loop5) & 1)
-                                                    {
-                                                        const size_t SystemIndex = Loop5 + (Loop4 * 8);
-                                                        
-                                                        ECSSubmitSystem(Context, GroupTimes[Index], SystemIndex, Range, Access, Update, AccessFlags, Refs, Block, Loop5, &State[Index], &Stage);
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        
-                                        goto FinishedRow;
-                                        
-                                    case ECSSystemStatusCompleted:
-                                        Completed = TRUE;
-                                        break;
-                                        
-                                    case ECSSystemStatusDeferred:
-                                        Completed = FALSE;
-                                        break;
-                                }
-                            }
-                        }
-                    }
-                }
-                
-            FinishedRow:;
+                ECSWaiting(WorkerID);
                 
-                if (Completed)
-                {
-                    if (!State[Index].running)
-                    {
-                        if (++State[Index].executing >= Groups[Index].priorities.count)
-                        {
-                            RunGroupIndexes[Loop] = RunGroupIndexes[--RunCount];
-                        }
-                        
-                        memset(State[Index].state, 0, BlockCount);
-                        
-                        Loop = -1;
-                        continue;
-                    }
-                }
+                *LocalAccessReleaseIndex = atomic_exchange_explicit(&Tick->releaseIndex[Source].index, *LocalAccessReleaseIndex, memory_order_consume);
             }
+            
+#if ECS_STATISTICS
+            atomic_fetch_add_explicit(&Tick->busy[WorkerID], ECSSystemExecutorRun(Executor, WorkerID, ArchetypeComponentIndexes), memory_order_relaxed);
+#else
+            ECSSystemExecutorRun(Executor, WorkerID, ArchetypeComponentIndexes);
+#endif
+            
+            const size_t Index = Tick->releases[Source][*LocalAccessReleaseIndex].count++;
+            Tick->releases[Source][*LocalAccessReleaseIndex].release[Index].system = Executor->system;
+            Tick->releases[Source][*LocalAccessReleaseIndex].release[Index].executionGroup = Executor->executionGroup;
+            
+            atomic_thread_fence(memory_order_release);
+            *LocalAccessReleaseIndex = atomic_exchange_explicit(&Tick->releaseIndex[Source].index, *LocalAccessReleaseIndex, memory_order_consume);
         }
         
-        CCConcurrentPoolStageCommit(SystemExecutorPool, &Stage);
-        
-        atomic_signal_fence(memory_order_release); // MARK: implicitly use CCConcurrentPoolStageCommit's release barrier, if it changes then replace this with atomic_thread_fence(memory_order_release)
-        
-        if (!RunCount)
+        else if ((ECSTaskTake(WorkerID, &Task)) || (ECSTaskStealAny(WorkerID, &Seed, &Task)))
         {
-        WaitForWorkers:;
-            size_t RunningCount = 0;
-            for (size_t Loop = 0; Loop < GroupCount; Loop++)
+            if (Parking)
             {
-                RunningCount += State[Loop].running;
+                ECSWorkerCancelPark();
+                Parking = FALSE;
             }
             
-            if (!RunningCount) goto Finished;
-        }
-        
-        while (!AccessReleases[TargetIndex][(LocalAccessReleaseIndexes[TargetIndex] = atomic_exchange_explicit(&AccessReleaseIndex[TargetIndex].index, LocalAccessReleaseIndexes[TargetIndex], memory_order_consume))].count)
-        {
-            ECSWaiting(-1);
+            IdleCount = 0;
             
-            TargetIndex = (TargetIndex + 1) % WorkerThreadCount;
+            ECSTaskRun(&Task);
         }
         
-        ECSReleaseAccessRefs(TargetIndex, Refs, AccessFlags);
-        
-        for (size_t Loop = 1; Loop < WorkerThreadCount; Loop++)
+        else
         {
-            const size_t Index = (TargetIndex + Loop) % WorkerThreadCount;
-            LocalAccessReleaseIndexes[Index] = atomic_exchange_explicit(&AccessReleaseIndex[Index].index, LocalAccessReleaseIndexes[Index], memory_order_consume);
+            ECSWaiting(WorkerID);
+            
+            _Bool Pending = FALSE;
+            for (size_t Loop = 0; Loop < ECS_TICK_CONCURRENT_MAX; Loop++)
+            {
+                if (TickStates[Loop].releases[Source][LocalAccessReleaseIndexes[Loop]].count)
+                {
+                    LocalAccessReleaseIndexes[Loop] = atomic_exchange_explicit(&TickStates[Loop].releaseIndex[Source].index, LocalAccessReleaseIndexes[Loop], memory_order_consume);
+                    Pending = TRUE;
+                }
+            }
+            
+            if (Pending) continue;
+            
+            if (Parking)
+            {
+                ECSWorkerPark();
+                
+                Parking = FALSE;
+                IdleCount = 0;
+            }
             
-            ECSReleaseAccessRefs(Index, Refs, AccessFlags);
+            else if (++IdleCount > ECSWorkerSpinBudget)
+            {
+                Parking = ECSWorkerAnnouncePark();
+                IdleCount = 0;
+            }
         }
-        
-        if (!RunCount) goto WaitForWorkers;
     }
     
-Finished:;
+    return 0;
 }
 
-static inline void ECSEntityInit(ECSContext *Context, size_t BaseIndex, size_t Count, ECSEntity *Entities)
+size_t ECSSharedMemorySize = 1048576;
+
+CCMemoryZone ECSSharedZone;
+
+void ECSInit(void)
 {
-    for (size_t Loop = 0; Loop < Count; Loop++)
+    for (size_t Loop = 0; Loop < ECS_TICK_CONCURRENT_MAX; Loop++)
     {
-        const size_t Index = BaseIndex + Loop;
-        
-        Entities[Loop] = Index;
-        
-        ECSComponentRefs *Ref = CCArrayGetElementAtIndex(Context->manager.map, Index);
-        Ref->archetype.ptr = NULL;
-        Ref->archetype.index = 0;
-        Ref->archetype.component.count = 0;
-        
-#if ECS_ARCHETYPE_COMPONENT_ID_SIMD_LOOKUP && CC_HARDWARE_VECTOR_SUPPORT_SSSE3
-#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
-        memset(Ref->archetype.component.ids, INT8_MAX, sizeof(Ref->archetype.component.ids));
-#else
-        memset(Ref->archetype.component.ids, UINT8_MAX, sizeof(Ref->archetype.component.ids));
-#endif
-#endif
+        atomic_flag_clear_explicit(&TickStates[Loop].active, memory_order_relaxed);
         
-        CC_BITS_INIT_CLEAR(Ref->has);
+        for (size_t Loop2 = 0; Loop2 < ECS_RELEASE_SOURCE_MAX; Loop2++) TickStates[Loop].localReleaseIndexes[Loop2] = 2;
+        for (size_t Loop2 = 0; Loop2 < ECS_TICK_CONCURRENT_MAX; Loop2++) TickStates[Loop].postReleaseIndexes[Loop2] = 1;
     }
-}
-
-void ECSEntityCreate(ECSContext *Context, ECSEntity *Entities, size_t Count)
-{
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(Entities, "Entities must not be null");
-    
-    size_t FreeCount = CCArrayGetCount(Context->manager.available);
     
-    if (FreeCount < Count)
+    for (size_t Loop = 0; Loop < ECS_WORKER_THREAD_MAX; Loop++)
     {
-        const size_t AppendCount = Count - FreeCount;
-        const size_t Index = CCArrayAppendElements(Context->manager.map, NULL, AppendCount);
-        
-        Count = Count - AppendCount;
-        
-        ECSEntityInit(Context, Index, AppendCount, Entities + Count);
+        atomic_init(&TaskDeques[Loop].top, 1);
+        atomic_init(&TaskDeques[Loop].bottom, 1);
     }
     
-    for (size_t Loop = 0; Loop < Count; Loop++)
-    {
-        const size_t FreeIndex = --FreeCount;
-        const size_t *Index = CCArrayGetElementAtIndex(Context->manager.available, FreeIndex);
-        CCArrayRemoveElementAtIndex(Context->manager.available, FreeIndex);
-        
-        ECSEntityInit(Context, *Index, 1, &Entities[Loop]);
-    }
+    atomic_init(&InjectedTasks.top, 1);
+    atomic_init(&InjectedTasks.bottom, 1);
+    
+    ECSSharedZone = CCMemoryZoneCreate(CC_STD_ALLOCATOR, ECSSharedMemorySize);
+    
+    mtx_init(&WorkerParkLock, mtx_plain);
+    cnd_init(&WorkerParkCondition);
 }
 
-const ECSComponentID *ECSComponentIDs;
+ECSTime ECSSystemChunkTargetTimeMin = ECS_TIME_FROM_MICROSECONDS(20);
 
-void ECSEntityDestroy(ECSContext *Context, const ECSEntity *Entities, size_t Count)
+ECSTime ECSSystemChunkTargetTimeMax = ECS_TIME_FROM_MICROSECONDS(50);
+
+ECSTime ECSTickBudget = 0;
+
+#define ECS_SYSTEM_CHUNK_COST_SHIFT 8
+
+/*!
+ * @brief Pick the chunk size for an adaptive system.
+ * @description The per entity cost is measured from the executors of the previous ticks of the system. The chunk size is only changed
+ *              when the estimated time of a chunk falls outside of the target time range.
+ *
+ * @param Chunk The chunk state of the system.
+ * @return Returns the chunk size.
+ */
+static size_t ECSSystemChunkAdapt(ECSSystemChunk *Chunk)
 {
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(Entities, "Entities must not be null");
+    if (!Chunk->size) Chunk->size = ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE;
     
-    size_t Offset = 0;
-    for (size_t Loop = 0; Loop < Count; Loop++)
+    const size_t Count = atomic_exchange_explicit(&Chunk->count, 0, memory_order_relaxed);
+    const ECSTime Time = atomic_exchange_explicit(&Chunk->time, 0, memory_order_relaxed);
+    
+    if (Count)
     {
-        if (!ECSEntityIsAlive(Context, Entities[Loop]))
-        {
-            const size_t SegmentCount = Loop - Offset;
-            if (SegmentCount) CCArrayAppendElements(Context->manager.available, Entities + Offset, SegmentCount);
-            
-            Offset = Loop + 1;
-            
-            continue;
-        }
-        
-        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Loop]);
-        CCBitsSet(Refs->has, ECSHasBitEntityDestroyed);
+        const ECSTime Cost = CCMax((Time << ECS_SYSTEM_CHUNK_COST_SHIFT) / Count, 1);
         
-        ECSLinkRemoveAllLinksForEntity(Context, Entities[Loop]);
+        Chunk->cost = Chunk->cost ? ((Chunk->cost * 3) + Cost) / 4 : Cost;
         
-        ECSComponentID IDs[32];
-        size_t ComponentCount = 0;
-        const size_t BlockSize = CC_BITS_BLOCK_SIZE(Refs->has);
+        const ECSTime Estimate = (Chunk->size * Chunk->cost) >> ECS_SYSTEM_CHUNK_COST_SHIFT;
         
-        for (size_t Loop2 = 0; Loop2 < ECS_COMPONENT_MAX; Loop2 += BlockSize)
+        if ((Estimate < ECSSystemChunkTargetTimeMin) || (Estimate > ECSSystemChunkTargetTimeMax))
         {
-            if (CCBitsAny(Refs->has, Loop2, BlockSize))
-            {
-                for (size_t Loop3 = 0; Loop3 < BlockSize; Loop3++)
-                {
-                    const size_t Index = Loop2 + Loop3;
-                    
-                    if (CCBitsGet(Refs->has, Index))
-                    {
-                        if (ComponentCount == (sizeof(IDs) / sizeof(*IDs)))
-                        {
-                            ECSEntityRemoveComponents(Context, Entities[Loop], IDs, ComponentCount);
-                            ComponentCount = 0;
-                        }
-                        
-                        IDs[ComponentCount++] = ECSComponentIDs[Index] & ~ECSComponentStorageModifierDuplicate;
-                    }
-                }
-            }
+            const ECSTime Target = (ECSSystemChunkTargetTimeMin + ECSSystemChunkTargetTimeMax) / 2;
+            
+            Chunk->size = CCMax((Target << ECS_SYSTEM_CHUNK_COST_SHIFT) / Chunk->cost, 1);
         }
-        
-        if (ComponentCount) ECSEntityRemoveComponents(Context, Entities[Loop], IDs, ComponentCount);
-        
-        ECSRegistryDeregister(Context, Entities[Loop]);
     }
     
-    const size_t SegmentCount = Count - Offset;
-    if (SegmentCount) CCArrayAppendElements(Context->manager.available, Entities + Offset, SegmentCount);
+    return Chunk->size;
 }
 
-void ECSDuplicateDestructor(void *Data, ECSComponentID ID)
+size_t ECSSystemGetChunkSize(const ECSGroup *Group, const ECSExecutionGroup *State, size_t SystemIndex)
 {
-    CCAssertLog(Data, "Data must not be null");
+    CCAssertLog(Group, "Group must not be null");
+    CCAssertLog(State, "State must not be null");
     
-    const size_t Index = (ID & ~ECSComponentStorageMask);
-    ECSComponentDestructor Destructor = NULL;
+    const ECSSystemUpdate Update = Group->priorities.systems.update[SystemIndex];
     
-    switch (ID & ECSComponentStorageTypeMask)
+    if (!ECS_SYSTEM_UPDATE_GET_PARALLEL(Update)) return SIZE_MAX;
+    
+    if (ECS_SYSTEM_UPDATE_GET_PARALLEL_ADAPTIVE(Update))
     {
-        case ECSComponentStorageTypeArchetype:
-            Destructor = ECSDuplicateArchetypeComponentDestructors[Index];
-            break;
-            
-        case ECSComponentStorageTypePacked:
-            Destructor = ECSDuplicatePackedComponentDestructors[Index];
-            break;
-            
-        case ECSComponentStorageTypeIndexed:
-            Destructor = ECSDuplicateIndexedComponentDestructors[Index];
-            break;
-            
-        case ECSComponentStorageTypeLocal:
-            Destructor = ECSDuplicateLocalComponentDestructors[ECSLocalComponentIndex(ID)];
-            break;
-            
-        default:
-            CCAssertLog(0, "Unsupported component type");
-            break;
+        if (!State->chunks) return ECS_SYSTEM_CHUNK_ADAPTIVE;
+        
+        return State->chunks[SystemIndex].size ? State->chunks[SystemIndex].size : ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE;
     }
     
-    CCArray Duplicates = *(CCArray*)Data;
+    return ECS_SYSTEM_UPDATE_GET_PARALLEL_CHUNK_SIZE(Update);
+}
+
+#define ECS_ACCESS_FLAG_INDEX(index) (((index) * 2) / (sizeof(ECSContextAccessFlag) * 8))
+#define ECS_ACCESS_FLAG_SHIFT(index) (((index) * 2) % (sizeof(ECSContextAccessFlag) * 8))
+
+static void ECSExecutionPlanAddAccess(ECSExecutionPlanSystem *System, ECSAccessMask *Masks, size_t *Indexes, size_t AccessIndex, ECSContextAccessFlag Conflict, ECSContextAccessFlag Acquire)
+{
+    const size_t Index = ECS_ACCESS_FLAG_INDEX(AccessIndex);
+    const size_t Shift = ECS_ACCESS_FLAG_SHIFT(AccessIndex);
+    
+    Indexes[System->components.count++] = AccessIndex;
     
-    if (Destructor)
+    for (size_t Loop = 0; Loop < System->access.count; Loop++)
     {
-        for (size_t Loop = 0, Count = CCArrayGetCount(Duplicates); Loop < Count; Loop++)
+        if (Masks[Loop].index == Index)
         {
-            Destructor(CCArrayGetElementAtIndex(Duplicates, Loop), ID);
+            Masks[Loop].conflict |= Conflict << Shift;
+            Masks[Loop].acquire |= Acquire << Shift;
+            
+            return;
         }
     }
     
-    CCArrayDestroy(Duplicates);
+    Masks[System->access.count++] = (ECSAccessMask){
+        .index = Index,
+        .conflict = Conflict << Shift,
+        .acquire = Acquire << Shift
+    };
 }
 
-void ECSEntityGetComponents(ECSContext *Context, ECSEntity Entity, ECSTypedComponent *Components, size_t *Count)
+static void ECSExecutionPlanAddComponentAccess(ECSExecutionPlanSystem *System, ECSAccessMask *Masks, size_t *Indexes, const ECSSystemAccess *Access, ECSComponentID ID, ECSContextAccessFlag Conflict, ECSContextAccessFlag Acquire)
 {
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(Count, "Count must not be null");
+    const size_t ComponentIndex = ECSComponentBaseIndex(ID);
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-    
-    size_t ComponentCount = 0;
-    const size_t BlockSize = CC_BITS_BLOCK_SIZE(Refs->has);
-    
-    for (size_t Loop2 = 0; Loop2 < ECS_COMPONENT_MAX; Loop2 += BlockSize)
+#if ECS_ARCHETYPE_DISJOINT_ACCESS
+    if ((ID & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype)
     {
-        if (CCBitsAny(Refs->has, Loop2, BlockSize))
+        for (size_t Loop = 0; Loop < Access->archetype.count; Loop++)
         {
-            for (size_t Loop3 = 0; Loop3 < BlockSize; Loop3++)
-            {
-                const size_t Index = Loop2 + Loop3;
-                
-                if (CCBitsGet(Refs->has, Index))
-                {
-                    if ((Components) && (ComponentCount < *Count))
-                    {
-                        const ECSComponentID ID = ECSComponentIDs[Index];
-                        
-                        Components[ComponentCount] = (ECSTypedComponent){
-                            .id = ID,
-                            .data = ECSEntityGetComponent(Context, Entity, ID) // TODO: Optimise this by handling archetype separate to the loop (loop only has to start for components after archetype max)
-                        };
-                    }
-                    
-                    if (ComponentCount++ >= *Count) return;
-                }
-            }
+            ECSExecutionPlanAddAccess(System, Masks, Indexes, ECSArchetypeAccessIndex(ComponentIndex, Access->archetype.pointer[Loop].archetype), Conflict, Acquire);
         }
+        
+        return;
     }
+#endif
     
-    *Count = ComponentCount;
+    ECSExecutionPlanAddAccess(System, Masks, Indexes, ComponentIndex, Conflict, Acquire);
 }
 
-const size_t *ECSArchetypeComponentSizes;
-const size_t *ECSPackedComponentSizes;
-const size_t *ECSIndexedComponentSizes;
-const size_t *ECSLocalComponentSizes;
-const size_t *ECSDuplicateArchetypeComponentSizes;
-const size_t *ECSDuplicatePackedComponentSizes;
-const size_t *ECSDuplicateIndexedComponentSizes;
-const size_t *ECSDuplicateLocalComponentSizes;
-
-const ECSComponentDestructor *ECSArchetypeComponentDestructors;
-const ECSComponentDestructor *ECSPackedComponentDestructors;
-const ECSComponentDestructor *ECSIndexedComponentDestructors;
-const ECSComponentDestructor *ECSLocalComponentDestructors;
-const ECSComponentDestructor *ECSDuplicateArchetypeComponentDestructors;
-const ECSComponentDestructor *ECSDuplicatePackedComponentDestructors;
-const ECSComponentDestructor *ECSDuplicateIndexedComponentDestructors;
-const ECSComponentDestructor *ECSDuplicateLocalComponentDestructors;
-
-static size_t SortedAdd(ECSArchetypeComponentID *Elements, size_t Count, ECSArchetypeComponentID Value)
+static size_t ECSExecutionPlanAccessCount(const ECSSystemAccess *Access)
 {
-    for (size_t Loop = Count; Loop--; )
+#if ECS_ARCHETYPE_DISJOINT_ACCESS
+    size_t Count = 0;
+    
+    for (size_t Loop = 0; Loop < Access->read.count; Loop++)
     {
-        if (Elements[Loop] > Value) Elements[Loop + 1] = Elements[Loop];
-        else
-        {
-            Elements[Loop + 1] = Value;
-            
-            return Loop + 1;
-        }
+        Count += (Access->read.ids[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype ? Access->archetype.count : 1;
     }
     
-    Elements[0] = Value;
+    for (size_t Loop = 0; Loop < Access->write.count; Loop++)
+    {
+        Count += (Access->write.ids[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype ? Access->archetype.count : 1;
+    }
     
-    return 0;
+    return Count;
+#else
+    return Access->read.count + Access->write.count;
+#endif
 }
 
-static inline size_t FindIndex(const ECSArchetypeComponentID *Elements, size_t Count, ECSArchetypeComponentID Max, ECSArchetypeComponentID Value)
+/*!
+ * @brief Compile the execution plan for a group.
+ * @description The plan precomputes the access flag masks each system conflicts with and acquires, the access indexes whose refs
+ *              each system holds, and the list of successors from each system's graph row.
+ *
+ * @param Group The group to compile the plan for.
+ * @return Returns the plan. This must be destroyed with @b ECSExecutionPlanDestroy.
+ */
+static ECSExecutionPlan *ECSExecutionPlanCreate(const ECSGroup *Group)
 {
-    size_t Offset = 0;
+    size_t SystemCount = 0, ComponentCount = 0, SuccessorCount = 0;
     
-    if (Value >= (Max / 2))
+    for (size_t Loop = 0; Loop < Group->priorities.count; Loop++)
     {
-        const size_t Reverse = (Max - Value) + 1;
+        const ECSSystemRange *Range = &Group->priorities.systems.range[Loop];
+        const uint8_t *Graph = &Group->priorities.systems.graphs[Range->index];
+        const size_t BlockCount = (Range->count + 7) / 8;
         
-        if (Reverse < Count)
+        SystemCount = CCMax(SystemCount, Range->index + Range->count);
+        
+        for (size_t Loop2 = 0; Loop2 < Range->count; Loop2++)
         {
-            Offset = Count - Reverse;
-            Count = Reverse;
+            const ECSSystemAccess *Access = &Group->priorities.systems.access[Range->index + Loop2];
+            
+            ComponentCount += ECSExecutionPlanAccessCount(Access);
+            
+            for (size_t Loop3 = 0; Loop3 < BlockCount; Loop3++)
+            {
+                const size_t BitCount = (Loop3 + 1 != BlockCount ? 8 : (8 - ((BlockCount * 8) - Range->count)));
+                
+                SuccessorCount += CCBitCountSet((uint8_t)(Graph[(Loop2 * BlockCount) + Loop3] & (0xff >> (8 - BitCount))));
+            }
         }
     }
     
-    else if (Value < Count) Count = Value + 1;
+    ECSExecutionPlan *Plan = CCMalloc(CC_STD_ALLOCATOR, sizeof(ECSExecutionPlan) + (sizeof(ECSExecutionPlanSystem) * SystemCount) + (sizeof(ECSAccessMask) * ComponentCount) + (sizeof(size_t) * (ComponentCount + SuccessorCount)), NULL, CC_DEFAULT_ERROR_CALLBACK);
     
-    Elements += Offset;
+    Plan->count = SystemCount;
+    memset(Plan->systems, 0, sizeof(ECSExecutionPlanSystem) * SystemCount);
     
-    for (size_t Loop = 0; Loop < Count; Loop++)
+    ECSAccessMask *Masks = (ECSAccessMask*)&Plan->systems[SystemCount];
+    size_t *Indexes = (size_t*)&Masks[ComponentCount];
+    
+    for (size_t Loop = 0; Loop < Group->priorities.count; Loop++)
     {
-        if (Elements[Loop] == Value) return Loop + Offset;
-        else if (Elements[Loop] > Value) break;
+        const ECSSystemRange *Range = &Group->priorities.systems.range[Loop];
+        const uint8_t *Graph = &Group->priorities.systems.graphs[Range->index];
+        const size_t BlockCount = (Range->count + 7) / 8;
+        
+        for (size_t Loop2 = 0; Loop2 < Range->count; Loop2++)
+        {
+            const ECSSystemAccess *Access = &Group->priorities.systems.access[Range->index + Loop2];
+            ECSExecutionPlanSystem *System = &Plan->systems[Range->index + Loop2];
+            
+            System->access.masks = Masks;
+            System->components.indexes = Indexes;
+            
+            for (size_t Loop3 = 0; Loop3 < Access->read.count; Loop3++)
+            {
+                ECSExecutionPlanAddComponentAccess(System, Masks, Indexes, Access, Access->read.ids[Loop3], 1, 2);
+            }
+            
+            for (size_t Loop3 = 0; Loop3 < Access->write.count; Loop3++)
+            {
+                ECSExecutionPlanAddComponentAccess(System, Masks, Indexes, Access, Access->write.ids[Loop3], 3, 1);
+            }
+            
+            Masks += System->access.count;
+            Indexes += System->components.count;
+            
+            System->successors.indexes = Indexes;
+            
+            for (size_t Loop3 = 0; Loop3 < BlockCount; Loop3++)
+            {
+                const size_t BitCount = (Loop3 + 1 != BlockCount ? 8 : (8 - ((BlockCount * 8) - Range->count)));
+                const uint8_t GraphBlock = Graph[(Loop2 * BlockCount) + Loop3];
+                
+                for (size_t Loop4 = 0; Loop4 < BitCount; Loop4++)
+                {
+                    if ((GraphBlock >> Loop4) & 1) Indexes[System->successors.count++] = Loop4 + (Loop3 * 8);
+                }
+            }
+            
+            Indexes += System->successors.count;
+        }
     }
     
-    return SIZE_MAX;
+    return Plan;
 }
 
-static size_t SortedSub(ECSArchetypeComponentID *Elements, size_t Count, ECSArchetypeComponentID Value)
+void ECSExecutionPlanDestroy(ECSExecutionPlan *Plan)
 {
-#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
-    ECSArchetypeComponentID CurrentID = INT8_MAX;
-#else
-    ECSArchetypeComponentID CurrentID = UINT8_MAX;
+    CCAssertLog(Plan, "Plan must not be null");
+    
+    CCFree(Plan);
+}
+
+typedef enum {
+    ECSSystemStatusDeferred,
+    ECSSystemStatusRunning,
+    ECSSystemStatusCompleted
+} ECSSystemStatus;
+
+static ECSSystemStatus ECSSubmitSystem(ECSContext *Context, ECSTime Time, size_t SystemIndex, const ECSSystemRange *Range, const ECSSystemAccess *Access, const ECSSystemUpdate *Update, ECSContextAccessFlag *AccessFlags, ECSTickState *Tick, uint8_t *Block, uint8_t BlockBit, ECSExecutionGroup *State, ECSExecutorStage *Stage, size_t *SubmitCount)
+{
+#if ECS_STATISTICS
+    ECSSystemStatistics *Statistics = State->statistics ? &State->statistics[Range->index + SystemIndex] : NULL;
 #endif
     
-    for (size_t Loop = Count; Loop--; )
+    const ECSExecutionPlanSystem *System = &State->plan->systems[Range->index + SystemIndex];
+    
+    for (size_t Loop = 0, MaskCount = System->access.count; Loop < MaskCount; Loop++)
     {
-        ECSArchetypeComponentID Temp = Elements[Loop];
-        Elements[Loop] = CurrentID;
-        CurrentID = Temp;
-        
-        if (CurrentID == Value) return Loop;
+        if (AccessFlags[System->access.masks[Loop].index] & System->access.masks[Loop].conflict) goto Deferred;
     }
     
-    Elements[0] = CurrentID;
+    const _Bool Main = ECS_SYSTEM_UPDATE_GET_MAIN(Update[SystemIndex]);
     
-    return 0;
-}
-
-static void ArchetypeRemove(ECSContext *Context, ECSArchetype *Arch, size_t Count, size_t Index)
-{
-    const size_t LastIndex = CCArrayGetCount(Arch->components[0]) - 1;
-    if (Index != LastIndex)
+    if ((Main) && (Stage->main.count == ECS_MAIN_EXECUTOR_MAX))
     {
-        for (size_t Loop = 0; Loop < Count; Loop++)
-        {
-            const void *Data = CCArrayGetElementAtIndex(Arch->components[Loop], LastIndex);
-            CCArrayReplaceElementAtIndex(Arch->components[Loop], Index, Data);
-            CCArrayRemoveElementAtIndex(Arch->components[Loop], LastIndex);
-        }
-        
-        const ECSEntity *Entity = CCArrayGetElementAtIndex(Arch->entities, LastIndex);
-        CCArrayReplaceElementAtIndex(Arch->entities, Index, Entity);
-        CCArrayRemoveElementAtIndex(Arch->entities, LastIndex);
+        // Only this thread can run the waiting main thread executors, so hand the workers what has been submitted and run them now
+        ECSWorkerWake(*SubmitCount);
+        *SubmitCount = 0;
         
-        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, *Entity);
-        Refs->archetype.index = Index;
+        ECSExecutorStageRunMain(Stage);
     }
     
-    else
+    *Block |= 1 << BlockBit;
+    
+    ECSSystemExecutor Executor = {
+        .access = &Access[SystemIndex],
+        .system = System,
+        .time = Time,
+        .update = ECS_SYSTEM_UPDATE_GET_UPDATE(Update[SystemIndex]),
+        .range = { 0, SIZE_MAX },
+        .executionGroup = State,
+        .context = Context,
+        .chunk = NULL,
+        .tick = Tick,
+#if ECS_CHANGE_VERSION
+        .version = atomic_fetch_add_explicit(&Context->version, 1, memory_order_relaxed) + 1
+#endif
+    };
+    
+#if ECS_STATISTICS
+    Executor.statistics = Statistics;
+    
+    if (Statistics)
     {
-        for (size_t Loop = 0; Loop < Count; Loop++)
+        Statistics->blocked = Statistics->blockedStart ? ECS_TIME_FROM_SECONDS(CCTimestamp()) - Statistics->blockedStart : 0;
+        Statistics->blockedStart = 0;
+        atomic_store_explicit(&Statistics->time, 0, memory_order_relaxed);
+        atomic_store_explicit(&Statistics->worker, (ECSWorkerID)-1, memory_order_relaxed);
+    }
+#endif
+    
+    const _Bool Parallel = !Main && ECS_SYSTEM_UPDATE_GET_PARALLEL(Update[SystemIndex]);
+    const size_t ArchCount = Access[SystemIndex].archetype.count;
+    size_t RefCount = 0, ChunkSize = SIZE_MAX;
+    CCArray Array = NULL;
+    
+    if (Parallel)
+    {
+        ChunkSize = ECS_SYSTEM_UPDATE_GET_PARALLEL_CHUNK_SIZE(Update[SystemIndex]);
+        
+        if (ECS_SYSTEM_UPDATE_GET_PARALLEL_ADAPTIVE(Update[SystemIndex]))
         {
-            CCArrayRemoveElementAtIndex(Arch->components[Loop], LastIndex);
+            if (State->chunks)
+            {
+                Executor.chunk = &State->chunks[Range->index + SystemIndex];
+                ChunkSize = ECSSystemChunkAdapt(Executor.chunk);
+            }
+            
+            else ChunkSize = ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE;
         }
         
-        CCArrayRemoveElementAtIndex(Arch->entities, LastIndex);
+        if (ECS_SYSTEM_UPDATE_GET_PARALLEL_ARCHETYPE(Update[SystemIndex]))
+        {
+            if (ChunkSize < SIZE_MAX)
+            {
+                for (size_t Loop = 0; Loop < ArchCount; Loop++)
+                {
+                    ECSArchetype *Archetype = (void*)Context + Executor.access->archetype.pointer[Loop].archetype;
+                    
+                    size_t Count;
+                    if ((Archetype->entities) && (Count = CCArrayGetCount(Archetype->entities)))
+                    {
+                        RefCount += ((Count - 1) / (ChunkSize == ECS_SYSTEM_CHUNK_ARCHETYPE ? Archetype->chunk : ChunkSize)) + 1;
+                    }
+                }
+            }
+            
+            else RefCount = ArchCount;
+        }
+        
+        else
+        {
+            Array = *(CCArray*)((void*)Context + ECS_SYSTEM_UPDATE_GET_PARALLEL_OFFSET(Update[SystemIndex]));
+            
+            size_t Count;
+            if ((Array) && (Count = CCArrayGetCount(Array))) RefCount = ((Count - 1) / ChunkSize) + 1;
+        }
+        
+#if ECS_STATISTICS
+        if (Statistics) Statistics->executors = RefCount;
+#endif
+        
+        if (!RefCount) return ECSSystemStatusCompleted;
     }
-}
-
-static size_t ArchtypeIndex(const ECSArchetypeComponentID *set, size_t n)
-{
-    size_t result = 0;
-    size_t factorial = 1;
     
-    for (size_t i = 0; i < n; i++)
+    else
     {
-        factorial *= (i + 1) * 1;
-
-        size_t p = 1;
-        for (size_t j = 0; j <= i; j++)
-        {
-            p *= (set[i] - j);
-        }
-
-        result += p / factorial;
+        RefCount = 1;
+        
+#if ECS_STATISTICS
+        if (Statistics) Statistics->executors = 1;
+#endif
     }
-
-    return result;
-}
-
-#define ECS_ARCHETYPE_OFFSET(x, index) { offsetof(ECSContext, archetypes##index), sizeof(ECSArchetype(index)) }
-#define ECS_ARCHETYPE_INIT_OFFSETS(count) CC_REPEAT(1, count, ECS_ARCHETYPE_OFFSET)
-
-static const struct {
-    ptrdiff_t base;
-    ptrdiff_t size;
-} ArchetypeOffset[ECS_ARCHETYPE_MAX + 1] = {
-    { 0, 0 },
-    ECS_ARCHETYPE_INIT_OFFSETS(ECS_ARCHETYPE_MAX)
-};
-
-void ECSArchetypeAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
-{
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    // Access is acquired before any executor is pushed, as pushing may process the access releases of executors that have already finished
+    for (size_t Loop = 0, MaskCount = System->access.count; Loop < MaskCount; Loop++)
+    {
+        AccessFlags[System->access.masks[Loop].index] |= System->access.masks[Loop].acquire;
+    }
     
-    const size_t CompIndex = ID & ~ECSComponentStorageMask;
+    for (size_t Loop = 0, ComponentCount = System->components.count; Loop < ComponentCount; Loop++)
+    {
+        Tick->refs[System->components.indexes[Loop]] += RefCount;
+    }
     
-    if (ECSEntityHasComponent(Context, Entity, ID))
+    State->running += RefCount;
+    
+    if (Main)
     {
-        size_t Index = ECSArchetypeComponentIndex(Refs, ID & ~ECSComponentStorageMask);
-        ECSArchetype *Archetype = Refs->archetype.ptr;
+        Executor.archetype.offset = 0;
+        Executor.archetype.count = ArchCount;
         
-        if (ID & ECSComponentStorageModifierDestructor)
-        {
-#if ECS_IMPURE_COMPONENT_DESTRUCTION
-            // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
-            ECSArchetypeRemoveComponent(Context, Entity, ID);
-            ECSArchetypeAddComponent(Context, Entity, Data, ID);
-            
-            return;
-#else
-            _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
-            CCBitsClear(Refs->has, CompIndex);
-            
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-            ECSArchetypeComponentDestructors[CompIndex](CCArrayGetElementAtIndex(Archetype->components[Index], Refs->archetype.index), ID);
-#else
-            CCMemoryZoneSave(ECSSharedZone);
-            
-            ECSArchetypeComponentDestructors[CompIndex](ECSSharedZoneStore(CCArrayGetElementAtIndex(Archetype->components[Index], Refs->archetype.index), ECSArchetypeComponentSizes[CompIndex]), ID);
-            
-            CCMemoryZoneRestore(ECSSharedZone);
-#endif
-            
-            CCBitsSet(Refs->has, CompIndex);
-            
-            if (Archetype != Refs->archetype.ptr)
-            {
-                Archetype = Refs->archetype.ptr;
-                Index = ECSArchetypeComponentIndex(Refs, ID & ~ECSComponentStorageMask);
-            }
-#endif
-        }
+        Stage->main.executors[Stage->main.count++] = Executor;
         
-        CCArrayReplaceElementAtIndex(Archetype->components[Index], Refs->archetype.index, Data);
+        return ECSSystemStatusRunning;
     }
     
-    else
+    *SubmitCount += RefCount;
+    
+    if (!Parallel)
     {
-        const size_t AddedIndex = SortedAdd(Refs->archetype.component.ids, Refs->archetype.component.count++, CompIndex);
-        const size_t Count = Refs->archetype.component.count;
-        const size_t ArchID = ArchtypeIndex(Refs->archetype.component.ids, Count);
-        ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
-        
-        if (CC_UNLIKELY(!Archetype->entities))
-        {
-            const size_t ChunkSize = ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ArchID, Count);
-            
-            Archetype->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize);
-            
-            for (size_t Loop = 0; Loop < Count; Loop++) Archetype->components[Loop] = CCArrayCreate(CC_STD_ALLOCATOR, ECSArchetypeComponentSizes[Refs->archetype.component.ids[Loop]], ChunkSize);
-        }
+        Executor.archetype.offset = 0;
+        Executor.archetype.count = ArchCount;
         
-        const size_t Index = CCArrayAppendElement(Archetype->components[AddedIndex], Data);
-        CCArrayAppendElement(Archetype->entities, &Entity);
+        ECSExecutorPush(&Executor, Stage);
+    }
+    
+    else if (ECS_SYSTEM_UPDATE_GET_PARALLEL_ARCHETYPE(Update[SystemIndex]))
+    {
+        Executor.archetype.count = 1;
         
-        if (Refs->archetype.ptr)
+        for (size_t Loop = 0; Loop < ArchCount; Loop++)
         {
-            ECSArchetype *PrevArchetype = Refs->archetype.ptr;
+            Executor.archetype.offset = Loop;
             
-            for (size_t Loop = 0; Loop < Count; Loop++)
+            if (ChunkSize < SIZE_MAX)
             {
-                if (Loop < AddedIndex)
-                {
-                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Refs->archetype.index);
-                    CCArrayAppendElement(Archetype->components[Loop], Copy);
-                }
+                ECSArchetype *Archetype = (void*)Context + Executor.access->archetype.pointer[Loop].archetype;
                 
-                else if (Loop > AddedIndex)
+                size_t Count;
+                if ((Archetype->entities) && (Count = CCArrayGetCount(Archetype->entities)))
                 {
-                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop - 1], Refs->archetype.index);
-                    CCArrayAppendElement(Archetype->components[Loop], Copy);
+                    const size_t ArchChunkSize = ChunkSize == ECS_SYSTEM_CHUNK_ARCHETYPE ? Archetype->chunk : ChunkSize;
+                    
+                    for (size_t Offset = 0; Offset < Count; Offset += ArchChunkSize)
+                    {
+                        Executor.range = (ECSRange){
+                            .index = Offset,
+                            .count = CCMin(Count - Offset, ArchChunkSize)
+                        };
+                        
+                        ECSExecutorPush(&Executor, Stage);
+                    }
                 }
             }
             
-            ArchetypeRemove(Context, PrevArchetype, Count - 1, Refs->archetype.index);
+            else ECSExecutorPush(&Executor, Stage);
         }
-        
-        Refs->archetype.ptr = Archetype;
-        Refs->archetype.index = Index;
-        
-        CCBitsSet(Refs->has, CompIndex);
     }
-}
-
-void ECSArchetypeRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
-{
-    CCAssertLog(Context, "Context must not be null");
     
-    if (ECSEntityHasComponent(Context, Entity, ID))
+    else
     {
-        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-        
-        const size_t CompIndex = ID & ~ECSComponentStorageMask;
-        const size_t RemovedIndex = SortedSub(Refs->archetype.component.ids, Refs->archetype.component.count--, CompIndex);
+        const size_t Count = CCArrayGetCount(Array);
         
-        _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
-        CCBitsClear(Refs->has, CompIndex);
+        Executor.archetype.offset = 0;
+        Executor.archetype.count = ArchCount;
         
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-        if (ID & ECSComponentStorageModifierDestructor) ECSArchetypeComponentDestructors[CompIndex](CCArrayGetElementAtIndex(Refs->archetype.ptr->components[RemovedIndex], Refs->archetype.index), ID);
-#else
-        void *CopiedComponent;
-        if (ID & ECSComponentStorageModifierDestructor)
+        for (size_t Offset = 0; Offset < Count; Offset += ChunkSize)
         {
-            CCMemoryZoneSave(ECSSharedZone);
+            Executor.range = (ECSRange){
+                .index = Offset,
+                .count = CCMin(Count - Offset, ChunkSize)
+            };
             
-            CopiedComponent = ECSSharedZoneStore(CCArrayGetElementAtIndex(Refs->archetype.ptr->components[RemovedIndex], Refs->archetype.index), ECSArchetypeComponentSizes[CompIndex]);
+            ECSExecutorPush(&Executor, Stage);
         }
+    }
+    
+    return ECSSystemStatusRunning;
+    
+Deferred:
+#if ECS_STATISTICS
+    if ((Statistics) && (!Statistics->blockedStart)) Statistics->blockedStart = ECS_TIME_FROM_SECONDS(CCTimestamp());
 #endif
+    
+    return ECSSystemStatusDeferred;
+}
+
+static inline void ECSReleaseSystemAccess(ECSTickState *Tick, const ECSExecutionPlanSystem *System, ECSExecutionGroup *State, ECSContextAccessFlag *AccessFlags)
+{
+    for (size_t Loop = 0, ComponentCount = System->components.count; Loop < ComponentCount; Loop++)
+    {
+        const size_t ComponentIndex = System->components.indexes[Loop];
         
-        const size_t Count = Refs->archetype.component.count;
-        if (Count)
+        if (!--Tick->refs[ComponentIndex]) AccessFlags[ECS_ACCESS_FLAG_INDEX(ComponentIndex)] &= ~((ECSContextAccessFlag)3 << ECS_ACCESS_FLAG_SHIFT(ComponentIndex));
+    }
+    
+    State->running--;
+}
+
+static inline void ECSReleaseAccessRefs(ECSTickState *Tick, size_t Source, ECSContextAccessFlag *AccessFlags)
+{
+    ECSComponentAccessRelease *Releases = &Tick->releases[Source][Tick->localReleaseIndexes[Source]];
+    
+    for (size_t Loop = 0, Count = Releases->count; Loop < Count; Loop++)
+    {
+        ECSReleaseSystemAccess(Tick, Releases->release[Loop].system, Releases->release[Loop].executionGroup, AccessFlags);
+    }
+    
+    Releases->count = 0;
+}
+
+/*!
+ * @brief Republish any access releases the tick has posted to other ticks that were handed back before being consumed.
+ * @param Tick The tick that posted the releases.
+ * @return Returns TRUE if there are still releases waiting to be consumed, otherwise FALSE.
+ */
+static _Bool ECSTickPostPendingReleases(ECSTickState *Tick)
+{
+    const size_t Source = Tick - TickStates;
+    _Bool Pending = FALSE;
+    
+    for (size_t Loop = 0; Loop < ECS_TICK_CONCURRENT_MAX; Loop++)
+    {
+        if (TickStates[Loop].releases[Source][Tick->postReleaseIndexes[Loop]].count)
         {
-            const size_t ArchID = ArchtypeIndex(Refs->archetype.component.ids, Count);
-            ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
-            
-            if (CC_UNLIKELY(!Archetype->entities))
-            {
-                const size_t ChunkSize = ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ArchID, Count);
-                
-                Archetype->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize);
-                
-                for (size_t Loop = 0; Loop < Count; Loop++) Archetype->components[Loop] = CCArrayCreate(CC_STD_ALLOCATOR, ECSArchetypeComponentSizes[Refs->archetype.component.ids[Loop]], ChunkSize);
-            }
-            
-            const size_t Index = CCArrayAppendElement(Archetype->entities, &Entity);
-            
-            const size_t PrevCount = Count + 1;
-            ECSArchetype *PrevArchetype = Refs->archetype.ptr;
-            
-            for (size_t Loop = 0; Loop < PrevCount; Loop++)
-            {
-                if (Loop < RemovedIndex)
-                {
-                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Refs->archetype.index);
-                    CCArrayAppendElement(Archetype->components[Loop], Copy);
-                }
-                
-                else if (Loop > RemovedIndex)
-                {
-                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Refs->archetype.index);
-                    CCArrayAppendElement(Archetype->components[Loop - 1], Copy);
-                }
-            }
-            
-            ArchetypeRemove(Context, PrevArchetype, PrevCount, Refs->archetype.index);
-            
-            Refs->archetype.ptr = Archetype;
-            Refs->archetype.index = Index;
+            Tick->postReleaseIndexes[Loop] = atomic_exchange_explicit(&TickStates[Loop].releaseIndex[Source].index, Tick->postReleaseIndexes[Loop], memory_order_consume);
+            Pending |= TickStates[Loop].releases[Source][Tick->postReleaseIndexes[Loop]].count != 0;
         }
+    }
+    
+    return Pending;
+}
+
+/*!
+ * @brief Make progress on the submitted work while every executor deque is full.
+ * @description Wakes the workers, processes the access releases posted to the tick (so workers waiting on the tick to consume them can
+ *              continue), and then steals an executor and executes it on the calling thread. The executor may belong to another tick, in
+ *              which case its release is posted to that tick the same way a worker would.
+ *
+ * @param Stage The stage of the tick that is submitting.
+ */
+static void ECSExecutorStageDrain(ECSExecutorStage *Stage)
+{
+    ECSTickState * const Tick = Stage->tick;
+    
+    ECSWorkerWake(WorkerThreadCount);
+    
+    for (size_t Loop = 0, Count = ECS_RELEASE_SOURCE_WORKER(WorkerThreadCount); Loop < Count; Loop++)
+    {
+        Tick->localReleaseIndexes[Loop] = atomic_exchange_explicit(&Tick->releaseIndex[Loop].index, Tick->localReleaseIndexes[Loop], memory_order_consume);
         
-        else
+        if (Tick->releases[Loop][Tick->localReleaseIndexes[Loop]].count)
         {
-            ArchetypeRemove(Context, Refs->archetype.ptr, 1, Refs->archetype.index);
-            
-            Refs->archetype.ptr = NULL;
-            Refs->archetype.index = 0;
+            ECSReleaseAccessRefs(Tick, Loop, Stage->accessFlags);
+            Stage->released = TRUE;
         }
+    }
+    
+    ECSTickPostPendingReleases(Tick);
+    
+    ECSSystemExecutor Executor;
+    _Bool Stolen = FALSE;
+    
+    for (size_t Loop = 0; (Loop < WorkerThreadCount) && (!Stolen); Loop++) Stolen = ECSExecutorSteal(&ExecutorDeques[(Stage->next + Loop) % WorkerThreadCount], &Executor);
+    
+    if (!Stolen)
+    {
+        ECSWaiting(-1);
         
-        
-#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
-        if (ID & ECSComponentStorageModifierDestructor)
-        {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wconditional-uninitialized"
-            ECSArchetypeComponentDestructors[CompIndex](CopiedComponent, ID);
-#pragma clang diagnostic pop
-            
-            CCMemoryZoneRestore(ECSSharedZone);
-        }
-#endif
+        return;
     }
-}
-
-void ECSPackedAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
-{
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSSystemExecutorRun(&Executor, -1, ECSArchetypeComponentIndexes);
     
-    const size_t Index = (ID & ~ECSComponentStorageMask);
-    ECSPackedComponent *Packed = &Context->packed[Index];
+    ECSTickState * const Target = Executor.tick;
     
-    CCArray(ECSEntity) Entities = Packed->entities;
-    CCArray Components = *Packed->components;
+    if (Target == Tick)
+    {
+        ECSReleaseSystemAccess(Tick, Executor.system, Executor.executionGroup, Stage->accessFlags);
+        Stage->released = TRUE;
+        
+        return;
+    }
     
-    if (ECSEntityHasComponent(Context, Entity, ID))
+    const size_t Source = Tick - TickStates;
+    size_t * const LocalAccessReleaseIndex = &Tick->postReleaseIndexes[Target - TickStates];
+    
+    while (Target->releases[Source][*LocalAccessReleaseIndex].count == ECS_COMPONENT_ACCESS_RELEASE_MAX)
     {
-        const size_t EntityIndex = Refs->packed.indexes[Index];
+        ECSWaiting(-1);
         
-        if (ID & ECSComponentStorageModifierDestructor)
-        {
-#if ECS_IMPURE_COMPONENT_DESTRUCTION
-            // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
-            ECSPackedRemoveComponent(Context, Entity, ID);
-            ECSPackedAddComponent(Context, Entity, Data, ID);
-            
-            return;
-#else
-            const size_t CompIndex = Index + ECSComponentBaseIndex(ECSComponentStorageTypePacked);
-            
-            CCBitsClear(Refs->has, CompIndex);
-            
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-            ECSPackedComponentDestructors[Index](CCArrayGetElementAtIndex(Components, EntityIndex), ID);
-#else
-            CCMemoryZoneSave(ECSSharedZone);
-            
-            ECSPackedComponentDestructors[Index](ECSSharedZoneStore(CCArrayGetElementAtIndex(Components, EntityIndex), ECSPackedComponentSizes[Index]), ID);
-            
-            CCMemoryZoneRestore(ECSSharedZone);
-#endif
-            
-            CCBitsSet(Refs->has, CompIndex);
-#endif
-        }
-        
-        CCArrayReplaceElementAtIndex(Components, EntityIndex, Data);
+        *LocalAccessReleaseIndex = atomic_exchange_explicit(&Target->releaseIndex[Source].index, *LocalAccessReleaseIndex, memory_order_consume);
     }
     
-    else
+    const size_t Index = Target->releases[Source][*LocalAccessReleaseIndex].count++;
+    Target->releases[Source][*LocalAccessReleaseIndex].release[Index].system = Executor.system;
+    Target->releases[Source][*LocalAccessReleaseIndex].release[Index].executionGroup = Executor.executionGroup;
+    
+    atomic_thread_fence(memory_order_release);
+    *LocalAccessReleaseIndex = atomic_exchange_explicit(&Target->releaseIndex[Source].index, *LocalAccessReleaseIndex, memory_order_consume);
+}
+
+/*!
+ * @brief Run the main thread executors waiting in a stage, and release their access.
+ * @description This must only be called by the thread running the tick that owns the stage.
+ * @param Stage The stage of the tick.
+ */
+static void ECSExecutorStageRunMain(ECSExecutorStage *Stage)
+{
+    for (size_t Loop = 0, Count = Stage->main.count; Loop < Count; Loop++)
     {
-        if (CC_UNLIKELY(!Components))
-        {
-            const size_t ChunkSize = ECS_PACKED_COMPONENT_ARRAY_CHUNK_SIZE(Index);
-            
-            Packed->entities = (Entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize));
-            
-            *Packed->components = (Components = CCArrayCreate(CC_STD_ALLOCATOR, ECSPackedComponentSizes[Index], ChunkSize));
-        }
-        
-        CCArrayAppendElement(Components, Data);
-        Refs->packed.indexes[Index] = CCArrayAppendElement(Entities, &Entity);
+        const ECSSystemExecutor *Executor = &Stage->main.executors[Loop];
         
-        CCBitsSet(Refs->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypePacked));
+        ECSSystemExecutorRun(Executor, -1, ECSArchetypeComponentIndexes);
+        ECSReleaseSystemAccess(Stage->tick, Executor->system, Executor->executionGroup, Stage->accessFlags);
     }
+    
+    Stage->main.count = 0;
+    Stage->released = TRUE;
 }
 
-void ECSPackedRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
+/*!
+ * @brief Check whether the current priority of a group is waiting on the priority of another group.
+ * @param Groups The groups being ticked.
+ * @param State The execution state of the groups.
+ * @param Index The index of the group to check.
+ * @return Returns the index of the group it is waiting on, or SIZE_MAX if it can run.
+ */
+static inline size_t ECSGroupWaitingOn(const ECSGroup *Groups, const ECSExecutionGroup *State, size_t Index)
 {
-    CCAssertLog(Context, "Context must not be null");
+    const ECSGroupDependency *Dependency = &Groups[Index].priorities.deps[State[Index].executing];
     
-    if (ECSEntityHasComponent(Context, Entity, ID))
-    {
-        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-        
-        const size_t Index = (ID & ~ECSComponentStorageMask);
-        ECSPackedComponent *Packed = &Context->packed[Index];
-        
-        CCArray(ECSEntity) Entities = Packed->entities;
-        CCArray Components = *Packed->components;
-        const size_t EntityIndex = Refs->packed.indexes[Index];
-        const size_t LastIndex = CCArrayGetCount(Components) - 1;
-        
-        CCBitsClear(Refs->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypePacked));
-        
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-        if (ID & ECSComponentStorageModifierDestructor) ECSPackedComponentDestructors[Index](CCArrayGetElementAtIndex(Components, EntityIndex), ID);
-#else
-        void *CopiedComponent;
-        if (ID & ECSComponentStorageModifierDestructor)
-        {
-            CCMemoryZoneSave(ECSSharedZone);
-            
-            CopiedComponent = ECSSharedZoneStore(CCArrayGetElementAtIndex(Components, EntityIndex), ECSPackedComponentSizes[Index]);
-        }
-#endif
-        
-        if (EntityIndex != LastIndex)
-        {
-            const void *Data = CCArrayGetElementAtIndex(Components, LastIndex);
-            CCArrayReplaceElementAtIndex(Components, EntityIndex, Data);
-            CCArrayRemoveElementAtIndex(Components, LastIndex);
-            
-            const size_t *Entity = CCArrayGetElementAtIndex(Entities, LastIndex);
-            CCArrayReplaceElementAtIndex(Entities, EntityIndex, Entity);
-            CCArrayRemoveElementAtIndex(Entities, LastIndex);
-            
-            ECSComponentRefs *ReplacementRef = CCArrayGetElementAtIndex(Context->manager.map, *Entity);
-            ReplacementRef->packed.indexes[Index] = EntityIndex;
-        }
-        
-        else
-        {
-            CCArrayRemoveElementAtIndex(Components, LastIndex);
-            CCArrayRemoveElementAtIndex(Entities, LastIndex);
-        }
-        
-        Refs->packed.indexes[Index] = SIZE_MAX;
-        
-#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
-        if (ID & ECSComponentStorageModifierDestructor)
-        {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wconditional-uninitialized"
-            ECSPackedComponentDestructors[Index](CopiedComponent, ID);
-#pragma clang diagnostic pop
-            
-            CCMemoryZoneRestore(ECSSharedZone);
-        }
-#endif
-    }
+    return (Dependency->group != SIZE_MAX) && (Dependency->priority >= State[Dependency->group].executing) ? Dependency->group : SIZE_MAX;
 }
 
-void ECSIndexedAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
+void ECSTick(ECSContext *Context, const ECSGroup *Groups, size_t GroupCount, ECSExecutionGroup *State, ECSTime DeltaTime)
 {
     CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
-    
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-    
-    const size_t Index = (ID & ~ECSComponentStorageMask);
-    ECSIndexedComponent *Indexed = &Context->indexed[Index];
-    
-    CCArray Components = *Indexed;
+    CCAssertLog(Groups, "Groups must not be null");
+    CCAssertLog(State, "State must not be null");
     
-    if (CC_UNLIKELY(!Components))
-    {
-        *Indexed = (Components = CCArrayCreate(CC_STD_ALLOCATOR, ECSIndexedComponentSizes[Index], ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index)));
-    }
+#if ECS_STATISTICS
+    const ECSTime TickStart = ECS_TIME_FROM_SECONDS(CCTimestamp());
     
-    const size_t Count = CCArrayGetCount(Components);
-    if (Entity >= Count)
+    for (size_t Loop = 0; Loop < GroupCount; Loop++)
     {
-        CCArrayAppendElements(Components, NULL, CC_ALIGN((Entity - Count) + 1, ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index)));
+        if ((State[Loop].statistics) && (Groups[Loop].priorities.count))
+        {
+            const ECSSystemRange *Range = &Groups[Loop].priorities.systems.range[Groups[Loop].priorities.count - 1];
+            
+            memset(State[Loop].statistics, 0, sizeof(ECSSystemStatistics) * (Range->index + Range->count));
+        }
     }
+#endif
     
-    const size_t CompIndex = Index + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed);
+    size_t RunGroupIndexes[GroupCount], RunCount = 0;
+    ECSTime GroupTimes[GroupCount];
     
-    if ((ID & ECSComponentStorageModifierDestructor) && (ECSEntityHasComponent(Context, Entity, ID)))
+    for (size_t Loop = 0; Loop < GroupCount; Loop++)
     {
-#if ECS_IMPURE_COMPONENT_DESTRUCTION
-        // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
-        ECSIndexedRemoveComponent(Context, Entity, ID);
-        ECSIndexedAddComponent(Context, Entity, Data, ID);
-            
-            return;
-#else
-        CCBitsClear(Refs->has, CompIndex);
+        if (CC_UNLIKELY(!State[Loop].plan)) State[Loop].plan = ECSExecutionPlanCreate(&Groups[Loop]);
         
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-        ECSIndexedComponentDestructors[Index](CCArrayGetElementAtIndex(Context->indexed[Index], Entity), ID);
-#else
-        CCMemoryZoneSave(ECSSharedZone);
+        State[Loop].running = 0;
+        State[Loop].deferred = FALSE;
+        State[Loop].start = 0;
         
-        ECSIndexedComponentDestructors[Index](ECSSharedZoneStore(CCArrayGetElementAtIndex(Context->indexed[Index], Entity), ECSIndexedComponentSizes[Index]), ID);
+        State[Loop].time += DeltaTime;
+        ECSTime Ticks = State[Loop].time / Groups[Loop].freq;
+        State[Loop].time -= Ticks * Groups[Loop].freq;
         
-        CCMemoryZoneRestore(ECSSharedZone);
-#endif
-#endif
+        if (Ticks)
+        {
+            State[Loop].executing = 0;
+            RunGroupIndexes[RunCount++] = Loop;
+            
+            if (!Groups[Loop].dynamic)
+            {
+                State[Loop].time += (Ticks - 1) * Groups[Loop].freq;
+                Ticks = 1;
+            }
+            
+            GroupTimes[Loop] = Ticks * Groups[Loop].freq;
+        }
+        
+        else State[Loop].executing = SIZE_MAX;
     }
     
-    CCArrayReplaceElementAtIndex(Components, Entity, Data);
-    
-    CCBitsSet(Refs->has, CompIndex);
-}
-
-void ECSIndexedRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
-{
-    CCAssertLog(Context, "Context must not be null");
+    const ECSTime Budget = ECSTickBudget;
     
-    if (ECSEntityHasComponent(Context, Entity, ID))
+    if (Budget)
     {
-        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-        
-        const size_t Index = (ID & ~ECSComponentStorageMask);
-        CCBitsClear(Refs->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed));
+        for (size_t Loop = 1; Loop < RunCount; Loop++)
+        {
+            const size_t Index = RunGroupIndexes[Loop];
+            
+            size_t Loop2 = Loop;
+            for ( ; (Loop2) && (Groups[RunGroupIndexes[Loop2 - 1]].priority > Groups[Index].priority); Loop2--) RunGroupIndexes[Loop2] = RunGroupIndexes[Loop2 - 1];
+            
+            RunGroupIndexes[Loop2] = Index;
+        }
         
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-        if (ID & ECSComponentStorageModifierDestructor) ECSIndexedComponentDestructors[Index](CCArrayGetElementAtIndex(Context->indexed[Index], Entity), ID);
-#else
-        if (ID & ECSComponentStorageModifierDestructor)
+        ECSTime Estimate = 0;
+        for (size_t Loop = 0; Loop < RunCount; Loop++)
         {
-            CCMemoryZoneSave(ECSSharedZone);
+            const size_t Index = RunGroupIndexes[Loop];
+            const ECSTime Cost = CCMax(Estimate, State[Index].cost);
             
-            ECSIndexedComponentDestructors[Index](ECSSharedZoneStore(CCArrayGetElementAtIndex(Context->indexed[Index], Entity), ECSIndexedComponentSizes[Index]), ID);
+            if ((Groups[Index].priority) && (Cost > Budget) && (State[Index].deferrals < ECS_TICK_BUDGET_DEFERRAL_MAX))
+            {
+                // Bound the time carried over so a group that keeps getting deferred won't try to catch up on an ever growing backlog
+                State[Index].time = CCMin(State[Index].time + GroupTimes[Index], Groups[Index].freq * (ECS_TICK_BUDGET_DEFERRAL_MAX + 1));
+                State[Index].executing = SIZE_MAX;
+                State[Index].deferred = TRUE;
+                State[Index].deferrals++;
+                
+                // Decay the cost as it can't be remeasured while deferred, so a group that was only briefly expensive gets to run again
+                State[Index].cost -= State[Index].cost / 4;
+                
+                memmove(&RunGroupIndexes[Loop], &RunGroupIndexes[Loop + 1], sizeof(*RunGroupIndexes) * (--RunCount - Loop));
+                Loop--;
+            }
             
-            CCMemoryZoneRestore(ECSSharedZone);
+            else
+            {
+                State[Index].deferrals = 0;
+                Estimate = Cost;
+            }
         }
-#endif
     }
-}
-
-void ECSLocalAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
-{
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    // Groups whose current priority is waiting on an unfinished priority of another group are taken off the ready list and chained
+    // to that group, they're only pushed back onto the ready list once that group advances past the priority they depend on
+    size_t WaitHead[GroupCount], WaitNext[GroupCount];
     
-    const size_t Index = ECSLocalComponentIndex(ID);
-    const size_t CompIndex = Index + ECSComponentBaseIndex(ECSComponentStorageTypeLocal);
+    for (size_t Loop = 0; Loop < GroupCount; Loop++) WaitHead[Loop] = SIZE_MAX;
     
-    if ((ID & ECSComponentStorageModifierDestructor) && (ECSEntityHasComponent(Context, Entity, ID)))
+    size_t ReadyCount = 0, WaitCount = 0;
+    for (size_t Loop = 0; Loop < RunCount; Loop++)
     {
-#if ECS_IMPURE_COMPONENT_DESTRUCTION
-        // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
-        ECSLocalRemoveComponent(Context, Entity, ID);
-        ECSLocalAddComponent(Context, Entity, Data, ID);
-        
-        return;
-#else
-        CCBitsClear(Refs->has, CompIndex);
-        
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-        ECSLocalComponentDestructors[Index](&Refs->local[ECSLocalComponentOffset(ID)], ID);
-#else
-        CCMemoryZoneSave(ECSSharedZone);
+        const size_t Index = RunGroupIndexes[Loop];
+        const size_t Dependency = ECSGroupWaitingOn(Groups, State, Index);
         
-        ECSLocalComponentDestructors[Index](ECSSharedZoneStore(&Refs->local[ECSLocalComponentOffset(ID)], ECSLocalComponentSizes[Index]), ID);
+        if (Dependency != SIZE_MAX)
+        {
+            WaitNext[Index] = WaitHead[Dependency];
+            WaitHead[Dependency] = Index;
+            WaitCount++;
+        }
         
-        CCMemoryZoneRestore(ECSSharedZone);
-#endif
-#endif
+        else RunGroupIndexes[ReadyCount++] = Index;
     }
     
-    if (Data)
+    RunCount = ReadyCount;
+    
+    ECSTickState *Tick = NULL;
+    for (size_t Loop = 0; !Tick; Loop = (Loop + 1) % ECS_TICK_CONCURRENT_MAX)
     {
-        const ptrdiff_t Offset = ECSLocalComponentOffset(ID);
-        memcpy(&Refs->local[Offset], Data, ECSLocalComponentSizes[Index]);
+        if (!atomic_flag_test_and_set_explicit(&TickStates[Loop].active, memory_order_acquire)) Tick = &TickStates[Loop];
+        else if (Loop + 1 == ECS_TICK_CONCURRENT_MAX) ECSWaiting(-1);
     }
     
-    CCBitsSet(Refs->has, CompIndex);
-}
-
-void ECSLocalRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
-{
-    CCAssertLog(Context, "Context must not be null");
+    ECSContextAccessFlag AccessFlags[((ECS_ACCESS_INDEX_MAX * 2) / (sizeof(ECSContextAccessFlag) * 8)) + 1] = {0};
     
-    if (ECSEntityHasComponent(Context, Entity, ID))
+    ECSExecutorStage Stage = {
+        .next = WorkerThreadCount ? (Tick - TickStates) % WorkerThreadCount : 0,
+        .tick = Tick,
+        .accessFlags = AccessFlags,
+        .released = FALSE,
+        .main.count = 0
+    };
+    
+    size_t TargetIndex = 0, SubmitCount = 0;
+    const size_t SourceCount = ECS_RELEASE_SOURCE_WORKER(WorkerThreadCount);
+    
+    while (RunCount)
     {
-        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-        
-        const size_t Index = ECSLocalComponentIndex(ID);
-        CCBitsClear(Refs->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypeLocal));
-        
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-        if (ID & ECSComponentStorageModifierDestructor) ECSLocalComponentDestructors[Index](&Refs->local[ECSLocalComponentOffset(ID)], ID);
-#else
-        if (ID & ECSComponentStorageModifierDestructor)
+        for (size_t Loop = 0; Loop < RunCount; Loop++)
         {
-            CCMemoryZoneSave(ECSSharedZone);
+            const size_t Index = RunGroupIndexes[Loop];
+            const size_t Priority = State[Index].executing;
             
-            ECSLocalComponentDestructors[Index](ECSSharedZoneStore(&Refs->local[ECSLocalComponentOffset(ID)], ECSLocalComponentSizes[Index]), ID);
+            if ((Budget) && (!State[Index].start)) State[Index].start = ECS_TIME_FROM_SECONDS(CCTimestamp());
             
-            CCMemoryZoneRestore(ECSSharedZone);
-        }
-#endif
-    }
-}
-
-void ECSEntityAddComponents(ECSContext *Context, ECSEntity Entity, const ECSTypedComponent *Components, size_t Count)
-{
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
-    CCAssertLog(Components, "Components must not be null");
-    
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
-    
-    void *RefData[ECS_ARCHETYPE_MAX];
-    void *ComponentData[ECS_ARCHETYPE_COMPONENT_MAX];
-    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) AddedComponent;
-    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) CachedComponentLookup;
-    
-    CC_BITS_INIT_CLEAR(AddedComponent);
-    CC_BITS_INIT_CLEAR(CachedComponentLookup);
-    
-    size_t IndexCount = 0, LastIndex = 0, RefDataCount = 0;
-    ECSArchetypeComponentID LastID = 0;
-    for (size_t Loop = 0; Loop < Count; Loop++)
-    {
-        switch (Components[Loop].id & (ECSComponentStorageTypeMask | ECSComponentStorageModifierDuplicate))
-        {
-            case ECSComponentStorageTypeArchetype:
+            const ECSSystemRange *Range = &Groups[Index].priorities.systems.range[Priority];
+            const ECSSystemAccess *Access = &Groups[Index].priorities.systems.access[Range->index];
+            const ECSSystemUpdate *Update = &Groups[Index].priorities.systems.update[Range->index];
+            
+            const size_t SystemCount = Range->count;
+            const size_t BlockCount = (SystemCount + 7) / 8;
+            
+            _Bool Completed = TRUE;
+            for (size_t Loop2 = 0; Loop2 < BlockCount; Loop2++)
             {
-                const ECSArchetypeComponentID ID = Components[Loop].id & ~ECSComponentStorageMask;
+                const uint8_t Block = State[Index].state[Loop2];
+                const size_t BitCount = (Loop2 + 1 != BlockCount ? 8 : (8 - ((BlockCount * 8) - SystemCount)));
                 
-                if (!ECSEntityHasComponent(Context, Entity, ID))
+                if (Block != (0xff >> (8 - BitCount)))
                 {
-                    const size_t Offset = LastID < ID ? LastIndex : 0;
-                    
-                    LastIndex = SortedAdd(Refs->archetype.component.ids + Offset, Refs->archetype.component.count++ - Offset, ID) + Offset;
-                    ComponentData[ID] = Components[Loop].data;
-                    IndexCount++;
-                    CCBitsSet(AddedComponent, ID);
-                    CCBitsSet(Refs->has, ID);
-                    
-                    LastID = ID;
+                    for (size_t Loop3 = 0; Loop3 < BitCount; Loop3++)
+                    {
+                        if (!((Block >> Loop3) & 1))
+                        {
+                            const size_t SystemIndex = Loop3 + (Loop2 * 8);
+                            
+                            switch (ECSSubmitSystem(Context, GroupTimes[Index], SystemIndex, Range, Access, Update, AccessFlags, Tick, &State[Index].state[Loop2], Loop3, &State[Index], &Stage, &SubmitCount))
+                            {
+                                case ECSSystemStatusRunning:
+                                {
+                                    Completed = FALSE;
+                                    
+                                    const ECSExecutionPlanSystem *System = &State[Index].plan->systems[Range->index + SystemIndex];
+                                    
+                                    for (size_t Loop4 = 0, SuccessorCount = System->successors.count; Loop4 < SuccessorCount; Loop4++)
+                                    {
+                                        const size_t SystemIndex = System->successors.indexes[Loop4];
+                                        uint8_t *Block = &State[Index].state[SystemIndex / 8];
+                                        
+                                        if (!((*Block >> (SystemIndex % 8)) & 1))
+                                        {
+                                            ECSSubmitSystem(Context, GroupTimes[Index], SystemIndex, Range, Access, Update, AccessFlags, Tick, Block, SystemIndex % 8, &State[Index], &Stage, &SubmitCount);
+                                        }
+                                    }
+                                    
+                                    goto FinishedRow;
+                                }
+                                    
+                                case ECSSystemStatusCompleted:
+                                    Completed = TRUE;
+                                    break;
+                                    
+                                case ECSSystemStatusDeferred:
+                                    Completed = FALSE;
+                                    break;
+                            }
+                        }
+                    }
                 }
-                break;
             }
-                
-            case ECSComponentStorageTypePacked:
-                ECSPackedAddComponent(Context, Entity, Components[Loop].data, Components[Loop].id);
-                break;
-                
-            case ECSComponentStorageTypeIndexed:
-                ECSIndexedAddComponent(Context, Entity, Components[Loop].data, Components[Loop].id);
-                break;
-                
-            case ECSComponentStorageTypeLocal:
-                ECSLocalAddComponent(Context, Entity, Components[Loop].data, Components[Loop].id);
-                break;
-                
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeArchetype:
+            
+        FinishedRow:;
+            
+            if (Completed)
             {
-                const ECSArchetypeComponentID ID = Components[Loop].id & ~ECSComponentStorageMask;
-                
-                if (!ECSEntityHasComponent(Context, Entity, ID))
+                if (!State[Index].running)
                 {
-                    const size_t Offset = LastID < ID ? LastIndex : 0;
+                    if (++State[Index].executing >= Groups[Index].priorities.count)
+                    {
+                        if (Budget)
+                        {
+                            const ECSTime Elapsed = ECS_TIME_FROM_SECONDS(CCTimestamp()) - State[Index].start;
+                            
+                            State[Index].cost = State[Index].cost ? ((State[Index].cost * 3) + Elapsed) / 4 : Elapsed;
+                        }
+                        
+                        RunGroupIndexes[Loop] = RunGroupIndexes[--RunCount];
+                    }
                     
-                    LastIndex = SortedAdd(Refs->archetype.component.ids + Offset, Refs->archetype.component.count++ - Offset, ID) + Offset;
-                    RefData[RefDataCount] = CCArrayCreate(CC_STD_ALLOCATOR, ECSDuplicateArchetypeComponentSizes[ID], ECS_DUPLICATE_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ID));
-                    ComponentData[ID] = &RefData[RefDataCount++];
-                    IndexCount++;
-                    CCBitsSet(AddedComponent, ID);
-                    CCBitsSet(Refs->has, ID);
+                    else
+                    {
+                        const size_t Dependency = ECSGroupWaitingOn(Groups, State, Index);
+                        
+                        if (Dependency != SIZE_MAX)
+                        {
+                            RunGroupIndexes[Loop] = RunGroupIndexes[--RunCount];
+                            
+                            WaitNext[Index] = WaitHead[Dependency];
+                            WaitHead[Dependency] = Index;
+                            WaitCount++;
+                        }
+                    }
                     
-                    LastID = ID;
-                }
-                
-                if ((!CCBitsGet(AddedComponent, ID)) && (!CCBitsGet(CachedComponentLookup, ID)))
-                {
-                    CCBitsSet(CachedComponentLookup, ID);
+                    memset(State[Index].state, 0, BlockCount);
                     
-                    const size_t Offset = ID ? CCBitsCount(AddedComponent, 0, ID - 1) : 0;
-                    size_t Index = ECSArchetypeComponentIndex(Refs, ID) - Offset;
-                    ComponentData[ID] = CCArrayGetElementAtIndex(Refs->archetype.ptr->components[Index], Refs->archetype.index);
+                    for (size_t *Waiting = &WaitHead[Index]; *Waiting != SIZE_MAX; )
+                    {
+                        const size_t WaitingIndex = *Waiting;
+                        
+                        if (ECSGroupWaitingOn(Groups, State, WaitingIndex) == SIZE_MAX)
+                        {
+                            *Waiting = WaitNext[WaitingIndex];
+                            RunGroupIndexes[RunCount++] = WaitingIndex;
+                            WaitCount--;
+                        }
+                        
+                        else Waiting = &WaitNext[WaitingIndex];
+                    }
+                    
+                    Loop = -1;
+                    continue;
                 }
-                
-                CCArray *Duplicates = ComponentData[ID];
-                CCArrayAppendElement(*Duplicates, Components[Loop].data);
-                break;
             }
-                
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypePacked:
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeIndexed:
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeLocal:
-                ECSEntityAddDuplicateComponent(Context, Entity, Components[Loop].data, Components[Loop].id, 1);
-                break;
-                
-            default:
-                CCAssertLog(0, "Unsupported component type");
-                break;
         }
-    }
-    
-    if (IndexCount)
-    {
-        Count = Refs->archetype.component.count;
         
-        const size_t ArchID = ArchtypeIndex(Refs->archetype.component.ids, Count);
-        ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
+        atomic_thread_fence(memory_order_release);
         
-        if (CC_UNLIKELY(!Archetype->entities))
+        ECSWorkerWake(SubmitCount);
+        SubmitCount = 0;
+        
+        if (Stage.main.count)
         {
-            const size_t ChunkSize = ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ArchID, Count);
+            ECSExecutorStageRunMain(&Stage);
             
-            Archetype->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize);
-
-            for (size_t Loop = 0; Loop < Count; Loop++) Archetype->components[Loop] = CCArrayCreate(CC_STD_ALLOCATOR, ECSArchetypeComponentSizes[Refs->archetype.component.ids[Loop]], ChunkSize);
+            if (RunCount) continue;
         }
         
-        const size_t Index = CCArrayAppendElement(Archetype->entities, &Entity);
-        
-        if (Refs->archetype.ptr)
+        // Executors that finished while the deques were full have already been released, so their systems may now be able to progress
+        if (Stage.released)
         {
-            ECSArchetype *PrevArchetype = Refs->archetype.ptr;
+            Stage.released = FALSE;
             
-            for (size_t Loop = 0, ComponentIndex = 0; Loop < Count; Loop++)
+            if (RunCount) continue;
+        }
+        
+        if (!RunCount)
+        {
+        WaitForWorkers:;
+            size_t RunningCount = 0;
+            for (size_t Loop = 0; Loop < GroupCount; Loop++)
             {
-                _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
-                
-                const ECSArchetypeComponentID ID = Refs->archetype.component.ids[Loop];
-                
-                if (CCBitsGet(AddedComponent, ID))
-                {
-                    CCArrayAppendElement(Archetype->components[Loop], ComponentData[ID]);
-                    ComponentIndex++;
-                }
-                
-                else
-                {
-                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop - ComponentIndex], Refs->archetype.index);
-                    CCArrayAppendElement(Archetype->components[Loop], Copy);
-                }
+                RunningCount += State[Loop].running;
             }
             
-            ArchetypeRemove(Context, PrevArchetype, Count - IndexCount, Refs->archetype.index);
+            if (!RunningCount) goto Finished;
         }
         
-        else
+        while (!Tick->releases[TargetIndex][(Tick->localReleaseIndexes[TargetIndex] = atomic_exchange_explicit(&Tick->releaseIndex[TargetIndex].index, Tick->localReleaseIndexes[TargetIndex], memory_order_consume))].count)
         {
-            for (size_t Loop = 0; Loop < Count; Loop++)
-            {
-                CCArrayAppendElement(Archetype->components[Loop], ComponentData[Refs->archetype.component.ids[Loop]]);
-            }
+            ECSWaiting(-1);
+            
+            if (CC_UNLIKELY(atomic_load_explicit(&ParkedWorkerCount, memory_order_relaxed) == WorkerThreadCount)) ECSWorkerWake(1); // MARK: guard against every worker having parked while work remains
+            
+            ECSTickPostPendingReleases(Tick);
+            
+            TargetIndex = (TargetIndex + 1) % SourceCount;
+        }
+        
+        ECSReleaseAccessRefs(Tick, TargetIndex, AccessFlags);
+        
+        for (size_t Loop = 1; Loop < SourceCount; Loop++)
+        {
+            const size_t Index = (TargetIndex + Loop) % SourceCount;
+            Tick->localReleaseIndexes[Index] = atomic_exchange_explicit(&Tick->releaseIndex[Index].index, Tick->localReleaseIndexes[Index], memory_order_consume);
+            
+            ECSReleaseAccessRefs(Tick, Index, AccessFlags);
         }
         
-        Refs->archetype.ptr = Archetype;
-        Refs->archetype.index = Index;
+        if (!RunCount) goto WaitForWorkers;
     }
-}
-
-void ECSEntityRemoveComponents(ECSContext *Context, ECSEntity Entity, const ECSComponentID *IDs, size_t Count)
-{
-    CCAssertLog(Context, "Context must not be null");
-    CCAssertLog(IDs, "IDs must not be null");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+Finished:;
     
-    void *ComponentData[ECS_ARCHETYPE_COMPONENT_MAX];
-    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) RemovedComponent;
-    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) CachedComponentLookup;
+    // The releases posted to other ticks must be consumed before finishing, as those ticks will be waiting on them
+    while (ECSTickPostPendingReleases(Tick)) ECSWaiting(-1);
     
-    CC_BITS_INIT_CLEAR(RemovedComponent);
-    CC_BITS_INIT_CLEAR(CachedComponentLookup);
+    CCAssertLog(!WaitCount, "Group dependencies must not form a cycle");
     
-#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
-    CCMemoryZoneSave(ECSSharedZone);
+#if ECS_STATISTICS
+    TickStatistics.time = ECS_TIME_FROM_SECONDS(CCTimestamp()) - TickStart;
+    TickStatistics.workerCount = WorkerThreadCount;
+    TickStatistics.workers = WorkerStatistics;
     
-    size_t CopiedComponentCount = 0;
-    struct {
-        ECSComponentDestructor destructor;
-        ECSTypedComponent component;
-    } *CopiedComponents = CCMemoryZoneAllocate(ECSSharedZone, sizeof(*CopiedComponents) * Count);
+    for (size_t Loop = 0; Loop < WorkerThreadCount; Loop++)
+    {
+        const ECSTime Busy = atomic_exchange_explicit(&Tick->busy[Loop], 0, memory_order_relaxed);
+        
+        WorkerStatistics[Loop] = (ECSWorkerStatistics){
+            .busy = Busy,
+            .idle = TickStatistics.time > Busy ? TickStatistics.time - Busy : 0
+        };
+    }
 #endif
     
-    size_t IndexCount = 0, LastIndex = 0;
-    ECSArchetypeComponentID LastID = 0;
+    atomic_flag_clear_explicit(&Tick->active, memory_order_release);
+}
+
+static inline void ECSEntityInit(ECSContext *Context, size_t BaseIndex, size_t Count, ECSEntity *Entities)
+{
     for (size_t Loop = 0; Loop < Count; Loop++)
     {
-        const ECSComponentID ID = IDs[Loop];
+        const size_t Index = BaseIndex + Loop;
         
-        switch (ID & (ECSComponentStorageTypeMask | ECSComponentStorageModifierDuplicate))
+        Entities[Loop] = Index;
+        
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Index);
+        Lookup->archetype = NULL;
+        Lookup->index = 0;
+        CC_BITS_INIT_CLEAR(Lookup->has);
+        
+        ECSComponentRefs *Ref = CCArrayGetElementAtIndex(Context->manager.map, Index);
+        Ref->archetype.component.count = 0;
+        
+#if ECS_ARCHETYPE_COMPONENT_ID_SIMD_LOOKUP && CC_HARDWARE_VECTOR_SUPPORT_SSSE3
+#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
+        memset(Ref->archetype.component.ids, INT8_MAX, sizeof(Ref->archetype.component.ids));
+#else
+        memset(Ref->archetype.component.ids, UINT8_MAX, sizeof(Ref->archetype.component.ids));
+#endif
+#endif
+    }
+}
+
+void ECSEntityCreate(ECSContext *Context, ECSEntity *Entities, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    
+    size_t FreeCount = CCArrayGetCount(Context->manager.available);
+    
+    if (FreeCount < Count)
+    {
+        const size_t AppendCount = Count - FreeCount;
+        if (!Context->manager.lookup) Context->manager.lookup = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntityLookup), Context->manager.map->chunkSize);
+        
+        const size_t Index = CCArrayAppendElements(Context->manager.map, NULL, AppendCount);
+        CCArrayAppendElements(Context->manager.lookup, NULL, AppendCount);
+        
+        Count = Count - AppendCount;
+        
+        ECSEntityInit(Context, Index, AppendCount, Entities + Count);
+    }
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        const size_t FreeIndex = --FreeCount;
+        const ECSEntity *Index = CCArrayGetElementAtIndex(Context->manager.available, FreeIndex);
+        CCArrayRemoveElementAtIndex(Context->manager.available, FreeIndex);
+        
+        ECSEntityInit(Context, *Index, 1, &Entities[Loop]);
+    }
+}
+
+const ECSComponentID *ECSComponentIDs;
+
+/*!
+ * @brief Remove all the components of an entity that is being destroyed.
+ * @param Context The context to be used.
+ * @param Entity The entity to remove the components from.
+ * @param Lookup The lookup of the entity.
+ */
+static void EntityRemoveAllComponents(ECSContext *Context, ECSEntity Entity, const ECSEntityLookup *Lookup)
+{
+    ECSComponentID IDs[32];
+    size_t ComponentCount = 0;
+    const size_t BlockSize = CC_BITS_BLOCK_SIZE(Lookup->has);
+    
+    for (size_t Loop = 0; Loop < ECS_COMPONENT_MAX; Loop += BlockSize)
+    {
+        if (CCBitsAny(Lookup->has, Loop, BlockSize))
         {
-            case ECSComponentStorageTypeArchetype:
+            for (size_t Loop2 = 0; Loop2 < BlockSize; Loop2++)
             {
-                if (ECSEntityHasComponent(Context, Entity, ID))
+                const size_t Index = Loop + Loop2;
+                
+                if (CCBitsGet(Lookup->has, Index))
                 {
-                    _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
-                    
-                    const ECSArchetypeComponentID CompID = ID & ~ECSComponentStorageMask;
-                    
-                    const size_t Offset = LastID < CompID ? LastIndex : 0;
-                    
-                    LastIndex = SortedSub(Refs->archetype.component.ids + Offset, Refs->archetype.component.count-- - Offset, CompID) + Offset;
-                    IndexCount++;
-                    CCBitsSet(RemovedComponent, CompID);
-                    CCBitsClear(Refs->has, CompID);
-                    
-                    LastID = CompID;
-                    
-                    if (ID & ECSComponentStorageModifierDestructor)
+                    if (ComponentCount == (sizeof(IDs) / sizeof(*IDs)))
                     {
-                        const size_t CompOffset = CompID ? CCBitsCount(RemovedComponent, 0, CompID - 1) : 0;
-                        const size_t RemovedIndex = ECSArchetypeComponentIndex(Refs, CompID) + CompOffset;
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-                        ECSArchetypeComponentDestructors[CompID](CCArrayGetElementAtIndex(Refs->archetype.ptr->components[RemovedIndex], Refs->archetype.index), ID);
+                        ECSEntityRemoveComponents(Context, Entity, IDs, ComponentCount);
+                        ComponentCount = 0;
+                    }
+                    
+                    IDs[ComponentCount++] = ECSComponentIDs[Index] & ~ECSComponentStorageModifierDuplicate;
+                }
+            }
+        }
+    }
+    
+    if (ComponentCount) ECSEntityRemoveComponents(Context, Entity, IDs, ComponentCount);
+}
+
+void ECSEntityDestroy(ECSContext *Context, const ECSEntity *Entities, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    
+    size_t Offset = 0;
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        if (!ECSEntityIsAlive(Context, Entities[Loop]))
+        {
+            const size_t SegmentCount = Loop - Offset;
+            if (SegmentCount) CCArrayAppendElements(Context->manager.available, Entities + Offset, SegmentCount);
+            
+            Offset = Loop + 1;
+            
+            continue;
+        }
+        
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop]);
+        CCBitsSet(Lookup->has, ECSHasBitEntityDestroyed);
+        
+        ECSLinkRemoveAllLinksForEntity(Context, Entities[Loop]);
+        
+        EntityRemoveAllComponents(Context, Entities[Loop], Lookup);
+        
+        ECSRegistryDeregister(Context, Entities[Loop]);
+    }
+    
+    const size_t SegmentCount = Count - Offset;
+    if (SegmentCount) CCArrayAppendElements(Context->manager.available, Entities + Offset, SegmentCount);
+}
+
+void ECSDuplicateDestructor(void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Data, "Data must not be null");
+    
+    const size_t Index = (ID & ~ECSComponentStorageMask);
+    ECSComponentDestructor Destructor = NULL;
+    
+    switch (ID & ECSComponentStorageTypeMask)
+    {
+        case ECSComponentStorageTypeArchetype:
+            Destructor = ECSDuplicateArchetypeComponentDestructors[Index];
+            break;
+            
+        case ECSComponentStorageTypePacked:
+            Destructor = ECSDuplicatePackedComponentDestructors[Index];
+            break;
+            
+        case ECSComponentStorageTypeIndexed:
+            Destructor = ECSDuplicateIndexedComponentDestructors[Index];
+            break;
+            
+        case ECSComponentStorageTypeLocal:
+            Destructor = ECSDuplicateLocalComponentDestructors[ECSLocalComponentIndex(ID)];
+            break;
+            
+        default:
+            CCAssertLog(0, "Unsupported component type");
+            break;
+    }
+    
+    ECSDuplicateComponent *Duplicates = Data;
+    
+    if (Destructor)
+    {
+        const size_t Size = ECSDuplicateComponentSize(ID);
+        
+        for (size_t Loop = 0, Count = ECSDuplicateComponentGetCount(Duplicates); Loop < Count; Loop++)
+        {
+            Destructor(ECSDuplicateComponentGetElementAtIndex(Duplicates, Size, Loop), ID);
+        }
+    }
+    
+    ECSDuplicateComponentDestroy(Duplicates);
+}
+
+void ECSEntityGetComponents(ECSContext *Context, ECSEntity Entity, ECSTypedComponent *Components, size_t *Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Count, "Count must not be null");
+    
+    const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    size_t ComponentCount = 0;
+    const size_t BlockSize = CC_BITS_BLOCK_SIZE(Lookup->has);
+    
+    for (size_t Loop2 = 0; Loop2 < ECS_COMPONENT_MAX; Loop2 += BlockSize)
+    {
+        if (CCBitsAny(Lookup->has, Loop2, BlockSize))
+        {
+            for (size_t Loop3 = 0; Loop3 < BlockSize; Loop3++)
+            {
+                const size_t Index = Loop2 + Loop3;
+                
+                if (CCBitsGet(Lookup->has, Index))
+                {
+                    if ((Components) && (ComponentCount < *Count))
+                    {
+                        const ECSComponentID ID = ECSComponentIDs[Index];
+                        
+                        Components[ComponentCount] = (ECSTypedComponent){
+                            .id = ID,
+                            .data = ECSEntityGetComponent(Context, Entity, ID) // TODO: Optimise this by handling archetype separate to the loop (loop only has to start for components after archetype max)
+                        };
+                    }
+                    
+                    if (ComponentCount++ >= *Count) return;
+                }
+            }
+        }
+    }
+    
+    *Count = ComponentCount;
+}
+
+const size_t *ECSArchetypeComponentSizes;
+const size_t *ECSPackedComponentSizes;
+const size_t *ECSIndexedComponentSizes;
+const size_t *ECSLocalComponentSizes;
+const size_t *ECSDuplicateArchetypeComponentSizes;
+const size_t *ECSDuplicatePackedComponentSizes;
+const size_t *ECSDuplicateIndexedComponentSizes;
+const size_t *ECSDuplicateLocalComponentSizes;
+const size_t *ECSSharedArchetypeComponentSizes;
+
+const ECSComponentDestructor *ECSArchetypeComponentDestructors;
+const ECSComponentDestructor *ECSPackedComponentDestructors;
+const ECSComponentDestructor *ECSIndexedComponentDestructors;
+const ECSComponentDestructor *ECSLocalComponentDestructors;
+const ECSComponentDestructor *ECSDuplicateArchetypeComponentDestructors;
+const ECSComponentDestructor *ECSDuplicatePackedComponentDestructors;
+const ECSComponentDestructor *ECSDuplicateIndexedComponentDestructors;
+const ECSComponentDestructor *ECSDuplicateLocalComponentDestructors;
+const ECSComponentDestructor *ECSSharedArchetypeComponentDestructors;
+
+const ECSSnapshotComponentHooks *ECSArchetypeComponentSnapshotHooks;
+const ECSSnapshotComponentHooks *ECSPackedComponentSnapshotHooks;
+const ECSSnapshotComponentHooks *ECSIndexedComponentSnapshotHooks;
+const ECSSnapshotComponentHooks *ECSLocalComponentSnapshotHooks;
+
+const ECSLink * const *ECSSnapshotLinks;
+size_t ECSSnapshotLinkCount;
+
+static size_t SortedAdd(ECSArchetypeComponentID *Elements, size_t Count, ECSArchetypeComponentID Value)
+{
+    for (size_t Loop = Count; Loop--; )
+    {
+        if (Elements[Loop] > Value) Elements[Loop + 1] = Elements[Loop];
+        else
+        {
+            Elements[Loop + 1] = Value;
+            
+            return Loop + 1;
+        }
+    }
+    
+    Elements[0] = Value;
+    
+    return 0;
+}
+
+static inline size_t FindIndex(const ECSArchetypeComponentID *Elements, size_t Count, ECSArchetypeComponentID Max, ECSArchetypeComponentID Value)
+{
+    size_t Offset = 0;
+    
+    if (Value >= (Max / 2))
+    {
+        const size_t Reverse = (Max - Value) + 1;
+        
+        if (Reverse < Count)
+        {
+            Offset = Count - Reverse;
+            Count = Reverse;
+        }
+    }
+    
+    else if (Value < Count) Count = Value + 1;
+    
+    Elements += Offset;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        if (Elements[Loop] == Value) return Loop + Offset;
+        else if (Elements[Loop] > Value) break;
+    }
+    
+    return SIZE_MAX;
+}
+
+static size_t SortedSub(ECSArchetypeComponentID *Elements, size_t Count, ECSArchetypeComponentID Value)
+{
+#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
+    ECSArchetypeComponentID CurrentID = INT8_MAX;
+#else
+    ECSArchetypeComponentID CurrentID = UINT8_MAX;
+#endif
+    
+    for (size_t Loop = Count; Loop--; )
+    {
+        ECSArchetypeComponentID Temp = Elements[Loop];
+        Elements[Loop] = CurrentID;
+        CurrentID = Temp;
+        
+        if (CurrentID == Value) return Loop;
+    }
+    
+    Elements[0] = CurrentID;
+    
+    return 0;
+}
+
+#if ECS_CHANGE_VERSION
+/*!
+ * @brief Stamp all columns of the chunks containing a range of entities in an archetype with a new version.
+ * @description This will also grow the archetype's versions to cover all of its entities.
+ * @param Context The context.
+ * @param Arch The archetype that was changed.
+ * @param Index The first entity that was changed.
+ * @param Count The number of entities that were changed.
+ */
+static void ArchetypeChanged(ECSContext *Context, ECSArchetype *Arch, size_t Index, size_t Count)
+{
+    const size_t Columns = CCArrayGetElementSize(Arch->versions) / sizeof(ECSChangeVersion);
+    const size_t ChunkCount = (CCArrayGetCount(Arch->entities) + Arch->chunk - 1) / Arch->chunk;
+    const size_t CurrentCount = CCArrayGetCount(Arch->versions);
+    
+    if (ChunkCount > CurrentCount)
+    {
+        CCArrayAppendElements(Arch->versions, NULL, ChunkCount - CurrentCount);
+        memset(CCArrayGetElementAtIndex(Arch->versions, CurrentCount), 0, CCArrayGetElementSize(Arch->versions) * (ChunkCount - CurrentCount));
+    }
+    
+    if (!Count) return;
+    
+    const ECSChangeVersion Version = atomic_fetch_add_explicit(&Context->version, 1, memory_order_relaxed) + 1;
+    ECSChangeVersion *Versions = CCArrayGetData(Arch->versions);
+    
+    for (size_t Chunk = Index / Arch->chunk, End = ((Index + Count - 1) / Arch->chunk) + 1; Chunk < End; Chunk++)
+    {
+        for (size_t Loop = 0; Loop < Columns; Loop++) Versions[(Chunk * Columns) + Loop] = Version;
+    }
+}
+
+#define ECS_ARCHETYPE_CHANGED(context, archetype, index, count) ArchetypeChanged(context, archetype, index, count)
+#define ECS_COMPONENT_CHANGED(context, component) atomic_store_explicit(&(component), atomic_fetch_add_explicit(&(context)->version, 1, memory_order_relaxed) + 1, memory_order_relaxed)
+#else
+#define ECS_ARCHETYPE_CHANGED(context, archetype, index, count)
+#define ECS_COMPONENT_CHANGED(context, component)
+#endif
+
+static void ArchetypeRemove(ECSContext *Context, ECSArchetype *Arch, size_t Count, size_t Index)
+{
+    const size_t LastIndex = CCArrayGetCount(Arch->components[0]) - 1;
+    if (Index != LastIndex)
+    {
+        for (size_t Loop = 0; Loop < Count; Loop++)
+        {
+            const void *Data = CCArrayGetElementAtIndex(Arch->components[Loop], LastIndex);
+            CCArrayReplaceElementAtIndex(Arch->components[Loop], Index, Data);
+            CCArrayRemoveElementAtIndex(Arch->components[Loop], LastIndex);
+        }
+        
+        const ECSEntity *Entity = CCArrayGetElementAtIndex(Arch->entities, LastIndex);
+        CCArrayReplaceElementAtIndex(Arch->entities, Index, Entity);
+        CCArrayRemoveElementAtIndex(Arch->entities, LastIndex);
+        
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, *Entity);
+        Lookup->index = Index;
+        
+        ECS_ARCHETYPE_CHANGED(Context, Arch, Index, 1);
+    }
+    
+    else
+    {
+        for (size_t Loop = 0; Loop < Count; Loop++)
+        {
+            CCArrayRemoveElementAtIndex(Arch->components[Loop], LastIndex);
+        }
+        
+        CCArrayRemoveElementAtIndex(Arch->entities, LastIndex);
+    }
+}
+
+static void ArchetypeCreate(ECSContext *Context, ECSArchetype *Archetype, size_t ArchID, const ECSArchetypeComponentID *IDs, size_t Count)
+{
+    const size_t ChunkSize = ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ArchID, Count);
+    
+    Archetype->chunk = ChunkSize;
+    Archetype->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize);
+    
+    for (size_t Loop = 0; Loop < Count; Loop++) Archetype->components[Loop] = CCArrayCreate(CC_STD_ALLOCATOR, ECSArchetypeComponentSizes[IDs[Loop]], ChunkSize);
+    
+    Archetype->mask = (ECSArchetypeComponentMask){ 0 };
+    for (size_t Loop = 0; Loop < Count; Loop++) ECSArchetypeComponentMaskSet(&Archetype->mask, IDs[Loop]);
+    
+#if ECS_CHANGE_VERSION
+    Archetype->versions = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSChangeVersion) * Count, 4);
+#endif
+    
+    if (!Context->archetypeInfo) Context->archetypeInfo = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSArchetypeInfo), 16);
+    
+    Archetype->info = CCArrayGetCount(Context->archetypeInfo);
+    
+    ECSArchetypeInfo Info = {
+        .offset = (void*)Archetype - (void*)Context,
+        .mask = Archetype->mask,
+        .count = Count
+    };
+    
+    memcpy(Info.ids, IDs, sizeof(ECSArchetypeComponentID) * Count);
+    
+    CCArrayAppendElement(Context->archetypeInfo, &Info);
+}
+
+static size_t ArchtypeIndex(const ECSArchetypeComponentID *set, size_t n)
+{
+    size_t result = 0;
+    size_t factorial = 1;
+    
+    for (size_t i = 0; i < n; i++)
+    {
+        factorial *= (i + 1) * 1;
+
+        size_t p = 1;
+        for (size_t j = 0; j <= i; j++)
+        {
+            p *= (set[i] - j);
+        }
+
+        result += p / factorial;
+    }
+
+    return result;
+}
+
+#define ECS_ARCHETYPE_OFFSET(x, index) { offsetof(ECSContext, archetypes##index), sizeof(ECSArchetype(index)) }
+#define ECS_ARCHETYPE_INIT_OFFSETS(count) CC_REPEAT(1, count, ECS_ARCHETYPE_OFFSET)
+
+static const struct {
+    ptrdiff_t base;
+    ptrdiff_t size;
+} ArchetypeOffset[ECS_ARCHETYPE_MAX + 1] = {
+    { 0, 0 },
+    ECS_ARCHETYPE_INIT_OFFSETS(ECS_ARCHETYPE_MAX)
+};
+
+/*!
+ * @brief Get the archetype an entity moves to when an archetype component is added or removed.
+ * @description On a cache hit the destination component IDs are copied from the destination's archetype info, otherwise they're
+ *              recomputed and the transition is cached.
+ *
+ * @param Context The context to be used.
+ * @param Source The archetype the entity is in (may be NULL).
+ * @param IDs The sorted component IDs of the source archetype. These are replaced with the sorted component IDs of the destination,
+ *            where a removal leaves the unused slot empty.
+ *
+ * @param Count The number of component IDs in the source archetype.
+ * @param Component The archetype component ID being added or removed.
+ * @param Add Whether the component is being added (TRUE) or removed (FALSE).
+ * @return The destination archetype.
+ */
+static ECSArchetype *ArchetypeTransition(ECSContext *Context, ECSArchetype *Source, ECSArchetypeComponentID *IDs, size_t Count, ECSArchetypeComponentID Component, _Bool Add)
+{
+    const ptrdiff_t SourceOffset = Source ? (void*)Source - (void*)Context : 0;
+    const uint64_t Key = ((uint64_t)SourceOffset << 16) | ((uint64_t)Component << 1) | Add;
+    
+    ECSArchetypeEdge *Edge = &Context->edges[(size_t)((Key * UINT64_C(0x9e3779b97f4a7c15)) >> 32) & (ECS_ARCHETYPE_EDGE_CACHE_MAX - 1)];
+    
+    if ((Edge->dest) && (Edge->source == SourceOffset) && (Edge->component == Component) && (Edge->add == Add))
+    {
+        ECSArchetype *Archetype = (void*)Context + Edge->dest;
+        const ECSArchetypeInfo *Info = CCArrayGetElementAtIndex(Context->archetypeInfo, Archetype->info);
+        
+        memcpy(IDs, Info->ids, sizeof(ECSArchetypeComponentID) * Info->count);
+        
+        if (!Add)
+        {
+#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
+            IDs[Info->count] = INT8_MAX;
+#else
+            IDs[Info->count] = UINT8_MAX;
+#endif
+        }
+        
+        return Archetype;
+    }
+    
+    if (Add) SortedAdd(IDs, Count++, Component);
+    else SortedSub(IDs, Count--, Component);
+    
+    const size_t ArchID = ArchtypeIndex(IDs, Count);
+    ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
+    
+    *Edge = (ECSArchetypeEdge){
+        .source = SourceOffset,
+        .dest = (void*)Archetype - (void*)Context,
+        .index = ArchID,
+        .component = Component,
+        .add = Add
+    };
+    
+    if (CC_UNLIKELY(!Archetype->entities)) ArchetypeCreate(Context, Archetype, ArchID, IDs, Count);
+    
+    return Archetype;
+}
+
+const ECSArchetypeEdge *ECSArchetypeGetEdges(ECSContext *Context, size_t *Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Count, "Count must not be null");
+    
+    *Count = ECS_ARCHETYPE_EDGE_CACHE_MAX;
+    
+    return Context->edges;
+}
+
+ECSQuery ECSQueryCreate(ECSContext *Context, const ECSComponentID *With, size_t WithCount, const ECSComponentID *Without, size_t WithoutCount, const ECSComponentID *Optional, size_t OptionalCount)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(!WithCount || With, "With must not be null");
+    CCAssertLog(!WithoutCount || Without, "Without must not be null");
+    CCAssertLog(!OptionalCount || Optional, "Optional must not be null");
+    CCAssertLog(WithCount <= ECS_ARCHETYPE_MAX, "WithCount must not exceed the maximum number of archetype components");
+    CCAssertLog(OptionalCount <= ECS_ARCHETYPE_MAX, "OptionalCount must not exceed the maximum number of archetype components");
+    
+    ECSQuery Query = {
+        .context = Context,
+        .with = { .count = WithCount },
+        .optional = { .count = OptionalCount },
+        .archetypes = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ptrdiff_t), 16),
+        .indexes = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(size_t), 16 * CCMax(WithCount + OptionalCount, 1)),
+        .seen = 0
+    };
+    
+    for (size_t Loop = 0; Loop < WithCount; Loop++)
+    {
+        CCAssertLog((With[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype, "With must only contain archetype components");
+        
+        Query.with.ids[Loop] = With[Loop] & ~ECSComponentStorageMask;
+        ECSArchetypeComponentMaskSet(&Query.mask.with, Query.with.ids[Loop]);
+    }
+    
+    for (size_t Loop = 0; Loop < WithoutCount; Loop++)
+    {
+        CCAssertLog((Without[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype, "Without must only contain archetype components");
+        
+        ECSArchetypeComponentMaskSet(&Query.mask.without, Without[Loop] & ~ECSComponentStorageMask);
+    }
+    
+    for (size_t Loop = 0; Loop < OptionalCount; Loop++)
+    {
+        CCAssertLog((Optional[Loop] & ECSComponentStorageTypeMask) == ECSComponentStorageTypeArchetype, "Optional must only contain archetype components");
+        
+        Query.optional.ids[Loop] = Optional[Loop] & ~ECSComponentStorageMask;
+    }
+    
+    ECSQueryUpdate(&Query);
+    
+    return Query;
+}
+
+void ECSQueryDestroy(ECSQuery *Query)
+{
+    CCAssertLog(Query, "Query must not be null");
+    
+    CCArrayDestroy(Query->archetypes);
+    CCArrayDestroy(Query->indexes);
+}
+
+void ECSQueryUpdate(ECSQuery *Query)
+{
+    CCAssertLog(Query, "Query must not be null");
+    
+    CCArray(ECSArchetypeInfo) Infos = Query->context->archetypeInfo;
+    
+    if (!Infos) return;
+    
+    const size_t Count = CCArrayGetCount(Infos);
+    
+    for (size_t Loop = Query->seen; Loop < Count; Loop++)
+    {
+        const ECSArchetypeInfo *Info = CCArrayGetElementAtIndex(Infos, Loop);
+        
+        if (ECSArchetypeComponentMaskMatch(&Info->mask, &Query->mask.with, &Query->mask.without))
+        {
+            size_t Indexes[ECS_ARCHETYPE_MAX * 2];
+            
+            for (size_t Loop2 = 0; Loop2 < Query->with.count; Loop2++)
+            {
+                Indexes[Loop2] = ECSArchetypeComponentMaskIndex(&Info->mask, Query->with.ids[Loop2]);
+            }
+            
+            for (size_t Loop2 = 0; Loop2 < Query->optional.count; Loop2++)
+            {
+                Indexes[Query->with.count + Loop2] = ECSArchetypeComponentMaskIndex(&Info->mask, Query->optional.ids[Loop2]);
+            }
+            
+            CCArrayAppendElement(Query->archetypes, &Info->offset);
+            CCArrayAppendElements(Query->indexes, Indexes, Query->with.count + Query->optional.count);
+        }
+    }
+    
+    Query->seen = Count;
+}
+
+static inline size_t ECSQueryChunkSize(const ECSArchetype *Archetype, size_t ChunkSize)
+{
+    return ChunkSize == ECS_SYSTEM_CHUNK_ARCHETYPE ? Archetype->chunk : ChunkSize;
+}
+
+void ECSQueryIterate(ECSQuery *Query, ECSQueryCallback Callback, void *Data, size_t ChunkSize)
+{
+    CCAssertLog(Query, "Query must not be null");
+    CCAssertLog(Callback, "Callback must not be null");
+    CCAssertLog(ChunkSize, "ChunkSize must not be 0");
+    
+    ECSQueryUpdate(Query);
+    
+    ECSContext * const Context = Query->context;
+    const size_t IndexCount = Query->with.count + Query->optional.count;
+    const size_t * const Indexes = CCArrayGetData(Query->indexes);
+    
+    for (size_t Loop = 0, ArchCount = CCArrayGetCount(Query->archetypes); Loop < ArchCount; Loop++)
+    {
+        ECSArchetype *Archetype = (void*)Context + *(ptrdiff_t*)CCArrayGetElementAtIndex(Query->archetypes, Loop);
+        const size_t Count = CCArrayGetCount(Archetype->entities);
+        const size_t ArchChunkSize = ECSQueryChunkSize(Archetype, ChunkSize);
+        
+        for (size_t Offset = 0; Offset < Count; Offset += CCMin(Count - Offset, ArchChunkSize))
+        {
+            Callback(Context, Archetype, Indexes + (Loop * IndexCount), (ECSRange){ .index = Offset, .count = CCMin(Count - Offset, ArchChunkSize) }, Data);
+        }
+    }
+}
+
+typedef struct {
+    ECSContext *context;
+    ECSArchetype *archetype;
+    const size_t *indexes;
+    ECSQueryCallback callback;
+    void *data;
+} ECSQueryTaskData;
+
+static void ECSQueryTask(void *Data, ECSRange Range)
+{
+    const ECSQueryTaskData *Task = Data;
+    
+    Task->callback(Task->context, Task->archetype, Task->indexes, Range, Task->data);
+}
+
+void ECSQueryIterateParallel(ECSQuery *Query, ECSQueryCallback Callback, void *Data, size_t ChunkSize)
+{
+    CCAssertLog(Query, "Query must not be null");
+    CCAssertLog(Callback, "Callback must not be null");
+    CCAssertLog(ChunkSize, "ChunkSize must not be 0");
+    
+    ECSQueryUpdate(Query);
+    
+    const size_t IndexCount = Query->with.count + Query->optional.count;
+    const size_t * const Indexes = CCArrayGetData(Query->indexes);
+    
+    for (size_t Loop = 0, ArchCount = CCArrayGetCount(Query->archetypes); Loop < ArchCount; Loop++)
+    {
+        ECSQueryTaskData Task = {
+            .context = Query->context,
+            .archetype = (void*)Query->context + *(ptrdiff_t*)CCArrayGetElementAtIndex(Query->archetypes, Loop),
+            .indexes = Indexes + (Loop * IndexCount),
+            .callback = Callback,
+            .data = Data
+        };
+        
+        ECSParallelFor(ECSQueryTask, &Task, CCArrayGetCount(Task.archetype->entities), ECSQueryChunkSize(Task.archetype, ChunkSize));
+    }
+}
+
+#if ECS_CHANGE_VERSION
+ECSRange ECSArchetypeNextChangedRange(const ECSArchetype *Archetype, const size_t *ArchetypeComponentIndexes, size_t Count, ECSRange *Range, ECSChangeVersion Since)
+{
+    CCAssertLog(Archetype, "Archetype must not be null");
+    CCAssertLog(ArchetypeComponentIndexes, "ArchetypeComponentIndexes must not be null");
+    CCAssertLog(Range, "Range must not be null");
+    
+    const size_t EntityCount = CCArrayGetCount(Archetype->entities);
+    const size_t End = CCMin(EntityCount, Range->index + CCMin(Range->count, EntityCount));
+    const size_t Columns = CCArrayGetElementSize(Archetype->versions) / sizeof(ECSChangeVersion);
+    const ECSChangeVersion *Versions = CCArrayGetData(Archetype->versions);
+    
+    ECSRange Changed = { .index = End, .count = 0 };
+    
+    for (size_t Index = Range->index; Index < End; )
+    {
+        const size_t Chunk = Index / Archetype->chunk;
+        const size_t ChunkEnd = CCMin((Chunk + 1) * Archetype->chunk, End);
+        
+        _Bool Newer = FALSE;
+        for (size_t Loop = 0; (!Newer) && (Loop < Count); Loop++)
+        {
+            Newer = ECSChangeVersionIsNewer(Versions[(Chunk * Columns) + ArchetypeComponentIndexes[Loop]], Since);
+        }
+        
+        if (Newer)
+        {
+            if (!Changed.count) Changed.index = Index;
+            
+            Changed.count = ChunkEnd - Changed.index;
+        }
+        
+        else if (Changed.count) break;
+        
+        Index = ChunkEnd;
+    }
+    
+    const size_t Consumed = (Changed.count ? Changed.index + Changed.count : End) - CCMin(Range->index, End);
+    
+    Range->index += Consumed;
+    Range->count = Range->count > Consumed ? Range->count - Consumed : 0;
+    
+    return Changed;
+}
+
+void ECSQueryIterateChanged(ECSQuery *Query, ECSQueryCallback Callback, void *Data, size_t ChunkSize, ECSChangeVersion Since)
+{
+    CCAssertLog(Query, "Query must not be null");
+    CCAssertLog(Callback, "Callback must not be null");
+    CCAssertLog(ChunkSize, "ChunkSize must not be 0");
+    
+    ECSQueryUpdate(Query);
+    
+    ECSContext * const Context = Query->context;
+    const size_t IndexCount = Query->with.count + Query->optional.count;
+    const size_t * const Indexes = CCArrayGetData(Query->indexes);
+    
+    for (size_t Loop = 0, ArchCount = CCArrayGetCount(Query->archetypes); Loop < ArchCount; Loop++)
+    {
+        ECSArchetype *Archetype = (void*)Context + *(ptrdiff_t*)CCArrayGetElementAtIndex(Query->archetypes, Loop);
+        const size_t ArchChunkSize = ECSQueryChunkSize(Archetype, ChunkSize);
+        const size_t *ArchetypeComponentIndexes = Indexes + (Loop * IndexCount);
+        
+        ECSRange Remaining = { .index = 0, .count = SIZE_MAX };
+        
+        for (ECSRange Changed; (Changed = ECSArchetypeNextChangedRange(Archetype, ArchetypeComponentIndexes, Query->with.count, &Remaining, Since)).count; )
+        {
+            for (size_t Offset = 0; Offset < Changed.count; Offset += CCMin(Changed.count - Offset, ArchChunkSize))
+            {
+                Callback(Context, Archetype, ArchetypeComponentIndexes, (ECSRange){ .index = Changed.index + Offset, .count = CCMin(Changed.count - Offset, ArchChunkSize) }, Data);
+            }
+        }
+    }
+}
+#endif
+
+ECSSharedComponentHandle ECSSharedComponentIntern(ECSContext *Context, const void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Data, "Data must not be null");
+    CCAssertLog((ID & (ECSComponentStorageTypeMask | ECSComponentStorageModifierShared)) == (ECSComponentStorageTypeArchetype | ECSComponentStorageModifierShared), "ID must be a shared archetype component");
+    CCAssertLog(CurrentWorkerID == (ECSWorkerID)-1, "Shared components must not be used from a worker thread");
+    
+    const size_t Index = ID & ~ECSComponentStorageMask;
+    const size_t Size = ECSSharedArchetypeComponentSizes[Index];
+    
+    if (!Context->shared[Index]) Context->shared[Index] = CCDictionaryCreate(CC_STD_ALLOCATOR, CCDictionaryHintHeavyFinding | CCDictionaryHintHeavyInserting | CCDictionaryHintHeavyDeleting, Size, sizeof(ECSSharedComponentHandle), NULL);
+    
+    CCDictionaryEntry Entry = CCDictionaryEntryForKey(Context->shared[Index], Data);
+    
+    if (CCDictionaryEntryIsInitialized(Context->shared[Index], Entry))
+    {
+        return ECSSharedComponentRetain(*(ECSSharedComponentHandle*)CCDictionaryGetEntry(Context->shared[Index], Entry));
+    }
+    
+    ECSSharedComponentHandle Handle = CCMalloc(CC_STD_ALLOCATOR, sizeof(ECSSharedComponentValue) + Size, NULL, CC_DEFAULT_ERROR_CALLBACK);
+    
+    Handle->context = Context;
+    Handle->refs = 1;
+    Handle->id = ID;
+    memcpy(Handle->data, Data, Size);
+    
+    CCDictionarySetEntry(Context->shared[Index], Entry, &Handle);
+    
+    return Handle;
+}
+
+ECSSharedComponentHandle ECSSharedComponentRetain(ECSSharedComponentHandle Handle)
+{
+    CCAssertLog(Handle, "Handle must not be null");
+    CCAssertLog(CurrentWorkerID == (ECSWorkerID)-1, "Shared components must not be used from a worker thread");
+    
+    Handle->refs++;
+    
+    return Handle;
+}
+
+void ECSSharedComponentRelease(ECSSharedComponentHandle Handle)
+{
+    CCAssertLog(Handle, "Handle must not be null");
+    CCAssertLog(Handle->refs, "Handle must be retained");
+    CCAssertLog(CurrentWorkerID == (ECSWorkerID)-1, "Shared components must not be used from a worker thread");
+    
+    if (--Handle->refs) return;
+    
+    const size_t Index = Handle->id & ~ECSComponentStorageMask;
+    
+    CCDictionaryRemoveValue(Handle->context->shared[Index], Handle->data);
+    
+    if ((ECSSharedArchetypeComponentDestructors) && (ECSSharedArchetypeComponentDestructors[Index])) ECSSharedArchetypeComponentDestructors[Index](Handle->data, Handle->id);
+    
+    CCFree(Handle);
+}
+
+void ECSSharedDestructor(void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Data, "Data must not be null");
+    
+    ECSSharedComponentRelease(*(ECSSharedComponentHandle*)Data);
+}
+
+typedef struct {
+    ECSSharedComponentHandle handle;
+    size_t index;
+} ECSSharedComponentRow;
+
+static int SharedComponentRowCompare(const void *a, const void *b)
+{
+    const ECSSharedComponentRow *RowA = a, *RowB = b;
+    
+    if (RowA->handle != RowB->handle) return (uintptr_t)RowA->handle < (uintptr_t)RowB->handle ? -1 : 1;
+    
+    return RowA->index < RowB->index ? -1 : (RowA->index > RowB->index);
+}
+
+void ECSSharedComponentGroup(ECSContext *Context, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog((ID & (ECSComponentStorageTypeMask | ECSComponentStorageModifierShared)) == (ECSComponentStorageTypeArchetype | ECSComponentStorageModifierShared), "ID must be a shared archetype component");
+    CCAssertLog(CurrentWorkerID == (ECSWorkerID)-1, "Shared components must not be used from a worker thread");
+    
+    if (!Context->archetypeInfo) return;
+    
+    const ECSArchetypeComponentID CompIndex = ID & ~ECSComponentStorageMask;
+    
+    for (size_t Loop = 0, InfoCount = CCArrayGetCount(Context->archetypeInfo); Loop < InfoCount; Loop++)
+    {
+        const ECSArchetypeInfo *Info = CCArrayGetElementAtIndex(Context->archetypeInfo, Loop);
+        const size_t Column = ECSArchetypeComponentMaskIndex(&Info->mask, CompIndex);
+        
+        if (Column == SIZE_MAX) continue;
+        
+        ECSArchetype *Archetype = (void*)Context + Info->offset;
+        const size_t Count = CCArrayGetCount(Archetype->entities);
+        const ECSSharedComponentHandle *Handles = CCArrayGetData(Archetype->components[Column]);
+        
+        size_t Sorted = 1;
+        while ((Sorted < Count) && ((uintptr_t)Handles[Sorted - 1] <= (uintptr_t)Handles[Sorted])) Sorted++;
+        
+        if (Sorted >= Count) continue;
+        
+        ECSSharedComponentRow *Rows = CCMalloc(CC_STD_ALLOCATOR, sizeof(ECSSharedComponentRow) * Count, NULL, CC_DEFAULT_ERROR_CALLBACK);
+        
+        for (size_t Loop2 = 0; Loop2 < Count; Loop2++) Rows[Loop2] = (ECSSharedComponentRow){ .handle = Handles[Loop2], .index = Loop2 };
+        
+        qsort(Rows, Count, sizeof(ECSSharedComponentRow), SharedComponentRowCompare);
+        
+        size_t BufferSize = sizeof(ECSEntity);
+        for (size_t Loop2 = 0; Loop2 < Info->count; Loop2++) BufferSize = CCMax(BufferSize, CCArrayGetElementSize(Archetype->components[Loop2]));
+        
+        uint8_t *Buffer = CCMalloc(CC_STD_ALLOCATOR, BufferSize * Count, NULL, CC_DEFAULT_ERROR_CALLBACK);
+        
+        for (size_t Loop2 = 0; Loop2 <= Info->count; Loop2++)
+        {
+            CCArray Array = Loop2 < Info->count ? Archetype->components[Loop2] : Archetype->entities;
+            const size_t Size = CCArrayGetElementSize(Array);
+            
+            if (!Size) continue;
+            
+            for (size_t Loop3 = 0; Loop3 < Count; Loop3++) memcpy(Buffer + (Size * Loop3), CCArrayGetElementAtIndex(Array, Rows[Loop3].index), Size);
+            
+            memcpy(CCArrayGetData(Array), Buffer, Size * Count);
+        }
+        
+        CCFree(Buffer);
+        CCFree(Rows);
+        
+        const ECSEntity *Entities = CCArrayGetData(Archetype->entities);
+        
+        for (size_t Loop2 = 0; Loop2 < Count; Loop2++)
+        {
+            ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop2]);
+            Lookup->index = Loop2;
+        }
+        
+        ECS_ARCHETYPE_CHANGED(Context, Archetype, 0, Count);
+    }
+}
+
+ECSRange ECSArchetypeNextSharedRange(const ECSArchetype *Archetype, size_t ArchetypeComponentIndex, ECSRange *Range)
+{
+    CCAssertLog(Archetype, "Archetype must not be null");
+    CCAssertLog(Range, "Range must not be null");
+    
+    const size_t EntityCount = CCArrayGetCount(Archetype->entities);
+    const size_t End = CCMin(EntityCount, Range->index + CCMin(Range->count, EntityCount));
+    
+    if (Range->index >= End) return (ECSRange){ .index = End, .count = 0 };
+    
+    const ECSSharedComponentHandle *Handles = CCArrayGetData(Archetype->components[ArchetypeComponentIndex]);
+    const size_t Index = Range->index;
+    
+    size_t Next = Index + 1;
+    while ((Next < End) && (Handles[Next] == Handles[Index])) Next++;
+    
+    const size_t Consumed = Next - Index;
+    
+    Range->index = Next;
+    Range->count = Range->count > Consumed ? Range->count - Consumed : 0;
+    
+    return (ECSRange){ .index = Index, .count = Consumed };
+}
+
+void ECSArchetypeAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
+    
+    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    const size_t CompIndex = ID & ~ECSComponentStorageMask;
+    
+    if (ECSEntityHasComponent(Context, Entity, ID))
+    {
+        ECSArchetype *Archetype = Lookup->archetype;
+        size_t Index = ECSArchetypeComponentMaskIndex(&Archetype->mask, CompIndex);
+        
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+#if ECS_IMPURE_COMPONENT_DESTRUCTION
+            // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
+            ECSArchetypeRemoveComponent(Context, Entity, ID);
+            ECSArchetypeAddComponent(Context, Entity, Data, ID);
+            
+            return;
+#else
+            _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+            CCBitsClear(Lookup->has, CompIndex);
+            
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+            ECSArchetypeComponentDestructors[CompIndex](CCArrayGetElementAtIndex(Archetype->components[Index], Lookup->index), ID);
+#else
+            CCMemoryZoneSave(ECSSharedZone);
+            
+            ECSArchetypeComponentDestructors[CompIndex](ECSSharedZoneStore(CCArrayGetElementAtIndex(Archetype->components[Index], Lookup->index), ECSArchetypeComponentSizes[CompIndex]), ID);
+            
+            CCMemoryZoneRestore(ECSSharedZone);
+#endif
+            
+            CCBitsSet(Lookup->has, CompIndex);
+            
+            if (Archetype != Lookup->archetype)
+            {
+                Archetype = Lookup->archetype;
+                Index = ECSArchetypeComponentMaskIndex(&Archetype->mask, CompIndex);
+            }
+#endif
+        }
+        
+        CCArrayReplaceElementAtIndex(Archetype->components[Index], Lookup->index, Data);
+        
+        ECS_ARCHETYPE_CHANGED(Context, Archetype, Lookup->index, 1);
+    }
+    
+    else
+    {
+        ECSArchetype *Archetype = ArchetypeTransition(Context, Lookup->archetype, Refs->archetype.component.ids, Refs->archetype.component.count++, CompIndex, TRUE);
+        const size_t AddedIndex = ECSArchetypeComponentMaskIndex(&Archetype->mask, CompIndex);
+        const size_t Count = Refs->archetype.component.count;
+        
+        const size_t Index = CCArrayAppendElement(Archetype->components[AddedIndex], Data);
+        CCArrayAppendElement(Archetype->entities, &Entity);
+        
+        if (Lookup->archetype)
+        {
+            ECSArchetype *PrevArchetype = Lookup->archetype;
+            
+            for (size_t Loop = 0; Loop < Count; Loop++)
+            {
+                if (Loop < AddedIndex)
+                {
+                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Lookup->index);
+                    CCArrayAppendElement(Archetype->components[Loop], Copy);
+                }
+                
+                else if (Loop > AddedIndex)
+                {
+                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop - 1], Lookup->index);
+                    CCArrayAppendElement(Archetype->components[Loop], Copy);
+                }
+            }
+            
+            ArchetypeRemove(Context, PrevArchetype, Count - 1, Lookup->index);
+        }
+        
+        Lookup->archetype = Archetype;
+        Lookup->index = Index;
+        
+        ECS_ARCHETYPE_CHANGED(Context, Archetype, Index, 1);
+        
+        CCBitsSet(Lookup->has, CompIndex);
+    }
+}
+
+void ECSArchetypeRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    
+    if (ECSEntityHasComponent(Context, Entity, ID))
+    {
+        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+        
+        const size_t CompIndex = ID & ~ECSComponentStorageMask;
+        const size_t RemovedIndex = ECSArchetypeComponentMaskIndex(&Lookup->archetype->mask, CompIndex);
+        
+        _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+        CCBitsClear(Lookup->has, CompIndex);
+        
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor) ECSArchetypeComponentDestructors[CompIndex](CCArrayGetElementAtIndex(Lookup->archetype->components[RemovedIndex], Lookup->index), ID);
+#else
+        void *CopiedComponent;
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+            CCMemoryZoneSave(ECSSharedZone);
+            
+            CopiedComponent = ECSSharedZoneStore(CCArrayGetElementAtIndex(Lookup->archetype->components[RemovedIndex], Lookup->index), ECSArchetypeComponentSizes[CompIndex]);
+        }
+#endif
+        
+        const size_t Count = --Refs->archetype.component.count;
+        if (Count)
+        {
+            ECSArchetype *Archetype = ArchetypeTransition(Context, Lookup->archetype, Refs->archetype.component.ids, Count + 1, CompIndex, FALSE);
+            
+            const size_t Index = CCArrayAppendElement(Archetype->entities, &Entity);
+            
+            const size_t PrevCount = Count + 1;
+            ECSArchetype *PrevArchetype = Lookup->archetype;
+            
+            for (size_t Loop = 0; Loop < PrevCount; Loop++)
+            {
+                if (Loop < RemovedIndex)
+                {
+                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Lookup->index);
+                    CCArrayAppendElement(Archetype->components[Loop], Copy);
+                }
+                
+                else if (Loop > RemovedIndex)
+                {
+                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Lookup->index);
+                    CCArrayAppendElement(Archetype->components[Loop - 1], Copy);
+                }
+            }
+            
+            ArchetypeRemove(Context, PrevArchetype, PrevCount, Lookup->index);
+            
+            Lookup->archetype = Archetype;
+            Lookup->index = Index;
+            
+            ECS_ARCHETYPE_CHANGED(Context, Archetype, Index, 1);
+        }
+        
+        else
+        {
+            SortedSub(Refs->archetype.component.ids, 1, CompIndex);
+            ArchetypeRemove(Context, Lookup->archetype, 1, Lookup->index);
+            
+            Lookup->archetype = NULL;
+            Lookup->index = 0;
+        }
+        
+        
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconditional-uninitialized"
+            ECSArchetypeComponentDestructors[CompIndex](CopiedComponent, ID);
+#pragma clang diagnostic pop
+            
+            CCMemoryZoneRestore(ECSSharedZone);
+        }
+#endif
+    }
+}
+
+typedef struct {
+    ECSArchetype *archetype;
+    size_t index;
+    size_t item;
+} ECSArchetypeMigration;
+
+static int ArchetypeMigrationCompare(const void *a, const void *b)
+{
+    const ECSArchetypeMigration *A = a, *B = b;
+    
+    if (A->archetype != B->archetype) return (uintptr_t)A->archetype < (uintptr_t)B->archetype ? -1 : 1;
+    
+    return (A->index > B->index) - (A->index < B->index);
+}
+
+/*!
+ * @brief Migrate many entities to the archetypes with the components added or removed.
+ * @description When adding, any of the components an entity already has are replaced in place instead.
+ * @param Context The context to be used.
+ * @param Entities The entities to be migrated.
+ * @param Count The number of entities.
+ * @param IDs The sorted component IDs of the archetype components to be added or removed.
+ * @param Data The data arrays for the added components (may be NULL).
+ * @param IDCount The number of component IDs.
+ * @param Add Whether the components should be added (TRUE) or removed (FALSE).
+ */
+static void ArchetypeMigrate(ECSContext *Context, const ECSEntity *Entities, size_t Count, const ECSComponentID *IDs, const void * const *Data, size_t IDCount, _Bool Add)
+{
+#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
+    const ECSArchetypeComponentID EmptyID = INT8_MAX;
+#else
+    const ECSArchetypeComponentID EmptyID = UINT8_MAX;
+#endif
+    
+    CCMemoryZoneSave(ECSSharedZone);
+    
+    ECSArchetypeMigration *Migrations = CCMemoryZoneAllocate(ECSSharedZone, sizeof(ECSArchetypeMigration) * Count);
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop]);
+        
+        Migrations[Loop] = (ECSArchetypeMigration){
+            .archetype = Lookup->archetype,
+            .index = Lookup->index,
+            .item = Loop
+        };
+    }
+    
+    qsort(Migrations, Count, sizeof(*Migrations), ArchetypeMigrationCompare);
+    
+    for (size_t Start = 0, End; Start < Count; Start = End)
+    {
+        ECSArchetype *Source = Migrations[Start].archetype;
+        
+        for (End = Start + 1; (End < Count) && (Migrations[End].archetype == Source); End++);
+        
+        const size_t GroupCount = End - Start;
+        
+        const ECSComponentRefs *GroupRefs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Migrations[Start].item]);
+        const size_t SourceCount = GroupRefs->archetype.component.count;
+        
+        ECSArchetypeComponentID SourceIDs[ECS_ARCHETYPE_MAX], DestIDs[ECS_ARCHETYPE_MAX];
+        size_t ColumnSource[ECS_ARCHETYPE_MAX], ColumnComponent[ECS_ARCHETYPE_MAX], Changed[ECS_ARCHETYPE_MAX], Replaced[ECS_ARCHETYPE_MAX], ReplacedComponent[ECS_ARCHETYPE_MAX];
+        size_t DestCount = 0, ChangedCount = 0, ReplacedCount = 0;
+        
+        memcpy(SourceIDs, GroupRefs->archetype.component.ids, sizeof(ECSArchetypeComponentID) * SourceCount);
+        
+        for (size_t Loop = 0, Loop2 = 0; (Loop < SourceCount) || ((Add) && (Loop2 < IDCount)); )
+        {
+            const ECSArchetypeComponentID ID = Loop2 < IDCount ? (IDs[Loop2] & ~ECSComponentStorageMask) : EmptyID;
+            
+            if ((Loop < SourceCount) && ((Loop2 == IDCount) || (SourceIDs[Loop] < ID)))
+            {
+                DestIDs[DestCount] = SourceIDs[Loop];
+                ColumnSource[DestCount++] = Loop++;
+            }
+            
+            else if ((Loop == SourceCount) || (ID < SourceIDs[Loop]))
+            {
+                if (Add)
+                {
+                    CCAssertLog(DestCount < ECS_ARCHETYPE_MAX, "Entities must not exceed the maximum number of archetype components");
+                    
+                    DestIDs[DestCount] = ID;
+                    ColumnSource[DestCount] = SIZE_MAX;
+                    ColumnComponent[DestCount++] = Loop2;
+                    Changed[ChangedCount++] = Loop2;
+                }
+                
+                Loop2++;
+            }
+            
+            else
+            {
+                if (Add)
+                {
+                    DestIDs[DestCount] = SourceIDs[Loop];
+                    ColumnSource[DestCount++] = Loop;
+                    
+                    if ((Data) && (Data[Loop2]) && (ECSArchetypeComponentSizes[ID]))
+                    {
+                        Replaced[ReplacedCount] = Loop;
+                        ReplacedComponent[ReplacedCount++] = Loop2;
+                    }
+                }
+                
+                else Changed[ChangedCount++] = Loop;
+                
+                Loop++;
+                Loop2++;
+            }
+        }
+        
+        if ((!ChangedCount) && (!ReplacedCount)) continue;
+        
+        // Added entities destroy the components they're replacing, while removed entities destroy the components being removed
+        const size_t *DestroyedColumns = Add ? Replaced : Changed;
+        const size_t DestroyedCount = Add ? ReplacedCount : ChangedCount;
+        
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+        size_t CopiedComponentCount = 0;
+        struct {
+            ECSComponentDestructor destructor;
+            ECSTypedComponent component;
+        } *CopiedComponents = DestroyedCount ? CCMemoryZoneAllocate(ECSSharedZone, sizeof(*CopiedComponents) * DestroyedCount * GroupCount) : NULL;
+#endif
+        
+        for (size_t Loop = 0; Loop < DestroyedCount; Loop++)
+        {
+            const ECSArchetypeComponentID CompID = SourceIDs[DestroyedColumns[Loop]];
+            const ECSComponentID ID = ECSComponentIDs[CompID];
+            
+            if (ID & ECSComponentStorageModifierDestructor)
+            {
+                CCArray Column = Source->components[DestroyedColumns[Loop]];
+                
+                for (size_t Loop2 = 0; Loop2 < GroupCount; Loop2++)
+                {
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+                    ECSArchetypeComponentDestructors[CompID](CCArrayGetElementAtIndex(Column, Migrations[Start + Loop2].index), ID);
+#else
+                    CopiedComponents[CopiedComponentCount++] = (typeof(*CopiedComponents)){
+                        .destructor = ECSArchetypeComponentDestructors[CompID],
+                        .component = {
+                            .id = ID,
+                            .data = ECSSharedZoneStore(CCArrayGetElementAtIndex(Column, Migrations[Start + Loop2].index), ECSArchetypeComponentSizes[CompID])
+                        }
+                    };
+#endif
+                }
+            }
+        }
+        
+        // Replace the existing components in the source rows, so any migration below carries the new values across
+        for (size_t Loop = 0; Loop < ReplacedCount; Loop++)
+        {
+            CCArray Column = Source->components[Replaced[Loop]];
+            const size_t Size = ECSArchetypeComponentSizes[SourceIDs[Replaced[Loop]]];
+            const uint8_t *ComponentData = Data[ReplacedComponent[Loop]];
+            
+            for (size_t Loop2 = 0; Loop2 < GroupCount; Loop2++)
+            {
+                CCArrayReplaceElementAtIndex(Column, Migrations[Start + Loop2].index, ComponentData + (Size * Migrations[Start + Loop2].item));
+            }
+        }
+        
+        if (!ChangedCount)
+        {
+            for (size_t Run = 0, RunEnd; Run < GroupCount; Run = RunEnd)
+            {
+                for (RunEnd = Run + 1; (RunEnd < GroupCount) && (Migrations[Start + RunEnd].index == (Migrations[Start + RunEnd - 1].index + 1)); RunEnd++);
+                
+                ECS_ARCHETYPE_CHANGED(Context, Source, Migrations[Start + Run].index, RunEnd - Run);
+            }
+            
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+            for (size_t Loop = 0; Loop < CopiedComponentCount; Loop++) CopiedComponents[Loop].destructor(CopiedComponents[Loop].component.data, CopiedComponents[Loop].component.id);
+#endif
+            
+            continue;
+        }
+        
+        ECSArchetype *Dest = NULL;
+        size_t Base = 0;
+        
+        if (DestCount)
+        {
+            if (ChangedCount == 1)
+            {
+                ECSArchetypeComponentID TransitionIDs[ECS_ARCHETYPE_MAX];
+                memcpy(TransitionIDs, SourceIDs, sizeof(ECSArchetypeComponentID) * SourceCount);
+                
+                Dest = ArchetypeTransition(Context, Source, TransitionIDs, SourceCount, Add ? (IDs[Changed[0]] & ~ECSComponentStorageMask) : SourceIDs[Changed[0]], Add);
+            }
+            
+            else
+            {
+                const size_t ArchID = ArchtypeIndex(DestIDs, DestCount);
+                Dest = ((void*)Context + ArchetypeOffset[DestCount].base) + (ArchetypeOffset[DestCount].size * ArchID);
+                
+                if (CC_UNLIKELY(!Dest->entities)) ArchetypeCreate(Context, Dest, ArchID, DestIDs, DestCount);
+            }
+            
+            Base = CCArrayAppendElements(Dest->entities, NULL, GroupCount);
+            
+            for (size_t Loop = 0; Loop < GroupCount; Loop++)
+            {
+                CCArrayReplaceElementAtIndex(Dest->entities, Base + Loop, &Entities[Migrations[Start + Loop].item]);
+            }
+            
+            ECS_ARCHETYPE_CHANGED(Context, Dest, Base, GroupCount);
+            
+            for (size_t Loop = 0; Loop < DestCount; Loop++)
+            {
+                CCArrayAppendElements(Dest->components[Loop], NULL, GroupCount);
+                
+                const size_t Size = ECSArchetypeComponentSizes[DestIDs[Loop]];
+                
+                if (!Size) continue;
+                
+                if (ColumnSource[Loop] != SIZE_MAX)
+                {
+                    CCArray Column = Source->components[ColumnSource[Loop]];
+                    
+                    for (size_t Run = 0, RunEnd; Run < GroupCount; Run = RunEnd)
+                    {
+                        for (RunEnd = Run + 1; (RunEnd < GroupCount) && (Migrations[Start + RunEnd].index == (Migrations[Start + RunEnd - 1].index + 1)); RunEnd++);
+                        
+                        memcpy(CCArrayGetElementAtIndex(Dest->components[Loop], Base + Run), CCArrayGetElementAtIndex(Column, Migrations[Start + Run].index), Size * (RunEnd - Run));
+                    }
+                }
+                
+                else if (Data[ColumnComponent[Loop]])
+                {
+                    const uint8_t *ComponentData = Data[ColumnComponent[Loop]];
+                    
+                    for (size_t Loop2 = 0; Loop2 < GroupCount; Loop2++)
+                    {
+                        CCArrayReplaceElementAtIndex(Dest->components[Loop], Base + Loop2, ComponentData + (Size * Migrations[Start + Loop2].item));
+                    }
+                }
+            }
+        }
+        
+        if (Source)
+        {
+            const size_t Remaining = CCArrayGetCount(Source->entities) - GroupCount;
+            
+            size_t Tail = Start;
+            while ((Tail < End) && (Migrations[Tail].index < Remaining)) Tail++;
+            
+            for (size_t Hole = Start, Filler = Remaining, Next = Tail; Hole < Tail; Hole++, Filler++)
+            {
+                for ( ; (Next < End) && (Migrations[Next].index == Filler); Next++, Filler++);
+                
+                const size_t Index = Migrations[Hole].index;
+                
+                for (size_t Loop = 0; Loop < SourceCount; Loop++)
+                {
+                    if (ECSArchetypeComponentSizes[SourceIDs[Loop]]) CCArrayReplaceElementAtIndex(Source->components[Loop], Index, CCArrayGetElementAtIndex(Source->components[Loop], Filler));
+                }
+                
+                const ECSEntity *Entity = CCArrayGetElementAtIndex(Source->entities, Filler);
+                CCArrayReplaceElementAtIndex(Source->entities, Index, Entity);
+                
+                ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, *Entity);
+                Lookup->index = Index;
+                
+                ECS_ARCHETYPE_CHANGED(Context, Source, Index, 1);
+            }
+            
+            for (size_t Loop = 0; Loop < SourceCount; Loop++) CCArrayRemoveElementsAtIndex(Source->components[Loop], Remaining, GroupCount);
+            CCArrayRemoveElementsAtIndex(Source->entities, Remaining, GroupCount);
+        }
+        
+        for (size_t Loop = 0; Loop < GroupCount; Loop++)
+        {
+            ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Migrations[Start + Loop].item]);
+            ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Migrations[Start + Loop].item]);
+            
+            Lookup->archetype = Dest;
+            Lookup->index = Base + Loop;
+            Refs->archetype.component.count = DestCount;
+            
+            memcpy(Refs->archetype.component.ids, DestIDs, sizeof(ECSArchetypeComponentID) * DestCount);
+            for (size_t Loop2 = DestCount; Loop2 < SourceCount; Loop2++) Refs->archetype.component.ids[Loop2] = EmptyID;
+            
+            _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+            
+            for (size_t Loop2 = 0; Loop2 < ChangedCount; Loop2++)
+            {
+                if (Add) CCBitsSet(Lookup->has, IDs[Changed[Loop2]] & ~ECSComponentStorageMask);
+                else CCBitsClear(Lookup->has, SourceIDs[Changed[Loop2]]);
+            }
+        }
+        
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+        for (size_t Loop = 0; Loop < CopiedComponentCount; Loop++) CopiedComponents[Loop].destructor(CopiedComponents[Loop].component.data, CopiedComponents[Loop].component.id);
+#endif
+    }
+    
+    CCMemoryZoneRestore(ECSSharedZone);
+}
+
+void ECSEntityDestroyBatch(ECSContext *Context, const ECSEntity *Entities, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    
+    CCMemoryZoneSave(ECSSharedZone);
+    
+    ECSEntity *Destroyed = CCMemoryZoneAllocate(ECSSharedZone, sizeof(ECSEntity) * Count);
+    size_t DestroyedCount = 0;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        // Also skips any entity that is repeated in the batch, as it will already be marked as destroyed
+        if (!ECSEntityIsAlive(Context, Entities[Loop])) continue;
+        
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop]);
+        CCBitsSet(Lookup->has, ECSHasBitEntityDestroyed);
+        
+        Destroyed[DestroyedCount++] = Entities[Loop];
+    }
+    
+    if (DestroyedCount)
+    {
+        for (size_t Loop = 0; Loop < DestroyedCount; Loop++) ECSLinkRemoveAllLinksForEntity(Context, Destroyed[Loop]);
+        
+        ECSComponentID ArchetypeIDs[ECS_ARCHETYPE_COMPONENT_MAX];
+        
+        _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+        
+        for (size_t Loop = 0; Loop < ECS_ARCHETYPE_COMPONENT_MAX; Loop++) ArchetypeIDs[Loop] = Loop;
+        
+        ArchetypeMigrate(Context, Destroyed, DestroyedCount, ArchetypeIDs, NULL, ECS_ARCHETYPE_COMPONENT_MAX, FALSE);
+        
+        for (size_t Loop = 0; Loop < DestroyedCount; Loop++)
+        {
+            EntityRemoveAllComponents(Context, Destroyed[Loop], CCArrayGetElementAtIndex(Context->manager.lookup, Destroyed[Loop]));
+        }
+        
+        ECSRegistryDeregisterEntities(Context, Destroyed, DestroyedCount);
+        
+        CCArrayAppendElements(Context->manager.available, Destroyed, DestroyedCount);
+    }
+    
+    CCMemoryZoneRestore(ECSSharedZone);
+}
+
+static int EntityCompareDescending(const void *a, const void *b)
+{
+    const ECSEntity A = *(const ECSEntity*)a, B = *(const ECSEntity*)b;
+    
+    return (A < B) - (A > B);
+}
+
+/*!
+ * @brief Move a live entity to a free entity ID.
+ * @param Context The context to be used.
+ * @param Entity The live entity to be moved.
+ * @param NewEntity The free entity ID to move it to. This must be lower than @b Entity.
+ */
+static void EntityMove(ECSContext *Context, ECSEntity Entity, ECSEntity NewEntity)
+{
+    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSComponentRefs *NewRefs = CCArrayGetElementAtIndex(Context->manager.map, NewEntity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    ECSEntityLookup *NewLookup = CCArrayGetElementAtIndex(Context->manager.lookup, NewEntity);
+    
+    // Local components are stored in the refs so are moved along with them
+    memcpy(NewRefs, Refs, CCArrayGetElementSize(Context->manager.map));
+    *NewLookup = *Lookup;
+    
+    if (NewLookup->archetype)
+    {
+        CCArrayReplaceElementAtIndex(NewLookup->archetype->entities, NewLookup->index, &NewEntity);
+        
+        ECS_ARCHETYPE_CHANGED(Context, NewLookup->archetype, NewLookup->index, 1);
+    }
+    
+    for (size_t Loop = 0; Loop < ECS_PACKED_COMPONENT_MAX; Loop++)
+    {
+        if (CCBitsGet(NewLookup->has, Loop + ECSComponentBaseIndex(ECSComponentStorageTypePacked)))
+        {
+            CCArrayReplaceElementAtIndex(Context->packed[Loop].entities, NewRefs->packed.indexes[Loop], &NewEntity);
+            
+            ECS_COMPONENT_CHANGED(Context, Context->packedVersions[Loop]);
+        }
+    }
+    
+    for (size_t Loop = 0; Loop < ECS_INDEXED_COMPONENT_MAX; Loop++)
+    {
+        if (CCBitsGet(NewLookup->has, Loop + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed)))
+        {
+#if ECS_INDEXED_SPARSE_SET
+            ECSIndexedSparseSet *Set = &Context->indexedSets[Loop];
+            const ECSEntityIndex DenseIndex = *(ECSEntityIndex*)CCArrayGetElementAtIndex(Set->sparse, Entity);
+            
+            CCArrayReplaceElementAtIndex(Set->sparse, NewEntity, &DenseIndex);
+            CCArrayReplaceElementAtIndex(Set->entities, DenseIndex, &NewEntity);
+#else
+            CCArrayReplaceElementAtIndex(Context->indexed[Loop], NewEntity, CCArrayGetElementAtIndex(Context->indexed[Loop], Entity));
+#endif
+            
+            ECS_COMPONENT_CHANGED(Context, Context->indexedVersions[Loop]);
+        }
+    }
+    
+    ECSLinkRemapEntity(Context, Entity, NewEntity);
+    ECSRegistryRemapEntity(Context, Entity, NewEntity);
+    
+    CC_BITS_INIT_CLEAR(Lookup->has);
+    CCBitsSet(Lookup->has, ECSHasBitEntityDestroyed);
+}
+
+/*!
+ * @brief Remove the elements of an entity indexed array beyond the chunk containing the last entity.
+ * @param Array The array to be truncated.
+ * @param Count The number of entities.
+ * @param ChunkSize The chunk size the array grows by.
+ */
+static void EntityArrayTruncate(CCArray Array, size_t Count, size_t ChunkSize)
+{
+    if (!Array) return;
+    
+    const size_t ArrayCount = CCArrayGetCount(Array);
+    const size_t AlignedCount = CC_ALIGN(Count, ChunkSize);
+    
+    if (AlignedCount < ArrayCount) CCArrayRemoveElementsAtIndex(Array, AlignedCount, ArrayCount - AlignedCount);
+}
+
+size_t ECSEntityCompact(ECSContext *Context, size_t Max, CCArray(ECSEntityRemap) Remap)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(!Remap || (CCArrayGetElementSize(Remap) == sizeof(ECSEntityRemap)), "Remap must be an array of ECSEntityRemap");
+    
+    const size_t FreeCount = CCArrayGetCount(Context->manager.available);
+    
+    if (!FreeCount) return 0;
+    
+    // Sorted so the lowest entities are at the end, where ECSEntityCreate will take them from
+    ECSEntity *Available = CCArrayGetData(Context->manager.available);
+    qsort(Available, FreeCount, sizeof(ECSEntity), EntityCompareDescending);
+    
+    size_t Count = CCArrayGetCount(Context->manager.map), Moved = 0, Head = 0, Tail = FreeCount;
+    
+    while (Head < Tail)
+    {
+        const ECSEntity Last = Count - 1;
+        
+        if (Available[Head] == Last) Head++;
+        else if (Moved < Max)
+        {
+            const ECSEntity NewEntity = Available[--Tail];
+            
+            EntityMove(Context, Last, NewEntity);
+            
+            if (Remap) CCArrayAppendElement(Remap, &(ECSEntityRemap){ .from = Last, .to = NewEntity });
+            
+            Moved++;
+        }
+        
+        else break;
+        
+        Count--;
+    }
+    
+    if (Tail < FreeCount) CCArrayRemoveElementsAtIndex(Context->manager.available, Tail, FreeCount - Tail);
+    if (Head) CCArrayRemoveElementsAtIndex(Context->manager.available, 0, Head);
+    
+    const size_t MapCount = CCArrayGetCount(Context->manager.map);
+    
+    if (Count < MapCount)
+    {
+        CCArrayRemoveElementsAtIndex(Context->manager.map, Count, MapCount - Count);
+        CCArrayRemoveElementsAtIndex(Context->manager.lookup, Count, MapCount - Count);
+    }
+    
+    const size_t AssociationCount = CCArrayGetCount(Context->links.associations);
+    
+    if (Count < AssociationCount)
+    {
+        CCDictionary *Associations = CCArrayGetData(Context->links.associations);
+        
+        for (size_t Loop = Count; Loop < AssociationCount; Loop++)
+        {
+            if (Associations[Loop]) CCDictionaryDestroy(Associations[Loop]);
+        }
+        
+        CCArrayRemoveElementsAtIndex(Context->links.associations, Count, AssociationCount - Count);
+    }
+    
+    const size_t IDCount = CCArrayGetCount(Context->registry.uniqueEntityIDs);
+    
+    if (Count < IDCount) CCArrayRemoveElementsAtIndex(Context->registry.uniqueEntityIDs, Count, IDCount - Count);
+    
+    for (size_t Loop = 0; Loop < ECS_INDEXED_COMPONENT_MAX; Loop++)
+    {
+#if ECS_INDEXED_SPARSE_SET
+        EntityArrayTruncate(Context->indexedSets[Loop].sparse, Count, ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Loop));
+#else
+        EntityArrayTruncate(Context->indexed[Loop], Count, ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Loop));
+#endif
+    }
+    
+    return Moved;
+}
+
+void ECSArchetypeAddComponents(ECSContext *Context, const ECSEntity *Entities, size_t Count, const ECSTypedComponent *Components, size_t ComponentCount)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    CCAssertLog(Components, "Components must not be null");
+    CCAssertLog(ComponentCount <= ECS_ARCHETYPE_COMPONENT_MAX, "ComponentCount must not exceed the number of archetype components");
+    
+    for (size_t Loop = 0; Loop < Count; Loop++) CCAssertLog(ECSEntityIsAlive(Context, Entities[Loop]), "Entity must be alive");
+    
+    ECSComponentID IDs[ECS_ARCHETYPE_COMPONENT_MAX];
+    const void *Data[ECS_ARCHETYPE_COMPONENT_MAX];
+    
+    for (size_t Loop = 0; Loop < ComponentCount; Loop++)
+    {
+        CCAssertLog(!(Components[Loop].id & (ECSComponentStorageTypeMask | ECSComponentStorageModifierDuplicate)), "Components must be non-duplicate archetype components");
+        
+        const ECSComponentID ID = Components[Loop].id;
+        const void *ComponentData = Components[Loop].data;
+        
+        size_t Index = Loop;
+        for ( ; (Index) && ((IDs[Index - 1] & ~ECSComponentStorageMask) > (ID & ~ECSComponentStorageMask)); Index--)
+        {
+            IDs[Index] = IDs[Index - 1];
+            Data[Index] = Data[Index - 1];
+        }
+        
+        IDs[Index] = ID;
+        Data[Index] = ComponentData;
+    }
+    
+    ArchetypeMigrate(Context, Entities, Count, IDs, Data, ComponentCount, TRUE);
+}
+
+void ECSArchetypeRemoveComponents(ECSContext *Context, const ECSEntity *Entities, size_t Count, const ECSComponentID *IDs, size_t IDCount)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    CCAssertLog(IDs, "IDs must not be null");
+    CCAssertLog(IDCount <= ECS_ARCHETYPE_COMPONENT_MAX, "IDCount must not exceed the number of archetype components");
+    
+    ECSComponentID SortedIDs[ECS_ARCHETYPE_COMPONENT_MAX];
+    
+    for (size_t Loop = 0; Loop < IDCount; Loop++)
+    {
+        CCAssertLog(!(IDs[Loop] & (ECSComponentStorageTypeMask | ECSComponentStorageModifierDuplicate)), "IDs must be non-duplicate archetype components");
+        
+        size_t Index = Loop;
+        for ( ; (Index) && ((SortedIDs[Index - 1] & ~ECSComponentStorageMask) > (IDs[Loop] & ~ECSComponentStorageMask)); Index--) SortedIDs[Index] = SortedIDs[Index - 1];
+        
+        SortedIDs[Index] = IDs[Loop];
+    }
+    
+    ArchetypeMigrate(Context, Entities, Count, SortedIDs, NULL, IDCount, FALSE);
+}
+
+void ECSPackedAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
+    
+    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    const size_t Index = (ID & ~ECSComponentStorageMask);
+    ECSPackedComponent *Packed = &Context->packed[Index];
+    
+    ECS_COMPONENT_CHANGED(Context, Context->packedVersions[Index]);
+    
+    CCArray(ECSEntity) Entities = Packed->entities;
+    CCArray Components = *Packed->components;
+    
+    if (ECSEntityHasComponent(Context, Entity, ID))
+    {
+        const size_t EntityIndex = Refs->packed.indexes[Index];
+        
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+#if ECS_IMPURE_COMPONENT_DESTRUCTION
+            // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
+            ECSPackedRemoveComponent(Context, Entity, ID);
+            ECSPackedAddComponent(Context, Entity, Data, ID);
+            
+            return;
+#else
+            const size_t CompIndex = Index + ECSComponentBaseIndex(ECSComponentStorageTypePacked);
+            
+            CCBitsClear(Lookup->has, CompIndex);
+            
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+            ECSPackedComponentDestructors[Index](CCArrayGetElementAtIndex(Components, EntityIndex), ID);
+#else
+            CCMemoryZoneSave(ECSSharedZone);
+            
+            ECSPackedComponentDestructors[Index](ECSSharedZoneStore(CCArrayGetElementAtIndex(Components, EntityIndex), ECSPackedComponentSizes[Index]), ID);
+            
+            CCMemoryZoneRestore(ECSSharedZone);
+#endif
+            
+            CCBitsSet(Lookup->has, CompIndex);
+#endif
+        }
+        
+        CCArrayReplaceElementAtIndex(Components, EntityIndex, Data);
+    }
+    
+    else
+    {
+        if (CC_UNLIKELY(!Components))
+        {
+            const size_t ChunkSize = ECS_PACKED_COMPONENT_ARRAY_CHUNK_SIZE(Index);
+            
+            Packed->entities = (Entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize));
+            
+            *Packed->components = (Components = CCArrayCreate(CC_STD_ALLOCATOR, ECSPackedComponentSizes[Index], ChunkSize));
+        }
+        
+        CCArrayAppendElement(Components, Data);
+        
+        const size_t EntityIndex = CCArrayAppendElement(Entities, &Entity);
+        CCAssertLog(EntityIndex < ECS_PACKED_COMPONENT_INDEX_NONE, "Packed component count exceeds the packed component index width");
+        
+        Refs->packed.indexes[Index] = (ECSPackedComponentIndex)EntityIndex;
+        
+        CCBitsSet(Lookup->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypePacked));
+    }
+}
+
+void ECSPackedRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    
+    if (ECSEntityHasComponent(Context, Entity, ID))
+    {
+        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+        
+        const size_t Index = (ID & ~ECSComponentStorageMask);
+        ECSPackedComponent *Packed = &Context->packed[Index];
+        
+        ECS_COMPONENT_CHANGED(Context, Context->packedVersions[Index]);
+        
+        CCArray(ECSEntity) Entities = Packed->entities;
+        CCArray Components = *Packed->components;
+        const size_t EntityIndex = Refs->packed.indexes[Index];
+        const size_t LastIndex = CCArrayGetCount(Components) - 1;
+        
+        CCBitsClear(Lookup->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypePacked));
+        
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor) ECSPackedComponentDestructors[Index](CCArrayGetElementAtIndex(Components, EntityIndex), ID);
+#else
+        void *CopiedComponent;
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+            CCMemoryZoneSave(ECSSharedZone);
+            
+            CopiedComponent = ECSSharedZoneStore(CCArrayGetElementAtIndex(Components, EntityIndex), ECSPackedComponentSizes[Index]);
+        }
+#endif
+        
+        if (EntityIndex != LastIndex)
+        {
+            const void *Data = CCArrayGetElementAtIndex(Components, LastIndex);
+            CCArrayReplaceElementAtIndex(Components, EntityIndex, Data);
+            CCArrayRemoveElementAtIndex(Components, LastIndex);
+            
+            const ECSEntity *Entity = CCArrayGetElementAtIndex(Entities, LastIndex);
+            CCArrayReplaceElementAtIndex(Entities, EntityIndex, Entity);
+            CCArrayRemoveElementAtIndex(Entities, LastIndex);
+            
+            ECSComponentRefs *ReplacementRef = CCArrayGetElementAtIndex(Context->manager.map, *Entity);
+            ReplacementRef->packed.indexes[Index] = (ECSPackedComponentIndex)EntityIndex;
+        }
+        
+        else
+        {
+            CCArrayRemoveElementAtIndex(Components, LastIndex);
+            CCArrayRemoveElementAtIndex(Entities, LastIndex);
+        }
+        
+        Refs->packed.indexes[Index] = ECS_PACKED_COMPONENT_INDEX_NONE;
+        
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconditional-uninitialized"
+            ECSPackedComponentDestructors[Index](CopiedComponent, ID);
+#pragma clang diagnostic pop
+            
+            CCMemoryZoneRestore(ECSSharedZone);
+        }
+#endif
+    }
+}
+
+void ECSIndexedAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
+    
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    const size_t Index = (ID & ~ECSComponentStorageMask);
+    ECSIndexedComponent *Indexed = &Context->indexed[Index];
+    
+    ECS_COMPONENT_CHANGED(Context, Context->indexedVersions[Index]);
+    
+    CCArray Components = *Indexed;
+    
+#if ECS_INDEXED_SPARSE_SET
+    ECSIndexedSparseSet *Set = &Context->indexedSets[Index];
+    
+    if (CC_UNLIKELY(!Components))
+    {
+        *Indexed = (Components = CCArrayCreate(CC_STD_ALLOCATOR, ECSIndexedComponentSizes[Index], ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index)));
+        Set->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
+        Set->sparse = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntityIndex), ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
+    }
+    
+    const size_t Count = CCArrayGetCount(Set->sparse);
+    if (Entity >= Count)
+    {
+        CCArrayAppendElements(Set->sparse, NULL, CC_ALIGN((Entity - Count) + 1, ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index)));
+    }
+#else
+    if (CC_UNLIKELY(!Components))
+    {
+        *Indexed = (Components = CCArrayCreate(CC_STD_ALLOCATOR, ECSIndexedComponentSizes[Index], ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index)));
+    }
+    
+    const size_t Count = CCArrayGetCount(Components);
+    if (Entity >= Count)
+    {
+        CCArrayAppendElements(Components, NULL, CC_ALIGN((Entity - Count) + 1, ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index)));
+    }
+#endif
+    
+    const size_t CompIndex = Index + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed);
+    
+#if ECS_INDEXED_SPARSE_SET
+    ECSEntityIndex *DenseIndex = CCArrayGetElementAtIndex(Set->sparse, Entity);
+    
+    if (!CCBitsGet(Lookup->has, CompIndex))
+    {
+        *DenseIndex = (ECSEntityIndex)CCArrayAppendElement(Components, Data);
+        CCArrayAppendElement(Set->entities, &Entity);
+        
+        CCBitsSet(Lookup->has, CompIndex);
+        
+        return;
+    }
+    
+    const size_t ComponentIndex = *DenseIndex;
+#else
+    const size_t ComponentIndex = Entity;
+#endif
+    
+    if ((ID & ECSComponentStorageModifierDestructor) && (ECSEntityHasComponent(Context, Entity, ID)))
+    {
+#if ECS_IMPURE_COMPONENT_DESTRUCTION
+        // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
+        ECSIndexedRemoveComponent(Context, Entity, ID);
+        ECSIndexedAddComponent(Context, Entity, Data, ID);
+            
+            return;
+#else
+        CCBitsClear(Lookup->has, CompIndex);
+        
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+        ECSIndexedComponentDestructors[Index](CCArrayGetElementAtIndex(Context->indexed[Index], ComponentIndex), ID);
+#else
+        CCMemoryZoneSave(ECSSharedZone);
+        
+        ECSIndexedComponentDestructors[Index](ECSSharedZoneStore(CCArrayGetElementAtIndex(Context->indexed[Index], ComponentIndex), ECSIndexedComponentSizes[Index]), ID);
+        
+        CCMemoryZoneRestore(ECSSharedZone);
+#endif
+#endif
+    }
+    
+    CCArrayReplaceElementAtIndex(Components, ComponentIndex, Data);
+    
+    CCBitsSet(Lookup->has, CompIndex);
+}
+
+void ECSIndexedRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    
+    if (ECSEntityHasComponent(Context, Entity, ID))
+    {
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+        
+        const size_t Index = (ID & ~ECSComponentStorageMask);
+        CCBitsClear(Lookup->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed));
+        
+        ECS_COMPONENT_CHANGED(Context, Context->indexedVersions[Index]);
+        
+#if ECS_INDEXED_SPARSE_SET
+        ECSIndexedSparseSet *Set = &Context->indexedSets[Index];
+        CCArray Components = Context->indexed[Index];
+        
+        const ECSEntityIndex ComponentIndex = *(ECSEntityIndex*)CCArrayGetElementAtIndex(Set->sparse, Entity);
+#else
+        const size_t ComponentIndex = Entity;
+#endif
+        
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor) ECSIndexedComponentDestructors[Index](CCArrayGetElementAtIndex(Context->indexed[Index], ComponentIndex), ID);
+#else
+        void *CopiedComponent;
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+            CCMemoryZoneSave(ECSSharedZone);
+            
+            CopiedComponent = ECSSharedZoneStore(CCArrayGetElementAtIndex(Context->indexed[Index], ComponentIndex), ECSIndexedComponentSizes[Index]);
+        }
+#endif
+        
+#if ECS_INDEXED_SPARSE_SET
+        const size_t LastIndex = CCArrayGetCount(Components) - 1;
+        
+        if (ComponentIndex != LastIndex)
+        {
+            const ECSEntity *LastEntity = CCArrayGetElementAtIndex(Set->entities, LastIndex);
+            
+            CCArrayReplaceElementAtIndex(Components, ComponentIndex, CCArrayGetElementAtIndex(Components, LastIndex));
+            CCArrayReplaceElementAtIndex(Set->entities, ComponentIndex, LastEntity);
+            CCArrayReplaceElementAtIndex(Set->sparse, *LastEntity, &ComponentIndex);
+        }
+        
+        CCArrayRemoveElementAtIndex(Components, LastIndex);
+        CCArrayRemoveElementAtIndex(Set->entities, LastIndex);
+#endif
+        
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconditional-uninitialized"
+            ECSIndexedComponentDestructors[Index](CopiedComponent, ID);
+#pragma clang diagnostic pop
+            
+            CCMemoryZoneRestore(ECSSharedZone);
+        }
+#endif
+    }
+}
+
+void ECSLocalAddComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
+    
+    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    const size_t Index = ECSLocalComponentIndex(ID);
+    const size_t CompIndex = Index + ECSComponentBaseIndex(ECSComponentStorageTypeLocal);
+    
+    if ((ID & ECSComponentStorageModifierDestructor) && (ECSEntityHasComponent(Context, Entity, ID)))
+    {
+#if ECS_IMPURE_COMPONENT_DESTRUCTION
+        // NOTE: Consider changing ECSComponentStorageModifierDestructor to a 2-bit mask, and adding ECSComponentStorageModifierDestructorImpure and ECSComponentStorageModifierDestructorPure.
+        ECSLocalRemoveComponent(Context, Entity, ID);
+        ECSLocalAddComponent(Context, Entity, Data, ID);
+        
+        return;
+#else
+        CCBitsClear(Lookup->has, CompIndex);
+        
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+        ECSLocalComponentDestructors[Index](&Refs->local[ECSLocalComponentOffset(ID)], ID);
+#else
+        CCMemoryZoneSave(ECSSharedZone);
+        
+        ECSLocalComponentDestructors[Index](ECSSharedZoneStore(&Refs->local[ECSLocalComponentOffset(ID)], ECSLocalComponentSizes[Index]), ID);
+        
+        CCMemoryZoneRestore(ECSSharedZone);
+#endif
+#endif
+    }
+    
+    if (Data)
+    {
+        const ptrdiff_t Offset = ECSLocalComponentOffset(ID);
+        memcpy(&Refs->local[Offset], Data, ECSLocalComponentSizes[Index]);
+    }
+    
+    CCBitsSet(Lookup->has, CompIndex);
+}
+
+void ECSLocalRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    
+    if (ECSEntityHasComponent(Context, Entity, ID))
+    {
+        ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+        
+        const size_t Index = ECSLocalComponentIndex(ID);
+        CCBitsClear(Lookup->has, Index + ECSComponentBaseIndex(ECSComponentStorageTypeLocal));
+        
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+        if (ID & ECSComponentStorageModifierDestructor) ECSLocalComponentDestructors[Index](&Refs->local[ECSLocalComponentOffset(ID)], ID);
+#else
+        if (ID & ECSComponentStorageModifierDestructor)
+        {
+            CCMemoryZoneSave(ECSSharedZone);
+            
+            ECSLocalComponentDestructors[Index](ECSSharedZoneStore(&Refs->local[ECSLocalComponentOffset(ID)], ECSLocalComponentSizes[Index]), ID);
+            
+            CCMemoryZoneRestore(ECSSharedZone);
+        }
+#endif
+    }
+}
+
+void ECSEntityAddComponents(ECSContext *Context, ECSEntity Entity, const ECSTypedComponent *Components, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(ECSEntityIsAlive(Context, Entity), "Entity must be alive");
+    CCAssertLog(Components, "Components must not be null");
+    
+    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    void *RefData[ECS_ARCHETYPE_MAX];
+    void *ComponentData[ECS_ARCHETYPE_COMPONENT_MAX];
+    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) AddedComponent;
+    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) CachedComponentLookup;
+    
+    CC_BITS_INIT_CLEAR(AddedComponent);
+    CC_BITS_INIT_CLEAR(CachedComponentLookup);
+    
+    size_t IndexCount = 0, LastIndex = 0, RefDataCount = 0;
+    ECSArchetypeComponentID LastID = 0;
+    
+#if ECS_DUPLICATE_INLINE_CAPACITY
+    CCMemoryZoneSave(ECSSharedZone);
+#endif
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        switch (Components[Loop].id & (ECSComponentStorageTypeMask | ECSComponentStorageModifierDuplicate))
+        {
+            case ECSComponentStorageTypeArchetype:
+            {
+                const ECSArchetypeComponentID ID = Components[Loop].id & ~ECSComponentStorageMask;
+                
+                if (!ECSEntityHasComponent(Context, Entity, ID))
+                {
+                    const size_t Offset = LastID < ID ? LastIndex : 0;
+                    
+                    LastIndex = SortedAdd(Refs->archetype.component.ids + Offset, Refs->archetype.component.count++ - Offset, ID) + Offset;
+                    ComponentData[ID] = Components[Loop].data;
+                    IndexCount++;
+                    CCBitsSet(AddedComponent, ID);
+                    CCBitsSet(Lookup->has, ID);
+                    
+                    LastID = ID;
+                }
+                break;
+            }
+                
+            case ECSComponentStorageTypePacked:
+                ECSPackedAddComponent(Context, Entity, Components[Loop].data, Components[Loop].id);
+                break;
+                
+            case ECSComponentStorageTypeIndexed:
+                ECSIndexedAddComponent(Context, Entity, Components[Loop].data, Components[Loop].id);
+                break;
+                
+            case ECSComponentStorageTypeLocal:
+                ECSLocalAddComponent(Context, Entity, Components[Loop].data, Components[Loop].id);
+                break;
+                
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeArchetype:
+            {
+                const ECSArchetypeComponentID ID = Components[Loop].id & ~ECSComponentStorageMask;
+                
+                if (!ECSEntityHasComponent(Context, Entity, ID))
+                {
+                    const size_t Offset = LastID < ID ? LastIndex : 0;
+                    
+                    LastIndex = SortedAdd(Refs->archetype.component.ids + Offset, Refs->archetype.component.count++ - Offset, ID) + Offset;
+#if ECS_DUPLICATE_INLINE_CAPACITY
+                    RefData[RefDataCount] = CCMemoryZoneAllocate(ECSSharedZone, ECS_DUPLICATE_COMPONENT_SIZE(ECSDuplicateArchetypeComponentSizes[ID]));
+                    ComponentData[ID] = RefData[RefDataCount++];
+#else
+                    ComponentData[ID] = &RefData[RefDataCount++];
+#endif
+                    ECSDuplicateComponentInit(ComponentData[ID], ECSDuplicateArchetypeComponentSizes[ID], ECS_DUPLICATE_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ID));
+                    IndexCount++;
+                    CCBitsSet(AddedComponent, ID);
+                    CCBitsSet(Lookup->has, ID);
+                    
+                    LastID = ID;
+                }
+                
+                if ((!CCBitsGet(AddedComponent, ID)) && (!CCBitsGet(CachedComponentLookup, ID)))
+                {
+                    CCBitsSet(CachedComponentLookup, ID);
+                    
+                    const size_t Offset = ID ? CCBitsCount(AddedComponent, 0, ID - 1) : 0;
+                    size_t Index = ECSArchetypeComponentIndex(Refs, ID) - Offset;
+                    ComponentData[ID] = CCArrayGetElementAtIndex(Lookup->archetype->components[Index], Lookup->index);
+                }
+                
+                ECSDuplicateComponentAppendElements(ComponentData[ID], ECSDuplicateArchetypeComponentSizes[ID], ECS_DUPLICATE_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ID), Components[Loop].data, 1);
+                break;
+            }
+                
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypePacked:
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeIndexed:
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeLocal:
+                ECSEntityAddDuplicateComponent(Context, Entity, Components[Loop].data, Components[Loop].id, 1);
+                break;
+                
+            default:
+                CCAssertLog(0, "Unsupported component type");
+                break;
+        }
+    }
+    
+    if (IndexCount)
+    {
+        Count = Refs->archetype.component.count;
+        
+        const size_t ArchID = ArchtypeIndex(Refs->archetype.component.ids, Count);
+        ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
+        
+        if (CC_UNLIKELY(!Archetype->entities)) ArchetypeCreate(Context, Archetype, ArchID, Refs->archetype.component.ids, Count);
+        
+        const size_t Index = CCArrayAppendElement(Archetype->entities, &Entity);
+        
+        if (Lookup->archetype)
+        {
+            ECSArchetype *PrevArchetype = Lookup->archetype;
+            
+            for (size_t Loop = 0, ComponentIndex = 0; Loop < Count; Loop++)
+            {
+                _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+                
+                const ECSArchetypeComponentID ID = Refs->archetype.component.ids[Loop];
+                
+                if (CCBitsGet(AddedComponent, ID))
+                {
+                    CCArrayAppendElement(Archetype->components[Loop], ComponentData[ID]);
+                    ComponentIndex++;
+                }
+                
+                else
+                {
+                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop - ComponentIndex], Lookup->index);
+                    CCArrayAppendElement(Archetype->components[Loop], Copy);
+                }
+            }
+            
+            ArchetypeRemove(Context, PrevArchetype, Count - IndexCount, Lookup->index);
+        }
+        
+        else
+        {
+            for (size_t Loop = 0; Loop < Count; Loop++)
+            {
+                CCArrayAppendElement(Archetype->components[Loop], ComponentData[Refs->archetype.component.ids[Loop]]);
+            }
+        }
+        
+        Lookup->archetype = Archetype;
+        Lookup->index = Index;
+        
+        ECS_ARCHETYPE_CHANGED(Context, Archetype, Index, 1);
+    }
+    
+#if ECS_DUPLICATE_INLINE_CAPACITY
+    CCMemoryZoneRestore(ECSSharedZone);
+#endif
+}
+
+void ECSEntityRemoveComponents(ECSContext *Context, ECSEntity Entity, const ECSComponentID *IDs, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(IDs, "IDs must not be null");
+    
+    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    void *ComponentData[ECS_ARCHETYPE_COMPONENT_MAX];
+    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) RemovedComponent;
+    CCBits(uint64_t, ECS_ARCHETYPE_COMPONENT_MAX) CachedComponentLookup;
+    
+    CC_BITS_INIT_CLEAR(RemovedComponent);
+    CC_BITS_INIT_CLEAR(CachedComponentLookup);
+    
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+    CCMemoryZoneSave(ECSSharedZone);
+    
+    size_t CopiedComponentCount = 0;
+    struct {
+        ECSComponentDestructor destructor;
+        ECSTypedComponent component;
+    } *CopiedComponents = CCMemoryZoneAllocate(ECSSharedZone, sizeof(*CopiedComponents) * Count);
+#endif
+    
+    size_t IndexCount = 0, LastIndex = 0;
+    ECSArchetypeComponentID LastID = 0;
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        const ECSComponentID ID = IDs[Loop];
+        
+        switch (ID & (ECSComponentStorageTypeMask | ECSComponentStorageModifierDuplicate))
+        {
+            case ECSComponentStorageTypeArchetype:
+            {
+                if (ECSEntityHasComponent(Context, Entity, ID))
+                {
+                    _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+                    
+                    const ECSArchetypeComponentID CompID = ID & ~ECSComponentStorageMask;
+                    
+                    const size_t Offset = LastID < CompID ? LastIndex : 0;
+                    
+                    LastIndex = SortedSub(Refs->archetype.component.ids + Offset, Refs->archetype.component.count-- - Offset, CompID) + Offset;
+                    IndexCount++;
+                    CCBitsSet(RemovedComponent, CompID);
+                    CCBitsClear(Lookup->has, CompID);
+                    
+                    LastID = CompID;
+                    
+                    if (ID & ECSComponentStorageModifierDestructor)
+                    {
+                        const size_t CompOffset = CompID ? CCBitsCount(RemovedComponent, 0, CompID - 1) : 0;
+                        const size_t RemovedIndex = ECSArchetypeComponentIndex(Refs, CompID) + CompOffset;
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+                        ECSArchetypeComponentDestructors[CompID](CCArrayGetElementAtIndex(Lookup->archetype->components[RemovedIndex], Lookup->index), ID);
+#else
+                        CopiedComponents[CopiedComponentCount++] = (typeof(*CopiedComponents)){
+                            .destructor = ECSArchetypeComponentDestructors[CompID],
+                            .component = {
+                                .id = ID,
+                                .data = ECSSharedZoneStore(CCArrayGetElementAtIndex(Lookup->archetype->components[RemovedIndex], Lookup->index), ECSArchetypeComponentSizes[CompID])
+                            }
+                        };
+#endif
+                    }
+                }
+                break;
+            }
+                
+            case ECSComponentStorageTypePacked:
+                ECSPackedRemoveComponent(Context, Entity, ID);
+                break;
+                
+            case ECSComponentStorageTypeIndexed:
+                ECSIndexedRemoveComponent(Context, Entity, ID);
+                break;
+                
+            case ECSComponentStorageTypeLocal:
+                ECSLocalRemoveComponent(Context, Entity, ID);
+                break;
+                
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeArchetype:
+            {
+                if (ECSEntityHasComponent(Context, Entity, ID))
+                {
+                    const ECSArchetypeComponentID CompID = ID & ~ECSComponentStorageMask;
+                    
+                    if (!CCBitsGet(CachedComponentLookup, CompID))
+                    {
+                        CCBitsSet(CachedComponentLookup, CompID);
+                        
+                        const size_t Offset = CompID ? CCBitsCount(RemovedComponent, 0, CompID - 1) : 0;
+                        const size_t Index = ECSArchetypeComponentIndex(Refs, CompID) + Offset;
+                        ComponentData[CompID] = CCArrayGetElementAtIndex(Lookup->archetype->components[Index], Lookup->index);
+                    }
+                    
+                    ECSDuplicateComponent *Duplicates = ComponentData[CompID];
+                    const size_t Count = ECSDuplicateComponentGetCount(Duplicates);
+                    if (Count)
+                    {
+                        if (ID & ECSComponentStorageModifierDestructor)
+                        {
+#if ECS_UNSAFE_COMPONENT_DESTRUCTION
+                            ECSDuplicateArchetypeComponentDestructors[CompID](ECSDuplicateComponentGetElementAtIndex(Duplicates, ECSDuplicateArchetypeComponentSizes[CompID], Count - 1), ID);
+#else
+                            CopiedComponents[CopiedComponentCount++] = (typeof(*CopiedComponents)){
+                                .destructor = ECSDuplicateArchetypeComponentDestructors[CompID],
+                                .component = {
+                                    .id = ID,
+                                    .data = ECSSharedZoneStore(ECSDuplicateComponentGetElementAtIndex(Duplicates, ECSDuplicateArchetypeComponentSizes[CompID], Count - 1), ECSDuplicateArchetypeComponentSizes[CompID])
+                                }
+                            };
+#endif
+                        }
+                        
+                        ECSDuplicateComponentRemoveElementsAtIndex(Duplicates, ECSDuplicateArchetypeComponentSizes[CompID], Count - 1, 1);
+                    }
+                    
+                    else
+                    {
+                        if (ID & ECSComponentStorageModifierDestructor) ECSDuplicateComponentDestroy(Duplicates);
+                        
+                        const size_t Offset = LastID < CompID ? LastIndex : 0;
+                        
+                        LastIndex = SortedSub(Refs->archetype.component.ids + Offset, Refs->archetype.component.count-- - Offset, CompID) + Offset;
+                        IndexCount++;
+                        CCBitsSet(RemovedComponent, CompID);
+                        CCBitsClear(Lookup->has, CompID);
+                        
+                        LastID = CompID;
+                    }
+                }
+                break;
+            }
+                
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypePacked:
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeIndexed:
+            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeLocal:
+                ECSEntityRemoveDuplicateComponent(Context, Entity, ID, -1, 1);
+                break;
+                
+            default:
+                CCAssertLog(0, "Unsupported component type");
+                break;
+        }
+    }
+    
+    if (IndexCount)
+    {
+        if ((Count = Refs->archetype.component.count))
+        {
+            const size_t ArchID = ArchtypeIndex(Refs->archetype.component.ids, Count);
+            ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
+            
+            if (CC_UNLIKELY(!Archetype->entities)) ArchetypeCreate(Context, Archetype, ArchID, Refs->archetype.component.ids, Count);
+            
+            const size_t Index = CCArrayAppendElement(Archetype->entities, &Entity);
+            
+            const size_t PrevCount = Count + IndexCount;
+            ECSArchetype *PrevArchetype = Lookup->archetype;
+            
+            for (size_t Loop = 0, ComponentIndex = 0; Loop < PrevCount; Loop++)
+            {
+                _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
+                
+                const ECSArchetypeComponentID ID = Refs->archetype.component.ids[Loop];
+                
+#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
+                if (ID == INT8_MAX) ComponentIndex++;
+#else
+                if (ID == UINT8_MAX) ComponentIndex++;
+#endif
+                else
+                {
+                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Lookup->index);
+                    CCArrayAppendElement(Archetype->components[Loop - ComponentIndex], Copy);
+                }
+            }
+            
+            ArchetypeRemove(Context, PrevArchetype, PrevCount, Lookup->index);
+            
+            Lookup->archetype = Archetype;
+            Lookup->index = Index;
+            
+            ECS_ARCHETYPE_CHANGED(Context, Archetype, Index, 1);
+        }
+        
+        else
+        {
+            ArchetypeRemove(Context, Lookup->archetype, IndexCount, Lookup->index);
+            
+            Lookup->archetype = NULL;
+            Lookup->index = 0;
+        }
+    }
+    
+#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
+    for (size_t Loop = 0; Loop < CopiedComponentCount; Loop++)
+    {
+        CopiedComponents[Loop].destructor(CopiedComponents[Loop].component.data, CopiedComponents[Loop].component.id);
+    }
+    
+    CCMemoryZoneRestore(ECSSharedZone);
+#endif
+}
+
+size_t ECSArchetypeComponentIndex(const ECSComponentRefs *Refs, ECSComponentID ID)
+{
+    CCAssertLog((ID & ECSComponentStorageMask) == 0, "ID must not have any modifiers");
+    
+#if ECS_ARCHETYPE_COMPONENT_ID_SIMD_LOOKUP && CC_HARDWARE_VECTOR_SUPPORT_SSSE3
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i One = _mm_set1_epi8(1);
+    const __m128i Value = _mm_set1_epi8(ID);
+    
+#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
+    __m128i Mask = _mm_and_si128(_mm_cmplt_epi8(_mm_load_si128((__m128i*)Refs->archetype.component.ids), Value), One);
+    for (size_t Loop = 16; Loop < ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX); Loop += 16)
+    {
+        Mask = _mm_add_epi8(Mask, _mm_and_si128(_mm_cmplt_epi8(_mm_load_si128((__m128i*)(Refs->archetype.component.ids + Loop)), Value), One));
+    }
+    
+    const uint32_t Index = _mm_cvtsi128_si32(_mm_hadd_epi16(_mm_hadd_epi16(_mm_hadd_epi16(Mask, Zero), Zero), Zero));
+    
+    return (Index & 0xff) + (Index >> 8);
+#else
+    __m128i Max = _mm_max_epu8(_mm_load_si128((__m128i*)Refs->archetype.component.ids), Value);
+    __m128i Mask = _mm_and_si128(_mm_cmpeq_epi8(Max, Value), One);
+    for (size_t Loop = 16; Loop < ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX); Loop += 16)
+    {
+        Max = _mm_max_epu8(_mm_load_si128((__m128i*)(Refs->archetype.component.ids + Loop)), Value);
+        Mask = _mm_add_epi8(Mask, _mm_and_si128(_mm_cmpeq_epi8(Max, Value), One));
+    }
+    
+    const uint32_t Index = _mm_cvtsi128_si32(_mm_hadd_epi16(_mm_hadd_epi16(_mm_hadd_epi16(Mask, Zero), Zero), Zero));
+    
+    return (Index & 0xff) + (Index >> 8) - 1;
+#endif
+#else
+    const size_t Index = FindIndex(Refs->archetype.component.ids, Refs->archetype.component.count, ECS_ARCHETYPE_COMPONENT_MAX, ID);
+    
+    CCAssertLog(Index != SIZE_MAX, "Invalid ID for archetype");
+    
+    return Index;
+#endif
+}
+
+#define ECS_SNAPSHOT_MAGIC 0x53534345 // "ECSS"
+#define ECS_SNAPSHOT_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t contextSize;
+    uint64_t refsSize;
+    uint32_t entitySize;
+    uint32_t archetypeMax;
+    uint32_t archetypeComponentMax;
+    uint32_t packedComponentMax;
+    uint32_t indexedComponentMax;
+    uint32_t localComponentMax;
+    uint32_t indexedSparseSet;
+    uint32_t reserved;
+    uint64_t layout;
+} ECSSnapshotHeader;
+
+typedef struct {
+    uint64_t entity;
+    uint64_t link;
+    uint64_t count;
+} ECSSnapshotLinkRecord;
+
+typedef struct {
+    uint64_t entity;
+    uint64_t length;
+} ECSSnapshotRegistryRecord;
+
+typedef struct {
+    ECSContext *context;
+    ECSSnapshotWriter writer;
+    void *userData;
+    void *buffer;
+    size_t size;
+} ECSSnapshotWriteState;
+
+typedef struct {
+    const uint8_t *data;
+    const uint8_t *end;
+} ECSSnapshotReader;
+
+static uint64_t SnapshotHashValue(uint64_t Hash, uint64_t Value)
+{
+    for (size_t Loop = 0; Loop < sizeof(Value); Loop++, Value >>= 8) Hash = (Hash ^ (Value & 0xff)) * UINT64_C(0x100000001b3);
+    
+    return Hash;
+}
+
+static uint64_t SnapshotHashSizes(uint64_t Hash, const size_t *Sizes, size_t Count)
+{
+    if (!Sizes) return SnapshotHashValue(Hash, UINT64_MAX);
+    
+    for (size_t Loop = 0; Loop < Count; Loop++) Hash = SnapshotHashValue(Hash, Sizes[Loop]);
+    
+    return Hash;
+}
+
+/*!
+ * @brief Hash the component IDs and component size tables.
+ * @description Two builds with the same ECS configuration may still assign different IDs or sizes to their components, in which case
+ *              their snapshots are not compatible.
+ *
+ * @return The hash of the component layout.
+ */
+static uint64_t SnapshotLayoutHash(void)
+{
+    uint64_t Hash = UINT64_C(0xcbf29ce484222325);
+    
+    for (size_t Loop = 0; Loop < ECS_COMPONENT_MAX; Loop++) Hash = SnapshotHashValue(Hash, ECSComponentIDs[Loop]);
+    
+    Hash = SnapshotHashSizes(Hash, ECSArchetypeComponentSizes, ECS_ARCHETYPE_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSPackedComponentSizes, ECS_PACKED_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSIndexedComponentSizes, ECS_INDEXED_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSLocalComponentSizes, ECS_LOCAL_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSDuplicateArchetypeComponentSizes, ECS_ARCHETYPE_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSDuplicatePackedComponentSizes, ECS_PACKED_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSDuplicateIndexedComponentSizes, ECS_INDEXED_COMPONENT_MAX);
+    Hash = SnapshotHashSizes(Hash, ECSDuplicateLocalComponentSizes, ECS_LOCAL_COMPONENT_MAX);
+    
+    return Hash;
+}
+
+static void SnapshotHeaderInit(ECSSnapshotHeader *Header, ECSContext *Context)
+{
+    memset(Header, 0, sizeof(ECSSnapshotHeader));
+    
+    Header->magic = ECS_SNAPSHOT_MAGIC;
+    Header->version = ECS_SNAPSHOT_VERSION;
+    Header->contextSize = sizeof(ECSContext);
+    Header->refsSize = CCArrayGetElementSize(Context->manager.map);
+    Header->entitySize = sizeof(ECSEntity);
+    Header->archetypeMax = ECS_ARCHETYPE_MAX;
+    Header->archetypeComponentMax = ECS_ARCHETYPE_COMPONENT_MAX;
+    Header->packedComponentMax = ECS_PACKED_COMPONENT_MAX;
+    Header->indexedComponentMax = ECS_INDEXED_COMPONENT_MAX;
+    Header->localComponentMax = ECS_LOCAL_COMPONENT_MAX;
+#if ECS_INDEXED_SPARSE_SET
+    Header->indexedSparseSet = 1;
+#endif
+    Header->layout = SnapshotLayoutHash();
+}
+
+static const ECSSnapshotComponentHooks *SnapshotComponentHooks(ECSComponentID ID)
+{
+    const ECSSnapshotComponentHooks *Hooks = NULL;
+    
+    switch (ID & ECSComponentStorageTypeMask)
+    {
+        case ECSComponentStorageTypeArchetype:
+            if (ECSArchetypeComponentSnapshotHooks) Hooks = &ECSArchetypeComponentSnapshotHooks[ID & ~ECSComponentStorageMask];
+            break;
+            
+        case ECSComponentStorageTypePacked:
+            if (ECSPackedComponentSnapshotHooks) Hooks = &ECSPackedComponentSnapshotHooks[ID & ~ECSComponentStorageMask];
+            break;
+            
+        case ECSComponentStorageTypeIndexed:
+            if (ECSIndexedComponentSnapshotHooks) Hooks = &ECSIndexedComponentSnapshotHooks[ID & ~ECSComponentStorageMask];
+            break;
+            
+        case ECSComponentStorageTypeLocal:
+            if (ECSLocalComponentSnapshotHooks) Hooks = &ECSLocalComponentSnapshotHooks[ECSLocalComponentIndex(ID)];
+            break;
+    }
+    
+    if ((Hooks) && (!Hooks->serialize) && (!Hooks->fixup)) Hooks = NULL;
+    
+    CCAssertLog((Hooks) || !(ID & (ECSComponentStorageModifierDestructor | ECSComponentStorageModifierDuplicate | ECSComponentStorageModifierShared)), "Components with destructors, duplicates, or shared values must have snapshot hooks");
+    
+    return Hooks;
+}
+
+static void SnapshotConvertLocalComponents(ECSContext *Context, ECSComponentRefs *Refs, const ECSEntityLookup *Lookup, _Bool Serialize)
+{
+    const size_t BaseIndex = ECSComponentBaseIndex(ECSComponentStorageTypeLocal);
+    
+    for (size_t Loop = 0; Loop < ECS_LOCAL_COMPONENT_MAX; Loop++)
+    {
+        if (CCBitsGet(Lookup->has, BaseIndex + Loop))
+        {
+            const ECSComponentID ID = ECSComponentIDs[BaseIndex + Loop];
+            const ECSSnapshotComponentHooks *Hooks = SnapshotComponentHooks(ID);
+            
+            if (Hooks)
+            {
+                ECSSnapshotComponentCallback Callback = Serialize ? Hooks->serialize : Hooks->fixup;
+                
+                if (Callback) Callback(Context, Refs->local + ECSLocalComponentOffset(ID), 1, ID);
+            }
+        }
+    }
+}
+
+#if !ECS_INDEXED_SPARSE_SET
+static inline _Bool SnapshotIndexedPresent(ECSContext *Context, size_t Entity, size_t CompIndex)
+{
+    return (Entity < CCArrayGetCount(Context->manager.lookup)) && (CCBitsGet(((ECSEntityLookup*)CCArrayGetElementAtIndex(Context->manager.lookup, Entity))->has, CompIndex));
+}
+
+/*!
+ * @brief Find the run of indexed components that are either all present or all absent.
+ * @param Context The context to be used.
+ * @param Start The first entity in the run.
+ * @param Count The number of components in the indexed array.
+ * @param CompIndex The has-bit index of the indexed component.
+ * @param Present Set to whether the components in the run are present.
+ * @return The entity after the end of the run.
+ */
+static size_t SnapshotIndexedRun(ECSContext *Context, size_t Start, size_t Count, size_t CompIndex, _Bool *Present)
+{
+    *Present = SnapshotIndexedPresent(Context, Start, CompIndex);
+    
+    size_t End = Start + 1;
+    for ( ; (End < Count) && (SnapshotIndexedPresent(Context, End, CompIndex) == *Present); End++);
+    
+    return End;
+}
+#endif
+
+static _Bool SnapshotWrite(ECSSnapshotWriteState *State, const void *Data, size_t Size)
+{
+    return (!Size) || (State->writer(Data, Size, State->userData));
+}
+
+static _Bool SnapshotWriteCount(ECSSnapshotWriteState *State, uint64_t Count)
+{
+    return SnapshotWrite(State, &Count, sizeof(Count));
+}
+
+static _Bool SnapshotWriteArray(ECSSnapshotWriteState *State, CCArray Array)
+{
+    const size_t Count = Array ? CCArrayGetCount(Array) : 0;
+    
+    return (SnapshotWriteCount(State, Count)) && ((!Count) || (SnapshotWrite(State, CCArrayGetData(Array), Count * CCArrayGetElementSize(Array))));
+}
+
+static void *SnapshotBuffer(ECSSnapshotWriteState *State, size_t Size)
+{
+    if (State->size < Size)
+    {
+        if (State->buffer) CCFree(State->buffer);
+        
+        State->size = CCMax(Size, ECS_SNAPSHOT_BUFFER_SIZE);
+        State->buffer = CCMalloc(CC_STD_ALLOCATOR, State->size, NULL, CC_DEFAULT_ERROR_CALLBACK);
+        
+        if (!State->buffer) State->size = 0;
+    }
+    
+    return State->buffer;
+}
+
+static _Bool SnapshotWriteComponents(ECSSnapshotWriteState *State, const void *Components, size_t Count, size_t Size, ECSComponentID ID)
+{
+    const ECSSnapshotComponentHooks *Hooks = SnapshotComponentHooks(ID);
+    
+    if ((!Hooks) || (!Hooks->serialize) || (!Size)) return SnapshotWrite(State, Components, Count * Size);
+    
+    void *Buffer = SnapshotBuffer(State, Size);
+    
+    if (!Buffer) return FALSE;
+    
+    const size_t BatchCount = State->size / Size;
+    
+    for (size_t Index = 0; Index < Count; Index += BatchCount)
+    {
+        const size_t WriteCount = CCMin(BatchCount, Count - Index);
+        
+        memcpy(Buffer, Components + (Index * Size), WriteCount * Size);
+        
+        Hooks->serialize(State->context, Buffer, WriteCount, ID);
+        
+        if (!SnapshotWrite(State, Buffer, WriteCount * Size)) return FALSE;
+    }
+    
+    return TRUE;
+}
+
+static _Bool SnapshotWriteEntities(ECSSnapshotWriteState *State)
+{
+    ECSContext *Context = State->context;
+    
+    const size_t Count = CCArrayGetCount(Context->manager.map);
+    const size_t Size = CCArrayGetElementSize(Context->manager.map);
+    
+    if (!SnapshotWriteCount(State, Count)) return FALSE;
+    
+    void *Buffer = SnapshotBuffer(State, Size);
+    
+    if (!Buffer) return FALSE;
+    
+    const size_t BatchCount = State->size / Size;
+    
+    for (size_t Index = 0; Index < Count; Index += BatchCount)
+    {
+        const size_t WriteCount = CCMin(BatchCount, Count - Index);
+        
+        memcpy(Buffer, CCArrayGetData(Context->manager.map) + (Index * Size), WriteCount * Size);
+        
+        if (ECSLocalComponentSnapshotHooks)
+        {
+            for (size_t Loop = 0; Loop < WriteCount; Loop++) SnapshotConvertLocalComponents(Context, Buffer + (Loop * Size), CCArrayGetElementAtIndex(Context->manager.lookup, Index + Loop), TRUE);
+        }
+        
+        if (!SnapshotWrite(State, Buffer, WriteCount * Size)) return FALSE;
+    }
+    
+    Buffer = SnapshotBuffer(State, sizeof(ECSEntityLookup));
+    
+    if (!Buffer) return FALSE;
+    
+    const size_t LookupBatchCount = State->size / sizeof(ECSEntityLookup);
+    
+    for (size_t Index = 0; Index < Count; Index += LookupBatchCount)
+    {
+        const size_t WriteCount = CCMin(LookupBatchCount, Count - Index);
+        
+        memcpy(Buffer, CCArrayGetElementAtIndex(Context->manager.lookup, Index), WriteCount * sizeof(ECSEntityLookup));
+        
+        for (size_t Loop = 0; Loop < WriteCount; Loop++)
+        {
+            ECSEntityLookup *Lookup = (ECSEntityLookup*)Buffer + Loop;
+            
+            // Archetypes are stored by their offset into the context
+            Lookup->archetype = (void*)(uintptr_t)(Lookup->archetype ? (void*)Lookup->archetype - (void*)Context : 0);
+        }
+        
+        if (!SnapshotWrite(State, Buffer, WriteCount * sizeof(ECSEntityLookup))) return FALSE;
+    }
+    
+    return SnapshotWriteArray(State, Context->manager.available);
+}
+
+static _Bool SnapshotWriteArchetypes(ECSSnapshotWriteState *State)
+{
+    ECSContext *Context = State->context;
+    
+    const size_t Count = Context->archetypeInfo ? CCArrayGetCount(Context->archetypeInfo) : 0;
+    
+    if (!SnapshotWriteCount(State, Count)) return FALSE;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        const ECSArchetypeInfo *Info = CCArrayGetElementAtIndex(Context->archetypeInfo, Loop);
+        const ECSArchetype *Archetype = (void*)Context + Info->offset;
+        const size_t EntityCount = CCArrayGetCount(Archetype->entities);
+        
+        if ((!SnapshotWrite(State, Info, sizeof(ECSArchetypeInfo))) || (!SnapshotWriteArray(State, Archetype->entities))) return FALSE;
+        
+        for (size_t Loop2 = 0; Loop2 < Info->count; Loop2++)
+        {
+            if (!SnapshotWriteComponents(State, CCArrayGetData(Archetype->components[Loop2]), EntityCount, CCArrayGetElementSize(Archetype->components[Loop2]), ECSComponentIDs[Info->ids[Loop2]])) return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+static _Bool SnapshotWritePacked(ECSSnapshotWriteState *State)
+{
+    ECSContext *Context = State->context;
+    
+    for (size_t Loop = 0; Loop < ECS_PACKED_COMPONENT_MAX; Loop++)
+    {
+        const ECSPackedComponent *Packed = &Context->packed[Loop];
+        const size_t Count = Packed->entities ? CCArrayGetCount(Packed->entities) : 0;
+        
+        if (!SnapshotWriteArray(State, Packed->entities)) return FALSE;
+        
+        if ((Count) && (!SnapshotWriteComponents(State, CCArrayGetData(*Packed->components), Count, CCArrayGetElementSize(*Packed->components), ECSComponentIDs[Loop + ECSComponentBaseIndex(ECSComponentStorageTypePacked)]))) return FALSE;
+    }
+    
+    return TRUE;
+}
+
+static _Bool SnapshotWriteIndexed(ECSSnapshotWriteState *State)
+{
+    ECSContext *Context = State->context;
+    
+    for (size_t Loop = 0; Loop < ECS_INDEXED_COMPONENT_MAX; Loop++)
+    {
+        CCArray Components = Context->indexed[Loop];
+        const size_t Count = Components ? CCArrayGetCount(Components) : 0;
+        const size_t CompIndex = Loop + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed);
+        
+        if (!SnapshotWriteCount(State, Count)) return FALSE;
+        
+#if ECS_INDEXED_SPARSE_SET
+        const ECSIndexedSparseSet *Set = &Context->indexedSets[Loop];
+        
+        if ((Count) && ((!SnapshotWrite(State, CCArrayGetData(Set->entities), Count * sizeof(ECSEntity))) || (!SnapshotWriteComponents(State, CCArrayGetData(Components), Count, CCArrayGetElementSize(Components), ECSComponentIDs[CompIndex])))) return FALSE;
+        
+        if (!SnapshotWriteArray(State, Set->sparse)) return FALSE;
 #else
-                        CopiedComponents[CopiedComponentCount++] = (typeof(*CopiedComponents)){
-                            .destructor = ECSArchetypeComponentDestructors[CompID],
-                            .component = {
-                                .id = ID,
-                                .data = ECSSharedZoneStore(CCArrayGetElementAtIndex(Refs->archetype.ptr->components[RemovedIndex], Refs->archetype.index), ECSArchetypeComponentSizes[CompID])
-                            }
-                        };
+        if (Count)
+        {
+            const ECSComponentID ID = ECSComponentIDs[CompIndex];
+            const size_t Size = CCArrayGetElementSize(Components);
+            const void *Data = CCArrayGetData(Components);
+            
+            if (!SnapshotComponentHooks(ID))
+            {
+                if (!SnapshotWrite(State, Data, Count * Size)) return FALSE;
+            }
+            
+            else
+            {
+                // Only the components of entities that have them can be converted
+                _Bool Present;
+                for (size_t Start = 0, End; Start < Count; Start = End)
+                {
+                    End = SnapshotIndexedRun(Context, Start, Count, CompIndex, &Present);
+                    
+                    if (!(Present ? SnapshotWriteComponents(State, Data + (Start * Size), End - Start, Size, ID) : SnapshotWrite(State, Data + (Start * Size), (End - Start) * Size))) return FALSE;
+                }
+            }
+        }
+#endif
+    }
+    
+    return TRUE;
+}
+
+static _Bool SnapshotWriteLinks(ECSSnapshotWriteState *State)
+{
+    ECSContext *Context = State->context;
+    
+    for (size_t Loop = 0, Count = Context->links.associations ? CCArrayGetCount(Context->links.associations) : 0; Loop < Count; Loop++)
+    {
+        CCEnumerable Enumerable;
+        ECSLinkEnumerable(Context, Loop, &Enumerable);
+        
+        for (void **Key = CCEnumerableGetCurrent(&Enumerable); Key; Key = CCEnumerableNext(&Enumerable))
+        {
+            const ECSLink *Link = ECS_LINK_IS_INVERTED(*Key) ? ECS_LINK_INVERT(*Key) : *Key;
+            
+            size_t Index = 0;
+            for ( ; (Index < ECSSnapshotLinkCount) && (ECSSnapshotLinks[Index] != Link); Index++);
+            
+            CCAssertLog(Index < ECSSnapshotLinkCount, "Links must be in ECSSnapshotLinks");
+            
+            if (Index == ECSSnapshotLinkCount) return FALSE;
+            
+            size_t LinkedCount;
+            const ECSEntity *Linked = ECSLinkGet(Context, Loop, *Key, &LinkedCount);
+            
+            const ECSSnapshotLinkRecord Record = {
+                .entity = Loop,
+                .link = (Index << 1) | ECS_LINK_IS_INVERTED(*Key),
+                .count = LinkedCount
+            };
+            
+            if ((!SnapshotWrite(State, &Record, sizeof(Record))) || (!SnapshotWrite(State, Linked, sizeof(ECSEntity) * LinkedCount))) return FALSE;
+        }
+    }
+    
+    return SnapshotWrite(State, &(ECSSnapshotLinkRecord){ .entity = ECS_ENTITY_NULL }, sizeof(ECSSnapshotLinkRecord));
+}
+
+static _Bool SnapshotWriteRegistryID(ECSSnapshotWriteState *State, ECSEntity Entity, ECSRegistryID ID)
+{
+    _Bool Written = FALSE;
+    
+    CCString String = CCBigIntFastGetString(ID);
+    
+    CC_STRING_TEMP_BUFFER(Buffer, String)
+    {
+        const size_t Length = strlen(Buffer);
+        
+        Written = (SnapshotWrite(State, &(ECSSnapshotRegistryRecord){ .entity = Entity, .length = Length }, sizeof(ECSSnapshotRegistryRecord))) && (SnapshotWrite(State, Buffer, Length));
+    }
+    
+    CCStringDestroy(String);
+    
+    return Written;
+}
+
+static _Bool SnapshotWriteRegistry(ECSSnapshotWriteState *State)
+{
+    ECSContext *Context = State->context;
+    
+    // The next registry ID, followed by the registered entities
+    if (!SnapshotWriteRegistryID(State, ECS_ENTITY_NULL, Context->registry.id ? Context->registry.id : CC_BIG_INT_FAST_0)) return FALSE;
+    
+    if (Context->registry.uniqueEntityIDs)
+    {
+        const ECSRegistryID *IDs = CCArrayGetData(Context->registry.uniqueEntityIDs);
+        
+        for (size_t Loop = 0, Count = CCArrayGetCount(Context->registry.uniqueEntityIDs); Loop < Count; Loop++)
+        {
+            if ((IDs[Loop]) && (!SnapshotWriteRegistryID(State, Loop, IDs[Loop]))) return FALSE;
+        }
+    }
+    
+    return SnapshotWrite(State, &(ECSSnapshotRegistryRecord){ .entity = ECS_ENTITY_NULL, .length = 0 }, sizeof(ECSSnapshotRegistryRecord));
+}
+
+_Bool ECSSnapshotWrite(ECSContext *Context, ECSSnapshotWriter Writer, void *UserData)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Writer, "Writer must not be null");
+    
+    ECSSnapshotWriteState State = {
+        .context = Context,
+        .writer = Writer,
+        .userData = UserData
+    };
+    
+    ECSSnapshotHeader Header;
+    SnapshotHeaderInit(&Header, Context);
+    
+    const _Bool Written = (SnapshotWrite(&State, &Header, sizeof(Header)))
+                        && (SnapshotWriteEntities(&State))
+                        && (SnapshotWriteArchetypes(&State))
+                        && (SnapshotWritePacked(&State))
+                        && (SnapshotWriteIndexed(&State))
+                        && (SnapshotWriteLinks(&State))
+                        && (SnapshotWriteRegistry(&State));
+    
+    if (State.buffer) CCFree(State.buffer);
+    
+    return Written;
+}
+
+static const void *SnapshotRead(ECSSnapshotReader *Reader, size_t Count, size_t Size)
+{
+    if ((Size) && (Count > ((size_t)(Reader->end - Reader->data) / Size))) return NULL;
+    
+    const void *Data = Reader->data;
+    Reader->data += Count * Size;
+    
+    return Data;
+}
+
+static _Bool SnapshotReadCount(ECSSnapshotReader *Reader, size_t *Count)
+{
+    const void *Data = SnapshotRead(Reader, 1, sizeof(uint64_t));
+    
+    if (!Data) return FALSE;
+    
+    uint64_t Value;
+    memcpy(&Value, Data, sizeof(Value));
+    
+    if (Value > SIZE_MAX) return FALSE;
+    
+    *Count = (size_t)Value;
+    
+    return TRUE;
+}
+
+static _Bool SnapshotReadElements(ECSSnapshotReader *Reader, CCArray Array, size_t Count)
+{
+    const void *Data = SnapshotRead(Reader, Count, CCArrayGetElementSize(Array));
+    
+    if (!Data) return FALSE;
+    
+    if (Count) CCArrayAppendElements(Array, Data, Count);
+    
+    return TRUE;
+}
+
+static void SnapshotFixupComponents(ECSContext *Context, CCArray Components, size_t Index, size_t Count, ECSComponentID ID)
+{
+    const ECSSnapshotComponentHooks *Hooks = SnapshotComponentHooks(ID);
+    
+    if ((Count) && (Hooks) && (Hooks->fixup)) Hooks->fixup(Context, CCArrayGetElementAtIndex(Components, Index), Count, ID);
+}
+
+static _Bool SnapshotReadEntities(ECSContext *Context, ECSSnapshotReader *Reader)
+{
+    size_t Count;
+    
+    if ((!SnapshotReadCount(Reader, &Count)) || (!SnapshotReadElements(Reader, Context->manager.map, Count))) return FALSE;
+    
+    if (!Context->manager.lookup) Context->manager.lookup = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntityLookup), Context->manager.map->chunkSize);
+    
+    if (!SnapshotReadElements(Reader, Context->manager.lookup, Count)) return FALSE;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Loop);
+        const uintptr_t Offset = (uintptr_t)Lookup->archetype;
+        
+        if (Offset >= sizeof(ECSContext)) return FALSE;
+        
+        Lookup->archetype = Offset ? (void*)Context + Offset : NULL;
+        
+        if (ECSLocalComponentSnapshotHooks) SnapshotConvertLocalComponents(Context, CCArrayGetElementAtIndex(Context->manager.map, Loop), Lookup, FALSE);
+    }
+    
+    return (SnapshotReadCount(Reader, &Count)) && (SnapshotReadElements(Reader, Context->manager.available, Count));
+}
+
+static _Bool SnapshotReadArchetypes(ECSContext *Context, ECSSnapshotReader *Reader)
+{
+    size_t Count;
+    
+    if (!SnapshotReadCount(Reader, &Count)) return FALSE;
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        const void *Data = SnapshotRead(Reader, 1, sizeof(ECSArchetypeInfo));
+        
+        if (!Data) return FALSE;
+        
+        ECSArchetypeInfo Info;
+        memcpy(&Info, Data, sizeof(Info));
+        
+        if ((!Info.count) || (Info.count > ECS_ARCHETYPE_MAX)) return FALSE;
+        
+        for (size_t Loop2 = 0; Loop2 < Info.count; Loop2++)
+        {
+            if ((Info.ids[Loop2] >= ECS_ARCHETYPE_COMPONENT_MAX) || ((Loop2) && (Info.ids[Loop2] <= Info.ids[Loop2 - 1]))) return FALSE;
+        }
+        
+        // The archetype must be stored in the slot its components map to
+        const size_t ArchID = ArchtypeIndex(Info.ids, Info.count);
+        
+        if (Info.offset != (ArchetypeOffset[Info.count].base + (ArchetypeOffset[Info.count].size * (ptrdiff_t)ArchID))) return FALSE;
+        
+        ECSArchetype *Archetype = (void*)Context + Info.offset;
+        
+        if (Archetype->entities) return FALSE;
+        
+        ArchetypeCreate(Context, Archetype, ArchID, Info.ids, Info.count);
+        
+        size_t EntityCount;
+        
+        if ((!SnapshotReadCount(Reader, &EntityCount)) || (!SnapshotReadElements(Reader, Archetype->entities, EntityCount))) return FALSE;
+        
+        for (size_t Loop2 = 0; Loop2 < Info.count; Loop2++)
+        {
+            if (!SnapshotReadElements(Reader, Archetype->components[Loop2], EntityCount)) return FALSE;
+            
+            SnapshotFixupComponents(Context, Archetype->components[Loop2], 0, EntityCount, ECSComponentIDs[Info.ids[Loop2]]);
+        }
+        
+        ECS_ARCHETYPE_CHANGED(Context, Archetype, 0, EntityCount);
+    }
+    
+    return TRUE;
+}
+
+static _Bool SnapshotReadPacked(ECSContext *Context, ECSSnapshotReader *Reader)
+{
+    for (size_t Loop = 0; Loop < ECS_PACKED_COMPONENT_MAX; Loop++)
+    {
+        size_t Count;
+        
+        if (!SnapshotReadCount(Reader, &Count)) return FALSE;
+        
+        if (!Count) continue;
+        
+        ECSPackedComponent *Packed = &Context->packed[Loop];
+        
+        if (!Packed->entities)
+        {
+            const size_t ChunkSize = ECS_PACKED_COMPONENT_ARRAY_CHUNK_SIZE(Loop);
+            
+            Packed->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize);
+            *Packed->components = CCArrayCreate(CC_STD_ALLOCATOR, ECSPackedComponentSizes[Loop], ChunkSize);
+        }
+        
+        if ((!SnapshotReadElements(Reader, Packed->entities, Count)) || (!SnapshotReadElements(Reader, *Packed->components, Count))) return FALSE;
+        
+        SnapshotFixupComponents(Context, *Packed->components, 0, Count, ECSComponentIDs[Loop + ECSComponentBaseIndex(ECSComponentStorageTypePacked)]);
+        
+        ECS_COMPONENT_CHANGED(Context, Context->packedVersions[Loop]);
+    }
+    
+    return TRUE;
+}
+
+static void SnapshotIndexedCreate(ECSContext *Context, size_t Index)
+{
+    if (Context->indexed[Index]) return;
+    
+    Context->indexed[Index] = CCArrayCreate(CC_STD_ALLOCATOR, ECSIndexedComponentSizes[Index], ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
+    
+#if ECS_INDEXED_SPARSE_SET
+    Context->indexedSets[Index].entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
+    Context->indexedSets[Index].sparse = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntityIndex), ECS_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
 #endif
-                    }
-                }
-                break;
-            }
-                
-            case ECSComponentStorageTypePacked:
-                ECSPackedRemoveComponent(Context, Entity, ID);
-                break;
-                
-            case ECSComponentStorageTypeIndexed:
-                ECSIndexedRemoveComponent(Context, Entity, ID);
-                break;
-                
-            case ECSComponentStorageTypeLocal:
-                ECSLocalRemoveComponent(Context, Entity, ID);
-                break;
-                
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeArchetype:
+}
+
+static _Bool SnapshotReadIndexed(ECSContext *Context, ECSSnapshotReader *Reader)
+{
+    for (size_t Loop = 0; Loop < ECS_INDEXED_COMPONENT_MAX; Loop++)
+    {
+        const size_t CompIndex = Loop + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed);
+        size_t Count;
+        
+        if (!SnapshotReadCount(Reader, &Count)) return FALSE;
+        
+        if (Count)
+        {
+            SnapshotIndexedCreate(Context, Loop);
+            
+#if ECS_INDEXED_SPARSE_SET
+            if (!SnapshotReadElements(Reader, Context->indexedSets[Loop].entities, Count)) return FALSE;
+#endif
+            
+            if (!SnapshotReadElements(Reader, Context->indexed[Loop], Count)) return FALSE;
+            
+#if ECS_INDEXED_SPARSE_SET
+            SnapshotFixupComponents(Context, Context->indexed[Loop], 0, Count, ECSComponentIDs[CompIndex]);
+#else
+            if (SnapshotComponentHooks(ECSComponentIDs[CompIndex]))
             {
-                if (ECSEntityHasComponent(Context, Entity, ID))
+                _Bool Present;
+                for (size_t Start = 0, End; Start < Count; Start = End)
                 {
-                    const ECSArchetypeComponentID CompID = ID & ~ECSComponentStorageMask;
-                    
-                    if (!CCBitsGet(CachedComponentLookup, CompID))
-                    {
-                        CCBitsSet(CachedComponentLookup, CompID);
-                        
-                        const size_t Offset = CompID ? CCBitsCount(RemovedComponent, 0, CompID - 1) : 0;
-                        const size_t Index = ECSArchetypeComponentIndex(Refs, CompID) + Offset;
-                        ComponentData[CompID] = CCArrayGetElementAtIndex(Refs->archetype.ptr->components[Index], Refs->archetype.index);
-                    }
-                    
-                    CCArray *Duplicates = ComponentData[CompID];
-                    const size_t Count = CCArrayGetCount(*Duplicates);
-                    if (Count)
-                    {
-                        if (ID & ECSComponentStorageModifierDestructor)
-                        {
-#if ECS_UNSAFE_COMPONENT_DESTRUCTION
-                            ECSDuplicateArchetypeComponentDestructors[CompID](CCArrayGetElementAtIndex(*Duplicates, Count - 1), ID);
-#else
-                            CopiedComponents[CopiedComponentCount++] = (typeof(*CopiedComponents)){
-                                .destructor = ECSDuplicateArchetypeComponentDestructors[CompID],
-                                .component = {
-                                    .id = ID,
-                                    .data = ECSSharedZoneStore(CCArrayGetElementAtIndex(*Duplicates, Count - 1), ECSDuplicateArchetypeComponentSizes[CompID])
-                                }
-                            };
-#endif
-                        }
-                        
-                        CCArrayRemoveElementAtIndex(*Duplicates, Count - 1);
-                    }
+                    End = SnapshotIndexedRun(Context, Start, Count, CompIndex, &Present);
                     
-                    else
-                    {
-                        if (ID & ECSComponentStorageModifierDestructor) CCArrayDestroy(*Duplicates);
-                        
-                        const size_t Offset = LastID < CompID ? LastIndex : 0;
-                        
-                        LastIndex = SortedSub(Refs->archetype.component.ids + Offset, Refs->archetype.component.count-- - Offset, CompID) + Offset;
-                        IndexCount++;
-                        CCBitsSet(RemovedComponent, CompID);
-                        CCBitsClear(Refs->has, CompID);
-                        
-                        LastID = CompID;
-                    }
+                    if (Present) SnapshotFixupComponents(Context, Context->indexed[Loop], Start, End - Start, ECSComponentIDs[CompIndex]);
                 }
-                break;
             }
-                
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypePacked:
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeIndexed:
-            case ECSComponentStorageModifierDuplicate | ECSComponentStorageTypeLocal:
-                ECSEntityRemoveDuplicateComponent(Context, Entity, ID, -1, 1);
-                break;
-                
-            default:
-                CCAssertLog(0, "Unsupported component type");
-                break;
+#endif
+            
+            ECS_COMPONENT_CHANGED(Context, Context->indexedVersions[Loop]);
+        }
+        
+#if ECS_INDEXED_SPARSE_SET
+        size_t SparseCount;
+        
+        if (!SnapshotReadCount(Reader, &SparseCount)) return FALSE;
+        
+        if (SparseCount)
+        {
+            SnapshotIndexedCreate(Context, Loop);
+            
+            if (!SnapshotReadElements(Reader, Context->indexedSets[Loop].sparse, SparseCount)) return FALSE;
         }
+#endif
     }
     
-    if (IndexCount)
+    return TRUE;
+}
+
+/*!
+ * @brief Check that the restored entities and their components reference each other.
+ * @description Every entity in an archetype, packed, or indexed component must be alive and reference that row, and every component an
+ *              entity has must be stored in a row that references it. Free entities must not be alive.
+ *
+ * @param Context The restored context.
+ * @return Whether the restored context is consistent.
+ */
+static _Bool SnapshotValidateEntities(ECSContext *Context)
+{
+    const size_t EntityCount = CCArrayGetCount(Context->manager.map);
+    size_t ArchetypeRowCount = 0, PackedRowCount = 0, IndexedRowCount = 0;
+    
+    for (size_t Loop = 0, InfoCount = Context->archetypeInfo ? CCArrayGetCount(Context->archetypeInfo) : 0; Loop < InfoCount; Loop++)
     {
-        if ((Count = Refs->archetype.component.count))
+        const ECSArchetypeInfo *Info = CCArrayGetElementAtIndex(Context->archetypeInfo, Loop);
+        ECSArchetype *Archetype = (void*)Context + Info->offset;
+        const ECSEntity *Entities = CCArrayGetData(Archetype->entities);
+        const size_t Count = CCArrayGetCount(Archetype->entities);
+        
+        for (size_t Loop2 = 0; Loop2 < Count; Loop2++)
         {
-            const size_t ArchID = ArchtypeIndex(Refs->archetype.component.ids, Count);
-            ECSArchetype *Archetype = ((void*)Context + ArchetypeOffset[Count].base) + (ArchetypeOffset[Count].size * ArchID);
+            if ((Entities[Loop2] >= EntityCount) || (!ECSEntityIsAlive(Context, Entities[Loop2]))) return FALSE;
             
-            if (CC_UNLIKELY(!Archetype->entities))
-            {
-                const size_t ChunkSize = ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ArchID, Count);
-                
-                Archetype->entities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), ChunkSize);
-                
-                for (size_t Loop = 0; Loop < Count; Loop++) Archetype->components[Loop] = CCArrayCreate(CC_STD_ALLOCATOR, ECSArchetypeComponentSizes[Refs->archetype.component.ids[Loop]], ChunkSize);
-            }
+            const ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Loop2]);
+            const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop2]);
             
-            const size_t Index = CCArrayAppendElement(Archetype->entities, &Entity);
-            
-            const size_t PrevCount = Count + IndexCount;
-            ECSArchetype *PrevArchetype = Refs->archetype.ptr;
+            if ((Lookup->archetype != Archetype) || (Lookup->index != Loop2) || (Refs->archetype.component.count != Info->count) || (memcmp(Refs->archetype.component.ids, Info->ids, sizeof(ECSArchetypeComponentID) * Info->count))) return FALSE;
             
-            for (size_t Loop = 0, ComponentIndex = 0; Loop < PrevCount; Loop++)
+            for (size_t Loop3 = 0; Loop3 < ECS_ARCHETYPE_COMPONENT_MAX; Loop3++)
             {
-                _Static_assert(ECSComponentStorageTypeArchetype == 0, "Expects archetype storage type to be 0");
-                
-                const ECSArchetypeComponentID ID = Refs->archetype.component.ids[Loop];
-                
-#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
-                if (ID == INT8_MAX) ComponentIndex++;
-#else
-                if (ID == UINT8_MAX) ComponentIndex++;
-#endif
-                else
-                {
-                    const void *Copy = CCArrayGetElementAtIndex(PrevArchetype->components[Loop], Refs->archetype.index);
-                    CCArrayAppendElement(Archetype->components[Loop - ComponentIndex], Copy);
-                }
+                if (CCBitsGet(Lookup->has, Loop3) != ECSArchetypeComponentMaskHas(&Archetype->mask, Loop3)) return FALSE;
             }
+        }
+        
+        ArchetypeRowCount += Count;
+    }
+    
+    for (size_t Loop = 0; Loop < ECS_PACKED_COMPONENT_MAX; Loop++)
+    {
+        if (!Context->packed[Loop].entities) continue;
+        
+        const ECSEntity *Entities = CCArrayGetData(Context->packed[Loop].entities);
+        const size_t Count = CCArrayGetCount(Context->packed[Loop].entities);
+        
+        for (size_t Loop2 = 0; Loop2 < Count; Loop2++)
+        {
+            if ((Entities[Loop2] >= EntityCount) || (!ECSEntityIsAlive(Context, Entities[Loop2]))) return FALSE;
             
-            ArchetypeRemove(Context, PrevArchetype, PrevCount, Refs->archetype.index);
+            const ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entities[Loop2]);
+            const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop2]);
             
-            Refs->archetype.ptr = Archetype;
-            Refs->archetype.index = Index;
+            if ((!CCBitsGet(Lookup->has, Loop + ECSComponentBaseIndex(ECSComponentStorageTypePacked))) || (Refs->packed.indexes[Loop] != Loop2)) return FALSE;
         }
         
-        else
+        PackedRowCount += Count;
+    }
+    
+#if ECS_INDEXED_SPARSE_SET
+    for (size_t Loop = 0; Loop < ECS_INDEXED_COMPONENT_MAX; Loop++)
+    {
+        const ECSIndexedSparseSet *Set = &Context->indexedSets[Loop];
+        
+        if (!Set->entities) continue;
+        
+        const ECSEntity *Entities = CCArrayGetData(Set->entities);
+        const size_t Count = CCArrayGetCount(Set->entities);
+        
+        for (size_t Loop2 = 0; Loop2 < Count; Loop2++)
         {
-            ArchetypeRemove(Context, Refs->archetype.ptr, IndexCount, Refs->archetype.index);
+            if ((Entities[Loop2] >= EntityCount) || (!ECSEntityIsAlive(Context, Entities[Loop2])) || (Entities[Loop2] >= CCArrayGetCount(Set->sparse))) return FALSE;
             
-            Refs->archetype.ptr = NULL;
-            Refs->archetype.index = 0;
+            const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entities[Loop2]);
+            
+            if ((!CCBitsGet(Lookup->has, Loop + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed))) || (*(ECSEntityIndex*)CCArrayGetElementAtIndex(Set->sparse, Entities[Loop2]) != Loop2)) return FALSE;
         }
+        
+        IndexedRowCount += Count;
     }
+#endif
     
-#if !ECS_UNSAFE_COMPONENT_DESTRUCTION
-    for (size_t Loop = 0; Loop < CopiedComponentCount; Loop++)
+    // Each verified row belongs to a different entity component, so if the totals match then every component an entity has was verified
+    for (size_t Loop = 0; Loop < EntityCount; Loop++)
     {
-        CopiedComponents[Loop].destructor(CopiedComponents[Loop].component.data, CopiedComponents[Loop].component.id);
+        if (!ECSEntityIsAlive(Context, Loop)) continue;
+        
+        const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Loop);
+        
+        if (Lookup->archetype)
+        {
+            if (!ArchetypeRowCount--) return FALSE;
+        }
+        
+        else
+        {
+            for (size_t Loop2 = 0; Loop2 < ECS_ARCHETYPE_COMPONENT_MAX; Loop2++)
+            {
+                if (CCBitsGet(Lookup->has, Loop2)) return FALSE;
+            }
+        }
+        
+        for (size_t Loop2 = 0; Loop2 < ECS_PACKED_COMPONENT_MAX; Loop2++)
+        {
+            if ((CCBitsGet(Lookup->has, Loop2 + ECSComponentBaseIndex(ECSComponentStorageTypePacked))) && (!PackedRowCount--)) return FALSE;
+        }
+        
+        for (size_t Loop2 = 0; Loop2 < ECS_INDEXED_COMPONENT_MAX; Loop2++)
+        {
+            if (CCBitsGet(Lookup->has, Loop2 + ECSComponentBaseIndex(ECSComponentStorageTypeIndexed)))
+            {
+#if ECS_INDEXED_SPARSE_SET
+                if (!IndexedRowCount--) return FALSE;
+#else
+                if ((!Context->indexed[Loop2]) || (Loop >= CCArrayGetCount(Context->indexed[Loop2]))) return FALSE;
+#endif
+            }
+        }
     }
     
-    CCMemoryZoneRestore(ECSSharedZone);
-#endif
+    if ((ArchetypeRowCount) || (PackedRowCount) || (IndexedRowCount)) return FALSE;
+    
+    const ECSEntity *Available = CCArrayGetData(Context->manager.available);
+    
+    for (size_t Loop = 0, Count = CCArrayGetCount(Context->manager.available); Loop < Count; Loop++)
+    {
+        if ((Available[Loop] >= EntityCount) || (ECSEntityIsAlive(Context, Available[Loop]))) return FALSE;
+    }
+    
+    return TRUE;
 }
 
-size_t ECSArchetypeComponentIndex(const ECSComponentRefs *Refs, ECSComponentID ID)
+static _Bool SnapshotReadLinks(ECSContext *Context, ECSSnapshotReader *Reader)
 {
-    CCAssertLog((ID & ECSComponentStorageMask) == 0, "ID must not have any modifiers");
+    const size_t EntityCount = CCArrayGetCount(Context->manager.map);
     
-#if ECS_ARCHETYPE_COMPONENT_ID_SIMD_LOOKUP && CC_HARDWARE_VECTOR_SUPPORT_SSSE3
-    const __m128i Zero = _mm_setzero_si128();
-    const __m128i One = _mm_set1_epi8(1);
-    const __m128i Value = _mm_set1_epi8(ID);
+    ECSLinkMapInit(Context);
     
-#if ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX) < INT8_MAX
-    __m128i Mask = _mm_and_si128(_mm_cmplt_epi8(_mm_load_si128((__m128i*)Refs->archetype.component.ids), Value), One);
-    for (size_t Loop = 16; Loop < ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX); Loop += 16)
+    for ( ; ; )
     {
-        Mask = _mm_add_epi8(Mask, _mm_and_si128(_mm_cmplt_epi8(_mm_load_si128((__m128i*)(Refs->archetype.component.ids + Loop)), Value), One));
+        const void *Data = SnapshotRead(Reader, 1, sizeof(ECSSnapshotLinkRecord));
+        
+        if (!Data) return FALSE;
+        
+        ECSSnapshotLinkRecord Record;
+        memcpy(&Record, Data, sizeof(Record));
+        
+        if (Record.entity == ECS_ENTITY_NULL) break;
+        
+        const size_t Index = Record.link >> 1;
+        
+        if ((Index >= ECSSnapshotLinkCount) || (Record.entity >= EntityCount) || (!Record.count)) return FALSE;
+        
+        const ECSEntity *Entities = SnapshotRead(Reader, Record.count, sizeof(ECSEntity));
+        
+        if ((!Entities) || (!ECSEntityIsAlive(Context, (ECSEntity)Record.entity))) return FALSE;
+        
+        for (size_t Loop = 0; Loop < Record.count; Loop++)
+        {
+            if ((Entities[Loop] >= EntityCount) || (!ECSEntityIsAlive(Context, Entities[Loop]))) return FALSE;
+        }
+        
+        const ECSLink *Link = ECSSnapshotLinks[Index];
+        
+        ECSLinkRestore(Context, (ECSEntity)Record.entity, (Record.link & 1) ? ECS_LINK_INVERT(Link) : Link, Entities, Record.count);
     }
     
-    const uint32_t Index = _mm_cvtsi128_si32(_mm_hadd_epi16(_mm_hadd_epi16(_mm_hadd_epi16(Mask, Zero), Zero), Zero));
+    return TRUE;
+}
+
+/*!
+ * @brief Read a registry ID from a snapshot.
+ * @param Reader The snapshot reader.
+ * @param Entity Set to the entity of the registry ID.
+ * @param ID Set to the registry ID, or NULL if there was none. The caller takes ownership of the ID.
+ * @return Whether the registry ID could be read.
+ */
+static _Bool SnapshotReadRegistryID(ECSSnapshotReader *Reader, ECSEntity *Entity, ECSRegistryID *ID)
+{
+    const void *Data = SnapshotRead(Reader, 1, sizeof(ECSSnapshotRegistryRecord));
     
-    return (Index & 0xff) + (Index >> 8);
-#else
-    __m128i Max = _mm_max_epu8(_mm_load_si128((__m128i*)Refs->archetype.component.ids), Value);
-    __m128i Mask = _mm_and_si128(_mm_cmpeq_epi8(Max, Value), One);
-    for (size_t Loop = 16; Loop < ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX); Loop += 16)
+    if (!Data) return FALSE;
+    
+    ECSSnapshotRegistryRecord Record;
+    memcpy(&Record, Data, sizeof(Record));
+    
+    const char *Characters = SnapshotRead(Reader, Record.length, sizeof(char));
+    
+    if (!Characters) return FALSE;
+    
+    *Entity = (ECSEntity)Record.entity;
+    *ID = NULL;
+    
+    if (Record.length)
     {
-        Max = _mm_max_epu8(_mm_load_si128((__m128i*)(Refs->archetype.component.ids + Loop)), Value);
-        Mask = _mm_add_epi8(Mask, _mm_and_si128(_mm_cmpeq_epi8(Max, Value), One));
+        CCString String = CCStringCreateWithSize(CC_STD_ALLOCATOR, CCStringEncodingASCII | CCStringHintCopy, Characters, Record.length);
+        
+        *ID = CC_BIG_INT_FAST_0;
+        CCBigIntFastSetString(ID, String);
+        
+        CCStringDestroy(String);
     }
     
-    const uint32_t Index = _mm_cvtsi128_si32(_mm_hadd_epi16(_mm_hadd_epi16(_mm_hadd_epi16(Mask, Zero), Zero), Zero));
+    return TRUE;
+}
+
+static _Bool SnapshotReadRegistry(ECSContext *Context, ECSSnapshotReader *Reader)
+{
+    ECSEntity Entity;
+    ECSRegistryID ID;
     
-    return (Index & 0xff) + (Index >> 8) - 1;
-#endif
-#else
-    const size_t Index = FindIndex(Refs->archetype.component.ids, Refs->archetype.component.count, ECS_ARCHETYPE_COMPONENT_MAX, ID);
+    if ((!SnapshotReadRegistryID(Reader, &Entity, &ID)) || (!ID)) return FALSE;
     
-    CCAssertLog(Index != SIZE_MAX, "Invalid ID for archetype");
+    ECSRegistryInit(Context, ID);
+    CCBigIntFastDestroy(ID);
     
-    return Index;
-#endif
+    const size_t EntityCount = CCArrayGetCount(Context->manager.map);
+    
+    for ( ; ; )
+    {
+        if (!SnapshotReadRegistryID(Reader, &Entity, &ID)) return FALSE;
+        
+        if (!ID) return Entity == ECS_ENTITY_NULL;
+        
+        if ((Entity >= EntityCount) || (!ECSEntityIsAlive(Context, Entity)))
+        {
+            CCBigIntFastDestroy(ID);
+            
+            return FALSE;
+        }
+        
+        // Ownership of the ID is passed to the registry
+        ECSRegistryReregister(Context, Entity, ID, TRUE);
+    }
+}
+
+_Bool ECSSnapshotRestore(ECSContext *Context, const void *Data, size_t Size)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Data, "Data must not be null");
+    CCAssertLog(!CCArrayGetCount(Context->manager.map), "Context must not contain any entities");
+    
+    ECSSnapshotReader Reader = {
+        .data = Data,
+        .end = (const uint8_t*)Data + Size
+    };
+    
+    ECSSnapshotHeader Header;
+    SnapshotHeaderInit(&Header, Context);
+    
+    const void *SnapshotHeader = SnapshotRead(&Reader, 1, sizeof(Header));
+    
+    if ((!SnapshotHeader) || (memcmp(SnapshotHeader, &Header, sizeof(Header)))) return FALSE;
+    
+    return (SnapshotReadEntities(Context, &Reader))
+        && (SnapshotReadArchetypes(Context, &Reader))
+        && (SnapshotReadPacked(Context, &Reader))
+        && (SnapshotReadIndexed(Context, &Reader))
+        && (SnapshotValidateEntities(Context))
+        && (SnapshotReadLinks(Context, &Reader))
+        && (SnapshotReadRegistry(Context, &Reader));
 }
@@ -49,6 +49,7 @@
  *                  - @b ECSDuplicatePackedComponentSizes
  *                  - @b ECSDuplicateIndexedComponentSizes
  *                  - @b ECSDuplicateLocalComponentSizes
+ *                  - @b ECSSharedArchetypeComponentSizes (only if shared components are used)
  *
  *                  Component Destructors
  *                  - @b ECSArchetypeComponentDestructors
@@ -59,6 +60,7 @@
  *                  - @b ECSDuplicatePackedComponentDestructors
  *                  - @b ECSDuplicateIndexedComponentDestructors
  *                  - @b ECSDuplicateLocalComponentDestructors
+ *                  - @b ECSSharedArchetypeComponentDestructors (optional)
  *
  *                  Mutable State Sizes
  *                  - @b ECSMutableStateEntitiesMax
@@ -82,10 +84,13 @@
  *             memset(&Context, 0, sizeof(Context));
  *             Context.mutations = &MutableState;
  *             Context.manager.map = CCArrayCreate(CC_ALIGNED_ALLOCATOR(ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), CC_ALIGN(sizeof(ECSComponentRefs) + LOCAL_STORAGE_SIZE, ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT), 16);
- *             Context.manager.available = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(size_t), 16);
+ *             Context.manager.available = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), 16);
  *             ECSRegistryInit(&Context, CC_BIG_INT_FAST_0);
  *             ```
  *
+ *             The @b manager.lookup array is created by the context when the first entity is created, and should be destroyed along with
+ *             @b manager.map.
+ *
  *             ## Groups
  *             Groups define how systems should run. Both the frequency, the ordering of the systems, and their dependencies (what they need to wait for before they can run).
  *             To create a group use @b ECS_SYSTEM_GROUP and the ecs\_tool to generate the configuration.
@@ -122,6 +127,7 @@
  *                  ##### Indexed
  *                  Indexed storage keeps the component data sepaarated by an Entity's ID. This means random lookups are faster than the archetype or packed variants, but iteration
  *                  is quite slow. If iteration is desired, it is best to parallelise the system by this component at a reasonable chunk size.
+ *                  If @b ECS_INDEXED_SPARSE_SET is enabled, indexed storage becomes a sparse set instead. See the configuration section.
  *
  *                  ##### Local
  *                  Local storage stores the component data in the entity itself. Similar to indexed, this means lookups are fast but iteration is slow. This storage type offers
@@ -131,7 +137,9 @@
  *                  These change the behaviour of components. Certain modifiers can be combined.
  *
  *                  ##### Duplicate
- *                  Duplicate components allow for multiple components of the same type to be added to an entity.
+ *                  Duplicate components allow for multiple components of the same type to be added to an entity. The component data stored for the entity is an
+ *                  @b ECSDuplicateComponent, so the component's size should be @b ECS_DUPLICATE_COMPONENT_SIZE of the element size, while the element size is set
+ *                  in the duplicate component sizes.
  *
  *                  ##### Tag
  *                  Tagged components allow for components with no data to be attached to an entity.
@@ -139,6 +147,15 @@
  *                  ##### Destructor
  *                  Component destructors allow for custom cleanup of component data when a component is removed.
  *
+ *                  ##### Shared
+ *                  Shared archetype components deduplicate identical values. The value is interned per context with @b ECSSharedComponentIntern, and entities store
+ *                  the returned @b ECSSharedComponentHandle (so the component's size is the size of the handle) whose reference they take ownership of. A shared
+ *                  component must also use the destructor modifier with @b ECSSharedDestructor as its destructor, so the value is released when the last entity
+ *                  referencing it removes the component. The size of the value itself is set in @b ECSSharedArchetypeComponentSizes. @b ECSSharedComponentGroup
+ *                  reorders archetypes so entities sharing a value are contiguous, and @b ECSArchetypeNextSharedRange can then be used by systems to hoist the
+ *                  value out of their inner loop. The interned values and their reference counts are not threadsafe, so interning, retaining, releasing, and
+ *                  grouping must only be done from the thread that ticks the context and applies its mutations (never from systems running on the workers).
+ *
  *             To register a component type use any of the following:
  *              - @b ECS_LOCAL_COMPONENT
  *              - @b ECS_PACKED_COMPONENT
@@ -179,10 +196,40 @@
  *
  *             Applying a mutation could be done on a worker as long as you can make the guarantee that @b Context will not be modified on another at the same time.
  *
+ *             ## Queries
+ *             Entities can also be iterated outside of systems by creating an @b ECSQuery. Queries cache the archetypes that match their with/without components
+ *             and pick up newly created archetypes incrementally, so they are cheap to keep around and iterate repeatedly.
+ *
+ *             ## Snapshots
+ *             A context can be written to a snapshot using @b ECSSnapshotWrite, and restored into an empty context using @b ECSSnapshotRestore. The snapshot stores the
+ *             entities, archetype columns, packed and indexed component arrays, local storage, links and registry as contiguous blocks, so restoring mostly consists of
+ *             copying each block into its array. The snapshot can be restored directly from memory, such as an mmap'd file. Snapshots are only compatible with builds
+ *             that use the same ECS configuration, component IDs and component sizes. When restoring, the entities and the component storage are checked to
+ *             reference each other, so a corrupt snapshot is rejected rather than restored.
+ *
+ *             Components that hold pointers or other resources (this includes any component with a destructor, duplicate components, and shared components) must
+ *             provide @b ECSSnapshotComponentHooks, so they can be converted to and from a form that can be stored. Links are stored by their index in
+ *             @b ECSSnapshotLinks.
+ *
  *             ## Concurrency
  *             The core concurrency mechanism is through scheduling systems to a pool of worker threads. When threads are waiting for work to become available to them they will call into a
  *             waiting callback that can perform some custom work in the meantime.
  *
+ *             Each worker has its own deque of system executors that @b ECSTick distributes work across. When a worker's deque is empty it will steal work from the deques of the
+ *             other workers, starting from a random victim.
+ *
+ *             Systems may also fork nested work onto the workers using @b ECSParallelFor or task groups (@b ECSTaskGroupRun and @b ECSTaskGroupWait). Tasks are pushed
+ *             to the calling worker's own task deque, and the waiting worker will help execute tasks until its group has finished. Other threads (such as the thread
+ *             calling @b ECSTick) push their tasks to a shared injection deque that the workers steal from, and help execute tasks while they wait in the same way.
+ *
+ *             Systems that must run on the thread calling @b ECSTick (such as those using a graphics context) can be marked as main thread systems using
+ *             @b ECS_SYSTEM_UPDATE_MAIN. These are scheduled using the same dependency and access rules, but are executed by the tick itself while the
+ *             workers execute the other systems.
+ *
+ *             Idle workers will spin (calling the waiting callback) for @b ECSWorkerSpinBudget attempts before parking. When @b ECSTick submits work it
+ *             only wakes as many parked workers as the number of executors it submitted. The @b ECSWorkerParkThreshold can be used to keep a number
+ *             of idle workers spinning, and @b ECSWorkerGetParkCounters can be used to tune these values.
+ *
  *             ## ecs_tool
  *             The CLI tool for generating a lot of the boilerplate that is required.
  *
@@ -193,13 +240,25 @@
  *                  ##### ECS_SYSTEM_EXECUTOR_COMPONENT_MAX
  *                  This should be set to at least the maximum number of components that a system will require access to. By default this is set to 16.
  *
- *                  ##### ECS_SYSTEM_EXECUTION_POOL_MAX
- *                  This should be set to a size that's larger than the maximum number of systems that may be scheduled to the worker pool at any one time. By default this is set to 1024.
+ *                  ##### ECS_WORKER_EXECUTOR_DEQUE_MAX
+ *                  This should be set to a power of 2 size for the maximum number of system executors each worker's deque can hold. If every deque is full the tick will wake the
+ *                  workers and execute executors itself until there is room, so a larger value only reduces how often the tick has to help. By default this is set to 1024.
+ *
+ *                  ##### ECS_WORKER_TASK_DEQUE_MAX
+ *                  This should be set to a power of 2 size for the maximum number of pending nested tasks per worker. If a worker's task deque is full further
+ *                  tasks are executed immediately. This is also the size of the injection deque used by threads that aren't workers. By default this is set to 256.
+ *
+ *                  ##### ECS_MAIN_EXECUTOR_MAX
+ *                  This can be defined to the maximum number of main thread systems that may be waiting to be executed by @b ECSTick at once. If this is
+ *                  exceeded the tick runs the waiting main thread systems before submitting any more. By default this is set to 16.
  *
  *                  ##### ECS_COMPONENT_ACCESS_RELEASE_MAX
  *                  This should be set to the maximum number of allowed entires in an access release. By default this is set to 16. A larger value reduces the likelihood of a worker's access
  *                  releases getting filled and having to wait until the @b ECSTick has processed them.
  *
+ *                  ##### ECS_TICK_CONCURRENT_MAX
+ *                  This can be defined to the maximum number of @b ECSTick calls that may run concurrently (for different contexts). By default this is set to 4.
+ *
  *                  ##### ECS_WORKER_THREAD_MAX
  *                  This can be defined to the hard maximum worker thread limit. By default this is set to 128.
  *
@@ -220,10 +279,64 @@
  *                  If component destructors don't reference any other component data than the component being destroyed, then @b ECS_UNSAFE_COMPONENT_DESTRUCTION can be defined as 1 to enable
  *                  the unsafe destruction pathway. The benefit of this is it will avoid a copy of the component data.
  *
+ *                  ##### ECS_INDEXED_SPARSE_SET
+ *                  If iteration of indexed components is needed, then @b ECS_INDEXED_SPARSE_SET can be defined as 1 to store indexed components as a sparse set. Each entity
+ *                  maps to an index into a dense array of the components, with a parallel array of the entities (@b ECSIndexedGetEntities). Lookups stay O(1), while
+ *                  iteration (and parallel chunking) only covers the components that are present. Note that the indexed component array a system receives is then the
+ *                  dense array, so it must not be indexed by the entity.
+ *
+ *                  ##### ECS_ENTITY_32
+ *                  If a context will never exceed 2^31 entities, then @b ECS_ENTITY_32 can be defined as 1 (or baked into ECSConfig.h by running gen_ecs_config.sh with
+ *                  ECS_ENTITY_32=1) to make @b ECSEntity, @b ECSProxyEntity and @b ECSEntityIndex 32-bit. This narrows the entity arrays of archetypes, packed and
+ *                  indexed components, links, the available entity list, and each entity's archetype row index.
+ *
+ *                  ##### ECS_PACKED_COMPONENT_INDEX_64
+ *                  An entity's index into each packed component is stored as 32 bits, which limits a packed component to fewer than UINT32_MAX entries. If more
+ *                  are needed then @b ECS_PACKED_COMPONENT_INDEX_64 can be defined as 1 to store them as @b size_t.
+ *
+ *                  ##### ECS_DUPLICATE_INLINE_CAPACITY
+ *                  By default the elements of a duplicate component are stored in an array. If most entities only have a few duplicates, then
+ *                  @b ECS_DUPLICATE_INLINE_CAPACITY can be defined to the number of elements to store inline in the component itself, so these avoid
+ *                  a separate allocation and an indirection. Any elements beyond that spill into an array which uses the duplicate array chunk sizes.
+ *                  The elements should then only be accessed through the @b ECSDuplicateComponent functions.
+ *
  *                  ##### ECS_ACCESS_RELEASE_INDEX_PAD_TO_CACHE_LINE
  *                  If the cost of false sharing access release indexes by workers is greater than the benefit of the @b ECSTick thread iterating the packed indexes, then @b ECS_ACCESS_RELEASE_INDEX_PAD_TO_CACHE_LINE
  *                  can be defined as 1 to enable a single index per cache line.
  *
+ *                  ##### ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE
+ *                  The chunk size an adaptive parallel system will use before any measurements of its cost have been made. By default this is set to 64.
+ *
+ *                  ##### ECS_TICK_BUDGET_DEFERRAL_MAX
+ *                  The number of consecutive ticks a group can be deferred due to @b ECSTickBudget, before it will be run regardless of the budget.
+ *                  By default this is set to 4.
+ *
+ *                  ##### ECS_SNAPSHOT_BUFFER_SIZE
+ *                  The size in bytes of the buffer components are copied into, in order to be converted by their @b ECSSnapshotComponentHooks when
+ *                  writing a snapshot. By default this is set to 64KB.
+ *
+ *                  ##### ECS_ARCHETYPE_EDGE_CACHE_MAX
+ *                  Archetype transitions (adding or removing a single archetype component) are cached in a direct mapped table of
+ *                  @b ECS_ARCHETYPE_EDGE_CACHE_MAX entries (a power of 2, by default 256) in each context. A collision only replaces
+ *                  the older edge. The cache can be inspected using @b ECSArchetypeGetEdges.
+ *
+ *                  ##### ECS_ARCHETYPE_DISJOINT_ACCESS
+ *                  By default access to a component is tracked for the component as a whole. If @b ECS_ARCHETYPE_DISJOINT_ACCESS is defined as 1, then access to
+ *                  archetype components will instead be tracked per (component, archetype) pair, so systems that access the same archetype component in disjoint
+ *                  archetypes may run concurrently. This requires systems to only access archetype components through the archetypes they were given. The pairs
+ *                  are hashed into @b ECS_ARCHETYPE_ACCESS_SLOT_MAX (a power of 2, by default 1024) slots, where collisions will only serialise the systems.
+ *
+ *                  ##### ECS_CHANGE_VERSION
+ *                  If consumers only need to process what has changed (such as replication or monitoring), then @b ECS_CHANGE_VERSION can be defined as 1 to
+ *                  version writes. Each system run (and each structural change) takes a new version from the context. When a system finishes with an archetype,
+ *                  every chunk of its range is stamped with that version in the columns it has write access to, and packed and indexed components it writes are
+ *                  stamped as a whole. Changed ranges can then be found using @b ECSArchetypeNextChangedRange or iterated using @b ECSQueryIterateChanged.
+ *                  Local components are not versioned.
+ *
+ *                  ##### ECS_STATISTICS
+ *                  If scheduler statistics are needed then @b ECS_STATISTICS can be defined as 1. This will record per system and per worker timings during
+ *                  each @b ECSTick, which can be retrieved using @b ECSTickGetStatistics and the @b statistics field of the @b ECSExecutionGroup.
+ *
  *                  ##### Array Chunk Sizes
  *                  The chunk size of the internal arrays can be overriden by defining the following:
  *                      - `ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(index, count)` : @b index is the archetype index, and @b count is the number of components in the archetype
@@ -300,6 +413,43 @@ typedef struct {
     size_t count;
 } ECSRange;
 
+/*!
+ * @brief An entity that was moved to a new entity ID by @b ECSEntityCompact.
+ */
+typedef struct {
+    ECSEntity from;
+    ECSEntity to;
+} ECSEntityRemap;
+
+/*!
+ * @brief A callback to convert components for a snapshot.
+ * @param Context The context the components belong to.
+ * @param Components The components to be converted in place.
+ * @param Count The number of components.
+ * @param ID The component ID.
+ */
+typedef void (*ECSSnapshotComponentCallback)(ECSContext *Context, void *Components, size_t Count, ECSComponentID ID);
+
+/*!
+ * @brief The hooks used to store a component in a snapshot.
+ * @description @b serialize is called on a copy of the components when writing a snapshot, and should replace anything that cannot be
+ *              stored (such as pointers) with a storable form of the same size. @b fixup is called on the restored components, and
+ *              should convert them back.
+ */
+typedef struct {
+    ECSSnapshotComponentCallback serialize;
+    ECSSnapshotComponentCallback fixup;
+} ECSSnapshotComponentHooks;
+
+/*!
+ * @brief A callback to write the data of a snapshot.
+ * @param Data The data to be written.
+ * @param Size The size of the data.
+ * @param UserData The user data passed to @b ECSSnapshotWrite.
+ * @return Return TRUE if the data was written, otherwise FALSE to stop writing the snapshot.
+ */
+typedef _Bool (*ECSSnapshotWriter)(const void *Data, size_t Size, void *UserData);
+
 /*!
  * @brief A callback for a system update.
  * @description For serial execution this callback will be once or more on the same thread if any of the requested components are in an archetype, or
@@ -321,18 +471,38 @@ typedef struct {
     ECSSystemUpdateCallback callback;
     size_t offset;
     size_t size;
+    _Bool main;
 } ECSSystemUpdate;
 
+/*!
+ * @brief The chunk size to use for a parallel system whose chunk size should adapt to its cost.
+ * @description The chunk size will be chosen so each executor of the system takes between @b ECSSystemChunkTargetTimeMin and
+ *              @b ECSSystemChunkTargetTimeMax. This requires the @b chunks field of the system's @b ECSExecutionGroup to be set,
+ *              otherwise the chunk size will remain at @b ECS_SYSTEM_CHUNK_ADAPTIVE_INITIAL_SIZE.
+ */
+#define ECS_SYSTEM_CHUNK_ADAPTIVE 0
+
+/*!
+ * @brief The chunk size to use for a parallel archetype system that should be split along the chunks of each archetype.
+ * @description Each executor will receive the range of a single archetype chunk (the archetype's @b chunk field, which is the array chunk
+ *              size from @b ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE), so no two executors will ever touch the same chunk.
+ */
+#define ECS_SYSTEM_CHUNK_ARCHETYPE (SIZE_MAX - 1)
+
 #define ECS_SYSTEM_UPDATE(update) (ECSSystemUpdate){ .callback = (update), .offset = 0, .size = 0 }
+#define ECS_SYSTEM_UPDATE_MAIN(update) (ECSSystemUpdate){ .callback = (update), .offset = 0, .size = 0, .main = TRUE }
 #define ECS_SYSTEM_UPDATE_PARALLEL(update) ECS_SYSTEM_UPDATE_PARALLEL_ARCHETYPE_CHUNK(update, SIZE_MAX)
 #define ECS_SYSTEM_UPDATE_PARALLEL_CHUNK(update, arrayOffset, chunkSize) (ECSSystemUpdate){ .callback = (update), .offset = (arrayOffset), .size = (chunkSize) }
 #define ECS_SYSTEM_UPDATE_PARALLEL_ARCHETYPE_CHUNK(update, chunkSize) ECS_SYSTEM_UPDATE_PARALLEL_CHUNK(update, 1, chunkSize)
+#define ECS_SYSTEM_UPDATE_PARALLEL_ARCHETYPE_STORAGE(update) ECS_SYSTEM_UPDATE_PARALLEL_ARCHETYPE_CHUNK(update, ECS_SYSTEM_CHUNK_ARCHETYPE)
 
 #define ECS_SYSTEM_UPDATE_GET_UPDATE(update) (update).callback
 #define ECS_SYSTEM_UPDATE_GET_PARALLEL(update) (_Bool)(update).offset
 #define ECS_SYSTEM_UPDATE_GET_PARALLEL_ARCHETYPE(update) (ECS_SYSTEM_UPDATE_GET_PARALLEL_OFFSET(update) == 1)
 #define ECS_SYSTEM_UPDATE_GET_PARALLEL_OFFSET(update) (update).offset
 #define ECS_SYSTEM_UPDATE_GET_PARALLEL_CHUNK_SIZE(update) (update).size
+#define ECS_SYSTEM_UPDATE_GET_PARALLEL_ADAPTIVE(update) ((update).size == ECS_SYSTEM_CHUNK_ADAPTIVE)
+#define ECS_SYSTEM_UPDATE_GET_MAIN(update) (update).main
 
 typedef struct {
     size_t index;
@@ -347,6 +517,7 @@ typedef struct {
 typedef struct {
     ECSTime freq;
     _Bool dynamic;
+    size_t priority;
     struct {
         size_t count;
         const ECSGroupDependency *deps;
@@ -359,24 +530,86 @@ typedef struct {
     } priorities;
 } ECSGroup;
 
+/*!
+ * @brief Worker thread ID;
+ */
+typedef uintptr_t ECSWorkerID;
+
+typedef struct {
+    size_t size;
+    ECSTime cost;
+    _Atomic(ECSTime) time;
+    _Atomic(size_t) count;
+} ECSSystemChunk;
+
+#if ECS_STATISTICS
+typedef struct {
+    _Atomic(ECSTime) time;
+    size_t executors;
+    ECSTime blocked;
+    _Atomic(ECSWorkerID) worker;
+    ECSTime blockedStart;
+} ECSSystemStatistics;
+
+typedef struct {
+    ECSTime busy;
+    ECSTime idle;
+} ECSWorkerStatistics;
+
+typedef struct {
+    ECSTime time;
+    size_t workerCount;
+    const ECSWorkerStatistics *workers;
+} ECSTickStatistics;
+#endif
+
+typedef struct ECSExecutionPlan ECSExecutionPlan;
+
+/*!
+ * @brief The execution state of a system group, see @b ECSTick for how the fields are used.
+ * @note The @b plan field is allocated by @b ECSTick the first time the group runs. Code that previously only needed to free the
+ *       @b state (and @b chunks) must now also destroy the plan with @b ECSExecutionPlanDestroy, otherwise it will be leaked.
+ */
 typedef struct {
     size_t executing;
     uint8_t *state;
     ECSTime time;
     size_t running;
+    ECSSystemChunk *chunks;
+    ECSExecutionPlan *plan;
+    ECSTime cost;
+    ECSTime start;
+    size_t deferrals;
+    _Bool deferred;
+#if ECS_STATISTICS
+    ECSSystemStatistics *statistics;
+#endif
 } ECSExecutionGroup;
 
-/*!
- * @brief Worker thread ID;
- */
-typedef uintptr_t ECSWorkerID;
-
 /*!
  * @brief A callback a waiting worker calls.
  * @param ID The unique ID (0..n) of the worker thread that called it. Or -1 when the tick calls it.
  */
 typedef void (*ECSWaitingCallback)(ECSWorkerID ID);
 
+/*!
+ * @brief A callback for a task.
+ * @param Data The data passed when the task was created.
+ * @param Range The sub-range the task should operate on.
+ */
+typedef void (*ECSTaskCallback)(void *Data, ECSRange Range);
+
+typedef struct {
+    _Atomic(size_t) pending;
+} ECSTaskGroup;
+
+#define ECS_TASK_GROUP_INIT (ECSTaskGroup){ .pending = ATOMIC_VAR_INIT(0) }
+
+typedef struct {
+    size_t park;
+    size_t wake;
+} ECSWorkerParkCounters;
+
 /*!
  * @brief The shared memory zone used for some allocations by the ECS.
  */
@@ -395,6 +628,43 @@ extern size_t ECSSharedMemorySize;
  */
 extern ECSWaitingCallback ECSWaiting;
 
+/*!
+ * @brief The number of consecutive times an idle worker will call @b ECSWaiting before it parks.
+ * @description Once a worker has exhausted its spin budget it will be parked until @b ECSTick submits work for it. Setting this to
+ *              @b SIZE_MAX will prevent workers from ever parking. By default it is set to 4096.
+ */
+extern size_t ECSWorkerSpinBudget;
+
+/*!
+ * @brief The number of idle workers that will keep spinning rather than park.
+ * @description Keeping some workers spinning avoids the wake latency for small amounts of work. By default it is set to 0.
+ */
+extern size_t ECSWorkerParkThreshold;
+
+/*!
+ * @brief The lower bound of the target execution time of an adaptive chunk.
+ * @description If an adaptive system's chunks are estimated to take less than this, a new chunk size will be chosen. By default
+ *              it is set to 20µs.
+ */
+extern ECSTime ECSSystemChunkTargetTimeMin;
+
+/*!
+ * @brief The upper bound of the target execution time of an adaptive chunk.
+ * @description If an adaptive system's chunks are estimated to take more than this, a new chunk size will be chosen. By default
+ *              it is set to 50µs.
+ */
+extern ECSTime ECSSystemChunkTargetTimeMax;
+
+/*!
+ * @brief The time budget of a tick.
+ * @description When set, @b ECSTick will estimate the duration of the tick from the previous cost of the groups that are due to run. Groups
+ *              are considered in order of their @b priority, and once the estimate exceeds the budget any remaining groups with a non-zero
+ *              @b priority are deferred until a later tick (their elapsed time carries over, up to @b ECS_TICK_BUDGET_DEFERRAL_MAX + 1 of
+ *              their frequency). Groups with a priority of 0 are never deferred, and a group that has been deferred @b ECS_TICK_BUDGET_DEFERRAL_MAX
+ *              ticks in a row will be run regardless of the budget. By default it is set to 0 (no budget).
+ */
+extern ECSTime ECSTickBudget;
+
 /*!
  * @brief Set the component IDs.
  * @warning This must be set prior to any calls to @b ECSEntityDestroy.
@@ -455,6 +725,12 @@ extern const size_t *ECSDuplicateIndexedComponentSizes;
  */
 extern const size_t *ECSDuplicateLocalComponentSizes;
 
+/*!
+ * @brief Set the shared archetype component value sizes.
+ * @warning This must be set prior to any calls to @b ECSSharedComponentIntern.
+ */
+extern const size_t *ECSSharedArchetypeComponentSizes;
+
 /*!
  * @brief Set the archetype component destructors.
  * @warning This must be set prior to any calls to @b ECSEntityDestroy or component removal.
@@ -503,12 +779,59 @@ extern const ECSComponentDestructor *ECSDuplicateIndexedComponentDestructors;
  */
 extern const ECSComponentDestructor *ECSDuplicateLocalComponentDestructors;
 
+/*!
+ * @brief Set the shared archetype component value destructors.
+ * @description This is optional, and may be NULL or contain NULL entries for values that don't need to be destroyed.
+ * @warning This must be set prior to any calls to @b ECSEntityDestroy or component removal.
+ */
+extern const ECSComponentDestructor *ECSSharedArchetypeComponentDestructors;
+
+/*!
+ * @brief Set the archetype component snapshot hooks.
+ * @description This is optional, and may be NULL or contain NULL entries for components that can be stored as they are.
+ * @warning This must be set prior to any calls to @b ECSSnapshotWrite or @b ECSSnapshotRestore.
+ */
+extern const ECSSnapshotComponentHooks *ECSArchetypeComponentSnapshotHooks;
+
+/*!
+ * @brief Set the packed component snapshot hooks.
+ * @description This is optional, and may be NULL or contain NULL entries for components that can be stored as they are.
+ * @warning This must be set prior to any calls to @b ECSSnapshotWrite or @b ECSSnapshotRestore.
+ */
+extern const ECSSnapshotComponentHooks *ECSPackedComponentSnapshotHooks;
+
+/*!
+ * @brief Set the indexed component snapshot hooks.
+ * @description This is optional, and may be NULL or contain NULL entries for components that can be stored as they are.
+ * @warning This must be set prior to any calls to @b ECSSnapshotWrite or @b ECSSnapshotRestore.
+ */
+extern const ECSSnapshotComponentHooks *ECSIndexedComponentSnapshotHooks;
+
+/*!
+ * @brief Set the local component snapshot hooks.
+ * @description This is optional, and may be NULL or contain NULL entries for components that can be stored as they are.
+ * @warning This must be set prior to any calls to @b ECSSnapshotWrite or @b ECSSnapshotRestore.
+ */
+extern const ECSSnapshotComponentHooks *ECSLocalComponentSnapshotHooks;
+
+/*!
+ * @brief Set the links that can be stored in a snapshot.
+ * @description Links are stored by their index, so the same links must be in the same order when restoring the snapshot.
+ * @warning This must be set prior to any calls to @b ECSSnapshotWrite or @b ECSSnapshotRestore.
+ */
+extern const ECSLink * const *ECSSnapshotLinks;
+
+/*!
+ * @brief Set the number of @b ECSSnapshotLinks.
+ */
+extern size_t ECSSnapshotLinkCount;
+
 /*!
  * @brief Create an ECS worker thread.
  * @description Can create up to @b ECS_WORKER_THREAD_MAX worker threads. The default is 128, if this limit needs to be changed @b ECS_WORKER_THREAD_MAX
  *              should be set to the new limit when compiling.
  *
- * @warning This should only be called from the same thread @b ECSTick is called from.
+ * @warning This should not be called while any @b ECSTick is running.
  * @return Returns TRUE if a worker thread was successfully created, otherwise returns FALSE if it was not.
  */
 _Bool ECSWorkerCreate(void);
@@ -518,18 +841,108 @@ _Bool ECSWorkerCreate(void);
  */
 void ECSInit(void);
 
+/*!
+ * @brief Get the worker park/wake counters.
+ * @description The counters are cumulative for the lifetime of the ECS. The @b park field is the number of times a worker has parked,
+ *              and the @b wake field is the number of times a parked worker was woken by @b ECSTick.
+ *
+ * @return Returns the park/wake counters.
+ */
+ECSWorkerParkCounters ECSWorkerGetParkCounters(void);
+
 /*!
  * @brief Update the ECS.
+ * @description Separate contexts may be ticked concurrently from different threads, sharing the same worker threads. Up to @b ECS_TICK_CONCURRENT_MAX
+ *              ticks may run at the same time, any further ticks will wait until one has finished. A context and its group state must only be used
+ *              by one tick at a time.
+ *
  * @param Context The context to be used for the update tick.
  * @param Groups The system groups to be used for the update tick.
  * @param GroupCount The number of system groups.
  * @param State The array of execution state (size of @b GroupCount) to be used by the ECS. The @b state field should be at least as big as the maximum number
- *              of systems in the largest priority of any group.
+ *              of systems in the largest priority of any group. The optional @b chunks field should either be NULL or be as big as the number of systems
+ *              in the group (zero initialised), it is required for systems using @b ECS_SYSTEM_CHUNK_ADAPTIVE to adapt their chunk sizes.
+ *
+ *              The @b plan field should initially be NULL, the tick will compile the group's execution plan into it the first time the group is
+ *              used. The plan should be destroyed with @b ECSExecutionPlanDestroy when the state is no longer needed, or reset if the group changes.
+ *
+ *              When @b ECSTickBudget is set the @b cost field will contain the estimated time it takes the group to complete, measured from when
+ *              the group starts executing, and decayed each time it's deferred. The @b deferred field will be set to TRUE if the group was due
+ *              to run but was deferred due to the budget, and the @b deferrals field counts the consecutive ticks it has been deferred. The
+ *              @b start field is used internally.
+ *
+ *              When compiled with @b ECS_STATISTICS the optional @b statistics field should either be NULL or be as big as the number of systems
+ *              in the group. After the tick it will contain each system's summed execution time, number of executors, time spent blocked on
+ *              component access, and the last worker to have executed it (systems that did not run will have no executors). Main thread
+ *              systems will have a worker of -1.
  *
  * @param DeltaTime The delta time of the tick.
  */
 void ECSTick(ECSContext *Context, const ECSGroup *Groups, size_t GroupCount, ECSExecutionGroup *State, ECSTime DeltaTime);
 
+#if ECS_STATISTICS
+/*!
+ * @brief Get the statistics of the last tick.
+ * @description The @b time field is the duration of the tick, and @b workers contains the busy and idle time of each worker during
+ *              the tick. The per system statistics are stored in the @b statistics field of the @b ECSExecutionGroup.
+ *
+ * @warning The workers array is only valid until the next call to @b ECSTick.
+ * @return Returns the statistics of the last tick.
+ */
+ECSTickStatistics ECSTickGetStatistics(void);
+#endif
+
+/*!
+ * @brief Run a task as part of a task group.
+ * @description When called from a worker thread (such as inside a system) the task will be pushed to the worker's task deque, otherwise
+ *              it is pushed to the shared injection deque. In either case it may be executed by any worker. If the deque is full (or there
+ *              are no workers) the task is executed immediately.
+ *
+ * @param Group The task group the task belongs to. Should be initialised with @b ECS_TASK_GROUP_INIT.
+ * @param Callback The callback for the task.
+ * @param Data The data to pass to the callback.
+ * @param Range The range to pass to the callback.
+ */
+void ECSTaskGroupRun(ECSTaskGroup *Group, ECSTaskCallback Callback, void *Data, ECSRange Range);
+
+/*!
+ * @brief Wait for all tasks in a task group to finish.
+ * @description The waiting thread will help execute tasks while it waits, so waiting from inside a system or another task will not
+ *              deadlock.
+ *
+ * @param Group The task group to wait on.
+ */
+void ECSTaskGroupWait(ECSTaskGroup *Group);
+
+/*!
+ * @brief Execute a parallel-for across the worker threads.
+ * @description Splits the range 0..Count into chunks that are executed as tasks, the calling thread will execute the first chunk and then
+ *              help execute the remaining tasks until they have all finished. This may be called from any thread, when not called from a
+ *              worker thread the tasks are handed to the workers through the injection deque.
+ *
+ * @param Callback The callback to execute for each chunk.
+ * @param Data The data to pass to the callback.
+ * @param Count The number of elements.
+ * @param ChunkSize The maximum number of elements per chunk. Must not be 0.
+ */
+void ECSParallelFor(ECSTaskCallback Callback, void *Data, size_t Count, size_t ChunkSize);
+
+/*!
+ * @brief Destroy a compiled execution plan.
+ * @param Plan The plan to be destroyed. Must not be null.
+ */
+void ECSExecutionPlanDestroy(ECSExecutionPlan *Plan);
+
+/*!
+ * @brief Get the chunk size of a system.
+ * @param Group The group the system belongs to.
+ * @param State The execution state of the group.
+ * @param SystemIndex The index of the system in the group (across all priorities).
+ * @return Returns the chunk size the system is currently using. This will be @b SIZE_MAX if the system is not chunked, or
+ *         @b ECS_SYSTEM_CHUNK_ADAPTIVE if an adaptive system has no chunk state.
+ */
+size_t ECSSystemGetChunkSize(const ECSGroup *Group, const ECSExecutionGroup *State, size_t SystemIndex);
+
 /*!
  * @brief Add an archetype component.
  * @note Should typically use @b ECSEntityAddComponent or @b ECSEntityAddComponents instead.
@@ -550,8 +963,182 @@ void ECSArchetypeAddComponent(ECSContext *Context, ECSEntity Entity, const void
  */
 void ECSArchetypeRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID);
 
+/*!
+ * @brief Add archetype components to many entities.
+ * @description The entities are grouped by their current archetype, and each group is migrated to its new archetype together. Contiguous
+ *              runs of entities are copied with a single copy per component column.
+ *
+ * @param Context The context to be used.
+ * @param Entities The entities to add the components to. An entity must not appear more than once.
+ * @param Count The number of entities.
+ * @param Components The components to be added. The ID of each must be a non-duplicate archetype component, and the data is either
+ *                   NULL (uninitialised) or an array of @b Count components (one for each entity). An entity that already has one of
+ *                   the components will have its component data replaced.
+ *
+ * @param ComponentCount The number of components.
+ */
+void ECSArchetypeAddComponents(ECSContext *Context, const ECSEntity *Entities, size_t Count, const ECSTypedComponent *Components, size_t ComponentCount);
+
+/*!
+ * @brief Remove archetype components from many entities.
+ * @description The entities are grouped by their current archetype, and each group is migrated to its new archetype together. Contiguous
+ *              runs of entities are copied with a single copy per component column.
+ *
+ * @note This function can be safely called on destroyed entity references.
+ * @param Context The context to be used.
+ * @param Entities The entities to remove the components from. An entity must not appear more than once.
+ * @param Count The number of entities.
+ * @param IDs The component IDs of the non-duplicate archetype components to be removed.
+ * @param IDCount The number of component IDs.
+ */
+void ECSArchetypeRemoveComponents(ECSContext *Context, const ECSEntity *Entities, size_t Count, const ECSComponentID *IDs, size_t IDCount);
+
+/*!
+ * @brief Get the archetype transition edge cache of a context.
+ * @description Adding or removing a single archetype component caches the destination archetype for the (archetype, component) pair, so
+ *              repeated transitions skip recomputing the archetype index and the destination's component IDs. This is intended for debugging
+ *              and inspecting the archetype graph.
+ * @param Context The context to get the edges of.
+ * @param Count A pointer to where the number of edges should be stored. This will always be @b ECS_ARCHETYPE_EDGE_CACHE_MAX.
+ * @return The edges. Edges with a @b dest of 0 are unused.
+ */
+const ECSArchetypeEdge *ECSArchetypeGetEdges(ECSContext *Context, size_t *Count);
+
+/*!
+ * @brief A callback for a query iteration.
+ * @param Context The context the query is operating on.
+ * @param Archetype The matching archetype to operate on.
+ * @param ArchetypeComponentIndexes The component indexes in the archetype for the query's with components followed by its optional
+ *        components, in the order they were given to @b ECSQueryCreate. Optional components that the archetype doesn't have are SIZE_MAX.
+ * @param Range The sub-range of entities/components to operate on.
+ * @param Data The data passed to the iterate function.
+ */
+typedef void (*ECSQueryCallback)(ECSContext *Context, ECSArchetype *Archetype, const size_t *ArchetypeComponentIndexes, ECSRange Range, void *Data);
+
+typedef struct {
+    ECSContext *context;
+    struct {
+        size_t count;
+        ECSArchetypeComponentID ids[ECS_ARCHETYPE_MAX];
+    } with, optional;
+    struct {
+        ECSArchetypeComponentMask with, without;
+    } mask;
+    CCArray(ptrdiff_t) archetypes;
+    CCArray(size_t) indexes;
+    size_t seen;
+} ECSQuery;
+
+/*!
+ * @brief Create a query over the archetypes of a context.
+ * @description A query matches the archetypes that have all of the @b With components and none of the @b Without components. The
+ *              matching archetypes are cached, and any archetypes created since the last iteration are matched incrementally.
+ *
+ * @param Context The context to query.
+ * @param With The archetype components the entities must have.
+ * @param WithCount The number of with components.
+ * @param Without The archetype components the entities must not have.
+ * @param WithoutCount The number of without components.
+ * @param Optional The archetype components whose indexes should also be provided if the archetype has them.
+ * @param OptionalCount The number of optional components.
+ * @return The query. This must be destroyed.
+ */
+CC_NEW ECSQuery ECSQueryCreate(ECSContext *Context, const ECSComponentID *With, size_t WithCount, const ECSComponentID *Without, size_t WithoutCount, const ECSComponentID *Optional, size_t OptionalCount);
+
+/*!
+ * @brief Destroy a query.
+ * @param Query The query to be destroyed.
+ */
+void ECSQueryDestroy(ECSQuery *CC_DESTROY(Query));
+
+/*!
+ * @brief Match any archetypes that have been created since the query was last updated.
+ * @note This is called by the iterate functions.
+ * @param Query The query to update.
+ */
+void ECSQueryUpdate(ECSQuery *Query);
+
+/*!
+ * @brief Iterate the entities matched by a query.
+ * @param Query The query to iterate.
+ * @param Callback The callback to call for each range of entities.
+ * @param Data The data to pass to the callback.
+ * @param ChunkSize The maximum number of entities per range. SIZE_MAX will use a single range per archetype, and
+ *        @b ECS_SYSTEM_CHUNK_ARCHETYPE will use the chunk size of each archetype.
+ */
+void ECSQueryIterate(ECSQuery *Query, ECSQueryCallback Callback, void *Data, size_t ChunkSize);
+
+/*!
+ * @brief Iterate the entities matched by a query in parallel.
+ * @description The ranges of each archetype are distributed using @b ECSParallelFor, so they will be executed across the workers whether
+ *              this is called from a worker (such as inside a system) or from another thread.
+ *
+ * @warning The callback must be threadsafe.
+ * @param Query The query to iterate.
+ * @param Callback The callback to call for each range of entities.
+ * @param Data The data to pass to the callback.
+ * @param ChunkSize The maximum number of entities per range. SIZE_MAX will use a single range per archetype, and
+ *        @b ECS_SYSTEM_CHUNK_ARCHETYPE will use the chunk size of each archetype.
+ */
+void ECSQueryIterateParallel(ECSQuery *Query, ECSQueryCallback Callback, void *Data, size_t ChunkSize);
+
+#if ECS_CHANGE_VERSION
+/*!
+ * @brief Iterate the entities matched by a query whose with components have changed.
+ * @description Only the archetype chunks where any of the query's with components have been changed after @b Since will be iterated.
+ * @param Query The query to iterate.
+ * @param Callback The callback to call for each range of entities.
+ * @param Data The data to pass to the callback.
+ * @param ChunkSize The maximum number of entities per range. SIZE_MAX will use a single range per run of changed chunks, and
+ *        @b ECS_SYSTEM_CHUNK_ARCHETYPE will use the chunk size of each archetype.
+ * @param Since The version the changes must be newer than.
+ */
+void ECSQueryIterateChanged(ECSQuery *Query, ECSQueryCallback Callback, void *Data, size_t ChunkSize, ECSChangeVersion Since);
+
+/*!
+ * @brief Get the current change version of a context.
+ * @description Read this before iterating any changes, and use it as the @b Since version of the next iteration.
+ * @param Context The context.
+ * @return The current change version.
+ */
+static inline ECSChangeVersion ECSContextGetChangeVersion(ECSContext *Context);
+
+/*!
+ * @brief Get the change version of an archetype component for the chunk containing an entity.
+ * @param Archetype The archetype.
+ * @param ArchetypeComponentIndex The index of the component in the archetype.
+ * @param Index The index of the entity in the archetype.
+ * @return The version the chunk's component was last changed.
+ */
+static inline ECSChangeVersion ECSArchetypeGetChangeVersion(const ECSArchetype *Archetype, size_t ArchetypeComponentIndex, size_t Index);
+
+/*!
+ * @brief Get the change version of a packed or indexed component.
+ * @description Packed and indexed components are versioned as a whole.
+ * @param Context The context.
+ * @param ID The packed or indexed component.
+ * @return The version the component was last changed.
+ */
+static inline ECSChangeVersion ECSComponentGetChangeVersion(ECSContext *Context, ECSComponentID ID);
+
+/*!
+ * @brief Get the next range of entities in an archetype whose components have changed.
+ * @description The range is made up of whole chunks (clamped to @b Range), where any of the components were changed after @b Since.
+ * @param Archetype The archetype.
+ * @param ArchetypeComponentIndexes The indexes of the components in the archetype to check.
+ * @param Count The number of components to check.
+ * @param Range The range of entities to search. This will be advanced past the returned range.
+ * @param Since The version the changes must be newer than.
+ * @return The changed range, or a range with a count of 0 if there are no more changes.
+ */
+ECSRange ECSArchetypeNextChangedRange(const ECSArchetype *Archetype, const size_t *ArchetypeComponentIndexes, size_t Count, ECSRange *Range, ECSChangeVersion Since);
+#endif
+
 /*!
  * @brief Get the archetype index of an archetype component.
+ * @description This searches the entity's component IDs, so it may be used while they are being changed. Otherwise the index can be
+ *              looked up in the entity's archetype using @b ECSArchetypeComponentMaskIndex.
+ *
  * @param ID The component ID of the archetype component to get the index of.
  * @return Returns the index of the archetype component.
  */
@@ -597,6 +1184,17 @@ void ECSIndexedAddComponent(ECSContext *Context, ECSEntity Entity, const void *D
  */
 void ECSIndexedRemoveComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID);
 
+#if ECS_INDEXED_SPARSE_SET
+/*!
+ * @brief Get the entities of an indexed component.
+ * @description The entities are in the same order as the dense component array (@b ECSContext.indexed).
+ * @param Context The context to get the entities from.
+ * @param ID The component ID of an indexed component.
+ * @return The entities that have the indexed component, or NULL if there are none.
+ */
+static inline CCArray(ECSEntity) ECSIndexedGetEntities(ECSContext *Context, ECSComponentID ID);
+#endif
+
 /*!
  * @brief Add a local component.
  * @note Should typically use @b ECSEntityAddComponent or @b ECSEntityAddComponents instead.
@@ -648,6 +1246,67 @@ void ECSEntityCreate(ECSContext *Context, ECSEntity *Entities, size_t Count);
  */
 void ECSEntityDestroy(ECSContext *Context, const ECSEntity *Entities, size_t Count);
 
+/*!
+ * @brief Destroy many entities at once.
+ * @description The entities are grouped by archetype, so each archetype is compacted in a single pass and its component destructors
+ *              are run column by column. Their remaining components are then removed, and the entities are deregistered and made
+ *              available together.
+ *
+ *              Unlike @b ECSEntityDestroy, which fully destroys one entity before moving on to the next, the callbacks are run in phases.
+ *              The links of every entity are removed first. Then the archetype component destructors are run grouped by archetype and
+ *              component, rather than in the order the entities were given. Then the remaining components of each entity are removed (in
+ *              entity order), and finally the entities are deregistered. So a destructor may observe other entities in the batch that have
+ *              already lost their links, or that still have their components.
+ *
+ * @note This function can be safely called on destroyed entity references.
+ * @param Context The context to be used.
+ * @param Entities A pointer to the entities to be destroyed.
+ * @param Count The number of entities to destroy.
+ */
+void ECSEntityDestroyBatch(ECSContext *Context, const ECSEntity *Entities, size_t Count);
+
+/*!
+ * @brief Compact the live entities into the lowest entity IDs.
+ * @description The highest live entities are moved into the lowest free entity IDs, updating the archetypes, packed and indexed components,
+ *              links, and registry to reference their new IDs. The entity map and the arrays indexed by entity are then shrunk to the
+ *              remaining entities, and the free entities are ordered so that new entities are created with the lowest IDs first.
+ *
+ *              As this may be costly, it can be performed incrementally by limiting how many entities are moved per call.
+ *
+ * @warning This must not be called while the context is being ticked or has pending mutations, and any entities held by the application
+ *          (or monitors) must be updated using @b Remap.
+ *
+ * @param Context The context to be used.
+ * @param Max The maximum number of entities to move. Use SIZE_MAX to fully compact the context.
+ * @param Remap An optional array of @b ECSEntityRemap to append each moved entity to.
+ * @return The number of entities that were moved. If this is less than @b Max then the context is fully compacted.
+ */
+size_t ECSEntityCompact(ECSContext *Context, size_t Max, CCArray(ECSEntityRemap) Remap);
+
+/*!
+ * @brief Write a snapshot of a context.
+ * @warning This must not be called while the context is being ticked or has pending mutations.
+ * @param Context The context to be written.
+ * @param Writer The callback to write the snapshot data to.
+ * @param UserData The user data to pass to @b Writer.
+ * @return Returns TRUE if the snapshot was written, or FALSE if @b Writer failed.
+ */
+_Bool ECSSnapshotWrite(ECSContext *Context, ECSSnapshotWriter Writer, void *UserData);
+
+/*!
+ * @brief Restore a snapshot into a context.
+ * @description The context must have been initialised but not contain any entities. The snapshot data is copied, so it does not need
+ *              to be kept around after restoring.
+ *
+ * @warning If the snapshot could not be restored, the context may be partially restored.
+ * @param Context The context to restore the snapshot into.
+ * @param Data The snapshot data.
+ * @param Size The size of the snapshot data.
+ * @return Returns TRUE if the snapshot was restored, or FALSE if the snapshot is truncated, inconsistent, or was written with a different
+ *         ECS configuration or component layout.
+ */
+_Bool ECSSnapshotRestore(ECSContext *Context, const void *Data, size_t Size);
+
 /*!
  * @brief Add a component to an entity.
  * @param Context The context to be used.
@@ -769,6 +1428,72 @@ static inline size_t ECSComponentSize(ECSComponentID ID);
  */
 static inline size_t ECSDuplicateComponentSize(ECSComponentID ID);
 
+/*!
+ * @brief Get the duplicate component chunk size.
+ * @param ID The component ID to get the duplicate chunk size for.
+ * @return Returns the chunk size of the duplicate component's array (or spill array).
+ */
+static inline size_t ECSDuplicateComponentChunkSize(ECSComponentID ID);
+
+/*!
+ * @brief Initialise the storage of a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ * @param Size The size of an element.
+ * @param ChunkSize The chunk size of the array (or spill array).
+ */
+static inline void ECSDuplicateComponentInit(ECSDuplicateComponent *Duplicates, size_t Size, size_t ChunkSize);
+
+/*!
+ * @brief Destroy the storage of a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ */
+static inline void ECSDuplicateComponentDestroy(ECSDuplicateComponent *Duplicates);
+
+/*!
+ * @brief Get the number of elements in a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ * @return The number of elements.
+ */
+static inline size_t ECSDuplicateComponentGetCount(const ECSDuplicateComponent *Duplicates);
+
+/*!
+ * @brief Get an element of a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ * @param Size The size of an element.
+ * @param Index The index of the element.
+ * @return The element.
+ */
+static inline void *ECSDuplicateComponentGetElementAtIndex(const ECSDuplicateComponent *Duplicates, size_t Size, size_t Index);
+
+/*!
+ * @brief Append elements to a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ * @param Size The size of an element.
+ * @param ChunkSize The chunk size of the spill array.
+ * @param Data The elements to append, or NULL if they should be left uninitialised.
+ * @param Count The number of elements to append.
+ */
+static inline void ECSDuplicateComponentAppendElements(ECSDuplicateComponent *Duplicates, size_t Size, size_t ChunkSize, const void *Data, size_t Count);
+
+/*!
+ * @brief Copy elements within a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ * @param Size The size of an element.
+ * @param FromIndex The index of the first element to copy.
+ * @param ToIndex The index to copy the elements to.
+ * @param Count The number of elements to copy.
+ */
+static inline void ECSDuplicateComponentCopyElementsAtIndex(ECSDuplicateComponent *Duplicates, size_t Size, size_t FromIndex, size_t ToIndex, size_t Count);
+
+/*!
+ * @brief Remove elements from a duplicate component.
+ * @param Duplicates The duplicate component storage.
+ * @param Size The size of an element.
+ * @param Index The index of the first element to remove.
+ * @param Count The number of elements to remove.
+ */
+static inline void ECSDuplicateComponentRemoveElementsAtIndex(ECSDuplicateComponent *Duplicates, size_t Size, size_t Index, size_t Count);
+
 /*!
  * @brief Store some data in the shared memory zone.
  * @note This should only be called from the same thread that is also executing other ECS functions. And will automatically be deallocated by the ECS if the data
@@ -787,6 +1512,68 @@ static inline void *ECSSharedZoneStore(const void *Data, size_t Size);
  */
 void ECSDuplicateDestructor(void *Data, ECSComponentID ID);
 
+/*!
+ * @brief The destructor for shared components.
+ * @description Releases the handle of the shared component.
+ * @param Data The data for the shared component.
+ * @param ID The ID of the shared component.
+ */
+void ECSSharedDestructor(void *Data, ECSComponentID ID);
+
+/*!
+ * @brief Intern a shared component value.
+ * @warning This must not be called from a worker thread (such as inside a system), the interned values are not threadsafe.
+ * @param Context The context to intern the value in.
+ * @param Data The value of the component. This is compared bytewise against the existing values.
+ * @param ID The ID of the shared archetype component.
+ * @return A retained handle to the interned value. This reference is owned by the caller, and is passed to the entity when the
+ *         handle is added as the component's data.
+ */
+ECSSharedComponentHandle ECSSharedComponentIntern(ECSContext *Context, const void *Data, ECSComponentID ID);
+
+/*!
+ * @brief Retain a shared component value.
+ * @warning Reference counts are not atomic, so this must not be called from a worker thread.
+ * @param Handle The handle to the shared value.
+ * @return The handle.
+ */
+ECSSharedComponentHandle ECSSharedComponentRetain(ECSSharedComponentHandle Handle);
+
+/*!
+ * @brief Release a shared component value.
+ * @description Once the last reference has been released the value will be destroyed.
+ * @warning This must not be called from a worker thread, as releasing the last reference removes the value from its context.
+ * @param Handle The handle to the shared value.
+ */
+void ECSSharedComponentRelease(ECSSharedComponentHandle Handle);
+
+/*!
+ * @brief Get the value of a shared component.
+ * @param Handle The handle to the shared value.
+ * @return The shared value.
+ */
+static inline void *ECSSharedComponentGetData(ECSSharedComponentHandle Handle);
+
+/*!
+ * @brief Group the entities of every archetype with a shared component by their shared value.
+ * @description Entities referencing the same value will be contiguous in the archetype after this call. Entities that
+ *              are added to the archetype afterwards will not be grouped until this is called again.
+ *
+ * @warning This must not be called from a worker thread, or while any systems may be accessing the archetypes.
+ * @param Context The context.
+ * @param ID The ID of the shared archetype component.
+ */
+void ECSSharedComponentGroup(ECSContext *Context, ECSComponentID ID);
+
+/*!
+ * @brief Get the next range of entities in an archetype that share the same value.
+ * @param Archetype The archetype.
+ * @param ArchetypeComponentIndex The index of the shared component in the archetype.
+ * @param Range The range of entities to search. This will be advanced past the returned range.
+ * @return The range of entities that share the value, or a range with a count of 0 if there are no more entities.
+ */
+ECSRange ECSArchetypeNextSharedRange(const ECSArchetype *Archetype, size_t ArchetypeComponentIndex, ECSRange *Range);
+
 #ifndef ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE
 #define ECS_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(index, count) 16
 #endif
@@ -883,6 +1670,170 @@ static inline size_t ECSDuplicateComponentSize(ECSComponentID ID)
     return SIZE_MAX;
 }
 
+static inline size_t ECSDuplicateComponentChunkSize(ECSComponentID ID)
+{
+    switch (ID & ECSComponentStorageTypeMask)
+    {
+        case ECSComponentStorageTypeArchetype:
+            return ECS_DUPLICATE_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(ID & ~ECSComponentStorageMask);
+            
+        case ECSComponentStorageTypePacked:
+            return ECS_DUPLICATE_PACKED_COMPONENT_ARRAY_CHUNK_SIZE(ID & ~ECSComponentStorageMask);
+            
+        case ECSComponentStorageTypeIndexed:
+            return ECS_DUPLICATE_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(ID & ~ECSComponentStorageMask);
+            
+        case ECSComponentStorageTypeLocal:
+            return ECS_DUPLICATE_LOCAL_COMPONENT_ARRAY_CHUNK_SIZE(ECSLocalComponentIndex(ID));
+    }
+    
+    CCAssertLog(0, "Unsupported component type");
+    
+    return SIZE_MAX;
+}
+
+#if ECS_DUPLICATE_INLINE_CAPACITY
+static inline void ECSDuplicateComponentInit(ECSDuplicateComponent *Duplicates, size_t Size, size_t ChunkSize)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    Duplicates->count = 0;
+    Duplicates->spill = NULL;
+}
+
+static inline void ECSDuplicateComponentDestroy(ECSDuplicateComponent *Duplicates)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    if (Duplicates->spill) CCArrayDestroy(Duplicates->spill);
+    
+    Duplicates->count = 0;
+    Duplicates->spill = NULL;
+}
+
+static inline size_t ECSDuplicateComponentGetCount(const ECSDuplicateComponent *Duplicates)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    return Duplicates->count;
+}
+
+static inline void *ECSDuplicateComponentGetElementAtIndex(const ECSDuplicateComponent *Duplicates, size_t Size, size_t Index)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    CCAssertLog(Index < Duplicates->count, "Index must not be out of bounds");
+    
+    if (Index < ECS_DUPLICATE_INLINE_CAPACITY) return (void*)Duplicates->elements + (Size * Index);
+    
+    return CCArrayGetElementAtIndex(Duplicates->spill, Index - ECS_DUPLICATE_INLINE_CAPACITY);
+}
+
+static inline void ECSDuplicateComponentAppendElements(ECSDuplicateComponent *Duplicates, size_t Size, size_t ChunkSize, const void *Data, size_t Count)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    if (Duplicates->count < ECS_DUPLICATE_INLINE_CAPACITY)
+    {
+        const size_t InlineCount = CCMin(ECS_DUPLICATE_INLINE_CAPACITY - Duplicates->count, Count);
+        
+        if (Data)
+        {
+            memcpy(Duplicates->elements + (Size * Duplicates->count), Data, Size * InlineCount);
+            Data += Size * InlineCount;
+        }
+        
+        Duplicates->count += InlineCount;
+        Count -= InlineCount;
+    }
+    
+    if (Count)
+    {
+        if (!Duplicates->spill) Duplicates->spill = CCArrayCreate(CC_STD_ALLOCATOR, Size, ChunkSize);
+        
+        CCArrayAppendElements(Duplicates->spill, Data, Count);
+        Duplicates->count += Count;
+    }
+}
+
+static inline void ECSDuplicateComponentCopyElementsAtIndex(ECSDuplicateComponent *Duplicates, size_t Size, size_t FromIndex, size_t ToIndex, size_t Count)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        memmove(ECSDuplicateComponentGetElementAtIndex(Duplicates, Size, ToIndex + Loop), ECSDuplicateComponentGetElementAtIndex(Duplicates, Size, FromIndex + Loop), Size);
+    }
+}
+
+static inline void ECSDuplicateComponentRemoveElementsAtIndex(ECSDuplicateComponent *Duplicates, size_t Size, size_t Index, size_t Count)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    CCAssertLog((Index + Count) <= Duplicates->count, "Elements must not be out of bounds");
+    
+    const size_t Remaining = Duplicates->count - Count;
+    
+    ECSDuplicateComponentCopyElementsAtIndex(Duplicates, Size, Index + Count, Index, Remaining - Index);
+    
+    if (Duplicates->count > ECS_DUPLICATE_INLINE_CAPACITY)
+    {
+        const size_t SpillIndex = CCMax(Remaining, ECS_DUPLICATE_INLINE_CAPACITY) - ECS_DUPLICATE_INLINE_CAPACITY;
+        
+        CCArrayRemoveElementsAtIndex(Duplicates->spill, SpillIndex, CCArrayGetCount(Duplicates->spill) - SpillIndex);
+    }
+    
+    Duplicates->count = Remaining;
+}
+#else
+static inline void ECSDuplicateComponentInit(ECSDuplicateComponent *Duplicates, size_t Size, size_t ChunkSize)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    *Duplicates = CCArrayCreate(CC_STD_ALLOCATOR, Size, ChunkSize);
+}
+
+static inline void ECSDuplicateComponentDestroy(ECSDuplicateComponent *Duplicates)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    CCArrayDestroy(*Duplicates);
+}
+
+static inline size_t ECSDuplicateComponentGetCount(const ECSDuplicateComponent *Duplicates)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    return CCArrayGetCount(*Duplicates);
+}
+
+static inline void *ECSDuplicateComponentGetElementAtIndex(const ECSDuplicateComponent *Duplicates, size_t Size, size_t Index)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    return CCArrayGetElementAtIndex(*Duplicates, Index);
+}
+
+static inline void ECSDuplicateComponentAppendElements(ECSDuplicateComponent *Duplicates, size_t Size, size_t ChunkSize, const void *Data, size_t Count)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    CCArrayAppendElements(*Duplicates, Data, Count);
+}
+
+static inline void ECSDuplicateComponentCopyElementsAtIndex(ECSDuplicateComponent *Duplicates, size_t Size, size_t FromIndex, size_t ToIndex, size_t Count)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    CCArrayCopyElementsAtIndex(*Duplicates, FromIndex, ToIndex, Count);
+}
+
+static inline void ECSDuplicateComponentRemoveElementsAtIndex(ECSDuplicateComponent *Duplicates, size_t Size, size_t Index, size_t Count)
+{
+    CCAssertLog(Duplicates, "Duplicates must not be null");
+    
+    CCArrayRemoveElementsAtIndex(*Duplicates, Index, Count);
+}
+#endif
+
 static inline void *ECSSharedZoneStore(const void *Data, size_t Size)
 {
     CCAssertLog(Data, "Data must not be null");
@@ -982,47 +1933,55 @@ static inline _Bool ECSEntityIsAlive(ECSContext *Context, ECSEntity Entity)
 {
     CCAssertLog(Context, "Context must not be null");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
     
-    return !CCBitsGet(Refs->has, ECSHasBitEntityDestroyed);
+    return !CCBitsGet(Lookup->has, ECSHasBitEntityDestroyed);
 }
 
 static inline _Bool ECSEntityHasComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
 {
     CCAssertLog(Context, "Context must not be null");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
     
-    return CCBitsGet(Refs->has, ECSComponentBaseIndex(ID));
+    return CCBitsGet(Lookup->has, ECSComponentBaseIndex(ID));
 }
 
 static inline void *ECSEntityGetComponent(ECSContext *Context, ECSEntity Entity, ECSComponentID ID)
 {
     CCAssertLog(Context, "Context must not be null");
     
-    ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+    const ECSEntityLookup *Lookup = CCArrayGetElementAtIndex(Context->manager.lookup, Entity);
+    
+    if (!CCBitsGet(Lookup->has, ECSComponentBaseIndex(ID))) return NULL;
     
     switch (ID & ECSComponentStorageTypeMask)
     {
         case ECSComponentStorageTypeArchetype:
-            return ECSEntityHasComponent(Context, Entity, ID) ? CCArrayGetElementAtIndex(Refs->archetype.ptr->components[ECSArchetypeComponentIndex(Refs, ID & ~ECSComponentStorageMask)], Refs->archetype.index) : NULL;
+            return CCArrayGetElementAtIndex(Lookup->archetype->components[ECSArchetypeComponentMaskIndex(&Lookup->archetype->mask, ID & ~ECSComponentStorageMask)], Lookup->index);
             
         case ECSComponentStorageTypePacked:
         {
             const size_t Index = (ID & ~ECSComponentStorageMask);
-            return ECSEntityHasComponent(Context, Entity, ID) ? CCArrayGetElementAtIndex(*Context->packed[Index].components, Refs->packed.indexes[Index]) : NULL;
+            const ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+            return CCArrayGetElementAtIndex(*Context->packed[Index].components, Refs->packed.indexes[Index]);
         }
             
         case ECSComponentStorageTypeIndexed:
         {
             const size_t Index = (ID & ~ECSComponentStorageMask);
-            return ECSEntityHasComponent(Context, Entity, ID) ? CCArrayGetElementAtIndex(Context->indexed[Index], Entity) : NULL;
+#if ECS_INDEXED_SPARSE_SET
+            return CCArrayGetElementAtIndex(Context->indexed[Index], *(ECSEntityIndex*)CCArrayGetElementAtIndex(Context->indexedSets[Index].sparse, Entity));
+#else
+            return CCArrayGetElementAtIndex(Context->indexed[Index], Entity);
+#endif
         }
             
         case ECSComponentStorageTypeLocal:
         {
             const ptrdiff_t Offset = ECSLocalComponentOffset(ID);
-            return ECSEntityHasComponent(Context, Entity, ID) ? &Refs->local[Offset] : NULL;
+            ECSComponentRefs *Refs = CCArrayGetElementAtIndex(Context->manager.map, Entity);
+            return &Refs->local[Offset];
         }
             
         default:
@@ -1033,6 +1992,57 @@ static inline void *ECSEntityGetComponent(ECSContext *Context, ECSEntity Entity,
     return NULL;
 }
 
+#if ECS_INDEXED_SPARSE_SET
+static inline CCArray(ECSEntity) ECSIndexedGetEntities(ECSContext *Context, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog((ID & ECSComponentStorageTypeMask) == ECSComponentStorageTypeIndexed, "ID must be an indexed component");
+    
+    return Context->indexedSets[ID & ~ECSComponentStorageMask].entities;
+}
+#endif
+
+#if ECS_CHANGE_VERSION
+static inline ECSChangeVersion ECSContextGetChangeVersion(ECSContext *Context)
+{
+    CCAssertLog(Context, "Context must not be null");
+    
+    return atomic_load_explicit(&Context->version, memory_order_relaxed);
+}
+
+static inline ECSChangeVersion ECSArchetypeGetChangeVersion(const ECSArchetype *Archetype, size_t ArchetypeComponentIndex, size_t Index)
+{
+    CCAssertLog(Archetype, "Archetype must not be null");
+    
+    return ((const ECSChangeVersion*)CCArrayGetElementAtIndex(Archetype->versions, Index / Archetype->chunk))[ArchetypeComponentIndex];
+}
+
+static inline ECSChangeVersion ECSComponentGetChangeVersion(ECSContext *Context, ECSComponentID ID)
+{
+    CCAssertLog(Context, "Context must not be null");
+    
+    switch (ID & ECSComponentStorageTypeMask)
+    {
+        case ECSComponentStorageTypePacked:
+            return atomic_load_explicit(&Context->packedVersions[ID & ~ECSComponentStorageMask], memory_order_relaxed);
+            
+        case ECSComponentStorageTypeIndexed:
+            return atomic_load_explicit(&Context->indexedVersions[ID & ~ECSComponentStorageMask], memory_order_relaxed);
+            
+        default:
+            CCAssertLog(0, "Only packed and indexed components are versioned as a whole");
+            return 0;
+    }
+}
+#endif
+
+static inline void *ECSSharedComponentGetData(ECSSharedComponentHandle Handle)
+{
+    CCAssertLog(Handle, "Handle must not be null");
+    
+    return Handle->data;
+}
+
 static inline void ECSEntityAddDuplicateComponent(ECSContext *Context, ECSEntity Entity, const void *Data, ECSComponentID ID, size_t Count)
 {
     CCAssertLog(Context, "Context must not be null");
@@ -1040,36 +2050,33 @@ static inline void ECSEntityAddDuplicateComponent(ECSContext *Context, ECSEntity
     
     if (ID & ECSComponentStorageModifierDuplicate)
     {
-        CCArray *Component = ECSEntityGetComponent(Context, Entity, ID);
-        CCArray Duplicates;
+        const size_t Size = ECSDuplicateComponentSize(ID);
+        const size_t ChunkSize = ECSDuplicateComponentChunkSize(ID);
+        ECSDuplicateComponent *Component = ECSEntityGetComponent(Context, Entity, ID);
         
         if (!Component)
         {
-            Component = &Duplicates;
+            _Alignas(ECSDuplicateComponent) uint8_t Duplicates[ECS_DUPLICATE_COMPONENT_SIZE(Size)];
             
-            size_t Index = (ID & ~ECSComponentStorageMask);
+            ECSDuplicateComponentInit((ECSDuplicateComponent*)Duplicates, Size, ChunkSize);
+            ECSDuplicateComponentAppendElements((ECSDuplicateComponent*)Duplicates, Size, ChunkSize, Data, Count);
             
             switch (ID & ECSComponentStorageTypeMask)
             {
                 case ECSComponentStorageTypeArchetype:
-                    Duplicates = CCArrayCreate(CC_STD_ALLOCATOR, ECSDuplicateArchetypeComponentSizes[Index], ECS_DUPLICATE_ARCHETYPE_COMPONENT_ARRAY_CHUNK_SIZE(Index));
-                    ECSArchetypeAddComponent(Context, Entity, &Duplicates, ID);
+                    ECSArchetypeAddComponent(Context, Entity, Duplicates, ID);
                     break;
                     
                 case ECSComponentStorageTypePacked:
-                    Duplicates = CCArrayCreate(CC_STD_ALLOCATOR, ECSDuplicatePackedComponentSizes[Index], ECS_DUPLICATE_PACKED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
-                    ECSPackedAddComponent(Context, Entity, &Duplicates, ID);
+                    ECSPackedAddComponent(Context, Entity, Duplicates, ID);
                     break;
                     
                 case ECSComponentStorageTypeIndexed:
-                    Duplicates = CCArrayCreate(CC_STD_ALLOCATOR, ECSDuplicateIndexedComponentSizes[Index], ECS_DUPLICATE_INDEXED_COMPONENT_ARRAY_CHUNK_SIZE(Index));
-                    ECSIndexedAddComponent(Context, Entity, &Duplicates, ID);
+                    ECSIndexedAddComponent(Context, Entity, Duplicates, ID);
                     break;
                     
                 case ECSComponentStorageTypeLocal:
-                    Index = ECSLocalComponentIndex(ID);
-                    Duplicates = CCArrayCreate(CC_STD_ALLOCATOR, ECSDuplicateLocalComponentSizes[Index], ECS_DUPLICATE_LOCAL_COMPONENT_ARRAY_CHUNK_SIZE(Index));
-                    ECSLocalAddComponent(Context, Entity, &Duplicates, ID);
+                    ECSLocalAddComponent(Context, Entity, Duplicates, ID);
                     break;
                     
                 default:
@@ -1078,9 +2085,7 @@ static inline void ECSEntityAddDuplicateComponent(ECSContext *Context, ECSEntity
             }
         }
         
-        else Duplicates = *Component;
-        
-        CCArrayAppendElements(Duplicates, Data, Count);
+        else ECSDuplicateComponentAppendElements(Component, Size, ChunkSize, Data, Count);
     }
     
     else CCAssertLog(0, "Component does not allow duplicates");
@@ -1130,12 +2135,12 @@ static inline void ECSEntityRemoveDuplicateComponent(ECSContext *Context, ECSEnt
 #endif
         }
         
-        CCArray *Component = ECSEntityGetComponent(Context, Entity, ID);
+        ECSDuplicateComponent *Duplicates = ECSEntityGetComponent(Context, Entity, ID);
         
-        if (Component)
+        if (Duplicates)
         {
-            CCArray Duplicates = *Component;
-            const size_t DuplicatesCount = CCArrayGetCount(Duplicates);
+            const size_t DuplicateComponentSize = ECSDuplicateComponentSize(ID);
+            const size_t DuplicatesCount = ECSDuplicateComponentGetCount(Duplicates);
             
             if (Index < 0)
             {
@@ -1159,15 +2164,14 @@ static inline void ECSEntityRemoveDuplicateComponent(ECSContext *Context, ECSEnt
                         if (ID & ECSComponentStorageModifierDestructor)
                         {
 #if ECS_UNSAFE_COMPONENT_DESTRUCTION
-                            for (size_t Loop = 0; Loop < ElementCount; Loop++) Destructor(CCArrayGetElementAtIndex(Duplicates, Loop + Index), ID);
+                            for (size_t Loop = 0; Loop < ElementCount; Loop++) Destructor(ECSDuplicateComponentGetElementAtIndex(Duplicates, DuplicateComponentSize, Loop + Index), ID);
 #else
                             CopiedComponents = CCMemoryZoneAllocate(ECSSharedZone, sizeof(*CopiedComponents) * ElementCount);
-                            const size_t DuplicateComponentSize = CCArrayGetElementSize(Duplicates);
-                            for (size_t Loop = 0; Loop < ElementCount; Loop++) CopiedComponents[CopiedComponentCount++] = ECSSharedZoneStore(CCArrayGetElementAtIndex(Duplicates, Loop + Index), DuplicateComponentSize); // TODO: don't loop and copy entire list of components at once
+                            for (size_t Loop = 0; Loop < ElementCount; Loop++) CopiedComponents[CopiedComponentCount++] = ECSSharedZoneStore(ECSDuplicateComponentGetElementAtIndex(Duplicates, DuplicateComponentSize, Loop + Index), DuplicateComponentSize); // TODO: don't loop and copy entire list of components at once
 #endif
                         }
                         
-                        CCArrayRemoveElementsAtIndex(Duplicates, Index, ElementCount);
+                        ECSDuplicateComponentRemoveElementsAtIndex(Duplicates, DuplicateComponentSize, Index, ElementCount);
                     }
                     
                     else
@@ -1175,14 +2179,13 @@ static inline void ECSEntityRemoveDuplicateComponent(ECSContext *Context, ECSEnt
                         if (ID & ECSComponentStorageModifierDestructor)
                         {
 #if ECS_UNSAFE_COMPONENT_DESTRUCTION
-                            for (size_t Loop = 0; Loop < DuplicatesCount; Loop++) Destructor(CCArrayGetElementAtIndex(Duplicates, Loop), ID);
+                            for (size_t Loop = 0; Loop < DuplicatesCount; Loop++) Destructor(ECSDuplicateComponentGetElementAtIndex(Duplicates, DuplicateComponentSize, Loop), ID);
 #else
                             CopiedComponents = CCMemoryZoneAllocate(ECSSharedZone, sizeof(*CopiedComponents) * DuplicatesCount);
-                            const size_t DuplicateComponentSize = CCArrayGetElementSize(Duplicates);
-                            for (size_t Loop = 0; Loop < DuplicatesCount; Loop++) CopiedComponents[CopiedComponentCount++] = ECSSharedZoneStore(CCArrayGetElementAtIndex(Duplicates, Loop), DuplicateComponentSize); // TODO: don't loop and copy entire list of components at once
+                            for (size_t Loop = 0; Loop < DuplicatesCount; Loop++) CopiedComponents[CopiedComponentCount++] = ECSSharedZoneStore(ECSDuplicateComponentGetElementAtIndex(Duplicates, DuplicateComponentSize, Loop), DuplicateComponentSize); // TODO: don't loop and copy entire list of components at once
 #endif
                             
-                            CCArrayDestroy(Duplicates);
+                            ECSDuplicateComponentDestroy(Duplicates);
                         }
                         
                         switch (ID & ECSComponentStorageTypeMask)
@@ -1224,16 +2227,15 @@ static inline void ECSEntityRemoveDuplicateComponent(ECSContext *Context, ECSEnt
                     if (ID & ECSComponentStorageModifierDestructor)
                     {
 #if ECS_UNSAFE_COMPONENT_DESTRUCTION
-                        for (size_t Loop = 0; Loop < Count; Loop++) Destructor(CCArrayGetElementAtIndex(Duplicates, Loop + Index), ID);
+                        for (size_t Loop = 0; Loop < Count; Loop++) Destructor(ECSDuplicateComponentGetElementAtIndex(Duplicates, DuplicateComponentSize, Loop + Index), ID);
 #else
                         CopiedComponents = CCMemoryZoneAllocate(ECSSharedZone, sizeof(*CopiedComponents) * Count);
-                        const size_t DuplicateComponentSize = CCArrayGetElementSize(Duplicates);
-                        for (size_t Loop = 0; Loop < Count; Loop++) CopiedComponents[CopiedComponentCount++] = ECSSharedZoneStore(CCArrayGetElementAtIndex(Duplicates, Loop + Index), DuplicateComponentSize); // TODO: don't loop and copy entire list of components at once
+                        for (size_t Loop = 0; Loop < Count; Loop++) CopiedComponents[CopiedComponentCount++] = ECSSharedZoneStore(ECSDuplicateComponentGetElementAtIndex(Duplicates, DuplicateComponentSize, Loop + Index), DuplicateComponentSize); // TODO: don't loop and copy entire list of components at once
 #endif
                     }
                     
-                    CCArrayCopyElementsAtIndex(Duplicates, CopyIndex, Index, CopyCount);
-                    CCArrayRemoveElementsAtIndex(Duplicates, DuplicatesCount - Count, Count);
+                    ECSDuplicateComponentCopyElementsAtIndex(Duplicates, DuplicateComponentSize, CopyIndex, Index, CopyCount);
+                    ECSDuplicateComponentRemoveElementsAtIndex(Duplicates, DuplicateComponentSize, DuplicatesCount - Count, Count);
                 }
             }
         }
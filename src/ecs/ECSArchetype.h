@@ -27,11 +27,116 @@
 #define CommonGameKit_ECSArchetype_h
 
 #include <CommonGameKit/Base.h>
+#include <CommonGameKit/ECSConfig.h>
 
+#define ECS_ARCHETYPE_COMPONENT_MASK_COUNT (((ECS_ARCHETYPE_COMPONENT_MAX) + 63) / 64)
+
+/*!
+ * @brief The set of archetype components in an archetype.
+ * @description Bit @b n is set if the archetype has the archetype component with the index @b n.
+ */
+typedef struct {
+    uint64_t bits[ECS_ARCHETYPE_COMPONENT_MASK_COUNT];
+} ECSArchetypeComponentMask;
+
+/*!
+ * @brief Add an archetype component to the mask.
+ * @param Mask The mask to add the component to.
+ * @param ID The archetype component index.
+ */
+static inline void ECSArchetypeComponentMaskSet(ECSArchetypeComponentMask *Mask, size_t ID)
+{
+    Mask->bits[ID / 64] |= UINT64_C(1) << (ID % 64);
+}
+
+/*!
+ * @brief Check whether the mask has an archetype component.
+ * @param Mask The mask to check.
+ * @param ID The archetype component index.
+ * @return TRUE if the component is in the mask, otherwise FALSE.
+ */
+static inline _Bool ECSArchetypeComponentMaskHas(const ECSArchetypeComponentMask *Mask, size_t ID)
+{
+    return (Mask->bits[ID / 64] >> (ID % 64)) & 1;
+}
+
+/*!
+ * @brief Get the column of an archetype component.
+ * @description As the columns of an archetype are sorted by component, the column is the number of components in the mask
+ *              that precede it.
+ *
+ * @param Mask The mask of the archetype.
+ * @param ID The archetype component index.
+ * @return The column index, or SIZE_MAX if the component is not in the mask.
+ */
+static inline size_t ECSArchetypeComponentMaskIndex(const ECSArchetypeComponentMask *Mask, size_t ID)
+{
+    const size_t Word = ID / 64;
+    const uint64_t Bit = UINT64_C(1) << (ID % 64);
+    
+    if (!(Mask->bits[Word] & Bit)) return SIZE_MAX;
+    
+    size_t Index = CCBitCountSet(Mask->bits[Word] & (Bit - 1));
+    
+    for (size_t Loop = 0; Loop < Word; Loop++) Index += CCBitCountSet(Mask->bits[Loop]);
+    
+    return Index;
+}
+
+/*!
+ * @brief Check whether a mask has all the required components and none of the excluded components.
+ * @param Mask The mask to check.
+ * @param With The required components.
+ * @param Without The excluded components.
+ * @return TRUE if the mask matches, otherwise FALSE.
+ */
+static inline _Bool ECSArchetypeComponentMaskMatch(const ECSArchetypeComponentMask *Mask, const ECSArchetypeComponentMask *With, const ECSArchetypeComponentMask *Without)
+{
+    uint64_t Mismatch = 0;
+    
+    for (size_t Loop = 0; Loop < ECS_ARCHETYPE_COMPONENT_MASK_COUNT; Loop++)
+    {
+        Mismatch |= (With->bits[Loop] & ~Mask->bits[Loop]) | (Without->bits[Loop] & Mask->bits[Loop]);
+    }
+    
+    return !Mismatch;
+}
+
+#if ECS_CHANGE_VERSION
+/*!
+ * @brief The version of a change.
+ * @description Versions wrap, so they should only be compared using @b ECSChangeVersionIsNewer.
+ */
+typedef uint32_t ECSChangeVersion;
+
+/*!
+ * @brief Check whether a version is newer than another.
+ * @param Version The version to check.
+ * @param Since The version to compare against.
+ * @return TRUE if @b Version is newer than @b Since, otherwise FALSE.
+ */
+static inline _Bool ECSChangeVersionIsNewer(ECSChangeVersion Version, ECSChangeVersion Since)
+{
+    return (int32_t)(Version - Since) > 0;
+}
+
+#define ECSArchetype(n) struct { \
+    CCArray(ECSEntity) entities; \
+    size_t chunk; \
+    size_t info; \
+    ECSArchetypeComponentMask mask; \
+    CCArray versions; \
+    CCArray components[n]; \
+}
+#else
 #define ECSArchetype(n) struct { \
     CCArray(ECSEntity) entities; \
+    size_t chunk; \
+    size_t info; \
+    ECSArchetypeComponentMask mask; \
     CCArray components[n]; \
 }
+#endif
 
 typedef ECSArchetype() ECSArchetype;
 
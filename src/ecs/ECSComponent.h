@@ -32,6 +32,13 @@ typedef ECSArchetype(1) ECSPackedComponent;
 
 typedef CCArray ECSIndexedComponent;
 
+#if ECS_INDEXED_SPARSE_SET
+typedef struct {
+    CCArray(ECSEntity) entities;
+    CCArray(ECSEntityIndex) sparse;
+} ECSIndexedSparseSet;
+#endif
+
 typedef uint32_t ECSComponentID;
 
 typedef CC_FLAG_ENUM(ECSComponentStorage, ECSComponentID) {
@@ -40,12 +47,13 @@ typedef CC_FLAG_ENUM(ECSComponentStorage, ECSComponentID) {
     ECSComponentStorageTypeIndexed = (2 << 27),
     ECSComponentStorageTypeLocal = (3 << 27),
     
+    ECSComponentStorageModifierShared = (1 << 26),
     ECSComponentStorageModifierDestructor = (1 << 29),
     ECSComponentStorageModifierDuplicate = (1 << 30),
     ECSComponentStorageModifierTag = (1 << 31),
     
     ECSComponentStorageTypeMask = 0x18000000,
-    ECSComponentStorageModifierMask = 0xe0000000,
+    ECSComponentStorageModifierMask = 0xe4000000,
     ECSComponentStorageMask = ECSComponentStorageTypeMask | ECSComponentStorageModifierMask
 };
 
@@ -54,6 +62,34 @@ typedef struct {
     void *data;
 } ECSTypedComponent;
 
+#if ECS_DUPLICATE_INLINE_CAPACITY
+/*!
+ * @brief The storage of a duplicate component.
+ * @description The first @b ECS_DUPLICATE_INLINE_CAPACITY elements are stored inline, with any beyond that being stored
+ *              in @b spill.
+ */
+typedef struct {
+    size_t count;
+    CCArray spill;
+    uint8_t elements[];
+} ECSDuplicateComponent;
+
+/*!
+ * @brief The size of a duplicate component's storage for elements of @b size.
+ */
+#define ECS_DUPLICATE_COMPONENT_SIZE(size) CC_ALIGN(sizeof(ECSDuplicateComponent) + ((size) * ECS_DUPLICATE_INLINE_CAPACITY), _Alignof(ECSDuplicateComponent))
+#else
+/*!
+ * @brief The storage of a duplicate component.
+ */
+typedef CCArray ECSDuplicateComponent;
+
+/*!
+ * @brief The size of a duplicate component's storage for elements of @b size.
+ */
+#define ECS_DUPLICATE_COMPONENT_SIZE(size) sizeof(CCArray)
+#endif
+
 /*!
  * @brief A callback for when a component is removed.
  * @param Data The data for the component.
@@ -61,4 +97,18 @@ typedef struct {
  */
 typedef void (*ECSComponentDestructor)(void *Data, ECSComponentID ID);
 
+/*!
+ * @brief An interned value of a shared component.
+ * @description Entities with a shared component store a handle to the interned value, and the value is only destroyed once
+ *              no more handles reference it.
+ */
+typedef struct {
+    struct ECSContext *context;
+    size_t refs;
+    ECSComponentID id;
+    _Alignas(max_align_t) uint8_t data[];
+} ECSSharedComponentValue;
+
+typedef ECSSharedComponentValue *ECSSharedComponentHandle;
+
 #endif
@@ -66,20 +66,36 @@ CC_ENUM(size_t) {
     ECSHasBitCount
 };
 
+#if ECS_PACKED_COMPONENT_INDEX_64
+typedef size_t ECSPackedComponentIndex;
+
+#define ECS_PACKED_COMPONENT_INDEX_NONE SIZE_MAX
+#else
+typedef uint32_t ECSPackedComponentIndex;
+
+#define ECS_PACKED_COMPONENT_INDEX_NONE UINT32_MAX
+#endif
+
+/*!
+ * @brief The per-entity state read by every has/get lookup.
+ * @description Kept in its own dense array (@b ECSEntityManager.lookup) so lookups don't pull in the entity's @b ECSComponentRefs.
+ */
+typedef struct {
+    CCBits(uint8_t, ECSHasBitCount) has;
+    ECSArchetype *archetype;
+    ECSEntityIndex index;
+} ECSEntityLookup;
+
 typedef struct {
     struct {
-        ECSArchetype *ptr;
-        size_t index;
         struct {
-            ECS_ARCHETYPE_COMPONENT_IDS_ALIGNAS ECSArchetypeComponentID ids[ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX)];
             size_t count;
+            ECS_ARCHETYPE_COMPONENT_IDS_ALIGNAS ECSArchetypeComponentID ids[ECS_ARCHETYPE_COMPONENT_ID_COUNT(ECS_ARCHETYPE_MAX)];
         } component;
     } archetype;
     
-    CCBits(uint8_t, ECSHasBitCount) has;
-    
     struct {
-        size_t indexes[ECS_PACKED_COMPONENT_MAX];
+        ECSPackedComponentIndex indexes[ECS_PACKED_COMPONENT_MAX];
     } packed;
     
     uint8_t local[];
@@ -87,9 +103,48 @@ typedef struct {
 
 _Static_assert((offsetof(ECSComponentRefs, archetype.component.ids) % ECS_ARCHETYPE_COMPONENT_IDS_ALIGNMENT) == 0, "Needs to be correctly aligned");
 
+#ifndef ECS_ARCHETYPE_EDGE_CACHE_MAX
+#define ECS_ARCHETYPE_EDGE_CACHE_MAX 256
+#endif
+
+/*!
+ * @brief A cached archetype transition.
+ * @description Describes the archetype an entity in archetype @b source will move to when archetype component @b component is added
+ *              or removed. Archetypes are referenced by their offset into the context, where a @b source of 0 is an entity that is in
+ *              no archetype, and a @b dest of 0 is an unused edge.
+ */
+typedef struct {
+    ptrdiff_t source;
+    ptrdiff_t dest;
+    size_t index;
+    ECSArchetypeComponentID component;
+    _Bool add;
+} ECSArchetypeEdge;
+
+_Static_assert((ECS_ARCHETYPE_EDGE_CACHE_MAX & (ECS_ARCHETYPE_EDGE_CACHE_MAX - 1)) == 0, "ECS_ARCHETYPE_EDGE_CACHE_MAX must be a power of 2");
+
+/*!
+ * @brief An archetype that has been created in a context.
+ * @description The archetype is referenced by its offset into the context, and @b ids are the sorted archetype component IDs. The
+ *              @b mask is a copy of the archetype's mask, so matching can scan the infos without touching the archetypes.
+ */
+typedef struct {
+    ptrdiff_t offset;
+    ECSArchetypeComponentMask mask;
+    size_t count;
+    ECSArchetypeComponentID ids[ECS_ARCHETYPE_MAX];
+} ECSArchetypeInfo;
+
+/*!
+ * @brief The entities of a context.
+ * @description The @b map and @b available arrays are created by the application. The @b lookup array is created by the context
+ *              when the first entity is created (using the @b map chunk size), is kept the same length as @b map, and must be
+ *              destroyed along with it.
+ */
 typedef struct {
     CCArray(ECSComponentRefs) map;
-    CCArray(size_t) available;
+    CCArray(ECSEntityLookup) lookup;
+    CCArray(ECSEntity) available;
 } ECSEntityManager;
 
 typedef struct ECSContext {
@@ -103,6 +158,17 @@ typedef struct ECSContext {
     ECS_ARCHETYPE_DECLARE_MEMBERS(ECS_ARCHETYPE_MAX);
     ECSPackedComponent packed[ECS_PACKED_COMPONENT_MAX];
     ECSIndexedComponent indexed[ECS_INDEXED_COMPONENT_MAX];
+#if ECS_INDEXED_SPARSE_SET
+    ECSIndexedSparseSet indexedSets[ECS_INDEXED_COMPONENT_MAX];
+#endif
+    ECSArchetypeEdge edges[ECS_ARCHETYPE_EDGE_CACHE_MAX];
+    CCArray(ECSArchetypeInfo) archetypeInfo;
+    CCDictionary shared[ECS_ARCHETYPE_COMPONENT_MAX]; // value data : ECSSharedComponentHandle
+#if ECS_CHANGE_VERSION
+    _Atomic(ECSChangeVersion) version;
+    _Atomic(ECSChangeVersion) packedVersions[ECS_PACKED_COMPONENT_MAX];
+    _Atomic(ECSChangeVersion) indexedVersions[ECS_INDEXED_COMPONENT_MAX];
+#endif
 } ECSContext;
 
 #endif
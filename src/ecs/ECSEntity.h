@@ -27,7 +27,21 @@
 #define CommonGameKit_ECSEntity_h
 
 #include <CommonGameKit/Base.h>
+#include <CommonGameKit/ECSConfig.h>
 
+#if ECS_ENTITY_32
+/*!
+ * @brief An entity.
+ */
+typedef uint32_t ECSEntity;
+
+/*!
+ * @brief A proxy entity that can either be an @b ECSEntity or a relative entity index.
+ */
+typedef uint32_t ECSProxyEntity;
+
+#define ECS_RELATIVE_ENTITY_FLAG ~(UINT32_MAX >> 1)
+#else
 /*!
  * @brief An entity.
  */
@@ -39,6 +53,12 @@ typedef size_t ECSEntity;
 typedef size_t ECSProxyEntity;
 
 #define ECS_RELATIVE_ENTITY_FLAG ~(SIZE_MAX >> 1)
+#endif
+
+/*!
+ * @brief An index into storage that has at most one element per entity (such as the rows of an archetype).
+ */
+typedef ECSEntity ECSEntityIndex;
 
 #define ECS_RELATIVE_ENTITY(x) ((x) | ECS_RELATIVE_ENTITY_FLAG)
 
@@ -61,7 +81,7 @@ static inline ECSEntity ECSProxyEntityResolve(ECSProxyEntity ProxyEntity, ECSEnt
     {
         ProxyEntity = ProxyEntity & ~ECS_RELATIVE_ENTITY_FLAG;
         
-        CCAssertLog(ProxyEntity < Count, "Relative entity (%zu) is out of bounds (%zu)", ProxyEntity, Count);
+        CCAssertLog(ProxyEntity < Count, "Relative entity (%zu) is out of bounds (%zu)", (size_t)ProxyEntity, Count);
         
         return Entities[ProxyEntity];
     }
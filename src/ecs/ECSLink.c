@@ -45,6 +45,44 @@ static CCComparisonResult ECSLinkComparator(const void **Left, const void **Righ
     return *Left == *Right ? CCComparisonResultEqual : CCComparisonResultInvalid;
 }
 
+static void ECSLinkAssociationsReserve(ECSContext *Context, ECSEntity MaxEntity)
+{
+    const size_t Count = CCArrayGetCount(Context->links.associations);
+    
+    if (MaxEntity >= Count)
+    {
+        const size_t NewElementCount = (MaxEntity - Count) + 1;
+        
+        CCArrayAppendElements(Context->links.associations, NULL, NewElementCount);
+        
+        memset(CCArrayGetData(Context->links.associations) + (Count * sizeof(CCDictionary)), 0, NewElementCount * sizeof(CCDictionary));
+    }
+}
+
+static CCDictionary ECSLinkAssociationsCreate(_Bool HasMany)
+{
+    size_t Size;
+    CCDictionaryElementDestructor Destructor;
+    
+    if (HasMany)
+    {
+        Size = sizeof(CCArray);
+        Destructor = CCArrayDestructorForDictionary;
+    }
+    
+    else
+    {
+        Size = sizeof(ECSEntity);
+        Destructor = NULL;
+    }
+    
+    return CCDictionaryCreate(CC_STD_ALLOCATOR, CCDictionaryHintHeavyFinding | CCDictionaryHintHeavyInserting | CCDictionaryHintHeavyDeleting, sizeof(void*), Size, &(CCDictionaryCallbacks){
+        .getHash = (CCDictionaryKeyHasher)ECSLinkHasher,
+        .compareKeys = (CCComparator)ECSLinkComparator,
+        .valueDestructor = Destructor
+    });
+}
+
 static _Bool ECSLinkFindEntity(const ECSEntity *Entities, size_t Count, ECSEntity Entity, size_t *Index)
 {
     if (!Count)
@@ -87,18 +125,7 @@ void ECSLinkAdd(ECSContext *Context, ECSEntity EntityA, void *DataA, const ECSLi
         EntityB = Temp;
     }
     
-    const size_t Count = CCArrayGetCount(Context->links.associations);
-    const size_t MaxEntity = CCMax(EntityA, EntityB);
-    
-    if (MaxEntity >= Count)
-    {
-        const size_t NewElementCount = (MaxEntity - Count) + 1;
-        
-        CCArrayAppendElements(Context->links.associations, NULL, NewElementCount);
-        
-        memset(CCArrayGetData(Context->links.associations) + (Count * sizeof(CCDictionary)), 0, NewElementCount * sizeof(CCDictionary));
-    }
-    
+    ECSLinkAssociationsReserve(Context, CCMax(EntityA, EntityB));
     
     struct {
         ECSEntity entity;
@@ -120,29 +147,7 @@ void ECSLinkAdd(ECSContext *Context, ECSEntity EntityA, void *DataA, const ECSLi
         
         CCDictionary *Assoc = CCArrayGetElementAtIndex(Context->links.associations, Pair[Loop].entity);
         
-        if (!*Assoc)
-        {
-            size_t Size;
-            CCDictionaryElementDestructor Destructor;
-            
-            if (HasMany)
-            {
-                Size = sizeof(CCArray);
-                Destructor = CCArrayDestructorForDictionary;
-            }
-            
-            else
-            {
-                Size = sizeof(ECSEntity);
-                Destructor = NULL;
-            }
-            
-            *Assoc = CCDictionaryCreate(CC_STD_ALLOCATOR, CCDictionaryHintHeavyFinding | CCDictionaryHintHeavyInserting | CCDictionaryHintHeavyDeleting, sizeof(void*), Size, &(CCDictionaryCallbacks){
-                .getHash = (CCDictionaryKeyHasher)ECSLinkHasher,
-                .compareKeys = (CCComparator)ECSLinkComparator,
-                .valueDestructor = Destructor
-            });
-        }
+        if (!*Assoc) *Assoc = ECSLinkAssociationsCreate(HasMany);
         
         CCDictionaryEntry LinkEntry = CCDictionaryEntryForKey(*Assoc, &Key);
         const ECSEntity LinkedEntity = Pair[(Loop + 1) & 1].entity;
@@ -680,6 +685,126 @@ Empty:
     return NULL;
 }
 
+void ECSLinkRestore(ECSContext *Context, ECSEntity Entity, const ECSLink *Link, const ECSEntity *Entities, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Link, "Link must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    
+    const void *Key = Link;
+    ECSLinkType OppositeSide;
+    
+    if (ECS_LINK_IS_INVERTED(Link))
+    {
+        Link = ECS_LINK_INVERT(Link);
+        
+        OppositeSide = ECSLinkTypeWithLeft;
+    }
+    
+    else
+    {
+        OppositeSide = ECSLinkTypeWithRight;
+    }
+    
+    OppositeSide = Link->type >> OppositeSide;
+    
+    const _Bool HasMany = (OppositeSide & ECSLinkTypeGroupMask) == ECSLinkTypeGroupMany;
+    
+    CCAssertLog(HasMany || (Count == 1), "Count must be 1 when only a single entity can be linked");
+    
+    ECSLinkAssociationsReserve(Context, Entity);
+    
+    CCDictionary *Assoc = CCArrayGetElementAtIndex(Context->links.associations, Entity);
+    
+    if (!*Assoc) *Assoc = ECSLinkAssociationsCreate(HasMany);
+    
+    if (HasMany)
+    {
+        CCArray(ECSEntity) LinkedEntities = CCArrayCreate(CC_STD_ALLOCATOR, sizeof(ECSEntity), 16);
+        CCArrayAppendElements(LinkedEntities, Entities, Count);
+        
+        CCDictionarySetValue(*Assoc, &Key, &LinkedEntities);
+    }
+    
+    else CCDictionarySetValue(*Assoc, &Key, Entities);
+}
+
+static void ECSLinkRemapOppositeEntity(CCDictionary OppositeAssoc, _Bool HasMany, const void *Key, ECSEntity Entity, ECSEntity NewEntity)
+{
+    void *Linked = CCDictionaryGetEntry(OppositeAssoc, CCDictionaryFindKey(OppositeAssoc, &Key));
+    
+    if (HasMany)
+    {
+        CCArray(ECSEntity) LinkedEntities = *(CCArray*)Linked;
+        
+        size_t Index = 0;
+        if (!ECSLinkFindEntity(CCArrayGetData(LinkedEntities), CCArrayGetCount(LinkedEntities), Entity, &Index)) return;
+        
+        CCArrayRemoveElementAtIndex(LinkedEntities, Index);
+        
+        const size_t LinkedCount = CCArrayGetCount(LinkedEntities);
+        
+        ECSLinkFindEntity(CCArrayGetData(LinkedEntities), LinkedCount, NewEntity, &Index);
+        
+        if (Index == LinkedCount) CCArrayAppendElement(LinkedEntities, &NewEntity);
+        else CCArrayInsertElementAtIndex(LinkedEntities, Index, &NewEntity);
+    }
+    
+    else if (*(ECSEntity*)Linked == Entity) *(ECSEntity*)Linked = NewEntity;
+}
+
+void ECSLinkRemapEntity(ECSContext *Context, ECSEntity Entity, ECSEntity NewEntity)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(NewEntity < Entity, "NewEntity must be lower than Entity");
+    
+    const size_t Count = CCArrayGetCount(Context->links.associations);
+    
+    if (Entity >= Count) return;
+    
+    CCDictionary Assoc = *(CCDictionary*)CCArrayGetElementAtIndex(Context->links.associations, Entity);
+    CCDictionary *NewAssoc = CCArrayGetElementAtIndex(Context->links.associations, NewEntity);
+    
+    // A destroyed entity may still have its (now empty) associations
+    if (*NewAssoc)
+    {
+        CCDictionaryDestroy(*NewAssoc);
+        *NewAssoc = NULL;
+    }
+    
+    if (!Assoc) return;
+    
+    CCEnumerable Enumerable;
+    CCDictionaryGetKeyEnumerable(Assoc, &Enumerable);
+    
+    for (void **Key = CCEnumerableGetCurrent(&Enumerable); Key; Key = CCEnumerableNext(&Enumerable))
+    {
+        const _Bool Inverted = ECS_LINK_IS_INVERTED(*Key);
+        const ECSLink *Link = Inverted ? ECS_LINK_INVERT(*Key) : *Key;
+        const ECSLinkType Side = Link->type >> (Inverted ? ECSLinkTypeWithRight : ECSLinkTypeWithLeft);
+        const ECSLinkType OppositeSide = Link->type >> (Inverted ? ECSLinkTypeWithLeft : ECSLinkTypeWithRight);
+        
+        const _Bool HasMany = (OppositeSide & ECSLinkTypeGroupMask) == ECSLinkTypeGroupMany;
+        const _Bool OppositeHasMany = (Side & ECSLinkTypeGroupMask) == ECSLinkTypeGroupMany;
+        
+        void *Linked = CCDictionaryGetEntry(Assoc, CCDictionaryFindKey(Assoc, Key));
+        const ECSEntity *LinkedEntities = HasMany ? CCArrayGetData(*(CCArray*)Linked) : Linked;
+        const size_t LinkedCount = HasMany ? CCArrayGetCount(*(CCArray*)Linked) : 1;
+        
+        for (size_t Loop = 0; Loop < LinkedCount; Loop++)
+        {
+            // Self links reference the same associations, and may have already been remapped by the opposite key
+            const ECSEntity LinkedEntity = LinkedEntities[Loop];
+            CCDictionary OppositeAssoc = (LinkedEntity == Entity) || (LinkedEntity == NewEntity) ? Assoc : *(CCDictionary*)CCArrayGetElementAtIndex(Context->links.associations, LinkedEntity);
+            
+            ECSLinkRemapOppositeEntity(OppositeAssoc, OppositeHasMany, ECS_LINK_INVERT(*Key), Entity, NewEntity);
+        }
+    }
+    
+    *NewAssoc = Assoc;
+    *(CCDictionary*)CCArrayGetElementAtIndex(Context->links.associations, Entity) = NULL;
+}
+
 void ECSLinkEnumerable(ECSContext *Context, ECSEntity Entity, CCEnumerable *Enumerable)
 {
     CCAssertLog(Context, "Context must not be null");
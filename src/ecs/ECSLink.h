@@ -196,4 +196,29 @@ const ECSEntity *ECSLinkGet(ECSContext *Context, ECSEntity Entity, const ECSLink
  */
 void ECSLinkEnumerable(ECSContext *Context, ECSEntity Entity, CCEnumerable *Enumerable);
 
+/*!
+ * @brief Restore the entities an entity is linked to.
+ * @description This only sets the entities associated with @b Entity for the given side of the link, it does not associate the opposite
+ *              side or trigger any of the link's associations (callbacks or components). It's intended for restoring links that were
+ *              previously retrieved using @b ECSLinkGet, such as from a snapshot.
+ *
+ * @param Context The context to restore the link in.
+ * @param Entity The entity to restore the link for.
+ * @param Link The link to be restored. To invert the order of the link use @b ECS_LINK_INVERT(link).
+ * @param Entities The sorted entities that are linked to @b Entity.
+ * @param Count The number of entities. If only a single entity can be linked then this must be 1.
+ */
+void ECSLinkRestore(ECSContext *Context, ECSEntity Entity, const ECSLink *Link, const ECSEntity *Entities, size_t Count);
+
+/*!
+ * @brief Move the links of an entity to a new entity ID.
+ * @description The entities linked to @b Entity will be updated to reference @b NewEntity instead. This is used when compacting
+ *              entity IDs, so @b NewEntity must be lower than @b Entity and must not have any links.
+ *
+ * @param Context The context to remap the links of.
+ * @param Entity The entity whose links should be moved.
+ * @param NewEntity The new ID of the entity.
+ */
+void ECSLinkRemapEntity(ECSContext *Context, ECSEntity Entity, ECSEntity NewEntity);
+
 #endif
@@ -112,7 +112,8 @@ void ECSMonitorRecord(ECSMonitor *Monitor, const void *Data)
     if (Monitor->id & ECSComponentStorageModifierDuplicate)
     {
         ECSMonitorDuplicateContext *DuplicateContext = Monitor->context;
-        const size_t Count = Data ? CCArrayGetCount(*(CCArray*)Data) : 0;
+        const size_t Count = Data ? ECSDuplicateComponentGetCount(Data) : 0;
+        const size_t Size = ECSDuplicateComponentSize(Monitor->id);
         
         ECSMonitorDuplicateDiff *HighestDuplicateDiff = Monitor->page.diffs[DuplicateContext->highest % (Monitor->page.size * Monitor->page.count)];
         const size_t HighestCount = HighestDuplicateDiff ? HighestDuplicateDiff->count : 0;
@@ -152,7 +153,7 @@ void ECSMonitorRecord(ECSMonitor *Monitor, const void *Data)
         
         for (size_t Loop = 0; Loop < ElementCount; Loop++)
         {
-            void *Diff = Monitor->interface->diff(Monitor->sharedContext, CCMemoryZoneBlockGetPointer(&Block, &Offset, NULL), Zone, Monitor->id, Loop < Count ? CCArrayGetElementAtIndex(*(CCArray*)Data, Loop) : NULL);
+            void *Diff = Monitor->interface->diff(Monitor->sharedContext, CCMemoryZoneBlockGetPointer(&Block, &Offset, NULL), Zone, Monitor->id, Loop < Count ? ECSDuplicateComponentGetElementAtIndex(Data, Size, Loop) : NULL);
             
             DuplicateDiff->diffs[Loop] = Diff;
             
@@ -322,8 +323,15 @@ _Bool ECSMonitorTransform(ECSMonitor *Monitor, void *Data, size_t Revisions)
         
         Revisions = CCMin(Revisions, DiffCount);
         
-        CCArray Duplicates = *(CCArray*)Data;
-        if (!Duplicates) Duplicates = CCArrayCreate(CC_STD_ALLOCATOR, ECSComponentSize(Monitor->id), 16);
+        const size_t Size = ECSDuplicateComponentSize(Monitor->id);
+        ECSDuplicateComponent *Duplicates = Data;
+        
+#if ECS_DUPLICATE_INLINE_CAPACITY
+        _Bool Present = ECSDuplicateComponentGetCount(Duplicates);
+#else
+        _Bool Present = *Duplicates;
+        if (!Present) ECSDuplicateComponentInit(Duplicates, Size, ECSDuplicateComponentChunkSize(Monitor->id));
+#endif
         
         ECSMonitorDuplicateContext *DuplicateContext = Monitor->context;
         
@@ -341,16 +349,16 @@ _Bool ECSMonitorTransform(ECSMonitor *Monitor, void *Data, size_t Revisions)
             
             if (DuplicateCount)
             {
-                const size_t CurrentCount = CCArrayGetCount(Duplicates);
+                const size_t CurrentCount = ECSDuplicateComponentGetCount(Duplicates);
                 
                 if (DuplicateCount < CurrentCount)
                 {
-                    CCArrayRemoveElementsAtIndex(Duplicates, DuplicateCount, CurrentCount - DuplicateCount);
+                    ECSDuplicateComponentRemoveElementsAtIndex(Duplicates, Size, DuplicateCount, CurrentCount - DuplicateCount);
                 }
                 
                 else if (DuplicateCount > CurrentCount)
                 {
-                    CCArrayAppendElements(Duplicates, NULL, DuplicateCount - CurrentCount);
+                    ECSDuplicateComponentAppendElements(Duplicates, Size, ECSDuplicateComponentChunkSize(Monitor->id), NULL, DuplicateCount - CurrentCount);
                 }
                 
                 CCMemoryZoneBlock *Block = CCMemoryZoneGetBlock(DuplicateContext->zone);
@@ -363,28 +371,31 @@ _Bool ECSMonitorTransform(ECSMonitor *Monitor, void *Data, size_t Revisions)
                     
                     if (Diff)
                     {
-                        void *Element = CCArrayGetElementAtIndex(Duplicates, Loop2);
+                        void *Element = ECSDuplicateComponentGetElementAtIndex(Duplicates, Size, Loop2);
                         void *TransformedData = Transform(Monitor->sharedContext, CCMemoryZoneBlockGetPointer(&Block, &Offset, NULL), Zone, DuplicateDiff->diffs[Loop2], Monitor->id, Element);
                         
-                        if (TransformedData != Element) CCArrayReplaceElementAtIndex(Duplicates, Loop2, TransformedData);
+                        if (TransformedData != Element) memcpy(Element, TransformedData, Size);
                     }
                     
                     Offset += ContextSize;
                 }
                 
-                *(CCArray*)Data = Duplicates;
+                Present = TRUE;
             }
             
             else
             {
-                CCArrayRemoveAllElements(Duplicates);
-                *(CCArray*)Data = NULL;
+                ECSDuplicateComponentRemoveElementsAtIndex(Duplicates, Size, 0, ECSDuplicateComponentGetCount(Duplicates));
+                Present = FALSE;
             }
         }
         
-        if (!*(CCArray*)Data)
+        if (!Present)
         {
-            CCArrayDestroy(Duplicates);
+            ECSDuplicateComponentDestroy(Duplicates);
+#if !ECS_DUPLICATE_INLINE_CAPACITY
+            *Duplicates = NULL;
+#endif
             
             return FALSE;
         }
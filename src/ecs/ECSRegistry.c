@@ -97,6 +97,53 @@ void ECSRegistryDeregister(ECSContext *Context, ECSEntity Entity)
     }
 }
 
+void ECSRegistryDeregisterEntities(ECSContext *Context, const ECSEntity *Entities, size_t Count)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(Entities, "Entities must not be null");
+    
+    const size_t IDCount = CCArrayGetCount(Context->registry.uniqueEntityIDs);
+    
+    if (!IDCount) return;
+    
+    ECSRegistryID *IDs = CCArrayGetData(Context->registry.uniqueEntityIDs);
+    
+    for (size_t Loop = 0; Loop < Count; Loop++)
+    {
+        const ECSEntity Entity = Entities[Loop];
+        
+        if ((Entity < IDCount) && (IDs[Entity]))
+        {
+            CCDictionaryRemoveValue(Context->registry.registeredEntities, &(ECSRegistryID){ IDs[Entity] });
+            IDs[Entity] = NULL;
+        }
+    }
+}
+
+void ECSRegistryRemapEntity(ECSContext *Context, ECSEntity Entity, ECSEntity NewEntity)
+{
+    CCAssertLog(Context, "Context must not be null");
+    CCAssertLog(NewEntity < Entity, "NewEntity must be lower than Entity");
+    
+    const size_t Count = CCArrayGetCount(Context->registry.uniqueEntityIDs);
+    
+    if (Entity < Count)
+    {
+        ECSRegistryID *IDs = CCArrayGetData(Context->registry.uniqueEntityIDs);
+        ECSRegistryID ID = IDs[Entity];
+        
+        if (ID)
+        {
+            CCAssertLog(!IDs[NewEntity], "NewEntity must not be registered");
+            
+            *(ECSEntity*)CCDictionaryGetEntry(Context->registry.registeredEntities, CCDictionaryFindKey(Context->registry.registeredEntities, &ID)) = NewEntity;
+            
+            IDs[NewEntity] = ID;
+            IDs[Entity] = NULL;
+        }
+    }
+}
+
 void ECSRegistryReregister(ECSContext *Context, ECSEntity Entity, ECSRegistryID ID, _Bool AcquireID)
 {
     CCAssertLog(Context, "Context must not be null");
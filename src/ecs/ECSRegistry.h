@@ -64,6 +64,28 @@ ECSRegistryID ECSRegistryRegister(ECSContext *Context, ECSEntity Entity);
  */
 void ECSRegistryDeregister(ECSContext *Context, ECSEntity Entity);
 
+/*!
+ * @brief Deregister many entities.
+ * @description Deregistering an entity doesn't make the registry ID available again. To reuse that ID, @b ECSRegistryReregister
+ *              must be used.
+ *
+ * @param Context The context to deregister the entities from.
+ * @param Entities The entities to be deregistered.
+ * @param Count The number of entities.
+ */
+void ECSRegistryDeregisterEntities(ECSContext *Context, const ECSEntity *Entities, size_t Count);
+
+/*!
+ * @brief Move the registration of an entity to a new entity ID.
+ * @description This is used when compacting entity IDs, so the registry ID will now lookup @b NewEntity. @b NewEntity must be
+ *              lower than @b Entity and must not be registered.
+ *
+ * @param Context The context to remap the registration of.
+ * @param Entity The entity whose registration should be moved.
+ * @param NewEntity The new ID of the entity.
+ */
+void ECSRegistryRemapEntity(ECSContext *Context, ECSEntity Entity, ECSEntity NewEntity);
+
 /*!
  * @brief Reregister an entity with the provided ID.
  * @param Context The context to reregister the entity with.
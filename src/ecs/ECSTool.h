@@ -146,6 +146,17 @@
  */
 #define ECS_SYSTEM(system, ...) void system(ECSContext *ECS_CONTEXT_VAR, ECSArchetype *ECS_ARCHETYPE_VAR, const size_t *ECS_ARCHETYPE_COMPONENT_INDEXES_VAR, const size_t *ECS_COMPONENT_OFFSETS_VAR, ECSRange ECS_RANGE_VAR, ECSTime ECS_TIME_VAR)
 
+/*!
+ * @define ECS_MAIN_SYSTEM
+ * @abstract Mark a main thread system for the ecs\_tool.
+ * @description Main thread systems are executed by the thread calling @b ECSTick rather than a worker thread.
+ * @param system The @b ECSSystemUpdateCallback callback for the system.
+ * @param read The list of components that the system needs read access to. Wrap the list in parantheses, empty parantheses will indicate no read components.
+ * @param write The list of components that the system needs write access to. Wrap the list in parantheses, empty parantheses will indicate no write components.
+ * @return Returns the system function declaration.
+ */
+#define ECS_MAIN_SYSTEM(...) ECS_SYSTEM(__VA_ARGS__)
+
 /*!
  * @define ECS_PARALLEL_SYSTEM
  * @abstract Mark a parallel system for the ecs\_tool.
@@ -159,7 +170,8 @@
  * @param parallelism Optionally specify how the system should be parallelised. By default systems are parallelised by archetype with no chunking, but they may also
  *                    be parallelised by a specific component type and number (chunks) of components of that type. Valid options are indicating the size of the archetype
  *                    component chunks (this is SIZE_MAX by default) by using an integer (may also be a macro to an integer), or specifying the compone and chunk size
- *                    by providing a tuple with the component type and chunk size @b (component, @b size).
+ *                    by providing a tuple with the component type and chunk size @b (component, @b size). A chunk size of @b ECS_SYSTEM_CHUNK_ADAPTIVE will
+ *                    let the chunk size adapt to the cost of the system.
  *
  * @return Returns the system function declaration.
  */
@@ -333,7 +345,11 @@
 // packed
 #define ECS_ITER_INIT_1(type) if (ECS_ENTITIES(type)), (ECS_ITER_ENTITY_ARRAY, ECS_ENTITIES(type)), void ECS_ITER_PACKED_PRE_INIT(type, 0), (() ECS_ITER_IGNORE,              () ECS_ITER_IGNORE, () ECS_ITER_IGNORE, () ECS_ITER_IGNORE), (ECS_ITER_WARNING_FETCH,   ECS_ITER_PACKED_FETCH,   ECS_ITER_FALLBACK_FETCH, ECS_ITER_FALLBACK_FETCH)
 // indexed
+#if ECS_INDEXED_SPARSE_SET
+#define ECS_ITER_INIT_2(type) if (ECSIndexedGetEntities(ECS_CONTEXT_VAR, ECS_ID_##type)), (ECS_ITER_ENTITY_ARRAY, ECSIndexedGetEntities(ECS_CONTEXT_VAR, ECS_ID_##type)), void ECS_ITER_PACKED_PRE_INIT(type, 0), (() ECS_ITER_IGNORE, () ECS_ITER_IGNORE, () ECS_ITER_IGNORE, () ECS_ITER_IGNORE), (ECS_ITER_WARNING_FETCH,   ECS_ITER_FALLBACK_FETCH,   ECS_ITER_PACKED_FETCH,   ECS_ITER_FALLBACK_FETCH)
+#else
 #define ECS_ITER_INIT_2(type) ,                        (ECS_ITER_ENTITY_FALLBACK, "indexed", type), ,                                       (() ECS_ITER_IGNORE,              () ECS_ITER_IGNORE, () ECS_ITER_IGNORE, () ECS_ITER_IGNORE), (ECS_ITER_WARNING_FETCH,   ECS_ITER_FALLBACK_FETCH,   ECS_ITER_FALLBACK_FETCH, ECS_ITER_FALLBACK_FETCH)
+#endif
 // local
 #define ECS_ITER_INIT_3(type) ,                        (ECS_ITER_ENTITY_FALLBACK, "local", type), ,                                         (() ECS_ITER_IGNORE,              () ECS_ITER_IGNORE, () ECS_ITER_IGNORE, () ECS_ITER_IGNORE), (ECS_ITER_WARNING_FETCH,   ECS_ITER_FALLBACK_FETCH,   ECS_ITER_FALLBACK_FETCH, ECS_ITER_FALLBACK_FETCH)
 
@@ -352,7 +368,7 @@ for (size_t ECS_ITER_PRIVATE__ent = 0; !ECS_ITER_PRIVATE__ent; ) for (ECSEntity
 
 #define ECS_ITER_DECLARE_ASSIGN(e, i, v) e = v
 
-#define ECS_ITER_DECLARE_ARRAY_VAR(e, i, v) CCArray *ECS_ITER_PRIVATE__fetch_array##i = v, CC_CAT(e, ECS_ITER_DUPLICATE_ARRAY_SUFFIX) = ECS_ITER_PRIVATE__fetch_array##i
+#define ECS_ITER_DECLARE_ARRAY_VAR(e, i, v) ECSDuplicateComponent *ECS_ITER_PRIVATE__fetch_array##i = v, CC_CAT(e, ECS_ITER_DUPLICATE_ARRAY_SUFFIX) = ECS_ITER_PRIVATE__fetch_array##i
 
 #define ECS_ITER_DECLARE_VAR(x, i, v) ECS_ITER_DECLARE_##x, i, v)
 #define ECS_ITER_DECLARE_VAR_0(x, i, v) ECS_ITER_DECLARE_##x, i, v)
@@ -376,8 +392,8 @@ for (size_t ECS_ITER_PRIVATE__ent = 0; !ECS_ITER_PRIVATE__ent; ) for (ECSEntity
 #define ECS_ITER_NESTED_NONE(e, i)
 
 #define ECS_ITER_NESTED_ARRAY_ITERATOR(e, i) \
-for (size_t ECS_ITER_PRIVATE__fetch_duplicate_index##i = 0, ECS_ITER_DECLARE_ELEMENT_INDEX_VAR(e, i, &ECS_ITER_PRIVATE__fetch_duplicate_index##i), ECS_ITER_PRIVATE__fetch_duplicate_count##i = CCArrayGetCount(*ECS_ITER_PRIVATE__fetch_array##i), ECS_ITER_PRIVATE__duplicate_set##i = 0; ECS_ITER_PRIVATE__fetch_duplicate_index##i < ECS_ITER_PRIVATE__fetch_duplicate_count##i; ECS_ITER_PRIVATE__fetch_duplicate_index##i++, ECS_ITER_PRIVATE__duplicate_set##i = 0) \
-for (ECS_ITER_DECLARE_ELEMENT_VAR(e, i, (ECS_QUALIFIER(ECS_ITER_TYPE(e)) void*)CCArrayGetElementAtIndex(*ECS_ITER_PRIVATE__fetch_array##i, ECS_ITER_PRIVATE__fetch_duplicate_index##i)); !ECS_ITER_PRIVATE__duplicate_set##i++; )
+for (size_t ECS_ITER_PRIVATE__fetch_duplicate_index##i = 0, ECS_ITER_DECLARE_ELEMENT_INDEX_VAR(e, i, &ECS_ITER_PRIVATE__fetch_duplicate_index##i), ECS_ITER_PRIVATE__fetch_duplicate_count##i = ECSDuplicateComponentGetCount(ECS_ITER_PRIVATE__fetch_array##i), ECS_ITER_PRIVATE__duplicate_set##i = 0; ECS_ITER_PRIVATE__fetch_duplicate_index##i < ECS_ITER_PRIVATE__fetch_duplicate_count##i; ECS_ITER_PRIVATE__fetch_duplicate_index##i++, ECS_ITER_PRIVATE__duplicate_set##i = 0) \
+for (ECS_ITER_DECLARE_ELEMENT_VAR(e, i, (ECS_QUALIFIER(ECS_ITER_TYPE(e)) void*)ECSDuplicateComponentGetElementAtIndex(ECS_ITER_PRIVATE__fetch_array##i, sizeof(ECS_ITER_TYPE(e)), ECS_ITER_PRIVATE__fetch_duplicate_index##i)); !ECS_ITER_PRIVATE__duplicate_set##i++; )
 
 #define ECS_ITER_DECLARE_ELEMENT_VAR(x, i, v) ECS_ITER_DECLARE_ELEMENT_##x, i, v)
 #define ECS_ITER_DECLARE_ELEMENT_VAR_0(x, i, v) ECS_ITER_DECLARE_ELEMENT_##x, i, v)